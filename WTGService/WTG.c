@@ -43,9 +43,10 @@ int main(int argc,char **argv)
 {
     FILE *fp;
     char Line[256];
-    char STAIPAddress[256],sControlPortName[256],portNumber[256],sDUTPort[256],sCommand[1024],sPath[512];
+    char STAIPAddress[256],sControlPortName[256],portNumber[256],sDUTPort[256],sPath[512];
     char sValue[512];
-    int i=0;
+    char sEndpoints[1024];
+    int i=0, n;
 
     memset(Line,'\0',sizeof(Line));
     memset(STAIPAddress,'\0',sizeof(STAIPAddress));
@@ -53,6 +54,7 @@ int main(int argc,char **argv)
     memset(sPath,'\0',sizeof(sPath));
     memset(sValue,'\0',sizeof(sValue));
     memset(sDUTPort,'\0',sizeof(sDUTPort));
+    memset(sEndpoints,'\0',sizeof(sEndpoints));
 
     serviceLogFile=fopen("/var/log/WTG-WTS.log","w");
     int iThreadCounter=0;
@@ -74,38 +76,35 @@ int main(int argc,char **argv)
                             getParameterValue(Line,"control_agent_port",portNumber) &&
                             getParameterValue(Line,"endpoint_port_number", sDUTPort))
                     {
-                        if(iLogging)
-                            sprintf(sCommand,"%s %s %s %s %s %s/%s_%s.%s",
-                                    WFA_CA,sControlPortName,portNumber,STAIPAddress,
-                                    sDUTPort,sPath,STAIPAddress,portNumber,"log");
-                        else
-                            sprintf(sCommand,"%s %s %s %s %s",
-                                    WFA_CA,sControlPortName,portNumber,STAIPAddress,sDUTPort);
-                        /* Start Control Agent for Testbed STAs */
-                        threadPool[iThreadCounter].thread_id=pthread_create(&threadPool[iThreadCounter].thr, &threadPool[iThreadCounter].attr,startControlAgent,(void *)sCommand);
-                        sleep(2);
-                        iThreadCounter++;
+                        /* Testbed STAs are all served by one Control Agent */
+                        n = strlen(sEndpoints);
+                        if(snprintf(sEndpoints + n, sizeof(sEndpoints) - n, " %s:%s:%s",
+                                    portNumber, STAIPAddress, sDUTPort) >= sizeof(sEndpoints) - n)
+                        {
+                            sEndpoints[n] = '\0';
+                            wfa_print("\n Too many Testbed STAs, %s:%s ignored",STAIPAddress,sDUTPort);
+                        }
                     }
                     else if ( *sPath && *sControlPortName && getParameterValue(Line,"wtg_control_port_number",sValue))
                     {
-                        if(iLogging)
-                            sprintf(sCommand,"%s %s %s  %s",WFA_DUT,"lo","8000","/var/log/WTG-WTS.log");
-                        else
-                            sprintf(sCommand,"%s %s %s",WFA_DUT,"lo","8000");
-
-                        /* Start Traffic Generator of PC-EndPoint */
-                        threadPool[iThreadCounter].thread_id=pthread_create(&threadPool[iThreadCounter].thr, &threadPool[iThreadCounter].attr,startTG,(void *)sCommand);
-                        sleep(2);
-                        iThreadCounter++;
+                        /* the PC-EndPoint is one more endpoint of the Control Agent */
+                        n = strlen(sEndpoints);
+                        if(snprintf(sEndpoints + n, sizeof(sEndpoints) - n, " %s:%s:%s",
+                                    sValue, "127.0.0.1", "8000") >= sizeof(sEndpoints) - n)
+                        {
+                            sEndpoints[n] = '\0';
+                            wfa_print("\n Too many endpoints, PC-EndPoint %s not started",sValue);
+                            memset(sValue,'\0',sizeof(sValue));
+                            continue;
+                        }
 
                         if(iLogging)
-                            sprintf(sCommand,"%s %s %s %s %s %s/%s_%s.%s",WFA_CA,"lo",sValue,"127.0.0.1", "8000",sPath,"WTG",sValue,"log");
+                            sprintf(threadPool[iThreadCounter].command,"%s %s %s  %s",WFA_DUT,"lo","8000","/var/log/WTG-WTS.log");
                         else
-                            sprintf(sCommand,"%s %s %s %s %s",WFA_CA,sControlPortName,sValue,"127.0.0.1","8000");
+                            sprintf(threadPool[iThreadCounter].command,"%s %s %s",WFA_DUT,"lo","8000");
 
-                        /* Start Control Agent of PC-EndPoint */
-                        threadPool[iThreadCounter].thread_id=pthread_create(&threadPool[iThreadCounter].thr, &threadPool[iThreadCounter].attr,startControlAgent,sCommand);
-                        sleep(2);
+                        /* Start Traffic Generator of PC-EndPoint */
+                        threadPool[iThreadCounter].thread_id=pthread_create(&threadPool[iThreadCounter].thr, &threadPool[iThreadCounter].attr,startTG,(void *)threadPool[iThreadCounter].command);
                         iThreadCounter++;
                     }
                     else if (getParameterValue(Line,"PATH",sPath))
@@ -130,7 +129,23 @@ int main(int argc,char **argv)
                 }
 
                 memset(sValue,'\0',sizeof(sValue));
-                memset(sCommand,'\0',sizeof(sCommand));
+            }
+
+            /*
+             * Start the Control Agent for all the endpoints at once. A DUT
+             * that is not up yet is connected on its first command.
+             */
+            if(*sEndpoints)
+            {
+                if(iLogging)
+                    snprintf(threadPool[iThreadCounter].command,WTG_CMD_LEN,"%s %s%s %s/%s.%s",
+                             WFA_CA,sControlPortName,sEndpoints,sPath,"WTG_CA","log");
+                else
+                    snprintf(threadPool[iThreadCounter].command,WTG_CMD_LEN,"%s %s%s",
+                             WFA_CA,sControlPortName,sEndpoints);
+
+                threadPool[iThreadCounter].thread_id=pthread_create(&threadPool[iThreadCounter].thr, &threadPool[iThreadCounter].attr,startControlAgent,(void *)threadPool[iThreadCounter].command);
+                iThreadCounter++;
             }
         }
         else
@@ -195,8 +210,8 @@ int isLineComment (char *Line)
 
 void* startControlAgent(void *commandLine)
 {
-    char sCommand[1024];
-    sprintf(sCommand,"%s",(char *)commandLine);
+    char sCommand[WTG_CMD_LEN];
+    snprintf(sCommand,sizeof(sCommand),"%s",(char *)commandLine);
     wfa_print("\n Starting Control Agent -  %s ",sCommand);
     while(1)
     {
@@ -208,8 +223,8 @@ void* startControlAgent(void *commandLine)
 
 void* startTG(void *commandLine)
 {
-    char sCommand[1024];
-    sprintf(sCommand,"%s",(char *)commandLine);
+    char sCommand[WTG_CMD_LEN];
+    snprintf(sCommand,sizeof(sCommand),"%s",(char *)commandLine);
     wfa_print("\n Starting WTG -  %s",(char *)sCommand);
 
     while(1)
@@ -24,6 +24,9 @@
 
 #define MAX_THREAD 10
 
+/* room for a Control Agent command line with all the Testbed STAs */
+#define WTG_CMD_LEN 2048
+
 /* Control Agent binary name */
 #define WFA_CA "/usr/bin/wfa_ca"
 
@@ -42,5 +45,5 @@ struct WTG_Thread
     pthread_t thr;
     pthread_attr_t attr;
     int thread_id;
-    char command[256];
+    char command[WTG_CMD_LEN];
 };
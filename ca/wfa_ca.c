@@ -28,7 +28,9 @@
 #include <stdlib.h>     /* for atoi() and exit() */
 #include <string.h>     /* for memset() */
 #include <unistd.h>     /* for close() */
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <errno.h>
 
 #include "wfa_debug.h"
 #include "wfa_main.h"
@@ -36,17 +38,18 @@
 #include "wfa_tlv.h"
 #include "wfa_tg.h"
 #include "wfa_cmds.h"
+#include "wfa_rsp.h"
 #include "wfa_miscs.h"
 #include "wfa_sock.h"
 #include "wfa_ca.h"
+#include "wfa_ca_resp.h"
 #include "wfa_agtctrl.h"
+#include "wfa_cli.h"
 
 #define WFA_ENV_AGENT_IPADDR "WFA_ENV_AGENT_IPADDR"
 
 extern int xcCmdProcGetVersion(unsigned char *parms);
 extern dutCommandRespFuncPtr wfaCmdRespProcFuncTbl[];
-extern typeNameStr_t nameStr[];
-extern char gRespStr[];
 
 int gSock = -1, tmsockfd, gCaSockfd = -1, xcSockfd, btSockfd;
 int gtgSend, gtgRecv, gtgTransac;
@@ -57,48 +60,726 @@ long          itimeout = 0;
 unsigned short wfa_defined_debug = WFA_DEBUG_ERR | WFA_DEBUG_WARNING | WFA_DEBUG_INFO;
 unsigned short dfd_lvl = WFA_DEBUG_DEFAULT | WFA_DEBUG_ERR | WFA_DEBUG_INFO;
 
+/*
+ * CAPI commands forwarded to the DUT that have not been answered yet,
+ * matched to their response by the control link request id
+ */
+#define WFA_CA_MAX_PENDING   16
+
+typedef struct _ca_pending
+{
+    WORD reqId;                 /* 0 when the slot is free  */
+    char name[WFA_BUFF_32];
+    struct timeval start;       /* when the command came in */
+} caPending_t;
+
+/*
+ * A test manager port and the DUT it drives. One process serves all the
+ * endpoints it is given from a single epoll loop; the response functions
+ * work on the endpoint selected by caSelect().
+ */
+typedef struct _ca_endpoint
+{
+    unsigned short tmPort;
+    int tmListenFd;
+    int tmFd;                   /* -1 while no test manager is connected */
+    struct sockaddr_in dutAddr;
+    int dutFd;                  /* -1 while the DUT link is down */
+    int connecting;             /* dutFd is not connected yet */
+    int retryMs;                /* reconnect backoff, 0 while the link is up */
+    struct timeval retryAt;     /* when the DUT link is tried again, or
+                                   the connect in progress given up */
+    WORD lastReqId;
+    wfaCtrlRx_t rx;             /* DUT link reassembly buffer */
+    wfaCtrlLine_t tmLine;       /* test manager line not complete yet */
+    BYTE parked[WFA_CAPI_CMD_SZ];   /* command waiting for the connect */
+    int parkedLen;
+    caPending_t pending[WFA_CA_MAX_PENDING];
+    wfaRespBuf_t resp;
+    char held[WFA_BUFF_4K];     /* DUT results that came with no test manager */
+    int heldLen;
+} caEndpoint_t;
+
+/* epoll data of a socket: the endpoint index and which of its sockets */
+#define CA_FD_LISTEN        0
+#define CA_FD_TM            1
+#define CA_FD_DUT           2
+#define CA_FD_KEY(idx, kind)    (((idx) << 2) | (kind))
+
+#define CA_MAX_EVENTS       16
+
+/* what the response functions may read of a single response */
+#define CA_RESP_MIN_LEN     (int)(WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t))
+
+/*
+ * a DUT link that is lost or refused is tried again on its own, first
+ * after CA_RETRY_MIN_MS and then twice as late each time up to
+ * CA_RETRY_MAX_MS. A connect is finished by the epoll loop, one that
+ * does not complete in time counts as refused; the other endpoints are
+ * not held up by a DUT that went away.
+ */
+#define CA_RETRY_MIN_MS     250
+#define CA_RETRY_MAX_MS     8000
+#define CA_CONNECT_TMOUT_MS 2000
+
+static caEndpoint_t *caEps;
+static int caNumEps;
+static int caEpfd = -1;
+
+static BYTE xcCmdBuf[WFA_CAPI_CMD_SZ];
+static BYTE caCmdBuf[WFA_CTRL_MAX_TLV];
+
+static void caDutConnectDone(caEndpoint_t *ep, int err);
+
+/*
+ * caPendingAdd(): remember a command sent to the DUT, a busy slot is
+ *                 taken over by the newest command.
+ */
+static void caPendingAdd(caEndpoint_t *ep, WORD reqId, char *name, struct timeval *start)
+{
+    caPending_t *p = &ep->pending[reqId % WFA_CA_MAX_PENDING];
+
+    if(p->reqId != 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "%s request %u still unanswered\n", p->name, p->reqId);
+    }
+
+    p->reqId = reqId;
+    snprintf(p->name, sizeof(p->name), "%s", name);
+    p->start = *start;
+}
+
+/*
+ * caPendingDone(): log the round trip of a command answered by the DUT.
+ */
+static void caPendingDone(caEndpoint_t *ep, WORD reqId)
+{
+    caPending_t *p = &ep->pending[reqId % WFA_CA_MAX_PENDING];
+    struct timeval now;
+
+    if(reqId == 0 || p->reqId != reqId)
+    {
+        DPRINT_INFO(WFA_OUT, "response to request %u, not pending\n", reqId);
+        return;
+    }
+
+    gettimeofday(&now, NULL);
+    DPRINT_INFO(WFA_OUT, "port %u %s request %u done in %.3f ms\n", ep->tmPort, p->name, reqId,
+                wfa_ftime_diff(&p->start, &now) * 1000);
+    p->reqId = 0;
+}
+
+/* the response functions answer the selected endpoint's test manager */
+static void caSelect(caEndpoint_t *ep)
+{
+    gCaSockfd = ep->tmFd;
+    gSock = ep->dutFd;
+    gResp = &ep->resp;
+}
+
+static void caSendStatus(caEndpoint_t *ep, char *status)
+{
+    char respStr[WFA_BUFF_64];
+
+    sprintf(respStr, "status,%s\r\n", status);
+    wfaCtrlSend(ep->tmFd, (BYTE *)respStr, strlen(respStr));
+}
+
+static int caWatch(int fd, int key, int op, unsigned int events)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u32 = key;
+
+    if(epoll_ctl(caEpfd, op, fd, &ev) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "epoll_ctl() failed: %i\n", errno);
+        return WFA_FAILURE;
+    }
+
+    return WFA_SUCCESS;
+}
+
+/* closing a socket also takes it out of the epoll set */
+static void caDutClose(caEndpoint_t *ep)
+{
+    if(ep->dutFd != -1)
+    {
+        close(ep->dutFd);
+        ep->dutFd = -1;
+    }
+    ep->connecting = 0;
+}
+
+/*
+ * caDutDown(): close the DUT link and set when it is tried again. The
+ *              commands still pending stay so, the DUT sends the results
+ *              of its streams again once the link is back.
+ */
+static void caDutDown(caEndpoint_t *ep)
+{
+    caDutClose(ep);
+
+    if(ep->retryMs == 0)
+        ep->retryMs = CA_RETRY_MIN_MS;
+    else if(ep->retryMs < CA_RETRY_MAX_MS)
+        ep->retryMs *= 2;
+    if(ep->retryMs > CA_RETRY_MAX_MS)
+        ep->retryMs = CA_RETRY_MAX_MS;
+
+    gettimeofday(&ep->retryAt, NULL);
+    ep->retryAt.tv_sec += ep->retryMs / 1000;
+    ep->retryAt.tv_usec += (ep->retryMs % 1000) * 1000;
+    if(ep->retryAt.tv_usec >= 1000000)
+    {
+        ep->retryAt.tv_sec++;
+        ep->retryAt.tv_usec -= 1000000;
+    }
+
+    DPRINT_INFO(WFA_OUT, "port %u DUT link down, retry in %i ms\n", ep->tmPort, ep->retryMs);
+}
+
+static void caTmClose(caEndpoint_t *ep)
+{
+    if(ep->tmFd != -1)
+    {
+        shutdown(ep->tmFd, SHUT_WR);
+        close(ep->tmFd);
+        ep->tmFd = -1;
+    }
+    ep->parkedLen = 0;
+}
+
+/*
+ * caDutUp(): the control link to the DUT is connected.
+ */
+static int caDutUp(caEndpoint_t *ep)
+{
+    int flags = fcntl(ep->dutFd, F_GETFL, 0);
+
+    fcntl(ep->dutFd, F_SETFL, flags & ~O_NONBLOCK);
+    wfaCtrlSockTune(ep->dutFd);
+    wfaCtrlRxReset(&ep->rx);
+
+    if(caWatch(ep->dutFd, CA_FD_KEY(ep - caEps, CA_FD_DUT), ep->connecting ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+               EPOLLIN) != WFA_SUCCESS)
+    {
+        caDutDown(ep);
+        return WFA_FAILURE;
+    }
+
+    ep->connecting = 0;
+    ep->retryMs = 0;
+    DPRINT_INFO(WFA_OUT, "port %u connected to DUT %s:%u\n", ep->tmPort,
+                inet_ntoa(ep->dutAddr.sin_addr), ntohs(ep->dutAddr.sin_port));
+
+    return WFA_SUCCESS;
+}
+
+static void caDutFailed(caEndpoint_t *ep, int err)
+{
+    DPRINT_ERR(WFA_ERR, "connect() to %s:%u failed: %i\n", inet_ntoa(ep->dutAddr.sin_addr),
+               ntohs(ep->dutAddr.sin_port), err);
+    caDutDown(ep);
+}
+
+/*
+ * caDutConnect(): open the control link to the endpoint's DUT. A connect
+ *                 that does not complete at once is left to the epoll
+ *                 loop, see caDutConnectDone().
+ * return:  WFA_SUCCESS if the link is up or connecting, WFA_FAILURE if it
+ *          is retried after the backoff or with the next command
+ */
+static int caDutConnect(caEndpoint_t *ep)
+{
+    int flags;
+
+    if ((ep->dutFd = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "socket() failed: %i", errno);
+        caDutDown(ep);
+        return WFA_FAILURE;
+    }
+
+    flags = fcntl(ep->dutFd, F_GETFL, 0);
+    fcntl(ep->dutFd, F_SETFL, flags | O_NONBLOCK);
+
+    if (connect(ep->dutFd, (struct sockaddr *) &ep->dutAddr, sizeof(ep->dutAddr)) == 0)
+        return caDutUp(ep);
+
+    if(errno != EINPROGRESS)
+    {
+        caDutFailed(ep, errno);
+        return WFA_FAILURE;
+    }
+
+    /* writable once connected or refused, given up at retryAt */
+    if(caWatch(ep->dutFd, CA_FD_KEY(ep - caEps, CA_FD_DUT), EPOLL_CTL_ADD, EPOLLOUT) != WFA_SUCCESS)
+    {
+        caDutDown(ep);
+        return WFA_FAILURE;
+    }
+
+    ep->connecting = 1;
+    gettimeofday(&ep->retryAt, NULL);
+    ep->retryAt.tv_sec += CA_CONNECT_TMOUT_MS / 1000;
+    ep->retryAt.tv_usec += (CA_CONNECT_TMOUT_MS % 1000) * 1000;
+    if(ep->retryAt.tv_usec >= 1000000)
+    {
+        ep->retryAt.tv_sec++;
+        ep->retryAt.tv_usec -= 1000000;
+    }
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * caRetryWait(): the epoll timeout until the next DUT link is due to be
+ *                tried again, -1 if every link is up.
+ */
+static int caRetryWait(void)
+{
+    struct timeval now;
+    int i, ms, wait = -1;
+
+    gettimeofday(&now, NULL);
+    for(i = 0; i < caNumEps; i++)
+    {
+        if(caEps[i].dutFd != -1 ? !caEps[i].connecting : caEps[i].retryMs == 0)
+            continue;
+
+        ms = (caEps[i].retryAt.tv_sec - now.tv_sec) * 1000 +
+             (caEps[i].retryAt.tv_usec - now.tv_usec) / 1000;
+        if(ms < 0)
+            ms = 0;
+        if(wait == -1 || ms < wait)
+            wait = ms;
+    }
+
+    return wait;
+}
+
+/*
+ * caRetryDue(): try again the DUT links whose backoff is over, give up
+ *               the connects that took too long
+ */
+static void caRetryDue(void)
+{
+    struct timeval now;
+    caEndpoint_t *ep;
+    int i;
+
+    gettimeofday(&now, NULL);
+    for(i = 0; i < caNumEps; i++)
+    {
+        ep = &caEps[i];
+        if(ep->dutFd != -1 ? !ep->connecting : ep->retryMs == 0)
+            continue;
+
+        if(now.tv_sec < ep->retryAt.tv_sec ||
+                (now.tv_sec == ep->retryAt.tv_sec && now.tv_usec < ep->retryAt.tv_usec))
+            continue;
+
+        caSelect(ep);
+        if(ep->connecting)
+            caDutConnectDone(ep, ETIMEDOUT);
+        else
+            caDutConnect(ep);
+    }
+}
+
+/*
+ * caEndpointAdd(): listen for a test manager on tmPort and send its
+ *                  commands to the DUT at dutIP:dutPort.
+ */
+static int caEndpointAdd(unsigned short tmPort, char *dutIP, unsigned short dutPort)
+{
+    caEndpoint_t *ep = &caEps[caNumEps];
+
+    memset(ep, 0, sizeof(*ep));
+    ep->tmPort = tmPort;
+    ep->tmFd = -1;
+    ep->dutFd = -1;
+    ep->dutAddr.sin_family      = AF_INET;
+    ep->dutAddr.sin_addr.s_addr = inet_addr(dutIP);
+    ep->dutAddr.sin_port        = htons(dutPort);
+
+    if((ep->tmListenFd = wfaCreateTCPServSock(tmPort)) < 0)
+        return WFA_FAILURE;
+
+    if(caWatch(ep->tmListenFd, CA_FD_KEY(caNumEps, CA_FD_LISTEN), EPOLL_CTL_ADD, EPOLLIN) != WFA_SUCCESS)
+        return WFA_FAILURE;
+
+    DPRINT_INFO(WFA_OUT, "port %u drives DUT %s:%u\n", tmPort, dutIP, dutPort);
+    caNumEps++;
+
+    return WFA_SUCCESS;
+}
+
+/* an endpoint given as <local control agent port>:<DUT IP>:<DUT port> */
+static int caEndpointParse(char *spec)
+{
+    char *tmPort, *dutIP, *dutPort, *save = NULL;
+
+    tmPort = strtok_r(spec, ":", &save);
+    dutIP = strtok_r(NULL, ":", &save);
+    dutPort = strtok_r(NULL, ":", &save);
+
+    if(tmPort == NULL || dutIP == NULL || dutPort == NULL ||
+            isNumber(tmPort) == WFA_FAILURE || isIpV4Addr(dutIP) == WFA_FAILURE ||
+            isNumber(dutPort) == WFA_FAILURE)
+    {
+        DPRINT_ERR(WFA_ERR, "bad endpoint %s, expected <port>:<DUT IP>:<DUT port>\n", spec);
+        return WFA_FAILURE;
+    }
+
+    return caEndpointAdd(atoi(tmPort), dutIP, atoi(dutPort));
+}
+
+static void caLogTo(char *path)
+{
+    FILE *logfile;
+    int fd;
+
+    logfile = fopen(path,"a");
+    if(logfile != NULL)
+    {
+        fd = fileno(logfile);
+        DPRINT_INFO(WFA_OUT,"redirecting the output to %s\n",path);
+        dup2(fd,1);
+        dup2(fd,2);
+    }
+    else
+    {
+        DPRINT_ERR(WFA_ERR, "Cant open the log file continuing without redirecting\n");
+    }
+}
+
+/*
+ * caTmCommand(): translate the CAPI command line in xcCmdBuf and pass it
+ *                on to the DUT.
+ */
+static void caTmCommand(caEndpoint_t *ep, int nbytes)
+{
+    typeNameStr_t *cmdEntry;
+    char cmdName[WFA_BUFF_32];
+    BYTE pcmdBuf[MAX_PARMS_BUFF];
+    char *pcmdStr = NULL;
+    int slen, cmdLen = MAX_PARMS_BUFF;
+    struct timeval cmdStart;
+
+    wfaRespReset();
+
+    gettimeofday(&cmdStart, NULL);
+    DPRINT_INFO(WFA_OUT, "port %u message %s %i\n", ep->tmPort, xcCmdBuf, nbytes);
+    slen = (int )strlen((char *)xcCmdBuf);
+
+    if(slen >= 3)
+        xcCmdBuf[slen-3] = '\0';
+
+    /* the connect made for it, see caTmLines(), failed */
+    if(ep->dutFd == -1)
+    {
+        caSendStatus(ep, "ERROR");
+        return;
+    }
+
+    /*
+     * a command listed for the DUT command line goes there
+     * whole, else it is split into its name and parameters
+     */
+    memset(cmdName, 0, sizeof(cmdName));
+    slen = strcspn((char *)xcCmdBuf, ",");
+    if(slen < sizeof(cmdName))
+        memcpy(cmdName, xcCmdBuf, slen);
+
+    if(wfaCliCmdIsListed(cmdName))
+    {
+        strcpy(cmdName, "wfa_cli_cmd");
+        pcmdStr = (char *)&xcCmdBuf[0];
+    }
+    else
+    {
+        strtok_r((char *)xcCmdBuf, ",", (char **)&pcmdStr);
+    }
+
+    cmdEntry = wfaNameStrLookup(cmdName);
+    DPRINT_INFO(WFA_OUT, "%s\n", cmdName);
+
+    /*
+     * a command is answered INVALID without RUNNING, that
+     * status alone tells the caller it is done with it
+     */
+    if(cmdEntry == NULL)
+    {
+        caSendStatus(ep, "INVALID");
+        DPRINT_WARNING(WFA_WNG, "Command not valid, check the name\n");
+        return;
+    }
+
+    memset(pcmdBuf, 0, MAX_PARMS_BUFF);
+    if(cmdEntry->cmdProcFunc(pcmdStr, pcmdBuf, &cmdLen)==WFA_FAILURE)
+    {
+        caSendStatus(ep, "INVALID");
+        DPRINT_WARNING(WFA_WNG, "Incorrect command syntax\n");
+        return;
+    }
+
+    /*
+     * send to DUT, the response comes back with the same
+     * request id. 0 is left for reports nobody asked for.
+     */
+    if(++ep->lastReqId == 0)
+        ep->lastReqId = 1;
+    if(wfaCtrlSendFrame(ep->dutFd, ep->lastReqId, pcmdBuf, cmdLen) != cmdLen)
+    {
+        caSendStatus(ep, "ERROR");
+        DPRINT_WARNING(WFA_WNG, "Incorrect sending ...\n");
+        caDutDown(ep);
+        return;
+    }
+
+    /*
+     * the command is with the DUT, tell the command line or
+     * TM; the final status follows when the DUT responds
+     */
+    caSendStatus(ep, "RUNNING");
+    caPendingAdd(ep, ep->lastReqId, cmdName, &cmdStart);
+
+    DPRINT_INFO(WFA_OUT, "sent to DUT, request %u\n", ep->lastReqId);
+}
+
+/*
+ * caTmLines(): run the commands the test manager completed. With the DUT
+ *              link down a command connects it first; until the connect
+ *              is done it is parked and the lines after it wait.
+ */
+static void caTmLines(caEndpoint_t *ep)
+{
+    int nbytes;
+
+    memset(xcCmdBuf, 0, WFA_CAPI_CMD_SZ);
+    while(ep->tmFd != -1 && !ep->connecting && (nbytes = wfaCtrlNextLine(&ep->tmLine, xcCmdBuf)) > 0)
+    {
+        if(ep->dutFd == -1)
+            caDutConnect(ep);
+
+        if(ep->connecting)
+        {
+            memcpy(ep->parked, xcCmdBuf, nbytes + 1);
+            ep->parkedLen = nbytes;
+            break;
+        }
+
+        caTmCommand(ep, nbytes);
+        memset(xcCmdBuf, 0, WFA_CAPI_CMD_SZ);
+    }
+}
+
+/*
+ * caTmRecv(): take what the test manager sent and run the commands it
+ *             completes. A partial line is kept for the next read, the
+ *             other endpoints are not held up waiting for its end.
+ */
+static void caTmRecv(caEndpoint_t *ep)
+{
+    if(wfaCtrlRecvLine(ep->tmFd, &ep->tmLine) <= 0)
+    {
+        caTmClose(ep);
+        return;
+    }
+
+    caTmLines(ep);
+}
+
+/*
+ * caDutConnectDone(): the connect in progress succeeded or failed, err
+ *                     being its SO_ERROR. The parked command goes to the
+ *                     DUT or is answered ERROR, the next lines follow.
+ */
+static void caDutConnectDone(caEndpoint_t *ep, int err)
+{
+    struct sockaddr_in peer;
+    socklen_t errLen = sizeof(err), peerLen = sizeof(peer);
+    int nbytes;
+
+    if(err == 0 && getsockopt(ep->dutFd, SOL_SOCKET, SO_ERROR, &err, &errLen) < 0)
+        err = errno;
+
+    /* an event of a socket closed earlier in the batch, this one still connects */
+    if(err == 0 && getpeername(ep->dutFd, (struct sockaddr *)&peer, &peerLen) < 0 && errno == ENOTCONN)
+        return;
+
+    if(err != 0)
+        caDutFailed(ep, err);
+    else
+        caDutUp(ep);
+
+    if(ep->parkedLen > 0)
+    {
+        nbytes = ep->parkedLen;
+        ep->parkedLen = 0;
+        memcpy(xcCmdBuf, ep->parked, nbytes + 1);
+        caTmCommand(ep, nbytes);
+    }
+
+    caTmLines(ep);
+}
+
+/*
+ * caHold(): keep the reply just made for a test manager that is not
+ *           connected, it gets it when it connects. Reports are not kept.
+ */
+static void caHold(caEndpoint_t *ep)
+{
+    if(gResp->len == 0)
+        return;
+
+    if(ep->heldLen + gResp->len >= sizeof(ep->held))
+    {
+        DPRINT_WARNING(WFA_WNG, "port %u result dropped, no test manager\n", ep->tmPort);
+        return;
+    }
+
+    memcpy(ep->held + ep->heldLen, gResp->buf, gResp->len);
+    ep->heldLen += gResp->len;
+}
+
+/*
+ * caDutResponses(): pass the DUT's responses on to the test manager.
+ */
+static void caDutResponses(caEndpoint_t *ep)
+{
+    int bytesRcvd;
+    WORD tag, reqId;
+
+    DPRINT_INFO(WFA_OUT, "received from DUT\n");
+    if ((bytesRcvd = wfaCtrlRecvFrames(ep->dutFd, &ep->rx)) <= 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "recv() failed or connection closed prematurely\n");
+        caDutDown(ep);
+        return;
+    }
+
+    /* dispatch every complete response, a partial one waits */
+    for(;;)
+    {
+        bytesRcvd = wfaCtrlNextFrame(&ep->rx, &reqId, caCmdBuf, WFA_CTRL_MAX_TLV);
+        if(bytesRcvd <= 0)
+            break;
+
+        /* a response is sent without its zero tail, see wfaEncodeResp() */
+        if(bytesRcvd < CA_RESP_MIN_LEN)
+            memset(caCmdBuf + bytesRcvd, 0, CA_RESP_MIN_LEN - bytesRcvd);
+
+#if DEBUG
+        {
+            int i;
+            for(i = 0; i< bytesRcvd; i++)
+                printf("%x ", caCmdBuf[i]);
+            printf("\n");
+        }
+#endif
+        tag = ((wfaTLV *)caCmdBuf)->tag;
+
+        DPRINT_INFO(WFA_OUT, "tag %i request %u\n", tag, reqId);
+        if(tag != 0 && tag <= WFA_STA_RESPONSE_END && wfaCmdRespProcFuncTbl[tag] != NULL)
+        {
+            wfaCmdRespProcFuncTbl[tag](caCmdBuf);
+            if(ep->tmFd == -1 && reqId != 0)
+                caHold(ep);
+        }
+        else
+        {
+            /* e.g. a command the DUT refused with tag 0, still answer it */
+            DPRINT_WARNING(WFA_WNG, "function not defined\n");
+            if(reqId != 0 && ep->tmFd != -1)
+                caSendStatus(ep, ((dutCmdResponse_t *)(caCmdBuf + 4))->status == STATUS_ERROR ? "ERROR" : "INVALID");
+        }
+
+        /* request 0 is an interval report, nothing waits for it */
+        if(reqId != 0)
+            caPendingDone(ep, reqId);
+    }
+
+    if(bytesRcvd < 0)
+    {
+        /* out of step with the DUT, start over */
+        caDutDown(ep);
+    }
+}
+
+static void caUsage(char *prog)
+{
+    DPRINT_ERR(WFA_ERR, "Usage: %s <control interface> <local control agent port> [<DUT IP ADDRESS> <DUT PORT> [<log file>]]\n", prog);
+    DPRINT_ERR(WFA_ERR, "       %s <control interface> <local control agent port>:<DUT IP ADDRESS>:<DUT PORT> ... [<log file>]\n", prog);
+}
+
 /*
  * the output format can be redefined for file output.
  */
 
 int main(int argc, char *argv[])
 {
-    int nfds;
-    struct sockaddr_in servAddr;
+    int nfds, i, idx;
     unsigned short servPort, myport;
     char *servIP=NULL, *tstr=NULL;
-    int bytesRcvd;
-    fd_set sockSet;
-    char cmdName[WFA_BUFF_32];
-    int i, isFound = 0, nbytes, ret_status, slen;
-    WORD tag;
-    int tmsockfd, cmdLen = WFA_BUFF_1K;
-    int maxfdn1;
-    BYTE xcCmdBuf[WFA_BUFF_4K];
-    BYTE caCmdBuf[WFA_BUFF_4K];
-    BYTE pcmdBuf[WFA_BUFF_1K];
-    char *pcmdStr = NULL;
-    char respStr[WFA_BUFF_512];
+    struct epoll_event events[CA_MAX_EVENTS];
+    caEndpoint_t *ep;
 
-    //start of CLI handling variables
-    char wfaCliBuff[128];
-    FILE *wfaCliFd;
-    char * cliCmd,*tempCmdBuff;
     if(argc < 3)
+    {
+        caUsage(argv[0]);
+        exit(1);
+    }
+
+    if(wfaNameStrInit() != WFA_SUCCESS || wfaCmdProcInit() != WFA_SUCCESS)
+        exit(1);
+
+    if((caEpfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "epoll_create1() failed: %i\n", errno);
+        exit(1);
+    }
+
+    /* at most one endpoint per argument */
+    caEps = (caEndpoint_t *)calloc(argc, sizeof(caEndpoint_t));
+    if(caEps == NULL)
+        exit(1);
+
+    if(strchr(argv[2], ':') != NULL)
+    {
+        for(i = 2; i < argc; i++)
         {
-            DPRINT_ERR(WFA_ERR, "Usage: %s <control interface> <local control agent port>\n", argv[0]);
-            exit(1);
+            if(strchr(argv[i], ':') != NULL)
+            {
+                if(caEndpointParse(argv[i]) != WFA_SUCCESS)
+                    exit(1);
+            }
+            else if(i == argc - 1)
+            {
+                caLogTo(argv[i]);
+            }
+            else
+            {
+                caUsage(argv[0]);
+                exit(1);
+            }
         }
+    }
+    else
+    {
+        myport = atoi(argv[2]);
 
-    myport = atoi(argv[2]);
-
-    if(argc > 3)
+        if(argc > 3)
         {
             if(argc < 5)
-                {
-                    DPRINT_ERR(WFA_ERR, "Usage: %s <control interface> <local control agent port> <DUT IP ADDRESS> <DUT PORT>\n", argv[0]);
-                    exit(1);
-                }
+            {
+                caUsage(argv[0]);
+                exit(1);
+            }
             servIP = argv[3];
             if(isIpV4Addr(argv[3])== WFA_FAILURE)
                 return WFA_FAILURE;
@@ -106,263 +787,96 @@ int main(int argc, char *argv[])
                 return WFA_FAILURE;
             servPort = atoi(argv[4]);
             if(argc > 5)
-                {
-                    FILE *logfile;
-                    int fd;
-                    logfile = fopen(argv[5],"a");
-                    if(logfile != NULL)
-                        {
-                            fd = fileno(logfile);
-                            DPRINT_INFO(WFA_OUT,"redirecting the output to %s\n",argv[5]);
-                            dup2(fd,1);
-                            dup2(fd,2);
-                        }
-                    else
-                        {
-                            DPRINT_ERR(WFA_ERR, "Cant open the log file continuing without redirecting\n");
-                        }
-                }
+                caLogTo(argv[5]);
         }
-    else
+        else
         {
             if((tstr = getenv("WFA_ENV_AGENT_IPADDR")) == NULL)
-                {
-                    DPRINT_ERR(WFA_ERR, "Environment variable WFA_ENV_AGENT_IPADDR not set or specify DUT IP/PORT\n");
-                    exit(1);
-                }
+            {
+                DPRINT_ERR(WFA_ERR, "Environment variable WFA_ENV_AGENT_IPADDR not set or specify DUT IP/PORT\n");
+                exit(1);
+            }
             if(isIpV4Addr(tstr)== WFA_FAILURE)
                 return WFA_FAILURE;
             servIP= tstr;
             if((tstr = getenv("WFA_ENV_AGENT_PORT")) == NULL)
-                {
-                    DPRINT_ERR(WFA_ERR, "Environment variable WFA_ENV_AGENT_PORT not set or specify DUT IP/PORT\n");
-                    exit(1);
-                }
+            {
+                DPRINT_ERR(WFA_ERR, "Environment variable WFA_ENV_AGENT_PORT not set or specify DUT IP/PORT\n");
+                exit(1);
+            }
             if(isNumber(tstr)== WFA_FAILURE)
                 return WFA_FAILURE;
             servPort = atoi(tstr);
         }
 
-    tmsockfd = wfaCreateTCPServSock(myport);
+        if(caEndpointAdd(myport, servIP, servPort) != WFA_SUCCESS)
+            exit(1);
+    }
 
-    maxfdn1 = tmsockfd + 1;
+    /* a DUT that is not up yet is tried again until it is */
+    for(i = 0; i < caNumEps; i++)
+        caDutConnect(&caEps[i]);
 
-    FD_ZERO(&sockSet);
-    if(gSock == -1)
+    for(;;)
+    {
+        nfds = epoll_wait(caEpfd, events, CA_MAX_EVENTS, caRetryWait());
+        caRetryDue();
+        if(nfds < 0)
         {
-            if ((gSock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0)
-                {
-                    DPRINT_ERR(WFA_ERR, "socket() failed: %i", errno);
-                    exit(1);
-                }
-
-            memset(&servAddr, 0, sizeof(servAddr));
-            servAddr.sin_family      = AF_INET;
-            servAddr.sin_addr.s_addr = inet_addr(servIP);
-            servAddr.sin_port        = htons(servPort);
-
-            if (connect(gSock, (struct sockaddr *) &servAddr, sizeof(servAddr)) < 0)
-                {
-                    DPRINT_ERR(WFA_ERR, "connect() failed: %i", errno);
-                    exit(1);
-                }
+            if(errno == EINTR)
+                continue;
 
+            DPRINT_WARNING(WFA_WNG, "epoll_wait error %i", errno);
+            continue;
         }
 
-    for(;;)
+        for(i = 0; i < nfds; i++)
         {
-            FD_ZERO(&sockSet);
-            FD_SET(tmsockfd, &sockSet);
-            maxfdn1 = tmsockfd + 1;
-
-            if(gCaSockfd != -1)
+            idx = events[i].data.u32 >> 2;
+            ep = &caEps[idx];
+            caSelect(ep);
+
+            switch(events[i].data.u32 & 3)
+            {
+            case CA_FD_LISTEN:
+                /* a new test manager connection replaces the old one */
+                caTmClose(ep);
+                wfaCtrlLineReset(&ep->tmLine);
+                ep->tmFd = wfaAcceptTCPConn(ep->tmListenFd);
+                if(ep->tmFd == -1)
+                    break;
+                if(caWatch(ep->tmFd, CA_FD_KEY(idx, CA_FD_TM), EPOLL_CTL_ADD, EPOLLIN) != WFA_SUCCESS)
+                    caTmClose(ep);
+                DPRINT_INFO(WFA_OUT, "port %u accept new connection\n", ep->tmPort);
+
+                if(ep->tmFd != -1 && ep->heldLen > 0)
                 {
-                    FD_SET(gCaSockfd, &sockSet);
-                    if(maxfdn1 < gCaSockfd)
-                        maxfdn1 = gCaSockfd +1;
+                    wfaCtrlSend(ep->tmFd, (BYTE *)ep->held, ep->heldLen);
+                    ep->heldLen = 0;
                 }
+                break;
 
-            if(gSock != -1)
+            case CA_FD_TM:
+                /* a socket closed earlier in this batch may still report */
+                if(ep->tmFd != -1)
                 {
-                    FD_SET(gSock, &sockSet);
-                    if(maxfdn1 < gSock)
-                        maxfdn1 = gSock +1;
+                    caTmRecv(ep);
                 }
+                break;
 
-            if((nfds = select(maxfdn1, &sockSet, NULL, NULL, NULL)) < 0)
+            case CA_FD_DUT:
+                if(ep->connecting)
                 {
-                    if(errno == EINTR)
-                        continue;
-                    else
-                        DPRINT_WARNING(WFA_WNG, "select error %i", errno);
+                    caDutConnectDone(ep, 0);
                 }
-
-            DPRINT_INFO(WFA_OUT, "new event \n");
-            if(FD_ISSET(tmsockfd, &sockSet))
+                else if(ep->dutFd != -1)
                 {
-                    gCaSockfd = wfaAcceptTCPConn(tmsockfd);
-                    DPRINT_INFO(WFA_OUT, "accept new connection\n");
-                    continue;
+                    caDutResponses(ep);
                 }
+                break;
+            }
+        }
+    } /* for */
 
-            if(gCaSockfd > 0 && FD_ISSET(gCaSockfd, &sockSet))
-                {
-                    memset(xcCmdBuf, 0, WFA_BUFF_4K);
-                    memset(gRespStr, 0, WFA_BUFF_512);
-
-                    nbytes = wfaCtrlRecv(gCaSockfd, xcCmdBuf);
-                    if(nbytes <=0)
-                        {
-                            shutdown(gCaSockfd, SHUT_WR);
-                            close(gCaSockfd);
-                            gCaSockfd = -1;
-                            continue;
-                        }
-
-                    /*
-                     * send back to command line or TM.
-                     */
-                    memset(respStr, 0, WFA_BUFF_128);
-                    sprintf(respStr, "status,RUNNING\r\n");
-                    wfaCtrlSend(gCaSockfd, (BYTE *)respStr, strlen(respStr));
-
-                    DPRINT_INFO(WFA_OUT, "%s\n", respStr);
-                    DPRINT_INFO(WFA_OUT, "message %s %i\n", xcCmdBuf, nbytes);
-                    slen = (int )strlen((char *)xcCmdBuf);
-
-                    DPRINT_INFO(WFA_OUT, "last %x last-1  %x last-2 %x last-3 %x\n", cmdName[slen], cmdName[slen-1], cmdName[slen-2], cmdName[slen-3]);
-
-                    xcCmdBuf[slen-3] = '\0';
-
-                    if(gSock == -1)
-                        {
-                            if ((gSock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0)
-                                {
-                                    DPRINT_ERR(WFA_ERR, "socket() failed: %i", errno);
-                                    exit(1);
-                                }
-
-                            memset(&servAddr, 0, sizeof(servAddr));
-                            servAddr.sin_family      = AF_INET;
-                            servAddr.sin_addr.s_addr = inet_addr(servIP);
-                            servAddr.sin_port        = htons(servPort);
-
-                            if (connect(gSock, (struct sockaddr *) &servAddr, sizeof(servAddr)) < 0)
-                                {
-                                    DPRINT_ERR(WFA_ERR, "connect() failed: %i", errno);
-                                    exit(1);
-                                }
-                        }
-
-                    isFound = 0;
-
-                    tempCmdBuff=(char* )malloc(sizeof(xcCmdBuf));
-                    memcpy(tempCmdBuff,xcCmdBuf,sizeof(xcCmdBuf));
-
-                    memcpy(cmdName, strtok_r((char *)tempCmdBuff, ",", (char **)&pcmdStr), 32);
-                    printf("\nInside the CLI huck block \n");
-
-                    wfaCliFd=fopen("/etc/WfaEndpoint/wfa_cli.txt","r");
-                    printf("\nAfter File open \n");
-                    if(wfaCliFd!= NULL)
-                        {
-                            while(fgets(wfaCliBuff, 128, wfaCliFd) != NULL)
-                                {
-                                    if(ferror(wfaCliFd))
-                                        break;
-                                    cliCmd=strtok(wfaCliBuff,"-");
-                                    if(strcmp(cliCmd,cmdName) == 0)
-                                        {
-                                            strcpy(cmdName,"wfa_cli_cmd");
-                                            pcmdStr = (char *)&xcCmdBuf[0];
-                                            break;
-                                        }
-                                }
-                            fclose(wfaCliFd);
-
-                        }
-                    printf("\nOutside the new block \n");
-                    free(tempCmdBuff);
-                    if(strcmp(cmdName,"wfa_cli_cmd") != 0)
-                        memcpy(cmdName, strtok_r((char *)xcCmdBuf, ",", (char **)&pcmdStr), 32);
-
-
-                    i = 0;
-                    while(nameStr[i].type != -1)
-                        {
-                            if(strcmp(nameStr[i].name, cmdName) == 0)
-                                {
-                                    isFound = 1;
-                                    break;
-                                }
-                            i++;
-                        }
-
-                    DPRINT_INFO(WFA_OUT, "%s\n", cmdName);
-
-                    if(isFound == 0)
-                        {
-                            sleep(1);
-                            sprintf(respStr, "status,INVALID\r\n");
-                            wfaCtrlSend(gCaSockfd, (BYTE *)respStr, strlen(respStr));
-                            DPRINT_WARNING(WFA_WNG, "Command not valid, check the name\n");
-                            continue;
-                        }
-
-                    memset(pcmdBuf, 0, WFA_BUFF_1K);
-                    if(nameStr[i].cmdProcFunc(pcmdStr, pcmdBuf, &cmdLen)==WFA_FAILURE)
-                        {
-                            sleep(1);
-                            sprintf(respStr, "status,INVALID\r\n");
-                            wfaCtrlSend(gCaSockfd, (BYTE *)respStr, strlen(respStr));
-                            DPRINT_WARNING(WFA_WNG, "Incorrect command syntax\n");
-                            continue;
-                        }
-
-                    /*
-                     * send to DUT.
-                     */
-                    if(send(gSock, pcmdBuf, cmdLen, 0) != cmdLen)
-                        {
-                            DPRINT_WARNING(WFA_WNG, "Incorrect sending ...\n");
-                            continue;
-                        }
-
-                    DPRINT_INFO(WFA_OUT, "sent to DUT\n");
-                } /* done with gCaSockfd */
-
-            if(gSock > 0 && FD_ISSET(gSock, &sockSet))
-                {
-                    DPRINT_INFO(WFA_OUT, "received from DUT\n");
-                    sleep(1);
-                    memset(respStr, 0, WFA_BUFF_128);
-                    memset(caCmdBuf, 0, WFA_BUFF_4K);
-                    if ((bytesRcvd = recv(gSock, caCmdBuf, WFA_BUFF_4K, 0)) <= 0)
-                        {
-                            DPRINT_WARNING(WFA_WNG, "recv() failed or connection closed prematurely");
-                            continue;
-                        }
-
-#if DEBUG
-                    for(i = 0; i< bytesRcvd; i++)
-                        printf("%x ", caCmdBuf[i]);
-                    printf("\n");
-#endif
-                    tag = ((wfaTLV *)caCmdBuf)->tag;
-
-                    memcpy(&ret_status, caCmdBuf+4, 4);
-
-                    DPRINT_INFO(WFA_OUT, "tag %i \n", tag);
-                    if(tag != 0 && wfaCmdRespProcFuncTbl[tag] != NULL)
-                        {
-                            wfaCmdRespProcFuncTbl[tag](caCmdBuf);
-                        }
-                    else
-                        DPRINT_WARNING(WFA_WNG, "function not defined\n");
-                } /* if(gCaSock */
-
-        } /* for */
-
-    close(gSock);
     exit(0);
 }
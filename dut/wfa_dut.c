@@ -42,6 +42,7 @@
 #include "wfa_agt.h"
 #include "wfa_rsp.h"
 #include "wfa_wmmps.h"
+#include "wfa_exec.h"
 
 /* Global flags for synchronizing the TG functions */
 int        gtimeOut = 0;        /* timeout value for select call in usec */
@@ -51,7 +52,6 @@ extern BOOL gtgWmmPS;
 extern unsigned long psTxMsg[512];
 extern unsigned long psRxMsg[512];
 extern wfaWmmPS_t wmmps_info;
-extern tgWMM_t    wmmps_mutex_info;
 extern int  psSockfd;
 extern struct apts_msg *apts_msgs;
 
@@ -78,12 +78,9 @@ extern int btSockfd;
 extern int tgSockfds[];
 
 extern     xcCommandFuncPtr gWfaCmdFuncTbl[]; /* command process functions */
-extern     char gCmdStr[];
 extern     tgStream_t *findStreamProfile(int);
 extern     int clock_drift_ps;
 
-dutCmdResponse_t gGenericResp;
-
 /* Debug message flags */
 unsigned short wfa_defined_debug = WFA_DEBUG_ERR | WFA_DEBUG_WARNING | WFA_DEBUG_INFO;
 unsigned short dfd_lvl = WFA_DEBUG_DEFAULT | WFA_DEBUG_ERR | WFA_DEBUG_INFO;
@@ -94,7 +91,6 @@ unsigned short dfd_lvl = WFA_DEBUG_DEFAULT | WFA_DEBUG_ERR | WFA_DEBUG_INFO;
 tgWMM_t wmm_thr[WFA_THREADS_NUM];
 
 extern void *wfa_wmm_thread(void *thr_param);
-extern void *wfa_wmmps_thread();
 
 extern double gtgPktRTDelay;
 
@@ -103,19 +99,21 @@ int gxcSockfd = -1;
 #define DEBUG 0
 
 extern int wfa_estimate_timer_latency();
-extern void wfa_dut_init(BYTE **tBuf, BYTE **rBuf, BYTE **paBuf, BYTE **cBuf, struct timeval **timerp);
+extern void wfa_dut_init(BYTE **tBuf, BYTE **rBuf, BYTE **cBuf, struct timeval **timerp);
 
 int
 main(int argc, char **argv)
 {
-    int	      nfds, maxfdn1 = -1, nbytes = 0, cmdLen = 0, isExit = 1;
-    int       respLen, ret;
+    int	      nfds, maxfdn1 = -1, nbytes = 0, isExit = 1;
+    int       sock;            /* a newly accepted control link              */
     WORD      locPortNo = 0;   /* local control port number                  */
     fd_set    sockSet;         /* Set of socket descriptors for select()     */
-    BYTE      *xcCmdBuf=NULL, *parmsVal=NULL;
+    BYTE      *xcCmdBuf=NULL;
     struct timeval *toutvalp=NULL, *tovalp; /* Timeout for select()           */
-    WORD      xcCmdTag;
+    WORD      xcReqId;
+    wfaTlvView_t xcCmd;        /* the command, decoded in place              */
     struct sockfds fds;
+    static wfaCtrlRx_t xcRx;   /* control link reassembly buffer */
 
     tgThrData_t tdata[WFA_THREADS_NUM];
     int i = 0;
@@ -179,7 +177,7 @@ main(int argc, char **argv)
     }
 
     /* allocate the traffic stream table */
-    wfa_dut_init(&trafficBuf, &respBuf, &parmsVal, &xcCmdBuf, &toutvalp);
+    wfa_dut_init(&trafficBuf, &respBuf, &xcCmdBuf, &toutvalp);
 
     /* 4create listening TCP socket */
     gagtSockfd = wfaCreateTCPServSock(locPortNo);
@@ -212,19 +210,20 @@ main(int argc, char **argv)
     for(i = 0; i < WFA_MAX_TRAFFIC_STREAMS; i++)
         tgSockfds[i] = -1;
 
-#ifdef WFA_WMM_PS_EXT
-    /* WMMPS thread   */
-    ret = pthread_mutex_init(&wmmps_mutex_info.thr_flag_mutex,NULL);
-    if ( ret !=0)
+    /* command class workers for the control link */
+    if(wfaExecInit() != WFA_SUCCESS)
     {
-        DPRINT_INFO(WFA_OUT, "WMMPS pthread_mutex_init faile\n");
+        DPRINT_ERR(WFA_ERR, "Failed to start command executor\n");
+        exit(1);
     }
-    ret = pthread_cond_init(&wmmps_mutex_info.thr_flag_cond,NULL);
-    if (ret != 0)
+
+#ifdef WFA_WMM_PS_EXT
+    /* WMM-PS station event loop */
+    if(wfaWmmpsInit() != WFA_SUCCESS)
     {
-        DPRINT_INFO(WFA_OUT, "WMMPS pthread_cond_init faile\n");
+        DPRINT_ERR(WFA_ERR, "Failed to start WMM-PS event loop\n");
+        exit(1);
     }
-    wmmps_mutex_info.thr_id=pthread_create(&wmmps_mutex_info.thr,NULL /*&ptAttr*/,wfa_wmmps_thread,(void*)&wmmps_mutex_info.thr_id);// calls up the wmmps-thread
 #endif
 
     maxfdn1 = gagtSockfd + 1;
@@ -234,9 +233,6 @@ main(int argc, char **argv)
         fds.cafd = &gxcSockfd;
         fds.tgfd = &btSockfd;
         fds.wmmfds = tgSockfds;
-#ifdef WFA_WMM_PS_EXT
-        fds.psfd = &psSockfd;
-#endif
 
         wfaSetSockFiDesc(&sockSet, &maxfdn1, &fds);
 
@@ -283,59 +279,64 @@ main(int argc, char **argv)
 
         if (FD_ISSET(gagtSockfd, &sockSet))
         {
-            /* Incoming connection request */
-            gxcSockfd = wfaAcceptTCPConn(gagtSockfd);
-            if(gxcSockfd == -1)
+            /*
+             * Incoming connection request. A control agent that lost the
+             * link connects again, it replaces the old link and gets the
+             * stream results that could not be sent meanwhile.
+             */
+            sock = wfaAcceptTCPConn(gagtSockfd);
+            if(sock == -1)
             {
                 DPRINT_ERR(WFA_ERR, "Failed to open control link socket\n");
-                exit(1);
+            }
+            else
+            {
+                wfaCtrlRxReset(&xcRx);
+                wfaExecLinkUp(sock);
             }
         }
 
         /* Control Link port event*/
         if(gxcSockfd >= 0 && FD_ISSET(gxcSockfd, &sockSet))
         {
-            memset(xcCmdBuf, 0, WFA_BUFF_1K);  /* reset the buffer */
-            nbytes = wfaCtrlRecv(gxcSockfd, xcCmdBuf);
+            nbytes = wfaCtrlRecvFrames(gxcSockfd, &xcRx);
+            if(nbytes == 0)
+                nbytes = -1;        /* closed by the control agent */
 
-            if(nbytes <=0)
-            {
-                /* errors at the port, close it */
-                shutdown(gxcSockfd, SHUT_WR);
-                close(gxcSockfd);
-                gxcSockfd = -1;
-            }
-            else
+            /* several commands may arrive in one read, or one over several */
+            while(nbytes > 0)
             {
-                /* command received */
-                wfaDecodeTLV(xcCmdBuf, nbytes, &xcCmdTag, &cmdLen, parmsVal);
-                memset(respBuf, 0, WFA_RESP_BUF_SZ);
-                respLen = 0;
-
-                /* reset two commond storages used by control functions */
-                memset(gCmdStr, 0, WFA_CMD_STR_SZ);
-                memset(&gGenericResp, 0, sizeof(dutCmdResponse_t));
+                nbytes = wfaCtrlNextFrame(&xcRx, &xcReqId, xcCmdBuf, MAX_CMD_BUFF);
+                if(nbytes <= 0)
+                    break;
 
-                /* command process function defined in wfa_ca.c and wfa_tg.c */
-                if(xcCmdTag != 0 && gWfaCmdFuncTbl[xcCmdTag] != NULL)
+                /* command received, its parameters stay in xcCmdBuf */
+                if(wfaTlvView(xcCmdBuf, nbytes, &xcCmd) != WFA_SUCCESS || xcCmd.len > MAX_PARMS_BUFF)
                 {
-                    /* since the new commands are expanded to new block */
-                    gWfaCmdFuncTbl[xcCmdTag](cmdLen, parmsVal, &respLen, (BYTE *)respBuf);
-                }
-                else
-                {
-                    // no command defined
-                    gWfaCmdFuncTbl[0](cmdLen, parmsVal, &respLen, (BYTE *)respBuf);
+                    /*
+                     * the controller was told it runs, it gets an answer;
+                     * tag 0, a command's own response handler would read
+                     * the status as its result
+                     */
+                    int status = STATUS_INVALID;
+
+                    DPRINT_ERR(WFA_ERR, "request %u: malformed or oversized command rejected\n", xcReqId);
+                    wfaEncodeTLV(0, 4, (BYTE *)&status, (BYTE *)respBuf);
+                    wfaExecSendResp(0, xcReqId, (BYTE *)respBuf, WFA_TLV_HDR_LEN + 4);
+                    continue;
                 }
 
-               // gWfaCmdFuncTbl[xcCmdTag](cmdLen, parmsVal, &respLen, (BYTE *)respBuf);
-               if(gxcSockfd != -1)
-               {
-                 if((ret = wfaCtrlSend(gxcSockfd, (BYTE *)respBuf, respLen)) != respLen)
-                 {
-                      DPRINT_WARNING(WFA_WNG, "wfa-dut main:wfaCtrlSend returned value %d != respLen %d\n", ret, respLen);
-                 }
-               }
+                /*
+                 * command process function defined in wfa_cs.c and wfa_tg.c,
+                 * run inline or by the class worker, which sends the response
+                 */
+                wfaExecDispatch(xcReqId, xcCmd.tag, xcCmd.len, xcCmd.value, (BYTE *)respBuf);
+            }
+
+            if(nbytes < 0)
+            {
+                /* errors at the port or a broken frame, close it */
+                wfaExecLinkDown();
             }
 
         }
@@ -360,7 +361,6 @@ main(int argc, char **argv)
     wFREE(toutvalp);
     wFREE(respBuf);
     wFREE(xcCmdBuf);
-    wFREE(parmsVal);
 
     /* Close sockets */
     wCLOSE(gagtSockfd);
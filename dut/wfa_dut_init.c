@@ -51,7 +51,7 @@ void init_thr_flag()
 }
 
 
-void wfa_dut_init(BYTE **tBuf, BYTE **rBuf, BYTE **paBuf, BYTE **cBuf, struct timeval **timerp)
+void wfa_dut_init(BYTE **tBuf, BYTE **rBuf, BYTE **cBuf, struct timeval **timerp)
 {
     /* allocate the traffic stream table */
     gStreams = (tgStream_t *) malloc(WFA_MAX_TRAFFIC_STREAMS*sizeof(tgStream_t));
@@ -85,19 +85,11 @@ void wfa_dut_init(BYTE **tBuf, BYTE **rBuf, BYTE **paBuf, BYTE **cBuf, struct ti
         exit(1);
     }
 
-    /* control command buf */
-    *cBuf = malloc(WFA_BUFF_1K);
+    /* control command buf, the command parameters are used where they are */
+    *cBuf = malloc(MAX_CMD_BUFF);
     if(*cBuf == NULL)
     {
         DPRINT_ERR(WFA_ERR, "Failed to malloc control command buf\n");
         exit(1);
     }
-
-    /* parameters buff */
-    *paBuf = malloc(MAX_PARMS_BUFF);
-    if(*paBuf == NULL)
-    {
-        DPRINT_ERR(WFA_ERR, "Failed to malloc parms value buff\n");
-        exit(1);
-    }
 }
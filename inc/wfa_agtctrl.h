@@ -30,6 +30,35 @@ typedef struct type_name_str_table
 
 extern int buildCommandProcessTable(void);
 
+extern int wfaNameStrInit(void);
+extern typeNameStr_t *wfaNameStrLookup(char *name);
+
+/*
+ * A CAPI command split once into its parameter name and value pairs. The
+ * strings point into the command buffer, which is cut in place. Each name
+ * is looked up in a keyword table sorted by name and gets its type, -1 if
+ * the table does not have it.
+ */
+#define WFA_CAPI_MAX_PARMS      48
+
+typedef struct _wfa_capi_parm
+{
+    char *key;
+    char *val;                  /* "" when the command ends at the name */
+    int   type;
+} wfaCapiParm_t;
+
+typedef struct _wfa_capi_parms
+{
+    int num;
+    wfaCapiParm_t parm[WFA_CAPI_MAX_PARMS];
+} wfaCapiParms_t;
+
+extern int wfaCmdProcInit(void);
+extern int wfaCapiParse(char *pcmdStr, typeNameStr_t *kwTbl, int kwNum, wfaCapiParms_t *parms);
+extern int wfaCapiKeyword(typeNameStr_t *kwTbl, int kwNum, char *name);
+extern void wfaCapiStrCpy(char *dst, int dstSize, char *val);
+
 typedef int (*dutCommandRespFuncPtr)(BYTE *cmdBuf);
 
 #endif
@@ -29,6 +29,8 @@ int wfaStaGetIpConfigResp(BYTE *cmdBuf);
 int wfaGetVersionResp(BYTE *cmdBuf);
 int wfaStaGetInfoResp(BYTE *cmdBuf);
 int wfaTrafficAgentConfigResp(BYTE *cmdBuf);
+int wfaTrafficAgentConfigBatchResp(BYTE *cmdBuf);
+int wfaTrafficAgentReportResp(BYTE *cmdBuf);
 int wfaTrafficAgentSendResp(BYTE *cmdBuf);
 int wfaTrafficAgentRecvStartResp(BYTE *cmdBuf);
 int wfaTrafficAgentRecvStopResp(BYTE *cmdBuf);
@@ -111,4 +113,26 @@ int     wfaStaGetEventDataResp(BYTE * cmdBuf);
 int 	wfaStaExecActionResp(BYTE *cmdBuf);
 
 
+/*
+ * The reply to the test manager is built in gResp. It only grows, so a
+ * reply is formatted in place in one pass however many streams it lists.
+ * gResp points at the reply of the endpoint being served.
+ */
+#define WFA_RESP_INIT_SZ    WFA_BUFF_512
+
+typedef struct _wfa_resp_buf
+{
+    char *buf;
+    int len;            /* not counting the terminating nul */
+    int size;
+    int truncated;      /* an append did not fit and could not grow */
+} wfaRespBuf_t;
+
+extern wfaRespBuf_t *gResp;
+
+void wfaRespReset(void);
+int wfaRespAppend(const char *fmt, ...);
+int wfaRespPrintf(const char *fmt, ...);
+int wfaRespSend(int sock);
+
 #endif
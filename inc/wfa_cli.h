@@ -0,0 +1,38 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * wfa_cli.h:
+ *   the command line override list, read by the control agent to
+ *   forward a command and by the DUT to run it.
+ */
+#ifndef _WFA_CLI_H
+#define _WFA_CLI_H
+
+/* CAPI commands passed to the DUT command line, one "name-TRUE," per line */
+#define WFA_CLI_CMDS_FILE       "/etc/WfaEndpoint/wfa_cli.txt"
+#define WFA_CLI_CMDS_HASH_SZ    64      /* power of 2 */
+
+/* how long a command line has to print its status, seconds */
+#define WFA_ENV_CLI_TMOUT       "WFA_ENV_CLI_TMOUT"
+#define WFA_CLI_TMOUT_MS        20000
+
+extern int wfaCliCmdIsListed(char *name);
+extern int wfaCliCmdLookup(char *name, int *retFlag);
+
+#endif /* _WFA_CLI_H */
@@ -0,0 +1,58 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * wfa_events.h:
+ *   supplicant events kept for sta_get_events and sta_get_event_details.
+ *   The interface cache thread pushes them into a ring, the handlers
+ *   take them out without talking to the supplicant.
+ */
+#ifndef _WFA_EVENTS_H
+#define _WFA_EVENTS_H
+
+#define WFA_EV_RING_SZ         64           /* a power of 2 */
+#define WFA_EV_TEXT_SZ         WFA_BUFF_512
+#define WFA_EV_MAX_IFS         4
+
+/* the WFDS event types are eSearchResult .. ePortStatus of wfa_cmds.h */
+#define WFA_EV_OTHER           0            /* not reported, only counted */
+#define WFA_EV_NAN             (ePortStatus + 1)
+#define WFA_EV_NUM_TYPES       (WFA_EV_NAN + 1)
+
+typedef struct _wfa_ev
+{
+    int type;
+    char ifname[WFA_IF_NAME_LEN];
+    char text[WFA_EV_TEXT_SZ];       /* as sent, without the <level> */
+} wfaEv_t;
+
+typedef struct _wfa_ev_stats
+{
+    unsigned int pushed;
+    unsigned int dropped;            /* the ring was full */
+    unsigned int counts[WFA_EV_NUM_TYPES];
+} wfaEvStats_t;
+
+extern void wfaEvPush(char *ifname, char *text);
+extern int wfaEvList(char *ifname, char *names, int namesSz);
+extern int wfaEvLatest(char *ifname, int type, int take, char *text, int textSz);
+extern void wfaEvStatsGet(wfaEvStats_t *stats);
+extern int wfaEvField(char *text, char *key, char *val, int valSz);
+extern int wfaEvWord(char *text, int n, char *val, int valSz);
+
+#endif /* _WFA_EVENTS_H */
@@ -0,0 +1,87 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * wfa_exec.h:
+ *   definitions for the DUT control command executor.
+ */
+#ifndef _WFA_EXEC_H
+#define _WFA_EXEC_H
+
+#include <pthread.h>
+
+/*
+ * Command classes. Commands of the same class are executed in the order
+ * they are received; commands of different classes may overlap.
+ */
+#define WFA_EXEC_CLASS_INLINE  -1     /* run on the control loop thread */
+#define WFA_EXEC_CLASS_TG       0     /* traffic agent commands         */
+#define WFA_EXEC_CLASS_STA      1     /* station/device configuration   */
+#define WFA_EXEC_CLASS_NUM      2
+
+#define WFA_EXEC_QUEUE_DEPTH   16
+
+typedef struct _wfa_exec_job
+{
+    WORD reqId;        /* control link request id, echoed in the response */
+    WORD tag;
+    int  len;
+    BYTE parms[MAX_PARMS_BUFF];
+} wfaExecJob_t;
+
+typedef struct _wfa_exec_queue
+{
+    int             cls;
+    pthread_t       thr;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    wfaExecJob_t    jobs[WFA_EXEC_QUEUE_DEPTH];
+    int             head;
+    int             tail;
+    int             count;
+    int             busy;      /* a job has been taken but not finished */
+    BYTE            *respBuf;  /* per worker response buffer            */
+} wfaExecQueue_t;
+
+/*
+ * Stream results that found the control link down, kept until the control
+ * agent connects again. A later result of the same stream replaces the
+ * earlier one, the oldest goes when all are taken.
+ */
+#define WFA_EXEC_MAX_RESULTS   WFA_MAX_TRAFFIC_STREAMS
+
+typedef struct _wfa_exec_result
+{
+    int streamId;      /* 0 when the slot is free                */
+    unsigned int seq;  /* order the results were kept in        */
+    WORD reqId;        /* request it answers, for the CA's log   */
+    int  len;
+    BYTE buf[WFA_RESP_BUF_SZ];
+} wfaExecResult_t;
+
+/* request id of the command the calling thread is running */
+extern wTHREAD_LOCAL WORD gCtrlReqId;
+
+extern int wfaExecInit(void);
+extern int wfaExecClassify(WORD tag, int len, BYTE *parms);
+extern int wfaExecDispatch(WORD reqId, WORD tag, int len, BYTE *parms, BYTE *respBuf);
+extern int wfaExecSendResp(int streamId, WORD reqId, BYTE *buf, int len);
+extern void wfaExecLinkUp(int sock);
+extern void wfaExecLinkDown(void);
+
+#endif /* _WFA_EXEC_H */
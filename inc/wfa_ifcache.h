@@ -0,0 +1,52 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * wfa_ifcache.h:
+ *   the link, address and supplicant state of the DUT interfaces, kept
+ *   in memory and dropped when the kernel or the supplicant says it
+ *   changed.
+ */
+#ifndef _WFA_IFCACHE_H
+#define _WFA_IFCACHE_H
+
+#define WFA_IFC_MAX_IFS        8
+#define WFA_IFC_STATUS_SZ      WFA_BUFF_1K
+
+typedef struct _wfa_ifc_entry
+{
+    char ifname[WFA_IF_NAME_LEN];   /* empty when the slot is free      */
+    int ifindex;                    /* what the kernel events refer to  */
+    int macOk;
+    char mac[WFA_MAC_ADDR_STR_LEN];
+    int ipOk;
+    char ipaddr[WFA_IP_ADDR_STR_LEN];
+    char mask[WFA_IP_MASK_STR_LEN];
+    int isDynamic;
+    int wpaOk;
+    int wpaFd;                      /* event socket watched, -1 if none */
+    unsigned int wpaSeq;            /* attach the status was read under */
+    char status[WFA_IFC_STATUS_SZ]; /* the last STATUS reply            */
+} wfaIfcEntry_t;
+
+extern int wfaIfcGetMac(char *ifname, char *mac, int macSz);
+extern int wfaIfcGetIpv4(char *ifname, char *ipaddr, char *mask, int *isDynamic);
+extern int wfaIfcWpaStatus(char *ifname, char *key, char *val, int valSz);
+extern int wfaIfcWpaWatch(char *ifname);
+
+#endif /* _WFA_IFCACHE_H */
@@ -32,8 +32,9 @@
 #define WFA_THREADS_NUM   8
 #endif
 
-#define MAX_CMD_BUFF        1024
-#define MAX_PARMS_BUFF      640
+/* a command TLV and its parameters, up to a batch of traffic profiles */
+#define MAX_CMD_BUFF        (WFA_BUFF_4K + WFA_BUFF_64)
+#define MAX_PARMS_BUFF      WFA_BUFF_4K
 
 #define MAX_TRAFFIC_BUF_SZ  1536
 
@@ -0,0 +1,83 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * wfa_nl.h:
+ *   interface addresses, routes and name servers of the DUT, read and set
+ *   over rtnetlink and resolv.conf instead of ifconfig/route, and the
+ *   interface counters from rtnetlink and nl80211.
+ */
+#ifndef _WFA_NL_H
+#define _WFA_NL_H
+
+#define WFA_RESOLV_CONF        "/etc/resolv.conf"
+#define WFA_RESOLV_CONF_BK     "/tmp/resolv.conf.bk"
+
+#define WFA_NL_BUFF_SZ         8192
+#define WFA_NL_TMOUT_MS        1000     /* the kernel answers at once or never */
+#define WFA_NL_MON_RCVBUF      (256 * 1024)
+
+#define WFA_SYS_NET_DIR        "/sys/class/net"
+#define WFA_PROC_NET_WIRELESS  "/proc/net/wireless"
+
+/* where the wireless counters of wfaNlGetStats() came from */
+#define WFA_NL_WL_NONE         0
+#define WFA_NL_WL_NL80211      1        /* station info of the driver       */
+#define WFA_NL_WL_WEXT         2        /* wireless extensions, no retries  */
+
+/* counters of one interface, all of them running totals */
+typedef struct _wfa_nl_stats
+{
+    unsigned long long rxPackets;
+    unsigned long long txPackets;
+    unsigned long long rxBytes;
+    unsigned long long txBytes;
+    unsigned long long rxErrors;
+    unsigned long long txErrors;
+    unsigned long long rxDropped;       /* dropped by the stack or driver   */
+    unsigned long long txDropped;
+    unsigned long long rxMulticast;
+    unsigned long long rxCrcErrors;
+    unsigned long long rxFifoErrors;
+    unsigned long long rxMissed;        /* lost by the device               */
+    unsigned long long txFifoErrors;
+    unsigned long long qdiscDrops;      /* root qdisc overflows             */
+    unsigned long long qdiscRequeues;
+    unsigned long long txRetries;       /* wireless, summed over stations   */
+    unsigned long long txFailed;
+    unsigned long long beaconLoss;
+    unsigned long long rxDropMisc;
+} wfaNlStats_t;
+
+#define WFA_NL_STATS_NUM       (sizeof(wfaNlStats_t) / sizeof(unsigned long long))
+
+/* a change the kernel announced: RTM_NEWLINK, RTM_DELADDR, ... */
+typedef void (*wfaNlEvCb_t)(int type, int ifindex, void *arg);
+
+extern int wfaNlGetMac(char *ifname, char *mac, int macSz);
+extern int wfaNlGetIpv4(char *ifname, char *ipaddr, char *mask, int *isDynamic);
+extern int wfaNlSetIpv4(char *ifname, char *ipaddr, char *mask);
+extern int wfaNlSetDefaultGw(char *gwaddr);
+extern int wfaNlNeighReachable(struct in_addr *addr);
+extern int wfaNlGetStats(char *ifname, wfaNlStats_t *stats, int *wlSrc);
+extern int wfaNlMonitorOpen(void);
+extern int wfaNlMonitorRead(int fd, wfaNlEvCb_t cb, void *arg);
+extern int wfaResolvGet(char dns[][WFA_IP_ADDR_STR_LEN], int maxDns);
+extern int wfaResolvSet(char *priDns, char *secDns);
+
+#endif /* _WFA_NL_H */
@@ -0,0 +1,67 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * wfa_ping.h:
+ *   ICMP/ICMPv6 echo sessions run by the DUT itself, one timer and one
+ *   socket per session, all served by a single engine thread.
+ */
+#ifndef _WFA_PING_H
+#define _WFA_PING_H
+
+#define WFA_PING_MAX_SESSIONS     32
+#define WFA_PING_SEQ_RING         256      /* sends a reply can lag and still be timed */
+#define WFA_PING_MAX_PAYLOAD      4000
+#define WFA_PING_MIN_INTERVAL_NS  100000   /* 10000 pings per second at most */
+#define WFA_PING_MAX_BURST        4        /* sends to catch up after a stall */
+#define WFA_PING_PROBE_MS         100      /* between reachability probes */
+#define WFA_PING_PROBE_SIZE       56
+
+/* send time of one echo request, by sequence number */
+typedef struct _wfa_ping_sent
+{
+    unsigned short seq;
+    unsigned short pending;       /* no reply seen yet */
+    struct timespec at;
+} wfaPingSent_t;
+
+typedef struct _wfa_ping_sess
+{
+    int id;                       /* the stream id, 0 when the slot is free */
+    int fd;
+    int tfd;                      /* timerfd on the absolute send schedule   */
+    int family;
+    int raw;                      /* raw socket, replies of others seen too  */
+    unsigned short ident;
+    unsigned short seq;
+    struct sockaddr_storage dst;
+    socklen_t dstLen;
+    int payload;
+    unsigned int total;           /* requests to send in all */
+    unsigned int sent;
+    unsigned int replied;
+    tgLatHist_t rtt;
+    wfaPingSent_t ring[WFA_PING_SEQ_RING];
+} wfaPingSess_t;
+
+extern int wfaPingStart(int streamid, tgPingStart_t *staPing);
+extern int wfaPingStop(int streamid, tgPingStopResp_t *stpResp);
+extern void wfaPingStopAll(void);
+extern int wfaPingProbe(char *dipaddr, int timeoutMs, int udpOnly);
+
+#endif /* _WFA_PING_H */
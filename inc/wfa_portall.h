@@ -96,6 +96,9 @@
 #define wMEMCPY(dp, sp, size) \
                            memcpy(dp, sp, size)
 
+#define wMEMMOVE(dp, sp, size) \
+                           memmove(dp, sp, size)
+
 #define wMEMSET(memp, val, size)  \
                            memset(memp, val, size)
 
@@ -169,6 +172,12 @@
 #define wPT_CREATE(t, ptattr, func, pdata) \
                            pthread_create(t, ptattr, func, pdata)
 
+/* per-thread storage for the command scratch buffers */
+#define wTHREAD_LOCAL      __thread
+
+/* full compiler and cpu memory barrier */
+#define wMEMORY_BARRIER()  __sync_synchronize()
+
 
 typedef struct _memblock
 {
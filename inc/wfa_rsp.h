@@ -32,6 +32,12 @@ typedef struct _tg_ping_stop_resp
 {
     int sendCnt;
     int repliedCnt;
+    unsigned int rttMin;          /* round trip of the replies, usec */
+    unsigned int rttAvg;
+    unsigned int rttP50;
+    unsigned int rttP95;
+    unsigned int rttP99;
+    unsigned int rttMax;
 } tgPingStopResp_t;
 
 typedef struct ca_sta_get_ipconfig_resp
@@ -53,6 +59,29 @@ typedef struct ca_sta_get_stats_resp
     int rxMulticast;
     int fcsErrors ;
     int txRetries;
+
+    /* the same and more at full width, all since the previous call */
+    unsigned int intervalMs;      /* 0 on the first call of an interface */
+    char wireless[16];            /* source of the wireless counters */
+    unsigned long long txPackets;
+    unsigned long long rxPackets;
+    unsigned long long txBytes;
+    unsigned long long rxBytes;
+    unsigned long long txErrors;
+    unsigned long long rxErrors;
+    unsigned long long txDropped;
+    unsigned long long rxDropped;
+    unsigned long long rxMulticast64;
+    unsigned long long rxCrcErrors;
+    unsigned long long rxFifoErrors;
+    unsigned long long rxMissed;
+    unsigned long long txFifoErrors;
+    unsigned long long qdiscDrops;
+    unsigned long long qdiscRequeues;
+    unsigned long long txRetries64;
+    unsigned long long txFailed;
+    unsigned long long beaconLoss;
+    unsigned long long rxDropMisc;
 } caStaGetStatsResp_t;
 
 typedef struct ca_device_get_info_resp
@@ -251,6 +280,7 @@ typedef struct ca_sta_GetEventDetails_cmd_resp
 
 typedef struct ca_sta_GetEvents_cmd_resp
 {
+	int program;        /* first, as in caStaGetEventsResp_t */
 	char result[512];
 } caStaGetEventListCmdResp_t;
 
@@ -286,6 +316,7 @@ typedef struct ca_sta_exec_action_resp
 
 typedef struct ca_sta_get_events_resp
 {
+	int program;        /* PROG_TYPE_NAN */
 	char eventName[64];
 	unsigned int remoteInstanceID;
 	unsigned int localInstanceID;
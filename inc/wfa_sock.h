@@ -40,18 +40,61 @@
 #define MAX_UDP_LEN       1470
 #define MAX_RCV_BUF_LEN   (32*1024)
 
+/*
+ * Control link framing between the control agent and the DUT agent.
+ * Each TLV is preceded by a header giving its length and a request id,
+ * both in network byte order. The DUT answers a command with the id it
+ * came with, so several commands can be in flight on one connection and
+ * be answered out of order. The receiver reassembles frames from the
+ * byte stream and is no longer bound to one TLV per recv().
+ */
+typedef struct _wfa_ctrl_hdr
+{
+    unsigned short reqId;
+    unsigned short flags;          /* reserved, 0 */
+    unsigned int   len;            /* TLV bytes that follow the header */
+} wfaCtrlHdr_t;
+
+#define WFA_CTRL_HDR_LEN          8
+#define WFA_CTRL_MAX_TLV          (4*4096)
+#define WFA_CTRL_RX_BUF_SZ        (WFA_CTRL_HDR_LEN + WFA_CTRL_MAX_TLV)
+
+/* control link liveness, see wfaCtrlSockTune() */
+#define WFA_CTRL_KEEPIDLE         10       /* sec idle before the first probe     */
+#define WFA_CTRL_KEEPINTVL        3        /* sec between probes                  */
+#define WFA_CTRL_KEEPCNT          3        /* probes unanswered before giving up  */
+#define WFA_CTRL_USER_TMOUT       30000    /* msec data may stay unacknowledged   */
+
+/* a CAPI command line from the test manager, a config batch is the longest */
+#define WFA_CAPI_CMD_SZ           (4*4096)
+
+/* reassembly buffer, one per control connection */
+typedef struct _wfa_ctrl_rx
+{
+    int head;                      /* start of the first unparsed frame */
+    int tail;                      /* end of the received bytes         */
+    unsigned char buf[WFA_CTRL_RX_BUF_SZ];
+} wfaCtrlRx_t;
+
+/* a CAPI command line that may come in several segments, one per test manager */
+typedef struct _wfa_ctrl_line
+{
+    int len;                       /* bytes received, not yet taken     */
+    unsigned char buf[WFA_CAPI_CMD_SZ];
+} wfaCtrlLine_t;
+
 struct sockfds
 {
     int *agtfd;      /* dut agent main socket fd */
     int *cafd;       /* sock fd to control agent */
     int *tgfd;       /* traffic agent fd         */
     int *wmmfds;     /* wmm stream ids           */
-    int *psfd;       /* wmm-ps socket id         */
 };
 
 extern int wfaCreateTCPServSock(unsigned short sport);
 extern int wfaCreateUDPSock(char *sipaddr, unsigned short sport);
 extern int wfaAcceptTCPConn(int servSock);
+extern int wfaCtrlSockTune(int sock);
 extern int wfaConnectUDPPeer(int sock, char *dipaddr, int dport);
 extern void wfaSetSockFiDesc(fd_set *sockset, int *, struct sockfds *);
 #ifdef _WINDOWS
@@ -59,7 +102,13 @@ extern int wfaCtrlSend(SOCKET sock, unsigned char *buf, int bufLen);
 #else
 extern int wfaCtrlSend(int sock, unsigned char *buf, int bufLen);
 #endif
-extern int wfaCtrlRecv(int sock, unsigned char *buf);
+extern void wfaCtrlLineReset(wfaCtrlLine_t *ln);
+extern int wfaCtrlRecvLine(int sock, wfaCtrlLine_t *ln);
+extern int wfaCtrlNextLine(wfaCtrlLine_t *ln, unsigned char *buf);
+extern int wfaCtrlSendFrame(int sock, unsigned short reqId, unsigned char *buf, int bufLen);
+extern void wfaCtrlRxReset(wfaCtrlRx_t *rx);
+extern int wfaCtrlRecvFrames(int sock, wfaCtrlRx_t *rx);
+extern int wfaCtrlNextFrame(wfaCtrlRx_t *rx, unsigned short *reqId, unsigned char *buf, int bufSize);
 extern int wfaTrafficSendTo(int sock, char *buf, int bufLen, struct sockaddr *to);
 extern int wfaTrafficRecv(int sock, char *buf, struct sockaddr *from);
 extern int wfaGetifAddr(char *ifname, struct sockaddr_in *sa);
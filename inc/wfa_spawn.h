@@ -0,0 +1,62 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * wfa_spawn.h:
+ *   external helper commands run without a shell, their output kept in
+ *   memory and their run time bounded.
+ */
+#ifndef _WFA_SPAWN_H
+#define _WFA_SPAWN_H
+
+#include <sys/types.h>
+#include <time.h>
+
+#define WFA_RUN_TMOUT_MS       10000    /* a helper running longer is killed */
+#define WFA_RUN_MAX_ARGS       32
+#define WFA_RUN_MAX_PROCS      16       /* helpers waited for at once */
+#define WFA_RUN_ERR_SZ         256
+#define WFA_RUN_TICK_MS        20       /* exit check without a pidfd */
+
+/* status of a helper that did not exit on its own */
+#define WFA_RUN_FAILED         -1       /* could not be started */
+#define WFA_RUN_KILLED         -2       /* ran over its timeout */
+
+typedef struct _wfa_proc
+{
+    pid_t pid;                      /* 0 once reaped                     */
+    int pidFd;                      /* readable at exit, -1 if no pidfd  */
+    int outFd;                      /* read ends, -1 at EOF              */
+    int errFd;
+    char *out;                      /* stdout, NULL if not wanted        */
+    int outSz;
+    int outLen;
+    char err[WFA_RUN_ERR_SZ];       /* start of stderr, for the log      */
+    int errLen;
+    int status;                     /* exit code or WFA_RUN_xxx          */
+    char name[WFA_BUFF_32];         /* argv[0]                           */
+} wfaProc_t;
+
+extern int wfaSpawn(wfaProc_t *proc, char *out, int outSz, const char *fmt, ...);
+extern int wfaSpawnWait(wfaProc_t *procs, int num, int tmoutMs);
+extern int wfaRun(char *out, int outSz, int tmoutMs, const char *fmt, ...);
+extern void wfaSpawnDeadline(struct timespec *deadline, int tmoutMs);
+extern int wfaSpawnReadLine(wfaProc_t *proc, char *line, int lineSz, struct timespec *deadline);
+extern void wfaSpawnRelease(wfaProc_t *proc, int stop);
+
+#endif /* _WFA_SPAWN_H */
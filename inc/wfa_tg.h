@@ -60,6 +60,7 @@
 #define KW_USERPRIORITY            17
 #define KW_MAXCNT                  18
 #define KW_TAGNAME                 19
+#define KW_WINDOW                  20
 
 /* Profile Types */
 #define PROF_FILE_TX               1
@@ -78,6 +79,10 @@
 /* Traffic Directions */
 #define DIRECT_SEND                1
 #define DIRECT_RECV                2
+#define DIRECT_BIDIR               3      /* send and receive on one socket */
+
+/* a bidirectional stream keeps receiving this long after its last send */
+#define WFA_BIDIR_DRAIN_MS         500
 
 #define TG_PROTO_TCP               0
 #define TG_PROTO_UDP               1
@@ -135,8 +140,65 @@ typedef struct _tg_stats
     unsigned int outOfSequenceFrames;
     unsigned int lostPkts;        /* voice over wi-fi */
     unsigned long jitter;         /* voice over wi-fi */
+    unsigned int rttMin;          /* transaction round trip, usec; frame latency for bidirectional */
+    unsigned int rttAvg;
+    unsigned int rttP50;
+    unsigned int rttP95;
+    unsigned int rttP99;
+    unsigned int rttMax;
+    unsigned int transPerSec;     /* completed transactions per second */
+    unsigned int transTimeouts;   /* requests without a reply in time  */
+    unsigned int txKbps;          /* bidirectional, per direction throughput */
+    unsigned int rxKbps;
 } tgStats_t;
 
+/*
+ * latency histogram in microseconds, log-linear buckets: 8 linear
+ * sub-buckets for each power of two, about 12% resolution up to 16 sec
+ */
+#define WFA_LAT_SUB_BITS           3
+#define WFA_LAT_SUB_BUCKETS        (1 << WFA_LAT_SUB_BITS)
+#define WFA_LAT_MAX_EXP            24
+#define WFA_LAT_BUCKETS            ((WFA_LAT_MAX_EXP - WFA_LAT_SUB_BITS + 1) * WFA_LAT_SUB_BUCKETS)
+
+typedef struct _tg_lat_hist
+{
+    unsigned int count;
+    unsigned int minUs;
+    unsigned int maxUs;
+    unsigned long long sumUs;
+    unsigned int bucket[WFA_LAT_BUCKETS];
+} tgLatHist_t;
+
+/*
+ * windowed transaction mode: up to "window" requests in flight, matched
+ * to replies by request number and timed out one by one from a wheel of
+ * one millisecond ticks
+ */
+#define WFA_TRANSC_MAX_WINDOW      64
+#define WFA_TRANSC_WHEEL_SLOTS     256
+#define WFA_TRANSC_REQ_TMOUT       50       /* msec, less than the wheel */
+
+typedef struct _tg_transc_req
+{
+    unsigned int sn;              /* 0 when the slot is free        */
+    unsigned int expTick;         /* wheel tick the request expires  */
+    struct timeval sendTime;
+    int next;                     /* wheel bucket chain, -1 ends     */
+    int prev;
+} tgTranscReq_t;
+
+/* transaction (request/response) state of one stream */
+typedef struct _tg_transc
+{
+    int running;                  /* the stream's transaction loop is on  */
+    unsigned int reqSN;           /* last request sequence number sent    */
+    unsigned int sentPkts;
+    unsigned int lateReplies;     /* replies to requests already timed out */
+    unsigned int timeouts;        /* requests given up without a reply     */
+    tgLatHist_t rtt;
+} tgTransc_t;
+
 typedef struct _e2e_stats
 {
     int seqnum;
@@ -161,8 +223,61 @@ typedef struct _tg_profile
     int  startdelay;
     int  maxcnt;
     char WmmpsTagName[10];//Aaron's//Store the test case name
+    int  window;             /* transaction requests in flight, 0/1 stop-and-wait */
 } tgProfile_t;
 
+/*
+ * traffic_agent_config_batch: the command carries an array of profiles,
+ * the response the stream ids given to them, in the same order
+ */
+#define WFA_TG_MAX_BATCH           32
+
+typedef struct _tg_config_batch_resp
+{
+    int status;
+    int numStreams;
+    int streamIds[WFA_TG_MAX_BATCH];
+} tgConfigBatchResp_t;
+
+/*
+ * The interval reports copy the stats and the latency histogram of running
+ * streams. The thread that owns a stream never waits for them: it makes
+ * the sequence odd around its updates and a reader copies again until it
+ * sees the same even sequence before and after.
+ */
+#define WFA_STATS_BEGIN(s)         do { (s)->statsSeq++; wMEMORY_BARRIER(); } while(0)
+#define WFA_STATS_END(s)           do { wMEMORY_BARRIER(); (s)->statsSeq++; } while(0)
+
+/* traffic_agent_status: report every periodMs, 0 stops the reports */
+#define WFA_TG_MAX_REPORT          32
+#define WFA_TG_REPORT_MIN_MS       100
+
+typedef struct _tg_status_req
+{
+    int periodMs;
+} tgStatusReq_t;
+
+/* one stream over one report interval */
+typedef struct _tg_interval_stats
+{
+    int streamId;
+    unsigned int txFrames;
+    unsigned int rxFrames;
+    unsigned int txBytes;
+    unsigned int rxBytes;
+    unsigned int lostPkts;
+    unsigned int jitter;         /* usec, running estimate of the receive side */
+    unsigned int latP50;         /* usec, frames of the interval only */
+    unsigned int latP99;
+} tgIntervalStats_t;
+
+typedef struct _tg_report
+{
+    int intervalMs;              /* time the report covers */
+    int numStreams;
+    tgIntervalStats_t streams[WFA_TG_MAX_REPORT];
+} tgReport_t;
+
 typedef struct _tg_stream
 {
     int id;
@@ -172,8 +287,12 @@ typedef struct _tg_stream
     int fmInterval;
     int rxTimeLast;       /* use for pkLost             */
     int state;            /* indicate if the stream being active */
+    WORD ctrlReqId;       /* control request that started it, for late responses */
+    volatile unsigned int statsSeq; /* odd while stats are updated, see WFA_STATS_BEGIN */
+    long long lastTransitUs;        /* one way transit of the last frame, for jitter */
     tgProfile_t profile;
     tgStats_t stats;
+    tgTransc_t transc;
 } tgStream_t;
 
 typedef struct _traffic_header
@@ -181,6 +300,15 @@ typedef struct _traffic_header
     char hdr[20];   /* always wfa */
 } tgHeader_t;
 
+/*
+ * header fields, all big endian. The transaction request number is
+ * echoed back untouched by the responder and matches replies to requests.
+ */
+#define TG_HDR_TRANSC_SN           4
+#define TG_HDR_SN                  8
+#define TG_HDR_TV_SEC              12
+#define TG_HDR_TV_USEC             16
+
 typedef struct _tg_wmm
 {
     int thr_flag;    /* this is used to indicate stream id */
@@ -225,6 +353,8 @@ typedef struct _tg_thr_data
 } tgThrData_t;
 
 extern int wfaTGConfig(int len, BYTE *buf, int *respLen, BYTE *respBuf);
+extern int wfaTGConfigBatch(int len, BYTE *buf, int *respLen, BYTE *respBuf);
+extern int wfaTGStatus(int len, BYTE *parms, int *respLen, BYTE *respBuf);
 extern int wfaSendLongFile(int fromSockfd, int streamId, BYTE *respBuf, int *respLen);
 extern int wfaRecvFile(int mySockfi, int profId, char *buf);
 extern int wfaTGRecvStart(int len, BYTE *parms, int *respLen, BYTE *respBuf);
@@ -241,4 +371,14 @@ tgStream_t *findStreamProfile(int streamId);
 tgProfile_t *findTGProfile(int streamId);
 int convertDscpToTos(int dscp); // return >=0 as TOS, otherwise error.
 
+extern void wfaLatHistReset(tgLatHist_t *hist);
+extern void wfaLatHistAdd(tgLatHist_t *hist, unsigned int usec);
+extern unsigned int wfaLatHistPercentile(tgLatHist_t *hist, int pct);
+extern void wfaLatHistSummary(tgLatHist_t *hist, tgStats_t *stats);
+extern int wfaTGStatsSnapshot(tgStream_t *myStream, tgStats_t *stats, tgLatHist_t *rtt);
+extern int wfaTranscRecvReply(int mySockfd, tgStream_t *myStream, char *recvBuf);
+extern int wfaTranscWindowRun(int mySockfd, tgStream_t *myStream);
+extern int wfaBidirRun(int mySockfd, tgStream_t *myStream);
+extern void wfaTranscStopAll(void);
+
 #endif
@@ -44,6 +44,14 @@ typedef struct _wfatlvHdr
 
 #define WFA_TLV_HDR_LEN sizeof(wfaTLV)
 
+/* a TLV decoded in place, value points into the buffer it came in */
+typedef struct _wfatlvView
+{
+    WORD tag;
+    WORD len;
+    BYTE *value;
+} wfaTlvView_t;
+
 enum cmd_tags
 {
     /* Commands */
@@ -150,6 +158,7 @@ enum cmd_tags
 	
    WFA_STA_SET_EAPAKAPRIME_TLV,           /* 80 */
    WFA_STA_SET_EAPPWD_TLV,                /* 81 */
+   WFA_TRAFFIC_AGENT_CONFIG_BATCH_TLV,    /* 87 */
    WFA_STA_COMMANDS_END,                  /* 82 */
   
    WFA_STA_EXEC_ACTION_TLV,			/* 86 */
@@ -259,6 +268,8 @@ enum resp_tags
 	WFA_STA_GET_EVENT_DETAILS_RESP_TLV,		/* 84 */
     WFA_STA_SET_EAPAKAPRIME_RESP_TLV,              /* 80 */
     WFA_STA_SET_EAPPWD_RESP_TLV,                   /* 81 */
+    WFA_TRAFFIC_AGENT_CONFIG_BATCH_RESP_TLV,       /* 87 */
+    WFA_TRAFFIC_AGENT_REPORT_RESP_TLV,             /* 88, interval stats, unrequested */
     WFA_STA_RESPONSE_END,                        /* 82 */
 	WFA_STA_EXEC_ACTION_RESP_TLV,					/* 86 */
 	WFA_STA_SCAN_RESP_TLV, 					/* 87 */
@@ -275,6 +286,8 @@ extern BOOL wfaIsValidTag(BYTE the_tag);
 extern void wfaAliasByTag(BYTE the_tag, char *aliasStr);
 extern BOOL wfaDecodeTLV(BYTE *tlv_data, int tlv_len, WORD *ptlv_tag, int *ptlv_val_len, BYTE *ptlv_value);
 extern BOOL wfaEncodeTLV(WORD the_tag, WORD the_len, BYTE *the_value, BYTE *tlv_data);
+extern int wfaTlvView(BYTE *tlv_data, int tlv_len, wfaTlvView_t *view);
+extern int wfaEncodeResp(WORD the_tag, void *the_resp, int the_size, BYTE *tlv_data);
 
 extern WORD wfaGetValueType(BYTE the_tag, BYTE *tlv_data);
 
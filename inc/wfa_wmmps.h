@@ -177,6 +177,7 @@ typedef struct wfa_wmmps
     int dscp;
     int resetWMMPS;
     int streamid;
+    int stop_recvd;     /* console STOP seen, finish after our own STOP */
     tgThrData_t *tdata;
     struct sockaddr_in psToAddr;
     pthread_t thr;
@@ -185,6 +186,33 @@ typedef struct wfa_wmmps
 
 } wfaWmmPS_t;
 
+/*
+ * The WMM-PS station runs as one event loop: the console socket, an
+ * absolute deadline timer for the send states and a wakeup for start/stop
+ * requests from the traffic generator are all multiplexed on one epoll set.
+ */
+#define WFA_WMMPS_REQ_NONE            0
+#define WFA_WMMPS_REQ_START           1
+#define WFA_WMMPS_REQ_STOP            2
+
+#define WFA_WMMPS_HELLO_PERIOD        1000000     /* usec between hellos */
+#define WFA_WMMPS_STOP_WAIT           3           /* sec to wait for a stop */
+
+typedef struct wfa_wmmps_engine
+{
+    int epfd;
+    int kickfd;                 /* eventfd, start/stop requests */
+    int tmrfd;                  /* timerfd, CLOCK_MONOTONIC absolute */
+    int running;
+    struct timespec deadline;   /* when the current send state fires */
+    int req;
+    int reqStreamId;
+    struct sockaddr_in reqToAddr;
+    pthread_t thr;
+    pthread_mutex_t mutex;
+    pthread_cond_t idleCond;
+} wfaWmmpsEngine_t;
+
 
 
 int WfaStaSndHello(char,int,int *state);
@@ -208,3 +236,8 @@ int WfaRcvVI(unsigned int *,int ,int *);
 int WfaRcvBE(unsigned int *,int ,int *);
 int WfaRcvBK(unsigned int *,int ,int *);
 int WfaRcvNotCare(unsigned int *,int ,int *);
+
+int wfaWmmpsInit(void);
+int wfaWmmpsStart(int streamid, struct sockaddr_in *toAddr);
+void wfaWmmpsStop(void);
+void wfaWmmpsFinish(void);
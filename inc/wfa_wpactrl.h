@@ -0,0 +1,85 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * wfa_wpactrl.h:
+ *   client of the wpa_supplicant control interface, one UNIX datagram
+ *   socket per wireless interface kept open between commands. The
+ *   network settings of a command can be sent as one transaction.
+ */
+#ifndef _WFA_WPACTRL_H
+#define _WFA_WPACTRL_H
+
+/* where the supplicant puts its per interface sockets, or from the env */
+#define WFA_WPA_CTRL_DIR          "/var/run/wpa_supplicant"
+#define WFA_ENV_WPA_CTRL_DIR      "WFA_ENV_WPA_CTRL_DIR"
+
+/* where the client sockets are bound so the supplicant can answer */
+#define WFA_WPA_CLIENT_DIR        "/tmp"
+
+#define WFA_WPA_MAX_IFS           4
+#define WFA_WPA_REPLY_SZ          4096
+#define WFA_WPA_TMOUT_MS          3000     /* a request not answered in time fails */
+
+#define WFA_WPA_TXN_MAX           24       /* requests in one transaction */
+#define WFA_WPA_TXN_BUF_SZ        4096
+#define WFA_WPA_TXN_WINDOW        8        /* in flight, below the socket queue */
+
+typedef struct _wfa_wpa_conn
+{
+    char ifname[WFA_IF_NAME_LEN];  /* empty when the slot is free       */
+    int  reqFd;                    /* requests and their replies        */
+    int  evFd;                     /* attached for events, -1 if not    */
+    unsigned int evSeq;            /* counts the attaches               */
+    char reqPath[WFA_BUFF_128];    /* local addresses, removed on close */
+    char evPath[WFA_BUFF_128];
+} wfaWpaConn_t;
+
+typedef struct _wfa_wpa_txn_req
+{
+    short off;                     /* the request in buf                */
+    short len;
+    char var[WFA_BUFF_32];         /* network variable set, "" if none  */
+} wfaWpaTxnReq_t;
+
+/* requests collected by a command, sent together by wfaWpaTxnCommit() */
+typedef struct _wfa_wpa_txn
+{
+    char ifname[WFA_IF_NAME_LEN];
+    int netId;
+    int num;
+    int used;                      /* of buf                            */
+    int overflow;                  /* a request did not fit             */
+    wfaWpaTxnReq_t reqs[WFA_WPA_TXN_MAX];
+    char buf[WFA_WPA_TXN_BUF_SZ];
+} wfaWpaTxn_t;
+
+extern int wfaWpaRequest(char *ifname, char *reply, int replySz, const char *fmt, ...);
+extern int wfaWpaCmd(char *ifname, const char *fmt, ...);
+extern int wfaWpaSetNetwork(char *ifname, int netId, char *var, const char *fmt, ...);
+extern int wfaWpaStatusGet(char *ifname, char *key, char *val, int valSz);
+extern int wfaWpaStatusField(char *status, char *key, char *val, int valSz);
+extern int wfaWpaEventFd(char *ifname, int attach, unsigned int *evSeq);
+extern int wfaWpaEventRecv(char *ifname, char *buf, int bufSz, int tmoutMs);
+extern void wfaWpaClose(char *ifname);
+extern void wfaWpaTxnBegin(wfaWpaTxn_t *txn, char *ifname, int netId);
+extern int wfaWpaTxnSet(wfaWpaTxn_t *txn, char *var, const char *fmt, ...);
+extern int wfaWpaTxnCmd(wfaWpaTxn_t *txn, const char *fmt, ...);
+extern int wfaWpaTxnCommit(wfaWpaTxn_t *txn);
+
+#endif /* _WFA_WPACTRL_H */
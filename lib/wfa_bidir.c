@@ -0,0 +1,233 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_bidir.c - full duplex traffic for a "bidirectional" stream.
+ *       One worker sends to the destination of the profile at its frame
+ *       rate and receives the peer's frames on the same socket, which is
+ *       bound to the source address and port of the profile, so both
+ *       directions share one 5-tuple. The socket is non-blocking and the
+ *       loop polls it between paced sends. The tx and rx counters of the
+ *       stream stats are the two directions.
+ */
+#include <sys/time.h>
+#include <time.h>
+#include <poll.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_tg.h"
+#include "wfa_sock.h"
+#include "wfa_miscs.h"
+
+extern unsigned short wfa_defined_debug;
+extern void int2BuffBigEndian(int val, char *buf);
+extern int bigEndianBuff2Int(char *buff);
+
+/* frames sent back to back per pass when the rate is unlimited */
+#define WFA_BIDIR_BURST          8
+
+/* monotonic time in microseconds */
+static unsigned long long wfaBidirNowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * account one received frame: sequence gaps are losses, a frame older
+ * than the last one fills an earlier gap, and the header timestamp gives
+ * its latency (the round trip if the peer reflects our frames)
+ */
+static void wfaBidirRecvFrame(tgStream_t *myStream, char *recvBuf, int prevSN)
+{
+    tgStats_t *stats = &myStream->stats;
+    struct timeval sent, now;
+    int sn = bigEndianBuff2Int(&((tgHeader_t *)recvBuf)->hdr[TG_HDR_SN]);
+    long long latUs;
+
+    WFA_STATS_BEGIN(myStream);
+    if(sn <= prevSN)
+    {
+        /* undo the gap wfaRecvFile() counted for this frame */
+        stats->lostPkts -= (sn - 1 - prevSN);
+        if(sn < prevSN && stats->lostPkts > 0)
+            stats->lostPkts--;
+        stats->outOfSequenceFrames++;
+        myStream->lastPktSN = prevSN;
+    }
+
+    sent.tv_sec = bigEndianBuff2Int(&((tgHeader_t *)recvBuf)->hdr[TG_HDR_TV_SEC]);
+    sent.tv_usec = bigEndianBuff2Int(&((tgHeader_t *)recvBuf)->hdr[TG_HDR_TV_USEC]);
+    if(sent.tv_sec != 0)
+    {
+        wGETTIMEOFDAY(&now, NULL);
+        latUs = (long long)(now.tv_sec - sent.tv_sec) * 1000000 + now.tv_usec - sent.tv_usec;
+
+        /* unsynchronized peer clocks can put the timestamp in the future */
+        if(latUs >= 0)
+            wfaLatHistAdd(&myStream->transc.rtt, (unsigned int)latUs);
+    }
+    WFA_STATS_END(myStream);
+}
+
+/*
+ * wfaBidirRun(): run both directions of a stream until the send side is
+ *                done and the receive side has drained, or until the
+ *                stream is stopped.
+ * input:   mySockfd -- non-blocking UDP socket bound to the stream source
+ * return:  frames received
+ */
+int wfaBidirRun(int mySockfd, tgStream_t *myStream)
+{
+    tgProfile_t *theProf = &myStream->profile;
+    tgStats_t *stats = &myStream->stats;
+    struct sockaddr_in toAddr;
+    struct pollfd pfd;
+    struct timeval tv;
+    char sendBuf[MAX_UDP_LEN+1];
+    char recvBuf[MAX_RCV_BUF_LEN+1];
+    unsigned long long startUs, nowUs, nextSendUs, intervalUs = 0;
+    unsigned long long sendEndUs = 0, drainEndUs = 0, txElapsedUs = 0, lastRxUs = 0;
+    unsigned int counter = 0, rcvd = 0;
+    int sending = 1, burst, nbytes, bytesSent, packLen, prevSN;
+
+    if(theProf->rate != 0)
+        intervalUs = 1000000 / theProf->rate;
+
+    /* like the send only profiles, an unlimited rate sends full frames */
+    packLen = (theProf->rate == 0) ? MAX_UDP_LEN : theProf->pksize;
+    if(packLen < sizeof(tgHeader_t))
+        packLen = sizeof(tgHeader_t);
+    if(packLen > MAX_UDP_LEN)
+        packLen = MAX_UDP_LEN;
+
+    wMEMSET(sendBuf, 0, sizeof(sendBuf));
+    wSTRNCPY(sendBuf, "1345678", sizeof(tgHeader_t));
+
+    wMEMSET(&toAddr, 0, sizeof(toAddr));
+    toAddr.sin_family = AF_INET;
+    toAddr.sin_addr.s_addr = inet_addr(theProf->dipaddr);
+    toAddr.sin_port = htons(theProf->dport);
+
+    pfd.fd = mySockfd;
+    pfd.events = POLLIN;
+
+    myStream->lastPktSN = 0;
+    myStream->transc.running = 1;
+
+    startUs = nextSendUs = wfaBidirNowUs();
+    if(theProf->maxcnt == 0)
+        sendEndUs = startUs + (unsigned long long)theProf->duration * 1000000;
+
+    DPRINT_INFO(WFA_OUT, "stream %d bidirectional, %d frames/sec of %d bytes\n", myStream->id, theProf->rate, packLen);
+
+    while(myStream->transc.running)
+    {
+        nowUs = wfaBidirNowUs();
+
+        if(sending)
+        {
+            if((theProf->maxcnt > 0 && counter >= theProf->maxcnt) ||
+                    (theProf->maxcnt == 0 && nowUs >= sendEndUs))
+            {
+                /* send side done, give the peer's last frames time to land */
+                sending = 0;
+                txElapsedUs = nowUs - startUs;
+                drainEndUs = nowUs + WFA_BIDIR_DRAIN_MS * 1000;
+            }
+        }
+        else if(nowUs >= drainEndUs)
+        {
+            break;
+        }
+
+        burst = 0;
+        while(sending && burst < WFA_BIDIR_BURST &&
+                (theProf->maxcnt == 0 || counter < theProf->maxcnt) &&
+                (intervalUs == 0 || nowUs >= nextSendUs))
+        {
+            wGETTIMEOFDAY(&tv, NULL);
+            int2BuffBigEndian(counter + 1, &((tgHeader_t *)sendBuf)->hdr[TG_HDR_SN]);
+            int2BuffBigEndian(tv.tv_sec, &((tgHeader_t *)sendBuf)->hdr[TG_HDR_TV_SEC]);
+            int2BuffBigEndian(tv.tv_usec, &((tgHeader_t *)sendBuf)->hdr[TG_HDR_TV_USEC]);
+
+            bytesSent = wfaTrafficSendTo(mySockfd, sendBuf, packLen, (struct sockaddr *)&toAddr);
+            if(bytesSent == -1)
+            {
+                /* socket queue full, try again on the next pass */
+                break;
+            }
+
+            counter++;
+            WFA_STATS_BEGIN(myStream);
+            stats->txFrames++;
+            stats->txPayloadBytes += bytesSent;
+            WFA_STATS_END(myStream);
+            burst++;
+
+            if(intervalUs != 0)
+            {
+                /* catch up on the poll granularity only, never burst */
+                if(nowUs > nextSendUs + intervalUs + 1000)
+                    nextSendUs = nowUs;
+                nextSendUs += intervalUs;
+            }
+        }
+
+        /* unpaced sending only peeks, paced sending sleeps up to a tick */
+        if(poll(&pfd, 1, (sending && intervalUs == 0) ? 0 : 1) > 0 && (pfd.revents & POLLIN))
+        {
+            for(;;)
+            {
+                prevSN = myStream->lastPktSN;
+                nbytes = wfaRecvFile(mySockfd, myStream->id, recvBuf);
+                if(nbytes <= 0)
+                    break;
+
+                wfaBidirRecvFrame(myStream, recvBuf, prevSN);
+                rcvd++;
+            }
+            lastRxUs = wfaBidirNowUs();
+        }
+    }
+
+    nowUs = wfaBidirNowUs();
+    if(sending)
+        txElapsedUs = nowUs - startUs;
+    myStream->transc.running = 0;
+
+    /* the receive rate covers the time up to the last frame, not the idle drain */
+    if(txElapsedUs > 0)
+        stats->txKbps = (unsigned int)(stats->txPayloadBytes * 8000 / txElapsedUs);
+    if(lastRxUs > startUs)
+        stats->rxKbps = (unsigned int)(stats->rxPayloadBytes * 8000 / (lastRxUs - startUs));
+    wfaLatHistSummary(&myStream->transc.rtt, stats);
+
+    DPRINT_INFO(WFA_OUT, "stream %d tx %u frames %u kbps, rx %u frames %u kbps %u lost %u out of order\n",
+                myStream->id, stats->txFrames, stats->txKbps, stats->rxFrames, stats->rxKbps,
+                stats->lostPkts, stats->outOfSequenceFrames);
+
+    return rcvd;
+}
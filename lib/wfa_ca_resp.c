@@ -25,6 +25,7 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <sys/socket.h>
 
@@ -42,7 +43,113 @@
 
 
 extern unsigned short wfa_defined_debug;
-char gRespStr[WFA_BUFF_512];
+static wfaRespBuf_t caDefResp;
+wfaRespBuf_t *gResp = &caDefResp;
+
+/*
+ * wfaRespReset(): start a new reply, the buffer is kept for the next one.
+ */
+void wfaRespReset(void)
+{
+    if(gResp->buf == NULL)
+    {
+        gResp->buf = (char *)malloc(WFA_RESP_INIT_SZ);
+        gResp->size = (gResp->buf != NULL) ? WFA_RESP_INIT_SZ : 0;
+    }
+
+    gResp->len = 0;
+    gResp->truncated = 0;
+    if(gResp->buf != NULL)
+        gResp->buf[0] = '\0';
+}
+
+static int wfaRespVAppend(const char *fmt, va_list ap)
+{
+    va_list ap2;
+    char *nbuf;
+    int n, nsize;
+
+    if(gResp->buf == NULL)
+        wfaRespReset();
+    if(gResp->buf == NULL)
+        return WFA_FAILURE;
+
+    va_copy(ap2, ap);
+    n = vsnprintf(gResp->buf + gResp->len, gResp->size - gResp->len, fmt, ap2);
+    va_end(ap2);
+    if(n < 0)
+        return WFA_FAILURE;
+
+    if(gResp->len + n >= gResp->size)
+    {
+        /* double until it fits, then format once more */
+        nsize = gResp->size;
+        while(gResp->len + n >= nsize)
+            nsize *= 2;
+
+        nbuf = (char *)realloc(gResp->buf, nsize);
+        if(nbuf == NULL)
+        {
+            DPRINT_ERR(WFA_ERR, "response of %i bytes truncated\n", gResp->len + n);
+            gResp->buf[gResp->len] = '\0';
+            gResp->truncated = 1;
+            return WFA_FAILURE;
+        }
+        gResp->buf = nbuf;
+        gResp->size = nsize;
+
+        vsnprintf(gResp->buf + gResp->len, gResp->size - gResp->len, fmt, ap);
+    }
+
+    gResp->len += n;
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaRespAppend(): printf onto the end of the reply.
+ */
+int wfaRespAppend(const char *fmt, ...)
+{
+    va_list ap;
+    int ret;
+
+    va_start(ap, fmt);
+    ret = wfaRespVAppend(fmt, ap);
+    va_end(ap);
+
+    return ret;
+}
+
+/*
+ * wfaRespPrintf(): start the reply over with the formatted string.
+ */
+int wfaRespPrintf(const char *fmt, ...)
+{
+    va_list ap;
+    int ret;
+
+    wfaRespReset();
+
+    va_start(ap, fmt);
+    ret = wfaRespVAppend(fmt, ap);
+    va_end(ap);
+
+    return ret;
+}
+
+/*
+ * wfaRespSend(): send the reply to the test manager.
+ */
+int wfaRespSend(int sock)
+{
+    if(gResp->buf == NULL)
+        wfaRespReset();
+    if(gResp->buf == NULL)
+        return WFA_FAILURE;
+
+    return wfaCtrlSend(sock, (BYTE *)gResp->buf, gResp->len);
+}
 
 dutCommandRespFuncPtr wfaCmdRespProcFuncTbl[WFA_STA_RESPONSE_END+1] =
 {
@@ -55,7 +162,7 @@ dutCommandRespFuncPtr wfaCmdRespProcFuncTbl[WFA_STA_RESPONSE_END+1] =
     wfaStaGenericResp,                   /* WFA_TRAFFIC_AGENT_RECV_START_RESP_TLV - WFA_STA_COMMANDS_END     (6) */
     wfaTrafficAgentRecvStopResp,         /* WFA_TRAFFIC_AGENT_RECV_STOP_RESP_TLV - WFA_STA_COMMANDS_END      (7) */
     wfaStaGenericResp,                   /* WFA_TRAFFIC_AGENT_RESET_RESP_TLV - WFA_STA_COMMANDS_END          (8) */
-    caCmdNotDefinedYet,                  /* WFA_TRAFFIC_AGENT_STATUS_RESP_TLV - WFA_STA_COMMANDS_END         (9) */
+    wfaStaGenericResp,                   /* WFA_TRAFFIC_AGENT_STATUS_RESP_TLV - WFA_STA_COMMANDS_END         (9) */
 
     wfaStaGetIpConfigResp,               /* WFA_STA_GET_IP_CONFIG_RESP_TLV - WFA_STA_COMMANDS_END           (10) */
     wfaStaGenericResp,                   /* WFA_STA_SET_IP_CONFIG_RESP_TLV - WFA_STA_COMMANDS_END           (11) */
@@ -141,6 +248,8 @@ dutCommandRespFuncPtr wfaCmdRespProcFuncTbl[WFA_STA_RESPONSE_END+1] =
 	wfaStaGetEventDataResp, /* 84*/
     wfaStaGenericResp,      /* 85 */
 	wfaStaExecActionResp,      /* 86 */	
+	wfaTrafficAgentConfigBatchResp,      /* 87 */
+	wfaTrafficAgentReportResp,           /* 88 */
 	
 
 };
@@ -151,9 +260,9 @@ int caCmdNotDefinedYet(BYTE *cmdBuf)
 {
     int done;
 
-    sprintf(gRespStr, "status,ERROR,Command Not Defined\r\n");
+    wfaRespPrintf("status,ERROR,Command Not Defined\r\n");
     /* make sure if getting send error, will close the socket */
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     done = 0;
 
@@ -174,18 +283,18 @@ int wfaStaVerifyIpConnectResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,connected,%i\r\n", verifyResp->cmdru.connected);
-        DPRINT_INFO(WFA_OUT, "%s", gRespStr);
+        wfaRespPrintf("status,COMPLETE,connected,%i\r\n", verifyResp->cmdru.connected);
+        DPRINT_INFO(WFA_OUT, "%s", gResp->buf);
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
-        DPRINT_INFO(WFA_OUT, "%s", gRespStr);
+        wfaRespPrintf("status,ERROR\r\n");
+        DPRINT_INFO(WFA_OUT, "%s", gResp->buf);
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
+        wfaRespPrintf("status,INVALID\r\n");
     }
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -204,17 +313,17 @@ int wfaStaIsConnectedResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,connected,%i\r\n", connectedResp->cmdru.connected);
+        wfaRespPrintf("status,COMPLETE,connected,%i\r\n", connectedResp->cmdru.connected);
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         break;
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
+        wfaRespPrintf("status,INVALID\r\n");
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
     return done;
 }
 
@@ -232,7 +341,7 @@ int wfaStaGetIpConfigResp(BYTE *cmdBuf)
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         break;
 
     case STATUS_COMPLETE:
@@ -241,7 +350,7 @@ int wfaStaGetIpConfigResp(BYTE *cmdBuf)
         if(strlen(getIpConfigResp->cmdru.getIfconfig.dns[1]) == 0)
             *getIpConfigResp->cmdru.getIfconfig.dns[1] = '\0';
 
-        sprintf(gRespStr, "status,COMPLETE,dhcp,%i,ip,%s,mask,%s,primary-dns,%s,secondary-dns,%s\r\n", getIpConfigResp->cmdru.getIfconfig.isDhcp,
+        wfaRespPrintf("status,COMPLETE,dhcp,%i,ip,%s,mask,%s,primary-dns,%s,secondary-dns,%s\r\n", getIpConfigResp->cmdru.getIfconfig.isDhcp,
                 getIpConfigResp->cmdru.getIfconfig.ipaddr,
                 getIpConfigResp->cmdru.getIfconfig.mask,
                 getIpConfigResp->cmdru.getIfconfig.dns[0],
@@ -249,10 +358,10 @@ int wfaStaGetIpConfigResp(BYTE *cmdBuf)
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
+        wfaRespPrintf("status,INVALID\r\n");
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
     return done;
 }
 
@@ -269,13 +378,13 @@ int wfaGetVersionResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,version,%s\r\n", getverResp->cmdru.version);
+        wfaRespPrintf("status,COMPLETE,version,%s\r\n", getverResp->cmdru.version);
         break;
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
+        wfaRespPrintf("status,INVALID\r\n");
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
     return done ;
 }
 
@@ -292,15 +401,15 @@ int wfaStaGetInfoResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,%s\r\n", infoResp->cmdru.info);
+        wfaRespPrintf("status,COMPLETE,%s\r\n", infoResp->cmdru.info);
         DPRINT_INFO(WFA_OUT, "info: %s\n", infoResp->cmdru.info);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
+        wfaRespPrintf("status,INVALID\r\n");
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -318,20 +427,178 @@ int wfaTrafficAgentConfigResp(BYTE *cmdBuf)
         done = 1;
         break;
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,streamID,%i\r\n", agtConfigResp->streamId);
+        wfaRespPrintf("status,COMPLETE,streamID,%i\r\n", agtConfigResp->streamId);
         break;
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
+        wfaRespPrintf("status,INVALID\r\n");
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
     return done;
 }
 
+/*
+ * wfaTrafficAgentConfigBatchResp(): the ids of a batch of profiles in
+ *                                   the order they were given
+ */
+int wfaTrafficAgentConfigBatchResp(BYTE *cmdBuf)
+{
+    tgConfigBatchResp_t *batchResp = (tgConfigBatchResp_t *)(cmdBuf + 4);
+    int i;
+
+    DPRINT_INFO(WFA_OUT, "Entering wfaTrafficAgentConfigBatchResp ...\n");
+    if(batchResp->status != STATUS_COMPLETE || batchResp->numStreams <= 0 ||
+            batchResp->numStreams > WFA_TG_MAX_BATCH)
+    {
+        wfaRespPrintf("status,INVALID\r\n");
+        wfaRespSend(gCaSockfd);
+        return 0;
+    }
+
+    wfaRespPrintf("status,COMPLETE,streamID,");
+    for(i = 0; i < batchResp->numStreams; i++)
+        wfaRespAppend(i == 0 ? "%i" : " %i", batchResp->streamIds[i]);
+    wfaRespAppend("\r\n");
+
+    wfaRespSend(gCaSockfd);
+    return 0;
+}
+
+/*
+ * wfaTrafficAgentReportResp(): an interval report the DUT sends on its
+ *                              own after traffic_agent_status, passed on
+ *                              as one "report" line
+ */
+int wfaTrafficAgentReportResp(BYTE *cmdBuf)
+{
+    tgReport_t *report = (tgReport_t *)(cmdBuf + 4);
+    tgIntervalStats_t *ist = report->streams;
+    int i, num = report->numStreams;
+
+    if(num <= 0 || num > WFA_TG_MAX_REPORT)
+        return 0;
+
+    wfaRespPrintf("report,interval,%d,streamID,", report->intervalMs);
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %d", ist[i].streamId);
+
+    wfaRespAppend(",txFrames,");
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %u", ist[i].txFrames);
+
+    wfaRespAppend(",rxFrames,");
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %u", ist[i].rxFrames);
+
+    wfaRespAppend(",txPayloadBytes,");
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %u", ist[i].txBytes);
+
+    wfaRespAppend(",rxPayloadBytes,");
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %u", ist[i].rxBytes);
+
+    wfaRespAppend(",lostFrames,");
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %u", ist[i].lostPkts);
+
+    wfaRespAppend(",jitter,");
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %u", ist[i].jitter);
+
+    wfaRespAppend(",latencyP50,");
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %u", ist[i].latP50);
+
+    wfaRespAppend(",latencyP99,");
+    for(i=0; i<num; i++)
+        wfaRespAppend(" %u", ist[i].latP99);
+
+    wfaRespAppend("\r\n");
+
+    wfaRespSend(gCaSockfd);
+    return 0;
+}
+
+/* bidirectional streams report both directions of one stream */
+static void wfaTrafficLogBidir(dutCmdResponse_t *statResp)
+{
+    tgStats_t *st = &statResp->cmdru.stats;
+
+    if(st->txKbps == 0 && st->rxKbps == 0)
+        return;
+
+    DPRINT_INFO(WFA_OUT, "stream %i tx %u frames %u kbps\n", statResp->streamId, st->txFrames, st->txKbps);
+    DPRINT_INFO(WFA_OUT, "stream %i rx %u frames %u kbps, %u lost, %u out of order, latency usec min %u avg %u p99 %u max %u\n",
+                statResp->streamId, st->rxFrames, st->rxKbps, st->lostPkts, st->outOfSequenceFrames,
+                st->rttMin, st->rttAvg, st->rttP99, st->rttMax);
+}
+
+/*
+ * put the per stream counters of a traffic reply, one list per field with
+ * the streams in the order the DUT returned them. The loss and latency
+ * lists are only there when a stream measured them (bidirectional and
+ * transaction streams), so the plain profiles keep their reply format.
+ */
+static void wfaTrafficStatsResp(dutCmdResponse_t *statResp, int numStreams)
+{
+    int i, hasLat = 0;
+
+    wfaRespPrintf("status,COMPLETE,streamID,");
+    for(i=0; i<numStreams; i++)
+        wfaRespAppend(" %d", statResp[i].streamId);
+
+    wfaRespAppend(",txFrames,");
+    for(i=0; i<numStreams; i++)
+        wfaRespAppend(" %u", statResp[i].cmdru.stats.txFrames);
+
+    wfaRespAppend(",rxFrames,");
+    for(i=0; i<numStreams; i++)
+        wfaRespAppend(" %u", statResp[i].cmdru.stats.rxFrames);
+
+    wfaRespAppend(",txPayloadBytes,");
+    for(i=0; i<numStreams; i++)
+        wfaRespAppend(" %llu", statResp[i].cmdru.stats.txPayloadBytes);
+
+    wfaRespAppend(",rxPayloadBytes,");
+    for(i=0; i<numStreams; i++)
+        wfaRespAppend(" %llu", statResp[i].cmdru.stats.rxPayloadBytes);
+
+    wfaRespAppend(",outOfSequenceFrames,");
+    for(i=0; i<numStreams; i++)
+        wfaRespAppend(" %d", statResp[i].cmdru.stats.outOfSequenceFrames);
+
+    for(i=0; i<numStreams; i++)
+    {
+        if(statResp[i].cmdru.stats.rttMax != 0)
+            hasLat = 1;
+    }
+
+    if(hasLat)
+    {
+        wfaRespAppend(",lostFrames,");
+        for(i=0; i<numStreams; i++)
+            wfaRespAppend(" %u", statResp[i].cmdru.stats.lostPkts);
+
+        wfaRespAppend(",latencyAvg,");
+        for(i=0; i<numStreams; i++)
+            wfaRespAppend(" %u", statResp[i].cmdru.stats.rttAvg);
+
+        wfaRespAppend(",latencyP99,");
+        for(i=0; i<numStreams; i++)
+            wfaRespAppend(" %u", statResp[i].cmdru.stats.rttP99);
+
+        wfaRespAppend(",latencyMax,");
+        for(i=0; i<numStreams; i++)
+            wfaRespAppend(" %u", statResp[i].cmdru.stats.rttMax);
+    }
+
+    wfaRespAppend("\r\n");
+}
+
 int wfaTrafficAgentSendResp(BYTE *cmdBuf)
 {
     int done=1,i;
-    char copyBuf[64];
     int errorStatus = 0;
     wfaTLV *ptlv = (wfaTLV *)cmdBuf;
     int len = ptlv->len;
@@ -342,68 +609,44 @@ int wfaTrafficAgentSendResp(BYTE *cmdBuf)
 
     numStreams = (len/sizeof(dutCmdResponse_t));
     printf("total %i streams\n", numStreams);
+
+    /* a status word alone, the send did not start */
+    if(numStreams == 0)
+        errorStatus = 1;
+
     for(i=0; i<numStreams; i++)
     {
-        if(statResp->status != STATUS_COMPLETE)
+        if(statResp[i].status != STATUS_COMPLETE)
         {
             errorStatus = 1;
         }
+
+        wfaTrafficLogBidir(&statResp[i]);
+
+        /* transaction streams carry their round trip distribution */
+        if(statResp[i].cmdru.stats.rttMax != 0 && statResp[i].cmdru.stats.txKbps == 0)
+        {
+            DPRINT_INFO(WFA_OUT, "stream %i rtt usec min %u avg %u p50 %u p95 %u p99 %u max %u\n",
+                        statResp[i].streamId, statResp[i].cmdru.stats.rttMin, statResp[i].cmdru.stats.rttAvg,
+                        statResp[i].cmdru.stats.rttP50, statResp[i].cmdru.stats.rttP95,
+                        statResp[i].cmdru.stats.rttP99, statResp[i].cmdru.stats.rttMax);
+            DPRINT_INFO(WFA_OUT, "stream %i %u trans/sec, %u timeouts\n", statResp[i].streamId,
+                        statResp[i].cmdru.stats.transPerSec, statResp[i].cmdru.stats.transTimeouts);
+        }
+
+        DPRINT_INFO(WFA_OUT, "stream %i jitter %lu\n", statResp[i].streamId, statResp[i].cmdru.stats.jitter);
     }
 
     if(errorStatus)
     {
-        sprintf(gRespStr, "status,ERROR");
+        wfaRespPrintf("status,ERROR\r\n");
     }
     else
     {
-        sprintf(gRespStr, "status,COMPLETE,streamID,");
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, " %i", statResp[i].streamId);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-
-        printf("streamids %s\n", gRespStr);
-
-        strncat(gRespStr, ",txFrames,", 10);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, "%i ", statResp[i].cmdru.stats.txFrames);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-
-        strncat(gRespStr, ",rxFrames,", 10);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, "%i ", statResp[i].cmdru.stats.rxFrames);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-
-        strncat(gRespStr, ",txPayloadBytes,", 16);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, "%llu ", statResp[i].cmdru.stats.txPayloadBytes);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-
-        strncat(gRespStr, ",rxPayloadBytes,", 16);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, " %llu ", statResp[i].cmdru.stats.rxPayloadBytes);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-        strncat(gRespStr, ",outOfSequenceFrames,", 20);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, "%i ", statResp[i].cmdru.stats.outOfSequenceFrames);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-
-        printf("jitter %lu\n", statResp[i].cmdru.stats.jitter);
-        strncat(gRespStr, "\r\n", 4);
+        wfaTrafficStatsResp(statResp, numStreams);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
     return done;
 }
 
@@ -412,73 +655,34 @@ int wfaTrafficAgentRecvStopResp(BYTE *cmdBuf)
     int done=1;
     int i = 0;
     int errorStatus = 0;
-    char copyBuf[64];
-    BYTE *dutRsp = cmdBuf+4;
-    BYTE *startRsp = dutRsp;
     wfaTLV *ptlv = (wfaTLV *)cmdBuf;
     int len = ptlv->len;
     int numStreams = len/sizeof(dutCmdResponse_t);
+    dutCmdResponse_t *statResp = (dutCmdResponse_t *)(cmdBuf + 4);
 
     DPRINT_INFO(WFA_OUT, "Entering wfaTrafficAgentRecvStopResp ...\n");
 
-    dutCmdResponse_t statResp[WFA_MAX_TRAFFIC_STREAMS];
-    for(i=0; i<numStreams; i++)
-    {
-        dutRsp = startRsp + i * sizeof(dutCmdResponse_t);
-        memcpy(&statResp[i], dutRsp, sizeof(dutCmdResponse_t));
-    }
+    /* a status word alone, no stream was stopped */
+    if(numStreams == 0)
+        errorStatus = 1;
+
     for(i=0; i<numStreams; i++)
     {
         if(statResp[i].status != STATUS_COMPLETE)
             errorStatus = 1;
+        wfaTrafficLogBidir(&statResp[i]);
     }
     if(errorStatus)
     {
-        sprintf(gRespStr, "status,ERROR");
+        wfaRespPrintf("status,ERROR\r\n");
     }
     else
     {
-        sprintf(gRespStr, "status,COMPLETE,streamID,");
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, " %d", statResp[i].streamId);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-        strncat(gRespStr, ",txFrames,", 10);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, " %u", statResp[i].cmdru.stats.txFrames);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-        strncat(gRespStr, ",rxFrames,", 10);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, " %u", statResp[i].cmdru.stats.rxFrames);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-        strncat(gRespStr, ",txPayloadBytes,", 16);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, " %llu", statResp[i].cmdru.stats.txPayloadBytes);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-        strncat(gRespStr, ",rxPayloadBytes,", 16);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, " %llu", statResp[i].cmdru.stats.rxPayloadBytes);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-        strncat(gRespStr, ",outOfSequenceFrames,", 20);
-        for(i=0; i<numStreams; i++)
-        {
-            sprintf(copyBuf, " %d", statResp[i].cmdru.stats.outOfSequenceFrames);
-            strncat(gRespStr, copyBuf, sizeof(copyBuf)-1);
-        }
-        strncat(gRespStr, "\r\n", 4);
+        wfaTrafficStatsResp(statResp, numStreams);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
-    printf("gRespStr = %s", gRespStr);
+    wfaRespSend(gCaSockfd);
+    printf("gResp->buf = %s", gResp->buf);
     return done;
 }
 
@@ -497,15 +701,15 @@ int wfaTrafficAgentPingStartResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,streamID,%i\r\n", staPingResp->streamId);
+        wfaRespPrintf("status,COMPLETE,streamID,%i\r\n", staPingResp->streamId);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
+        wfaRespPrintf("status,INVALID\r\n");
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
-    DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+    wfaRespSend(gCaSockfd);
+    DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
 
     return done;
 }
@@ -524,19 +728,24 @@ int wfaTrafficAgentPingStopResp(BYTE *cmdBuf)
 
     case STATUS_COMPLETE:
     {
-        sprintf(gRespStr, "status,COMPLETE,sent,%d,replies,%d\r\n",
-                stpResp->cmdru.pingStp.sendCnt,
-                stpResp->cmdru.pingStp.repliedCnt);
-        DPRINT_INFO(WFA_OUT, "%s\n", gRespStr);
+        tgPingStopResp_t *stp = &stpResp->cmdru.pingStp;
+
+        wfaRespPrintf("status,COMPLETE,sent,%d,replies,%d", stp->sendCnt, stp->repliedCnt);
+        /* the round trips are only there when some were timed */
+        if(stp->rttMax != 0)
+            wfaRespAppend(",latencyMin,%u,latencyAvg,%u,latencyP50,%u,latencyP95,%u,latencyP99,%u,latencyMax,%u",
+                          stp->rttMin, stp->rttAvg, stp->rttP50, stp->rttP95, stp->rttP99, stp->rttMax);
+        wfaRespAppend("\r\n");
+        DPRINT_INFO(WFA_OUT, "%s\n", gResp->buf);
         break;
     }
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
     return done;
 }
 
@@ -554,21 +763,21 @@ int wfaStaGetMacAddressResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,mac,%s\r\n", getmacResp->cmdru.mac);
+        wfaRespPrintf("status,COMPLETE,mac,%s\r\n", getmacResp->cmdru.mac);
         printf("status,COMPLETE,mac,%s\r\n", getmacResp->cmdru.mac);
         break;
 
     case STATUS_ERROR:
         printf("status,ERROR\n");
-        sprintf(gRespStr, "status,COMPLETE,mac,00:00:00:00:00:00\r\n");
+        wfaRespPrintf("status,COMPLETE,mac,00:00:00:00:00:00\r\n");
         break;
 
     default:
-        sprintf(gRespStr, "status,COMPLETE,mac,00:00:00:00:00:00\r\n");
+        wfaRespPrintf("status,COMPLETE,mac,00:00:00:00:00:00\r\n");
         printf("unknown status\n");
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -587,18 +796,18 @@ int wfaStaGetBSSIDResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,bssid,%s\r\n", getBssidResp->cmdru.bssid);
+        wfaRespPrintf("status,COMPLETE,bssid,%s\r\n", getBssidResp->cmdru.bssid);
         printf("status,COMPLETE,bssid,%s\r\n", getBssidResp->cmdru.bssid);
         break;
     case STATUS_ERROR:
         printf("status,ERROR\n");
-        sprintf(gRespStr, "status,COMPLETE,mac,00:00:00:00:00:00\r\n");
+        wfaRespPrintf("status,COMPLETE,mac,00:00:00:00:00:00\r\n");
         break;
     default:
-        sprintf(gRespStr, "status,COMPLETE,mac,00:00:00:00:00:00\r\n");
+        wfaRespPrintf("status,COMPLETE,mac,00:00:00:00:00:00\r\n");
         printf("unknown status\n");
     }
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -617,22 +826,22 @@ int wfaStaSetEncryptionResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE\r\n");
+        wfaRespPrintf("status,COMPLETE\r\n");
         printf("status,COMPLETE\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         printf("status,ERROR\r\n");
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -652,16 +861,16 @@ int wfaStaReAssociateResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,COMPLETE\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -684,21 +893,27 @@ int wfaStaGetStatsResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,txFrames,%i,rxFrames,%i,txMulticast,%i,rxMulticast,%i,fcsErrors,%i,txRetries,%i\r\n",
-                stats->txFrames, stats->rxFrames, stats->txMulticast, stats->rxMulticast, stats->fcsErrors, stats->txRetries);
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,COMPLETE,txFrames,%llu,rxFrames,%llu,txMulticast,%i,rxMulticast,%llu,fcsErrors,%llu,txRetries,%llu,"
+                "interval,%u,wireless,%s,txBytes,%llu,rxBytes,%llu,txErrors,%llu,rxErrors,%llu,txDropped,%llu,rxDropped,%llu,"
+                "rxFifoErrors,%llu,rxMissed,%llu,txFifoErrors,%llu,qdiscDrops,%llu,qdiscRequeues,%llu,"
+                "txFailed,%llu,beaconLoss,%llu,rxDropMisc,%llu\r\n",
+                stats->txPackets, stats->rxPackets, stats->txMulticast, stats->rxMulticast64, stats->rxCrcErrors, stats->txRetries64,
+                stats->intervalMs, stats->wireless, stats->txBytes, stats->rxBytes, stats->txErrors, stats->rxErrors,
+                stats->txDropped, stats->rxDropped, stats->rxFifoErrors, stats->rxMissed, stats->txFifoErrors,
+                stats->qdiscDrops, stats->qdiscRequeues, stats->txFailed, stats->beaconLoss, stats->rxDropMisc);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -718,19 +933,19 @@ int wfaDeviceGetInfoResp(BYTE *cmdBuf)
 
     case STATUS_COMPLETE:
         if(dinfo->firmware[0] != '\0' || dinfo->firmware[0] != '\n')
-            sprintf(gRespStr, "status,COMPLETE,firmware,%s\r\n", dinfo->firmware);
+            wfaRespPrintf("status,COMPLETE,firmware,%s\r\n", dinfo->firmware);
         else
-            sprintf(gRespStr, "status,COMPLETE,vendor,%s,model,%s,version,%s\r\n",
+            wfaRespPrintf("status,COMPLETE,vendor,%s,model,%s,version,%s\r\n",
                     dinfo->vendor, dinfo->model, dinfo->version);
-        DPRINT_INFO(WFA_OUT, "%s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, "%s\n", gResp->buf);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -751,32 +966,30 @@ int wfaDeviceListIFResp(BYTE *cmdBuf)
     case STATUS_COMPLETE:
         if(ifResp->iftype == IF_80211)
         {
-            sprintf(gRespStr, "status,COMPLETE,interfaceType,802.11,interfaceID");
-            DPRINT_INFO(WFA_OUT, "%s\n", gRespStr);
+            wfaRespPrintf("status,COMPLETE,interfaceType,802.11,interfaceID");
+            DPRINT_INFO(WFA_OUT, "%s\n", gResp->buf);
             DPRINT_INFO(WFA_OUT, "%s\n", ifResp->ifs[0]);
         }
         else if(ifResp->iftype == IF_ETH)
-            sprintf(gRespStr, "status,COMPLETE,interfaceType,Ethernet,interfaceID");
+            wfaRespPrintf("status,COMPLETE,interfaceType,Ethernet,interfaceID");
 
         for(i=0; i<1; i++)
         {
             if(ifResp->ifs[i][0] != '\0')
             {
-                strncat(gRespStr,",", 4);
-                strncat(gRespStr, ifResp->ifs[i], sizeof(ifResp->ifs[i]));
-                strncat(gRespStr, "\r\n", 4);
+                wfaRespAppend(",%.*s\r\n", (int)sizeof(ifResp->ifs[i]), ifResp->ifs[i]);
             }
         }
 
-        DPRINT_INFO(WFA_OUT, "%s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, "%s\n", gResp->buf);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -795,19 +1008,19 @@ int wfaStaUploadResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,code,%i,%s\r\n",
+        wfaRespPrintf("status,COMPLETE,code,%i,%s\r\n",
                 upld->seqnum, upld->bytes);
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         printf("status,COMPLETE\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -833,16 +1046,16 @@ int wfaStaGetP2pDevAddressResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,devid,%s\r\n", p2pDevAddResp->cmdru.devid);
+        wfaRespPrintf("status,COMPLETE,devid,%s\r\n", p2pDevAddResp->cmdru.devid);
         printf("status,COMPLETE,devid,%s\r\n", p2pDevAddResp->cmdru.devid);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -860,17 +1073,17 @@ int wfaStaStartAutoGO(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,groupid,%s\r\n", p2pResp->cmdru.grpid);
+        wfaRespPrintf("status,COMPLETE,groupid,%s\r\n", p2pResp->cmdru.grpid);
         printf("status,COMPLETE,groupid,%s\r\n", p2pResp->cmdru.grpid);
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -889,16 +1102,16 @@ int wfaStaP2pStartGrpFormResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,result,%s,groupid,%s\r\n", grpInfo->result,grpInfo->grpId);
+        wfaRespPrintf("status,COMPLETE,result,%s,groupid,%s\r\n", grpInfo->result,grpInfo->grpId);
         printf("status,COMPLETE,result,%s,groupid,%s\r\n", grpInfo->result,grpInfo->grpId);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -917,16 +1130,16 @@ int wfaStaWpsReadPinResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,pin,%s\r\n", p2pResp->cmdru.wpsPin);
+        wfaRespPrintf("status,COMPLETE,pin,%s\r\n", p2pResp->cmdru.wpsPin);
         printf("status,COMPLETE,pin,%s\r\n", p2pResp->cmdru.wpsPin);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -945,16 +1158,16 @@ int wfaStaGetPskResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,passphrase,%s,ssid,%s\r\n", pskInfo->passPhrase,pskInfo->ssid);
+        wfaRespPrintf("status,COMPLETE,passphrase,%s,ssid,%s\r\n", pskInfo->passPhrase,pskInfo->ssid);
         printf("status,COMPLETE,passphrase,%s,ssid,%s\r\n", pskInfo->passPhrase,pskInfo->ssid);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -972,16 +1185,16 @@ int wfaStaWpsReadLabelResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,label,%s\r\n", p2pResp->cmdru.wpsPin);
+        wfaRespPrintf("status,COMPLETE,label,%s\r\n", p2pResp->cmdru.wpsPin);
         printf("status,COMPLETE,label,%s\r\n", p2pResp->cmdru.wpsPin);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1000,7 +1213,7 @@ int wfaStaGetP2pIpConfigResp(BYTE *cmdBuf)
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         break;
 
     case STATUS_COMPLETE:
@@ -1009,7 +1222,7 @@ int wfaStaGetP2pIpConfigResp(BYTE *cmdBuf)
         if(strlen(getIpConfigResp->cmdru.getIfconfig.dns[1]) == 0)
             *getIpConfigResp->cmdru.getIfconfig.dns[1] = '\0';
 
-        sprintf(gRespStr, "status,COMPLETE,dhcp,%i,ip,%s,mask,%s,primary-dns,%s,p2pinterfaceaddress,%s\r\n", getIpConfigResp->cmdru.getIfconfig.isDhcp,
+        wfaRespPrintf("status,COMPLETE,dhcp,%i,ip,%s,mask,%s,primary-dns,%s,p2pinterfaceaddress,%s\r\n", getIpConfigResp->cmdru.getIfconfig.isDhcp,
                 getIpConfigResp->cmdru.getIfconfig.ipaddr,
                 getIpConfigResp->cmdru.getIfconfig.mask,
                 getIpConfigResp->cmdru.getIfconfig.dns[0],
@@ -1018,11 +1231,11 @@ int wfaStaGetP2pIpConfigResp(BYTE *cmdBuf)
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
+        wfaRespPrintf("status,INVALID\r\n");
 
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1038,23 +1251,23 @@ int wfaStaGenericResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE\r\n");
+        wfaRespPrintf("status,COMPLETE\r\n");
         printf("status,COMPLETE\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         printf("status,COMPLETE\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1074,16 +1287,16 @@ int wfaStaStartWfdConnectionResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,result,%s,groupid,%s,wfdsessionid,%s\r\n", wfdConnInfo->result,wfdConnInfo->p2pGrpId,wfdConnInfo->wfdSessionId);
+        wfaRespPrintf("status,COMPLETE,result,%s,groupid,%s,wfdsessionid,%s\r\n", wfdConnInfo->result,wfdConnInfo->p2pGrpId,wfdConnInfo->wfdSessionId);
         printf("status,COMPLETE,result,%s,groupid,%s,wfdsessionid,%s\r\n", wfdConnInfo->result,wfdConnInfo->p2pGrpId,wfdConnInfo->wfdSessionId);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 
@@ -1105,30 +1318,30 @@ int wfaStaCliCmdResp(BYTE *cmdBuf)
     case STATUS_COMPLETE:
         if(staCliCmdResp->resFlag == 1)
         {
-            sprintf(gRespStr, "status,COMPLETE,%s\r\n", staCliCmdResp->result);
+            wfaRespPrintf("status,COMPLETE,%s\r\n", staCliCmdResp->result);
             printf("\nstatus,COMPLETE,%s****\r\n", staCliCmdResp->result);
         }
         else
         {
-            sprintf(gRespStr, "status,COMPLETE\r\n");
+            wfaRespPrintf("status,COMPLETE\r\n");
             printf("status,COMPLETE\r\n");
         }
 
         break;
 
     case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         printf("status,ERROR\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1148,16 +1361,16 @@ int wfaStaConnectGoStartWfdResp(BYTE *cmdBuf)
         break;
 
     case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,wfdsessionid,%s\r\n",wfdConnInfo->wfdSessionId);
+        wfaRespPrintf("status,COMPLETE,wfdsessionid,%s\r\n",wfdConnInfo->wfdSessionId);
         printf("status,COMPLETE,wfdsessionid,%s\r\n", wfdConnInfo->wfdSessionId);
         break;
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 
@@ -1181,35 +1394,35 @@ int wfaStaGetParameterResp(BYTE *cmdBuf)
         case STATUS_COMPLETE:
 		if(getParamInfo->getParamType == eDiscoveredDevList)
 		{
-	        sprintf(gRespStr, "status,COMPLETE,DeviceList,%s\r\n",getParamInfo->devList);
+	        wfaRespPrintf("status,COMPLETE,DeviceList,%s\r\n",getParamInfo->devList);
 	        printf("status,COMPLETE,DeviceList,%s\r\n", getParamInfo->devList);
 	        break;		
 		}
 		else if(getParamInfo->getParamType == eOpenPorts)
 		{
-	        sprintf(gRespStr, "status,COMPLETE,OpenPortList,%s\r\n",getParamInfo->devList);
+	        wfaRespPrintf("status,COMPLETE,OpenPortList,%s\r\n",getParamInfo->devList);
 	        printf("status,COMPLETE,OpenPortList,%s\r\n", getParamInfo->devList);
 	        break;		
 		}
 		else if(getParamInfo->getParamType == eMasterPref)
 		{
-	        sprintf(gRespStr, "status,COMPLETE,MasterPref,%s\r\n",getParamInfo->masterPref);
+	        wfaRespPrintf("status,COMPLETE,MasterPref,%s\r\n",getParamInfo->masterPref);
 	        printf("status,COMPLETE,MasterPref,%s\r\n", getParamInfo->masterPref);
 	        break;		
 		}
 		else
 		{
-	        sprintf(gRespStr, "status,COMPLETE,UnkownGetParmResp\r\n");
+	        wfaRespPrintf("status,COMPLETE,UnkownGetParmResp\r\n");
 	        printf("status,COMPLETE,UnkownGetParmResp\r\n");
 	        break;		
 		}
 
     default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 
@@ -1230,16 +1443,16 @@ int wfaStaNfcActionResp(BYTE *cmdBuf)
         break;
 
         case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,result,%s,groupid,%s,peerRoole,%i\r\n", nfcAction->result,nfcAction->grpId,nfcAction->peerRole);
+        wfaRespPrintf("status,COMPLETE,result,%s,groupid,%s,peerRoole,%i\r\n", nfcAction->result,nfcAction->grpId,nfcAction->peerRole);
         printf("status,COMPLETE,result,%s,groupid,%s,peerRoole,%i\r\n", nfcAction->result,nfcAction->grpId,nfcAction->peerRole);
         break;
 
         default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1257,22 +1470,22 @@ int wfaStaExecActionResp(BYTE *cmdBuf)
         break;
 
         case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,mac,%s\r\n", execActionResp->cmdru.execAction.mac);
+        wfaRespPrintf("status,COMPLETE,mac,%s\r\n", execActionResp->cmdru.execAction.mac);
         printf("status,COMPLETE,mac,%s\r\n", execActionResp->cmdru.execAction.mac);
         break;
 
         case STATUS_ERROR:
-        sprintf(gRespStr, "status,ERROR\r\n");
+        wfaRespPrintf("status,ERROR\r\n");
         printf("status,COMPLETE\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
         break;
 
         default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
  
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1312,19 +1525,19 @@ int wfaStaInvokeCommandResp(BYTE *cmdBuf)
 				sprintf(advidList, "%s %lx", advidList,invokeCmdResp->invokeCmdResp.advRsp.servAdvInfo[i].advtID );			
 				sprintf(serviceMac, "%s %s", serviceMac,invokeCmdResp->invokeCmdResp.advRsp.servAdvInfo[i].serviceMac );			
 			}
-			sprintf(gRespStr, "status,COMPLETE,ServName,%s,AdvID,%s,Service_Mac,%s\r\n",serviceList,advidList,serviceMac );
+			wfaRespPrintf("status,COMPLETE,ServName,%s,AdvID,%s,Service_Mac,%s\r\n",serviceList,advidList,serviceMac );
 			printf("status,COMPLETE,ServName,%s,AdvID,%s,Service_Mac,%s\r\n",serviceList,advidList,serviceMac );
 
 		}
 		else if( invokeCmdResp->invokeCmdRspType == eCmdPrimTypeSeek )
 		{
-			sprintf(gRespStr, "status,COMPLETE,SearchID,%lx\r\n",invokeCmdResp->invokeCmdResp.seekRsp.searchID );
+			wfaRespPrintf("status,COMPLETE,SearchID,%lx\r\n",invokeCmdResp->invokeCmdResp.seekRsp.searchID );
 			printf("status,COMPLETE,SearchID,%lx\r\n",invokeCmdResp->invokeCmdResp.seekRsp.searchID );
 
 		}
 		else if( invokeCmdResp->invokeCmdRspType == eCmdPrimTypeConnSession )
 		{
-			sprintf(gRespStr, "status,COMPLETE,Session_id,%lx,P2P_result,%s,groupid,%s\r\n", \
+			wfaRespPrintf("status,COMPLETE,Session_id,%lx,P2P_result,%s,groupid,%s\r\n", \
 				invokeCmdResp->invokeCmdResp.connSessResp.sessionID,invokeCmdResp->invokeCmdResp.connSessResp.result,
 				invokeCmdResp->invokeCmdResp.connSessResp.grpId);
 			printf("status,COMPLETE,Session_id,%lx,P2P_result,%s,groupid,%s\r\n", \
@@ -1339,25 +1552,25 @@ int wfaStaInvokeCommandResp(BYTE *cmdBuf)
 			invokeCmdResp->invokeCmdRspType == eCmdPrimTypeServiceStatusChange||
 			invokeCmdResp->invokeCmdRspType == eCmdPrimTypeCloseSession)
 		{
-			sprintf(gRespStr, "status,COMPLETE\r\n");
+			wfaRespPrintf("status,COMPLETE\r\n");
 			printf("status,COMPLETE\r\n");
 
 		}
 		
 		else
 		{
-		    sprintf(gRespStr, "status,INVALID\r\n");
-        	DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+		    wfaRespPrintf("status,INVALID\r\n");
+        	DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
 		}
 			
         break;
 
         default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1377,18 +1590,18 @@ int wfaStaManageServiceResp(BYTE *cmdBuf)
         break;
 
         case STATUS_COMPLETE:
-		sprintf(gRespStr, "status,COMPLETE,Session_id,%lx,P2P_result,%s,groupid,%s\r\n", \
+		wfaRespPrintf("status,COMPLETE,Session_id,%lx,P2P_result,%s,groupid,%s\r\n", \
 			mangeServ->sessionID,mangeServ->result,mangeServ->grpId);
 		printf("status,COMPLETE,Session_id,%lx,P2P_result,%s,groupid,%s\r\n", \
 			mangeServ->sessionID,mangeServ->result,mangeServ->grpId);			
         break;
 
         default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1408,16 +1621,22 @@ int wfaStaGetEventsResp(BYTE *cmdBuf)
         break;
 
         case STATUS_COMPLETE:
-        sprintf(gRespStr, "status,COMPLETE,EventName,%s,RemoteInstanceID,%u,LocalInstanceID,%u,mac,%s\r\n", getEvents->eventName,getEvents->remoteInstanceID,getEvents->localInstanceID,getEvents->mac);
+        if(getEvents->program != PROG_TYPE_NAN)
+        {
+            wfaRespPrintf("status,COMPLETE,EventList,%s\r\n", getEventsResp->cmdru.staGetEvents.result);
+            printf("status,COMPLETE,EventList,%s\r\n", getEventsResp->cmdru.staGetEvents.result);
+            break;
+        }
+        wfaRespPrintf("status,COMPLETE,EventName,%s,RemoteInstanceID,%u,LocalInstanceID,%u,mac,%s\r\n", getEvents->eventName,getEvents->remoteInstanceID,getEvents->localInstanceID,getEvents->mac);
         printf("status,COMPLETE,EventName,%s,RemoteInstanceID,%u,LocalInstanceID,%u,mac,%s\r\n", getEvents->eventName,getEvents->remoteInstanceID,getEvents->localInstanceID,getEvents->mac);
         break;
 
         default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
@@ -1440,7 +1659,7 @@ int wfaStaGetEventDataResp(BYTE *cmdBuf)
 		if ( evntDataResp->eventID== eSearchResult )
 		{
 
-			sprintf(gRespStr, "status,COMPLETE,SerchId,%lx,Service_Mac,%s,AdvID,%lx,Service_name,%s,service_status,%i\r\n",\
+			wfaRespPrintf("status,COMPLETE,SerchId,%lx,Service_Mac,%s,AdvID,%lx,Service_name,%s,service_status,%i\r\n",\
 				evntDataResp->getEventDetails.searchResult.searchID,\
 				evntDataResp->getEventDetails.searchResult.serviceMac,\
 				evntDataResp->getEventDetails.searchResult.advID,\
@@ -1458,7 +1677,7 @@ int wfaStaGetEventDataResp(BYTE *cmdBuf)
 		}
 		else if( evntDataResp->eventID == eSearchTerminated )
 		{
-			sprintf(gRespStr, "status,COMPLETE,SearchID,%lx\r\n",evntDataResp->getEventDetails.searchTerminated.searchID );
+			wfaRespPrintf("status,COMPLETE,SearchID,%lx\r\n",evntDataResp->getEventDetails.searchTerminated.searchID );
 			printf("status,COMPLETE,SearchID,%lx\r\n",evntDataResp->getEventDetails.searchTerminated.searchID );
 
 		}
@@ -1471,7 +1690,7 @@ int wfaStaGetEventDataResp(BYTE *cmdBuf)
 				strcpy(t_status,"NotAdvertised");
 				
 
-			sprintf(gRespStr, "status,COMPLETE,AdvID,%lx,status,%s\r\n",\
+			wfaRespPrintf("status,COMPLETE,AdvID,%lx,status,%s\r\n",\
 				evntDataResp->getEventDetails.advStatus.advID,t_status);
 
 			printf("status,COMPLETE,AdvID,%lx,status,%s\r\n",\
@@ -1482,7 +1701,7 @@ int wfaStaGetEventDataResp(BYTE *cmdBuf)
 		else if( evntDataResp->eventID== eSessionRequest )
 		{
 
-			sprintf(gRespStr, "status,COMPLETE,AdvID,%lx,Session_Mac,%s,session_ID,%lx\r\n",\
+			wfaRespPrintf("status,COMPLETE,AdvID,%lx,Session_Mac,%s,session_ID,%lx\r\n",\
 				evntDataResp->getEventDetails.sessionReq.advID,\
 				evntDataResp->getEventDetails.sessionReq.sessionMac,\
 				evntDataResp->getEventDetails.sessionReq.sessionID);
@@ -1507,7 +1726,7 @@ int wfaStaGetEventDataResp(BYTE *cmdBuf)
 				strcpy(t_status,"CLOSED");								
 
 
-			sprintf(gRespStr, "status,COMPLETE,session_ID,%lx,Session_Mac,%s,state,%s\r\n",\
+			wfaRespPrintf("status,COMPLETE,session_ID,%lx,Session_Mac,%s,state,%s\r\n",\
 				evntDataResp->getEventDetails.sessionStatus.sessionID,\
 				evntDataResp->getEventDetails.sessionStatus.sessionMac,\
 				t_status);
@@ -1540,7 +1759,7 @@ int wfaStaGetEventDataResp(BYTE *cmdBuf)
 				strcpy(t_status,"GroupFormationFailed");	
 
 
-			sprintf(gRespStr, "status,COMPLETE,session_ID,%lx,Session_Mac,%s,status,%s\r\n",\
+			wfaRespPrintf("status,COMPLETE,session_ID,%lx,Session_Mac,%s,status,%s\r\n",\
 				evntDataResp->getEventDetails.connStatus.sessionID,\
 				evntDataResp->getEventDetails.connStatus.sessionMac,\
 				t_status);
@@ -1565,7 +1784,7 @@ int wfaStaGetEventDataResp(BYTE *cmdBuf)
 				strcpy(t_status,"RemotePortAllowed");								
 
 
-			sprintf(gRespStr, "status,COMPLETE,session_ID,%lx,Session_Mac,%s,port,%i,status,%s\r\n",\
+			wfaRespPrintf("status,COMPLETE,session_ID,%lx,Session_Mac,%s,port,%i,status,%s\r\n",\
 				evntDataResp->getEventDetails.portStatus.sessionID,\
 				evntDataResp->getEventDetails.portStatus.sessionMac,\
 				evntDataResp->getEventDetails.portStatus.port,t_status);
@@ -1580,18 +1799,18 @@ int wfaStaGetEventDataResp(BYTE *cmdBuf)
 		
 		else
 		{
-		    sprintf(gRespStr, "status,INVALID\r\n");
-        	DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+		    wfaRespPrintf("status,INVALID\r\n");
+        	DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
 		}
 			
         break;
 
         default:
-        sprintf(gRespStr, "status,INVALID\r\n");
-        DPRINT_INFO(WFA_OUT, " %s\n", gRespStr);
+        wfaRespPrintf("status,INVALID\r\n");
+        DPRINT_INFO(WFA_OUT, " %s\n", gResp->buf);
     }
 
-    wfaCtrlSend(gCaSockfd, (BYTE *)gRespStr, strlen(gRespStr));
+    wfaRespSend(gCaSockfd);
 
     return done;
 }
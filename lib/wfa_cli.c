@@ -0,0 +1,139 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_cli.c - the command line override list, WFA_CLI_CMDS_FILE.
+ *       Kept in a hash of the command names with their return flag and
+ *       read again only when the file changes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "wfa_debug.h"
+#include "wfa_types.h"
+#include "wfa_cli.h"
+
+extern unsigned short wfa_defined_debug;
+
+typedef struct _wfa_cli_cmd
+{
+    char name[32];
+    int retFlag;                /* "TRUE": the result string goes back */
+} wfaCliCmd_t;
+
+static wfaCliCmd_t cliCmds[WFA_CLI_CMDS_HASH_SZ];
+static time_t cliCmdsMtime;
+static off_t cliCmdsSize = -1;
+
+static unsigned int wfaCliCmdHash(char *name)
+{
+    unsigned int h = 5381;
+
+    while(*name != '\0')
+        h = h * 33 + (unsigned char)*name++;
+
+    return h & (WFA_CLI_CMDS_HASH_SZ - 1);
+}
+
+static void wfaCliCmdsLoad(FILE *fp)
+{
+    char line[128], *name, *flag, *savep;
+    unsigned int h, n;
+
+    memset(cliCmds, 0, sizeof(cliCmds));
+
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        name = strtok_r(line, "-", &savep);
+        if(name == NULL || name[0] == '#' || name[0] == '\n' || name[0] == '\r' ||
+                strlen(name) >= sizeof(cliCmds[0].name))
+            continue;
+
+        h = wfaCliCmdHash(name);
+        for(n = 0; n < WFA_CLI_CMDS_HASH_SZ && cliCmds[h].name[0] != '\0' && strcmp(cliCmds[h].name, name) != 0; n++)
+            h = (h + 1) & (WFA_CLI_CMDS_HASH_SZ - 1);
+
+        if(n == WFA_CLI_CMDS_HASH_SZ)
+        {
+            DPRINT_WARNING(WFA_WNG, "%s: too many commands\n", WFA_CLI_CMDS_FILE);
+            break;
+        }
+        strcpy(cliCmds[h].name, name);
+
+        flag = strtok_r(NULL, ",", &savep);
+        if(flag == NULL)
+        {
+            DPRINT_WARNING(WFA_WNG, "%s: %s not followed by TRUE/FALSE\n", WFA_CLI_CMDS_FILE, name);
+        }
+        cliCmds[h].retFlag = (flag != NULL && strcmp(flag, "TRUE") == 0);
+    }
+}
+
+/*
+ * wfaCliCmdLookup(): tell if a command is listed in WFA_CLI_CMDS_FILE and
+ *                    whether its result string is to be returned.
+ */
+int wfaCliCmdLookup(char *name, int *retFlag)
+{
+    struct stat st;
+    FILE *fp;
+    unsigned int h, n;
+
+    if(stat(WFA_CLI_CMDS_FILE, &st) != 0)
+    {
+        cliCmdsSize = -1;
+        return 0;
+    }
+
+    if(st.st_mtime != cliCmdsMtime || st.st_size != cliCmdsSize)
+    {
+        fp = fopen(WFA_CLI_CMDS_FILE, "r");
+        if(fp == NULL)
+            return 0;
+
+        wfaCliCmdsLoad(fp);
+        fclose(fp);
+        cliCmdsMtime = st.st_mtime;
+        cliCmdsSize = st.st_size;
+    }
+
+    h = wfaCliCmdHash(name);
+    for(n = 0; n < WFA_CLI_CMDS_HASH_SZ && cliCmds[h].name[0] != '\0'; n++)
+    {
+        if(strcmp(cliCmds[h].name, name) == 0)
+        {
+            if(retFlag != NULL)
+                *retFlag = cliCmds[h].retFlag;
+            return 1;
+        }
+        h = (h + 1) & (WFA_CLI_CMDS_HASH_SZ - 1);
+    }
+
+    return 0;
+}
+
+/*
+ * wfaCliCmdIsListed(): tell if a command is to be run as a DUT command
+ *                      line, as listed in WFA_CLI_CMDS_FILE.
+ */
+int wfaCliCmdIsListed(char *name)
+{
+    return wfaCliCmdLookup(name, NULL);
+}
@@ -36,32 +36,124 @@
 #include "wfa_miscs.h"
 #include "wfa_agtctrl.h"
 
+extern unsigned short wfa_defined_debug;
 extern int gSock;
 extern void printProfile(tgProfile_t *);
 int wfaStandardBoolParsing (char *str);
 
-/* command KEY WORD String table */
+/* command KEY WORD String table, sorted by name for wfaCapiKeyword() */
 typeNameStr_t keywordStr[] =
 {
-    { KW_PROFILE,      "profile",       NULL},
-    { KW_DIRECTION,    "direction",     NULL},
     { KW_DIPADDR,      "destination",   NULL},
     { KW_DPORT,        "destinationport",  NULL},
-    { KW_SIPADDR,      "source",        NULL},
-    { KW_SPORT,        "sourceport",    NULL},
-    { KW_FRATE,        "framerate",     NULL},
+    { KW_DIRECTION,    "direction",     NULL},
     { KW_DURATION,     "duration",      NULL},
+    { KW_FRATE,        "framerate",     NULL},
+    { KW_MAXCNT,       "maxcnt",        NULL},
+    { KW_NUMFRAME,     "numframes",     NULL},
     { KW_PLOAD,        "payloadsize",   NULL},
-    { KW_TCLASS,       "trafficClass",  NULL},    /* It is to indicate WMM traffic pattern */
-    { KW_STREAMID,     "streamid",      NULL},
+    { KW_PROFILE,      "profile",       NULL},
+    { KW_SIPADDR,      "source",        NULL},
+    { KW_SPORT,        "sourceport",    NULL},
     { KW_STARTDELAY,   "startdelay",    NULL},     /* It is used to schedule multi-stream test such as WMM */
-    { KW_NUMFRAME,     "numframes",     NULL},
-    { KW_USESYNCCLOCK, "useSyncClock",  NULL},
+    { KW_STREAMID,     "streamid",      NULL},
+    { KW_TAGNAME,      "tagName",	    NULL},
+    { KW_TCLASS,       "trafficClass",  NULL},    /* It is to indicate WMM traffic pattern */
     { KW_USERPRIORITY, "userpriority",  NULL},
-    { KW_MAXCNT,       "maxcnt",        NULL},
-    { KW_TAGNAME,      "tagName",	    NULL}
+    { KW_USESYNCCLOCK, "useSyncClock",  NULL},
+    { KW_WINDOW,       "window",        NULL}
+};
+
+/* parameter names of the ping and sta_set_* commands */
+#define CAPI_KW_ACTIVEKEY          1
+#define CAPI_KW_CHANNEL            2
+#define CAPI_KW_CLIENTCERT         3
+#define CAPI_KW_DEFGATEWAY         4
+#define CAPI_KW_DESTINATION        5
+#define CAPI_KW_DHCP               6
+#define CAPI_KW_DSCP               7
+#define CAPI_KW_DURATION           8
+#define CAPI_KW_ENCPTYPE           9
+#define CAPI_KW_FRAMERATE          10
+#define CAPI_KW_FRAMESIZE          11
+#define CAPI_KW_INNEREAP           12
+#define CAPI_KW_INTERFACE          13
+#define CAPI_KW_IP                 14
+#define CAPI_KW_IPTYPE             15
+#define CAPI_KW_KEY1               16
+#define CAPI_KW_KEY2               17
+#define CAPI_KW_KEY3               18
+#define CAPI_KW_KEY4               19
+#define CAPI_KW_KEYMGMTTYPE        20
+#define CAPI_KW_MASK               21
+#define CAPI_KW_MICALG             22
+#define CAPI_KW_PASSPHRASE         23
+#define CAPI_KW_PASSWORD           24
+#define CAPI_KW_PEAPVERSION        25
+#define CAPI_KW_PMF                26
+#define CAPI_KW_PREFER             27
+#define CAPI_KW_PRIDNS             28
+#define CAPI_KW_PROG               29
+#define CAPI_KW_QOS                30
+#define CAPI_KW_SECDNS             31
+#define CAPI_KW_SSID               32
+#define CAPI_KW_STREAMID           33
+#define CAPI_KW_TRIPLET1           34
+#define CAPI_KW_TRIPLET2           35
+#define CAPI_KW_TRIPLET3           36
+#define CAPI_KW_TRUSTEDROOTCA      37
+#define CAPI_KW_TYPE               38
+#define CAPI_KW_USERNAME           39
+#define CAPI_KW_INTERVAL           40
+
+/* sorted by name for wfaCapiKeyword() */
+typeNameStr_t capiKwStr[] =
+{
+    { CAPI_KW_ACTIVEKEY,     "activeKey",         NULL},
+    { CAPI_KW_CHANNEL,       "channel",           NULL},
+    { CAPI_KW_CLIENTCERT,    "clientCertificate", NULL},
+    { CAPI_KW_DEFGATEWAY,    "defaultGateway",    NULL},
+    { CAPI_KW_DESTINATION,   "destination",       NULL},
+    { CAPI_KW_DHCP,          "dhcp",              NULL},
+    { CAPI_KW_DSCP,          "dscp",              NULL},
+    { CAPI_KW_DURATION,      "duration",          NULL},
+    { CAPI_KW_ENCPTYPE,      "encpType",          NULL},
+    { CAPI_KW_FRAMERATE,     "frameRate",         NULL},
+    { CAPI_KW_FRAMESIZE,     "frameSize",         NULL},
+    { CAPI_KW_INNEREAP,      "innerEAP",          NULL},
+    { CAPI_KW_INTERFACE,     "interface",         NULL},
+    { CAPI_KW_INTERVAL,      "interval",          NULL},
+    { CAPI_KW_IP,            "ip",                NULL},
+    { CAPI_KW_IPTYPE,        "iptype",            NULL},
+    { CAPI_KW_KEY1,          "key1",              NULL},
+    { CAPI_KW_KEY2,          "key2",              NULL},
+    { CAPI_KW_KEY3,          "key3",              NULL},
+    { CAPI_KW_KEY4,          "key4",              NULL},
+    { CAPI_KW_KEYMGMTTYPE,   "keyMgmtType",       NULL},
+    { CAPI_KW_MASK,          "mask",              NULL},
+    { CAPI_KW_MICALG,        "micAlg",            NULL},
+    { CAPI_KW_PASSPHRASE,    "passPhrase",        NULL},
+    { CAPI_KW_PASSWORD,      "password",          NULL},
+    { CAPI_KW_PEAPVERSION,   "peapVersion",       NULL},
+    { CAPI_KW_PMF,           "pmf",               NULL},
+    { CAPI_KW_PREFER,        "Prefer",            NULL},
+    { CAPI_KW_PRIDNS,        "primary-dns",       NULL},
+    { CAPI_KW_PROG,          "Prog",              NULL},
+    { CAPI_KW_QOS,           "qos",               NULL},
+    { CAPI_KW_SECDNS,        "secondary-dns",     NULL},
+    { CAPI_KW_SSID,          "ssid",              NULL},
+    { CAPI_KW_STREAMID,      "streamid",          NULL},
+    { CAPI_KW_TRIPLET1,      "triplet1",          NULL},
+    { CAPI_KW_TRIPLET2,      "triplet2",          NULL},
+    { CAPI_KW_TRIPLET3,      "triplet3",          NULL},
+    { CAPI_KW_TRUSTEDROOTCA, "trustedRootCA",     NULL},
+    { CAPI_KW_TYPE,          "type",              NULL},
+    { CAPI_KW_USERNAME,      "username",          NULL}
 };
 
+#define KEYWORD_NUM     (sizeof(keywordStr)/sizeof(typeNameStr_t))
+#define CAPI_KW_NUM     (sizeof(capiKwStr)/sizeof(typeNameStr_t))
+
 /* profile type string table */
 typeNameStr_t profileStr[] =
 {
@@ -78,7 +170,8 @@ typeNameStr_t profileStr[] =
 typeNameStr_t direcStr[] =
 {
     { DIRECT_SEND,  "send",          NULL},
-    { DIRECT_RECV,  "receive",       NULL}
+    { DIRECT_RECV,  "receive",       NULL},
+    { DIRECT_BIDIR, "bidirectional", NULL}
 };
 
 /*
@@ -96,7 +189,9 @@ int getParamValueInt(char *pcmdStr, char *pParam, int *paramValue)
     if(strcasecmp(pcmdStr, pParam) == 0)
     {
         str = strtok_r(NULL, ",", &pcmdStr);
-        paramValue = atoi(str);
+        if(str == NULL)
+            return -1;
+        *paramValue = atoi(str);
         return 0;
     }
     return -1;
@@ -119,14 +214,133 @@ int getParamValueStr(char *pcmdStr, char *pParam, char *paramValue, int paramVal
     if(strcasecmp(pcmdStr, pParam) == 0)
     {
         str = strtok_r(NULL, ",", &pcmdStr);
-        strncpy(paramValue, str, (paramValLen - 1));
-        paramValue[paramValLen] = 0;
+        if(str == NULL)
+            return -1;
+        wfaCapiStrCpy(paramValue, paramValLen, str);
      return 0;
     }
     return -1;
 }
 
+static int wfaCapiKwCmp(const void *a, const void *b)
+{
+    return strcasecmp(((typeNameStr_t *)a)->name, ((typeNameStr_t *)b)->name);
+}
+
+/*
+ * wfaCmdProcInit(): the keyword tables are written sorted by name, check
+ *                   that they still are.
+ * return:  WFA_SUCCESS or WFA_FAILURE
+ */
+int wfaCmdProcInit(void)
+{
+    struct
+    {
+        typeNameStr_t *tbl;
+        int num;
+    } kwTbls[] = { {keywordStr, KEYWORD_NUM}, {capiKwStr, CAPI_KW_NUM} };
+    int i, j;
+
+    for(i = 0; i < sizeof(kwTbls)/sizeof(kwTbls[0]); i++)
+    {
+        for(j = 1; j < kwTbls[i].num; j++)
+        {
+            if(wfaCapiKwCmp(&kwTbls[i].tbl[j-1], &kwTbls[i].tbl[j]) >= 0)
+            {
+                DPRINT_ERR(WFA_ERR, "keyword %s out of order\n", kwTbls[i].tbl[j].name);
+                return WFA_FAILURE;
+            }
+        }
+    }
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaCapiKeyword(): the type of a parameter name in a sorted keyword table.
+ * return:  the type, or -1 if the name is not in the table
+ */
+int wfaCapiKeyword(typeNameStr_t *kwTbl, int kwNum, char *name)
+{
+    typeNameStr_t key, *kw;
+
+    if(strlen(name) >= sizeof(key.name))
+        return -1;
+
+    strcpy(key.name, name);
+    kw = (typeNameStr_t *)bsearch(&key, kwTbl, kwNum, sizeof(typeNameStr_t), wfaCapiKwCmp);
+
+    return (kw != NULL) ? kw->type : -1;
+}
+
+/* cut the string at the next comma, return what follows */
+static char *wfaCapiCut(char *p)
+{
+    while(*p != '\0' && *p != ',')
+        p++;
+
+    if(*p == ',')
+        *p++ = '\0';
+
+    return p;
+}
+
+/*
+ * wfaCapiParse(): split the parameters of a CAPI command into name and
+ *                 value pairs in one pass, cutting the string in place.
+ *                 A value may be empty, stray commas between pairs are
+ *                 skipped.
+ *  input:   pcmdStr -- the parameters, what follows the command name
+ *  input:   kwTbl, kwNum -- keyword table to type the names with
+ *  output:  parms
+ *  return:  number of pairs
+ */
+int wfaCapiParse(char *pcmdStr, typeNameStr_t *kwTbl, int kwNum, wfaCapiParms_t *parms)
+{
+    char *p = pcmdStr;
+    wfaCapiParm_t *parm;
+
+    parms->num = 0;
+    if(p == NULL)
+        return 0;
+
+    while(*p != '\0')
+    {
+        if(*p == ',')
+        {
+            p++;
+            continue;
+        }
+
+        if(parms->num == WFA_CAPI_MAX_PARMS)
+        {
+            DPRINT_WARNING(WFA_WNG, "more than %i parameters, rest ignored\n", WFA_CAPI_MAX_PARMS);
+            break;
+        }
+
+        parm = &parms->parm[parms->num++];
+        parm->key = p;
+        p = wfaCapiCut(p);
+        parm->val = p;
+        p = wfaCapiCut(p);
+        parm->type = wfaCapiKeyword(kwTbl, kwNum, parm->key);
+    }
+
+    return parms->num;
+}
+
+/*
+ * wfaCapiStrCpy(): copy a parameter value into a fixed size field, cut to
+ *                  the field and always terminated.
+ */
+void wfaCapiStrCpy(char *dst, int dstSize, char *val)
+{
+    if(dstSize <= 0)
+        return;
 
+    strncpy(dst, val, dstSize - 1);
+    dst[dstSize - 1] = '\0';
+}
 
 /*
  * cmdProcNotDefinedYet(): a dummy function
@@ -140,8 +354,6 @@ int cmdProcNotDefinedYet(char *pcmdStr, char *buf, int *len)
     return (WFA_SUCCESS);
 }
 
-extern unsigned short wfa_defined_debug;
-
 /*
  *  xcCmdProcGetVersion(): process the command get_version string from TM
  *                         to convert it into a internal format
@@ -163,314 +375,283 @@ int xcCmdProcGetVersion(char *pcmdStr, BYTE *aBuf, int *aLen)
 }
 
 /*
- *  xcCmdProcAgentConfig(): process the command traffic_agent_config string
- *                          from TM to convert it into a internal format
- *  input:        pcmdStr -- a string pointer to the command string
+ *  xcCmdProcProfile(): fill a traffic profile from the parameters of
+ *                      traffic_agent_config, one profile of a batch
+ *  input:        parm, num -- the parsed parameters of the profile
+ *  output:       pf -- profile, set to its defaults by the caller
  */
-int xcCmdProcAgentConfig(char *pcmdStr, BYTE *aBuf, int *aLen)
+static int xcCmdProcProfile(wfaCapiParm_t *parm, int num, tgProfile_t *pf)
 {
     char *str;
     int i = 0, j=0, kwcnt = 0;
-    wfaTLV *hdr = (wfaTLV *)aBuf;
-    tgProfile_t tgpf = {0, 0, "", -1, "", -1, 0, 0, 0, TG_WMM_AC_BE, 0, 0};
-    tgProfile_t *pf = &tgpf;
     int userPrio = 0;
 
-    DPRINT_INFO(WFA_OUT, "start xcCmdProcAgentConfig ...\n");
-    DPRINT_INFO(WFA_OUT, "params:  %s\n", pcmdStr);
-
-    if(aBuf == NULL)
-        return WFA_FAILURE;
-
-    while((str = strtok_r(NULL, ",", (char **)&pcmdStr)) != NULL)
+    for(i = 0; i < num; i++)
     {
-        for(i = 0; i<sizeof(keywordStr)/sizeof(typeNameStr_t); i++)
+        str = parm[i].val;
+
+        switch(parm[i].type)
         {
-            if(strcasecmp(str, keywordStr[i].name) == 0)
+        case  KW_PROFILE:
+            if(isString(str) == WFA_FAILURE)
             {
-                switch(keywordStr[i].type)
+                DPRINT_ERR(WFA_ERR, "Incorrect profile keyword format\n");
+                return WFA_FAILURE;
+            }
+
+            for(j = 0; j < PROF_LAST; j++)
+            {
+                if(strcasecmp(str, profileStr[j].name) == 0)
                 {
-                case  KW_PROFILE:
-                    str = strtok_r(NULL, ",", (char **)&pcmdStr);
-                    if(isString(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect profile keyword format\n");
-                        return WFA_FAILURE;
-                    }
+                    pf->profile = profileStr[j].type;
+                }
+            }
 
-                    for(j = 0; j < PROF_LAST; j++)
-                    {
-                        if(strcasecmp(str, profileStr[j].name) == 0)
-                        {
-                            pf->profile = profileStr[j].type;
-                        }
-                    }
+            DPRINT_INFO(WFA_OUT, "profile type %i\n", pf->profile);
+            kwcnt++;
+            break;
 
-                    DPRINT_INFO(WFA_OUT, "profile type %i\n", pf->profile);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_DIRECTION:
+            if(isString(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect direction keyword format\n");
+                return WFA_FAILURE;
+            }
 
-                case KW_DIRECTION:
-                    str = strtok_r(NULL, ",", (char **)&pcmdStr);
-                    if(isString(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect direction keyword format\n");
-                        return WFA_FAILURE;
-                    }
+            if(strcasecmp(str, "send") == 0)
+            {
+                pf->direction = DIRECT_SEND;
+            }
+            else if(strcasecmp(str, "receive") == 0)
+            {
+                pf->direction = DIRECT_RECV;
+            }
+            else if(strcasecmp(str, "bidirectional") == 0)
+            {
+                pf->direction = DIRECT_BIDIR;
+            }
+            else
+                printf("Don't know direction\n");
 
-                    if(strcasecmp(str, "send") == 0)
-                    {
-                        pf->direction = DIRECT_SEND;
-                    }
-                    else if(strcasecmp(str, "receive") == 0)
-                    {
-                        pf->direction = DIRECT_RECV;
-                    }
-                    else
-                        printf("Don't know direction\n");
+            DPRINT_INFO(WFA_OUT, "direction %i\n", pf->direction);
+            kwcnt++;
+            break;
 
-                    DPRINT_INFO(WFA_OUT, "direction %i\n", pf->direction);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_DIPADDR: /* dest ip address */
+            wfaCapiStrCpy(pf->dipaddr, sizeof(pf->dipaddr), str);
+            if(isIpV4Addr(pf->dipaddr) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect ipaddr format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "dipaddr %s\n", pf->dipaddr);
 
-                case KW_DIPADDR: /* dest ip address */
-                    memcpy(pf->dipaddr, strtok_r(NULL, ",", &pcmdStr), IPV4_ADDRESS_STRING_LEN);
-                    if(isIpV4Addr(pf->dipaddr) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect ipaddr format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "dipaddr %s\n", pf->dipaddr);
+            kwcnt++;
+            break;
 
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_DPORT:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect port number format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "dport %s\n", str);
+            pf->dport = atoi(str);
 
-                case KW_DPORT:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect port number format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "dport %s\n", str);
-                    pf->dport = atoi(str);
+            kwcnt++;
+            break;
 
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_SIPADDR:
+            wfaCapiStrCpy(pf->sipaddr, sizeof(pf->sipaddr), str);
 
-                case KW_SIPADDR:
-                    memcpy(pf->sipaddr, strtok_r(NULL, ",", &pcmdStr), IPV4_ADDRESS_STRING_LEN);
+            if(isIpV4Addr(pf->sipaddr) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect ipaddr format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "sipaddr %s\n", pf->sipaddr);
+            kwcnt++;
+            break;
 
-                    if(isIpV4Addr(pf->sipaddr) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect ipaddr format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "sipaddr %s\n", pf->sipaddr);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_SPORT:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect port number format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "sport %s\n", str);
+            pf->sport = atoi(str);
 
-                case KW_SPORT:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect port number format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "sport %s\n", str);
-                    pf->sport = atoi(str);
+            kwcnt++;
+            break;
 
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_FRATE:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect frame rate format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "framerate %s\n", str);
+            pf->rate = atoi(str);
+            kwcnt++;
+            break;
 
-                case KW_FRATE:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect frame rate format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "framerate %s\n", str);
-                    pf->rate = atoi(str);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_DURATION:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect duration format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "duration %s\n", str);
+            pf->duration = atoi(str);
+            kwcnt++;
+            break;
 
-                case KW_DURATION:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect duration format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "duration %s\n", str);
-                    pf->duration = atoi(str);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_PLOAD:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect payload format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "payload %s\n", str);
+            pf->pksize = atoi(str);
+            kwcnt++;
+            break;
 
-                case KW_PLOAD:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect payload format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "payload %s\n", str);
-                    pf->pksize = atoi(str);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_STARTDELAY:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect startDelay format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "startDelay %s\n", str);
+            pf->startdelay = atoi(str);
+            kwcnt++;
+            break;
 
-                case KW_STARTDELAY:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect startDelay format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "startDelay %s\n", str);
-                    pf->startdelay = atoi(str);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_MAXCNT:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect max count format\n");
+                return WFA_FAILURE;
+            }
+            pf->maxcnt = atoi(str);
+            kwcnt++;
+            break;
 
-                case KW_MAXCNT:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect max count format\n");
-                        return WFA_FAILURE;
-                    }
-                    pf->maxcnt = atoi(str);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_TCLASS:
+            // if user priority is used, tclass is ignored.
+            if(userPrio == 1)
+                break;
 
-                case KW_TCLASS:
-                    str = strtok_r(NULL, ",", &pcmdStr);
+            if(strcasecmp(str, "voice") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_VO;
+            }
+            else if(strcasecmp(str, "Video") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_VI;
+            }
+            else if(strcasecmp(str, "Background") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_BK;
+            }
+            else if(strcasecmp(str, "BestEffort") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_BE;
+            }
+            else
+            {
+                pf->trafficClass = TG_WMM_AC_BE;
+            }
 
-                    // if user priority is used, tclass is ignored.
-                    if(userPrio == 1)
-                        break;
+            kwcnt++;
+            break;
 
-                    if(strcasecmp(str, "voice") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_VO;
-                    }
-                    else if(strcasecmp(str, "Video") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_VI;
-                    }
-                    else if(strcasecmp(str, "Background") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_BK;
-                    }
-                    else if(strcasecmp(str, "BestEffort") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_BE;
-                    }
-                    else
-                    {
-                        pf->trafficClass = TG_WMM_AC_BE;
-                    }
+        case KW_USERPRIORITY:
+            if( strcasecmp(str, "6") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_UP6;
+            }
+            else if( strcasecmp(str, "7") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_UP7;
+            }
+            else if( strcasecmp(str, "5") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_UP5;
+            }
+            else if( strcasecmp(str, "4") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_UP4;
+            }
+            else if( strcasecmp(str, "1") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_UP1;
+            }
+            else if( strcasecmp(str, "2") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_UP2;
+            }
+            else if( strcasecmp(str, "0") == 0 )
+            {
+                pf->trafficClass = TG_WMM_AC_UP0;
+            }
+            else if( strcasecmp(str, "3") == 0)
+            {
+                pf->trafficClass = TG_WMM_AC_UP3;
+            }
 
-                    kwcnt++;
-                    str = NULL;
-                    break;
+            // if User Priority is used
+            userPrio = 1;
 
-                case KW_USERPRIORITY:
-                    str = strtok_r(NULL, ",", &pcmdStr);
+            kwcnt++;
+            break;
 
-                    if( strcasecmp(str, "6") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_UP6;
-                    }
-                    else if( strcasecmp(str, "7") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_UP7;
-                    }
-                    else if( strcasecmp(str, "5") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_UP5;
-                    }
-                    else if( strcasecmp(str, "4") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_UP4;
-                    }
-                    else if( strcasecmp(str, "1") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_UP1;
-                    }
-                    else if( strcasecmp(str, "2") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_UP2;
-                    }
-                    else if( strcasecmp(str, "0") == 0 )
-                    {
-                        pf->trafficClass = TG_WMM_AC_UP0;
-                    }
-                    else if( strcasecmp(str, "3") == 0)
-                    {
-                        pf->trafficClass = TG_WMM_AC_UP3;
-                    }
-
-                    // if User Priority is used
-                    userPrio = 1;
-
-                    kwcnt++;
-                    str = NULL;
-                    break;
-
-                case KW_STREAMID:
-                    kwcnt++;
-                    break;
+        case KW_STREAMID:
+            kwcnt++;
+            break;
 
-                case KW_NUMFRAME:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect numframe format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "num frame %s\n", str);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_NUMFRAME:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect numframe format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "num frame %s\n", str);
+            kwcnt++;
+            break;
 
-                case KW_USESYNCCLOCK:
-                    str = strtok_r(NULL, ",", &pcmdStr);
-                    if(isNumber(str) == WFA_FAILURE)
-                    {
-                        DPRINT_ERR(WFA_ERR, "Incorrect sync clock format\n");
-                        return WFA_FAILURE;
-                    }
-                    DPRINT_INFO(WFA_OUT, "sync clock %s\n", str);
-                    kwcnt++;
-                    str = NULL;
-                    break;
+        case KW_USESYNCCLOCK:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect sync clock format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "sync clock %s\n", str);
+            kwcnt++;
+            break;
 
-                case KW_TAGNAME:
-                    str=strtok_r(NULL,",",&pcmdStr);
-                    strncpy(pf->WmmpsTagName,str,strlen(str));
-                    printf("Got name %s\n",pf->WmmpsTagName);
-                    break;
+        case KW_TAGNAME:
+            wfaCapiStrCpy(pf->WmmpsTagName, sizeof(pf->WmmpsTagName), str);
+            printf("Got name %s\n",pf->WmmpsTagName);
+            break;
 
-                default:
-                    ;
-                } /* switch */
+        case KW_WINDOW:
+            if(isNumber(str) == WFA_FAILURE)
+            {
+                DPRINT_ERR(WFA_ERR, "Incorrect window format\n");
+                return WFA_FAILURE;
+            }
+            DPRINT_INFO(WFA_OUT, "window %s\n", str);
+            pf->window = atoi(str);
+            kwcnt++;
+            break;
 
-                if(str==NULL)
-                    break;
-            }  /* if */
-        } /* for */
-    } /* while */
+        default:
+            ;
+        } /* switch */
+    } /* for */
 
 #if 0
     if(kwcnt < 8)
@@ -480,6 +661,32 @@ int xcCmdProcAgentConfig(char *pcmdStr, BYTE *aBuf, int *aLen)
     }
 #endif
 
+    return WFA_SUCCESS;
+}
+
+/*
+ *  xcCmdProcAgentConfig(): process the command traffic_agent_config string
+ *                          from TM to convert it into a internal format
+ *  input:        pcmdStr -- a string pointer to the command string
+ */
+int xcCmdProcAgentConfig(char *pcmdStr, BYTE *aBuf, int *aLen)
+{
+    wfaTLV *hdr = (wfaTLV *)aBuf;
+    tgProfile_t tgpf = {0, 0, "", -1, "", -1, 0, 0, 0, TG_WMM_AC_BE, 0, 0};
+    tgProfile_t *pf = &tgpf;
+    wfaCapiParms_t parms;
+
+    DPRINT_INFO(WFA_OUT, "start xcCmdProcAgentConfig ...\n");
+    DPRINT_INFO(WFA_OUT, "params:  %s\n", pcmdStr);
+
+    if(aBuf == NULL)
+        return WFA_FAILURE;
+
+    wfaCapiParse(pcmdStr, keywordStr, KEYWORD_NUM, &parms);
+
+    if(xcCmdProcProfile(parms.parm, parms.num, pf) != WFA_SUCCESS)
+        return WFA_FAILURE;
+
     printProfile(pf);
     hdr->tag =  WFA_TRAFFIC_AGENT_CONFIG_TLV;
     hdr->len = sizeof(tgProfile_t);
@@ -492,59 +699,156 @@ int xcCmdProcAgentConfig(char *pcmdStr, BYTE *aBuf, int *aLen)
 }
 
 /*
- * xcCmdProcAgentSend(): Process and send the Control command
- *                       "traffic_agent_send"
- * input - pcmdStr  parameter string pointer
- * return - WFA_SUCCESS or WFA_FAILURE;
+ *  xcCmdProcAgentConfigBatch(): process the command
+ *                          traffic_agent_config_batch, the parameters of
+ *                          traffic_agent_config for several streams, each
+ *                          one starting with its "profile". All of them
+ *                          go to the DUT in one TLV.
+ *  input:        pcmdStr -- a string pointer to the command string
  */
-int xcCmdProcAgentSend(char *pcmdStr, BYTE *aBuf, int *aLen)
+int xcCmdProcAgentConfigBatch(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     wfaTLV *hdr = (wfaTLV *)aBuf;
-    char *str, *sid;
-    int strid;
-    int id_cnt = 0;
+    tgProfile_t tgpf = {0, 0, "", -1, "", -1, 0, 0, 0, TG_WMM_AC_BE, 0, 0};
+    tgProfile_t *pf = (tgProfile_t *)(aBuf+4);
+    wfaCapiParms_t parms;
+    wfaCapiParm_t parm;
+    char *p = pcmdStr;
+    int num = 0, end;
 
-    if(aBuf == NULL)
-        return WFA_FAILURE;
+    DPRINT_INFO(WFA_OUT, "start xcCmdProcAgentConfigBatch ...\n");
 
-    memset(aBuf, 0, 512);
+    if(aBuf == NULL || p == NULL)
+        return WFA_FAILURE;
 
-    DPRINT_INFO(WFA_OUT, "Entering xcCmdProcAgentSend ...\n");
-    /* there is only one stream for baseline. Will support
-     * multiple streams later.
+    /*
+     * the whole command has more pairs than one parse holds, so the
+     * pairs are cut here and handed over a profile at a time
      */
-    str = strtok_r(NULL, ",", &pcmdStr);
+    parms.num = 0;
+    for(;;)
+    {
+        while(*p == ',')
+            p++;
 
-    if(str == NULL || str[0] == '\0')
+        end = (*p == '\0');
+        if(!end)
+        {
+            parm.key = p;
+            p = wfaCapiCut(p);
+            parm.val = p;
+            p = wfaCapiCut(p);
+            parm.type = wfaCapiKeyword(keywordStr, KEYWORD_NUM, parm.key);
+        }
+
+        if((end || parm.type == KW_PROFILE) && parms.num > 0)
+        {
+            if(num == WFA_TG_MAX_BATCH || 4+(num+1)*sizeof(tgProfile_t) > *aLen)
+            {
+                DPRINT_ERR(WFA_ERR, "more than %i profiles\n", num);
+                return WFA_FAILURE;
+            }
+
+            memcpy(&pf[num], &tgpf, sizeof(tgProfile_t));
+            if(xcCmdProcProfile(parms.parm, parms.num, &pf[num]) != WFA_SUCCESS ||
+                    pf[num].profile == 0)
+            {
+                DPRINT_ERR(WFA_ERR, "profile %i incorrect\n", num+1);
+                return WFA_FAILURE;
+            }
+
+            num++;
+            parms.num = 0;
+        }
+
+        if(end)
+            break;
+
+        if(parms.num == WFA_CAPI_MAX_PARMS)
+        {
+            DPRINT_ERR(WFA_ERR, "profile %i has too many parameters\n", num+1);
+            return WFA_FAILURE;
+        }
+        parms.parm[parms.num++] = parm;
+    }
+
+    if(num == 0)
         return WFA_FAILURE;
 
-    /* take the stream ids */
-    if(strcasecmp(str, "streamid") != 0)
+    hdr->tag = WFA_TRAFFIC_AGENT_CONFIG_BATCH_TLV;
+    hdr->len = num*sizeof(tgProfile_t);
+
+    *aLen = 4+hdr->len;
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * xcCmdProcStreamIds(): put the space separated ids of the "streamid"
+ *                       parameter after the TLV header
+ * return - number of ids, or -1 if the command has no streamid
+ */
+static int xcCmdProcStreamIds(char *pcmdStr, BYTE *aBuf)
+{
+    wfaCapiParms_t parms;
+    char *sid, *ids;
+    int strid;
+    int id_cnt = 0;
+
+    if(wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms) == 0)
+        return -1;
+
+    /* there is only one stream for baseline. Will support
+     * multiple streams later.
+     */
+    if(parms.parm[0].type != CAPI_KW_STREAMID)
     {
         DPRINT_ERR(WFA_ERR, "invalid type name\n");
-        return WFA_FAILURE;
+        return -1;
     }
 
     /*
      * To handle there are multiple stream ids such as WMM
      */
-    while(1)
+    ids = parms.parm[0].val;
+    while((sid = strtok_r(NULL, " ", &ids)) != NULL)
     {
-        sid = strtok_r (NULL, " ", &pcmdStr);
-        if(sid == NULL)
-            break;
-
-        printf("sid %s\n", sid);
         if(isNumber(sid) == WFA_FAILURE)
             continue;
 
+        if(id_cnt == WFA_CAPI_MAX_PARMS)
+            break;
+
         strid = atoi(sid);
-        printf("id %i\n", strid);
         id_cnt++;
 
         memcpy(aBuf+4*id_cnt, (char *)&strid, 4);
     }
 
+    return id_cnt;
+}
+
+/*
+ * xcCmdProcAgentSend(): Process and send the Control command
+ *                       "traffic_agent_send"
+ * input - pcmdStr  parameter string pointer
+ * return - WFA_SUCCESS or WFA_FAILURE;
+ */
+int xcCmdProcAgentSend(char *pcmdStr, BYTE *aBuf, int *aLen)
+{
+    wfaTLV *hdr = (wfaTLV *)aBuf;
+    int id_cnt;
+
+    if(aBuf == NULL)
+        return WFA_FAILURE;
+
+    memset(aBuf, 0, 512);
+
+    DPRINT_INFO(WFA_OUT, "Entering xcCmdProcAgentSend ...\n");
+
+    if((id_cnt = xcCmdProcStreamIds(pcmdStr, aBuf)) < 0)
+        return WFA_FAILURE;
+
     hdr->tag =  WFA_TRAFFIC_AGENT_SEND_TLV;
     hdr->len = 4*id_cnt;  /* multiple 4s if more streams */
 
@@ -590,58 +894,71 @@ int xcCmdProcAgentReset(char *pcmdStr, BYTE *aBuf, int *aLen)
 }
 
 /*
- * xcCmdProcAgentRecvStart(): Process and send the Control command
- *                       "traffic_agent_receive_start"
+ * xcCmdProcAgentStatus(): Process and send the Control command
+ *                       "traffic_agent_status", the report period of
+ *                       the running streams in msec, 0 to stop
  * input - pcmdStr  parameter string pointer
  * return - WFA_SUCCESS or WFA_FAILURE;
  */
-int xcCmdProcAgentRecvStart(char *pcmdStr, BYTE *aBuf, int *aLen)
+int xcCmdProcAgentStatus(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
-
     wfaTLV *hdr = (wfaTLV *)aBuf;
-    char *str, *sid;
-    int strid;
-    int id_cnt = 0;
+    tgStatusReq_t *req = (tgStatusReq_t *)(aBuf+sizeof(wfaTLV));
+    wfaCapiParms_t parms;
+    int i, found = 0;
 
-    DPRINT_INFO(WFA_OUT, "Entering xcCmdProcAgentRecvStart ...%s\n", pcmdStr);
+    DPRINT_INFO(WFA_OUT, "Entering xcCmdProcAgentStatus ...\n");
 
     if(aBuf == NULL)
         return WFA_FAILURE;
 
     memset(aBuf, 0, *aLen);
 
-    /* there is only one stream for baseline. Will support
-     * multiple streams later.
-     */
-    str = strtok_r(NULL, ",", &pcmdStr);
-
-    if(str == NULL || str[0] == '\0')
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+    for(i = 0; i < parms.num; i++)
     {
-        DPRINT_ERR(WFA_ERR, "Null string\n");
-        return WFA_FAILURE;
-    }
+        if(parms.parm[i].type == CAPI_KW_INTERVAL)
+        {
+            if(isNumber(parms.parm[i].val) == WFA_FAILURE)
+                return WFA_FAILURE;
 
+            req->periodMs = atoi(parms.parm[i].val);
+            found = 1;
+        }
+    }
 
-    if(strcasecmp(str, "streamid") != 0)
-    {
-        DPRINT_ERR(WFA_ERR, "invalid type name\n");
+    if(!found)
         return WFA_FAILURE;
-    }
 
-    while(1)
-    {
-        sid = strtok_r (NULL, " ", &pcmdStr);
-        if(sid == NULL)
-            break;
+    hdr->tag =  WFA_TRAFFIC_AGENT_STATUS_TLV;
+    hdr->len = sizeof(tgStatusReq_t);
 
-        if(isNumber(sid) == WFA_FAILURE)
-            continue;
+    *aLen = 4+sizeof(tgStatusReq_t);
 
-        strid = atoi(sid);
-        id_cnt++;
+    return WFA_SUCCESS;
+}
 
-        memcpy(aBuf+4*id_cnt, (char *)&strid, 4);
-    }
+/*
+ * xcCmdProcAgentRecvStart(): Process and send the Control command
+ *                       "traffic_agent_receive_start"
+ * input - pcmdStr  parameter string pointer
+ * return - WFA_SUCCESS or WFA_FAILURE;
+ */
+int xcCmdProcAgentRecvStart(char *pcmdStr, BYTE *aBuf, int *aLen)
+{
+
+    wfaTLV *hdr = (wfaTLV *)aBuf;
+    int id_cnt;
+
+    DPRINT_INFO(WFA_OUT, "Entering xcCmdProcAgentRecvStart ...%s\n", pcmdStr);
+
+    if(aBuf == NULL)
+        return WFA_FAILURE;
+
+    memset(aBuf, 0, *aLen);
+
+    if((id_cnt = xcCmdProcStreamIds(pcmdStr, aBuf)) < 0)
+        return WFA_FAILURE;
 
     hdr->tag =  WFA_TRAFFIC_AGENT_RECV_START_TLV;
     hdr->len = 4*id_cnt;  /* multiple 4s if more streams */
@@ -669,9 +986,7 @@ int xcCmdProcAgentRecvStart(char *pcmdStr, BYTE *aBuf, int *aLen)
 int xcCmdProcAgentRecvStop(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     wfaTLV *hdr = (wfaTLV *)aBuf;
-    char *str, *sid;
-    int strid;
-    int id_cnt = 0;
+    int id_cnt;
 
     DPRINT_INFO(WFA_OUT, "Entering xcCmdProcAgentRecvStop ...\n");
 
@@ -680,33 +995,8 @@ int xcCmdProcAgentRecvStop(char *pcmdStr, BYTE *aBuf, int *aLen)
 
     memset(aBuf, 0, *aLen);
 
-    /* there is only one stream for baseline. Will support
-     * multiple streams later.
-     */
-    str = strtok_r(NULL, ",", &pcmdStr);
-
-    if(str == NULL || str[0] == '\0')
-        return WFA_FAILURE;
-
-    if(strcasecmp(str, "streamid") != 0)
-    {
-        DPRINT_ERR(WFA_ERR, "invalid type name\n");
+    if((id_cnt = xcCmdProcStreamIds(pcmdStr, aBuf)) < 0)
         return WFA_FAILURE;
-    }
-    while(1)
-    {
-        sid = strtok_r (NULL, " ", &pcmdStr);
-        if(sid == NULL)
-            break;
-
-        if(isNumber(sid) == WFA_FAILURE)
-            continue;
-
-        strid = atoi(sid);
-        id_cnt++;
-
-        memcpy(aBuf+4*id_cnt, (char *)&strid, 4);
-    }
 
     hdr->tag =  WFA_TRAFFIC_AGENT_RECV_STOP_TLV;
     hdr->len = 4*id_cnt;  /* multiple 4s if more streams */
@@ -720,67 +1010,61 @@ int xcCmdProcAgentSendPing(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     wfaTLV *hdr = (wfaTLV *)aBuf;
     tgPingStart_t *staping = (tgPingStart_t *) (aBuf+sizeof(wfaTLV));
+    wfaCapiParms_t parms;
     char *str;
-    staping->type = 0;
+    int i;
 
     if(aBuf == NULL)
         return WFA_FAILURE;
 
     memset(aBuf, 0, *aLen);
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "destination") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(staping->dipaddr, str, 39);
+        case CAPI_KW_DESTINATION:
+            wfaCapiStrCpy(staping->dipaddr, sizeof(staping->dipaddr), str);
             DPRINT_INFO(WFA_OUT, "destination %s ", staping->dipaddr);
-        }
-        if(strcasecmp(str, "frameSize") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_FRAMESIZE:
             staping->frameSize=atoi(str);
             DPRINT_INFO(WFA_OUT, "framesize %i ", staping->frameSize);
-        }
-        if(strcasecmp(str, "frameRate") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_FRAMERATE:
             staping->frameRate=atof(str);
             DPRINT_INFO(WFA_OUT, "framerate %f ", staping->frameRate);
-        }
-        if(strcasecmp(str, "duration") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_DURATION:
             staping->duration=atoi(str);
             DPRINT_INFO(WFA_OUT, "duration %i \n", staping->duration);
-        }
-        if(strcasecmp(str, "type") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_TYPE:
             if(strcasecmp(str, "udp") == 0)
                 staping->type = 1;
             else
                 staping->type = 0;
-        }
-        if(strcasecmp(str, "iptype") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_IPTYPE:
             staping->iptype=atoi(str);
             DPRINT_INFO(WFA_OUT, "iptype %i \n", staping->iptype);
-        }
-        if(strcasecmp(str, "dscp") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_DSCP:
             staping->dscp=atoi(str);
             DPRINT_INFO(WFA_OUT, "dscp %i\n", staping->dscp);
-        }
-        if(strcasecmp(str, "qos") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_QOS:
             if(strcasecmp(str, "vo") == 0)
             {
                 staping->qos = TG_WMM_AC_VO;
@@ -802,6 +1086,10 @@ int xcCmdProcAgentSendPing(char *pcmdStr, BYTE *aBuf, int *aLen)
                 // be
                 staping->qos = TG_WMM_AC_BE;
             }
+            break;
+
+        default:
+            ;
         }
     }
 
@@ -816,30 +1104,27 @@ int xcCmdProcAgentSendPing(char *pcmdStr, BYTE *aBuf, int *aLen)
 int xcCmdProcAgentStopPing(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     wfaTLV *hdr = (wfaTLV *)aBuf;
-    char *str;
+    wfaCapiParms_t parms;
     int strid;
-    str = strtok_r(NULL, ",", &pcmdStr);
 
     if(aBuf == NULL)
         return WFA_FAILURE;
 
     memset(aBuf, 0, *aLen);
 
-    if(str == NULL || str[0] == '\0')
+    if(wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms) == 0)
         return WFA_FAILURE;
 
-    if(strcasecmp(str, "streamid") == 0)
-        str = strtok_r(NULL, ",", &pcmdStr);
-    else
+    if(parms.parm[0].type != CAPI_KW_STREAMID)
     {
         DPRINT_ERR(WFA_ERR, "invalid type name\n");
         return WFA_FAILURE;
     }
 
-    if(isNumber(str) == WFA_FAILURE)
+    if(isNumber(parms.parm[0].val) == WFA_FAILURE)
         return WFA_FAILURE;
 
-    strid = atoi(str);
+    strid = atoi(parms.parm[0].val);
 
     memcpy(aBuf+4, (char *)&strid, 4);
 
@@ -885,7 +1170,9 @@ int xcCmdProcStaSetIpConfig(char *pcmdStr, BYTE *aBuf, int *aLen)
     dutCommand_t staSetIpConfig;
     caStaSetIpConfig_t *setip = (caStaSetIpConfig_t *)&staSetIpConfig.cmdsu.ipconfig;
     caStaSetIpConfig_t defparams = {"", 0, "", "", "", "", ""};
+    wfaCapiParms_t parms;
     char *str;
+    int i;
 
     if(aBuf == NULL)
         return WFA_FAILURE;
@@ -893,57 +1180,51 @@ int xcCmdProcStaSetIpConfig(char *pcmdStr, BYTE *aBuf, int *aLen)
     memset(aBuf, 0, *aLen);
     memcpy(setip, &defparams, sizeof(caStaSetIpConfig_t));
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "interface") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setip->intf, str, 15);
+        case CAPI_KW_INTERFACE:
+            wfaCapiStrCpy(setip->intf, sizeof(setip->intf), str);
             DPRINT_INFO(WFA_OUT, "interface %s\n", setip->intf);
-        }
-        else if(strcasecmp(str, "dhcp") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_DHCP:
             setip->isDhcp = atoi(str);
             DPRINT_INFO(WFA_OUT, "dhcp %i\n", setip->isDhcp);
-        }
-        else if(strcasecmp(str, "ip") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setip->ipaddr, str, 15);
+            break;
+
+        case CAPI_KW_IP:
+            wfaCapiStrCpy(setip->ipaddr, sizeof(setip->ipaddr), str);
             DPRINT_INFO(WFA_OUT, "ip %s\n", setip->ipaddr);
-        }
-        else if(strcasecmp(str, "mask") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setip->mask, str, 15);
+            break;
+
+        case CAPI_KW_MASK:
+            wfaCapiStrCpy(setip->mask, sizeof(setip->mask), str);
             DPRINT_INFO(WFA_OUT, "mask %s\n", setip->mask);
-        }
-        else if(strcasecmp(str, "defaultGateway") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setip->defGateway, str, 15);
+            break;
+
+        case CAPI_KW_DEFGATEWAY:
+            wfaCapiStrCpy(setip->defGateway, sizeof(setip->defGateway), str);
             DPRINT_INFO(WFA_OUT, "gw %s\n", setip->defGateway);
-        }
-        else if(strcasecmp(str, "primary-dns") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setip->pri_dns, str, 15);
+            break;
+
+        case CAPI_KW_PRIDNS:
+            wfaCapiStrCpy(setip->pri_dns, sizeof(setip->pri_dns), str);
             DPRINT_INFO(WFA_OUT, "dns p %s\n", setip->pri_dns);
-        }
-        else if(strcasecmp(str, "secondary-dns") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setip->sec_dns, str, 15);
+            break;
+
+        case CAPI_KW_SECDNS:
+            wfaCapiStrCpy(setip->sec_dns, sizeof(setip->sec_dns), str);
             DPRINT_INFO(WFA_OUT, "dns s %s\n", setip->sec_dns);
-        }
-        else
-        {
-            DPRINT_ERR(WFA_ERR, "invalid command %s\n",str);
+            break;
+
+        default:
+            DPRINT_ERR(WFA_ERR, "invalid command %s\n", parms.parm[i].key);
             return WFA_FAILURE;
         }
     }
@@ -1160,7 +1441,9 @@ int xcCmdProcStaGetStats(char *pcmdStr, BYTE *aBuf, int *aLen)
 int  xcCmdProcStaSetEncryption(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     caStaSetEncryption_t *setencryp = (caStaSetEncryption_t *) (aBuf+sizeof(wfaTLV));
+    wfaCapiParms_t parms;
     char *str;
+    int i;
     caStaSetEncryption_t defparams = {"", "", 0, {"", "", "", ""}, 0};
 
     if(aBuf == NULL)
@@ -1169,62 +1452,48 @@ int  xcCmdProcStaSetEncryption(char *pcmdStr, BYTE *aBuf, int *aLen)
     memset(aBuf, 0, *aLen);
     memcpy((void *)setencryp, (void *)&defparams, sizeof(caStaSetEncryption_t));
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "interface") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setencryp->intf, str, 15);
-        }
-        else if(strcasecmp(str, "ssid") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setencryp->ssid, str, 64);
-        }
-        else if(strcasecmp(str, "encpType") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+        case CAPI_KW_INTERFACE:
+            wfaCapiStrCpy(setencryp->intf, sizeof(setencryp->intf), str);
+            break;
+
+        case CAPI_KW_SSID:
+            wfaCapiStrCpy(setencryp->ssid, sizeof(setencryp->ssid), str);
+            break;
+
+        case CAPI_KW_ENCPTYPE:
             if(strcasecmp(str, "wep") == 0)
                 setencryp->encpType = ENCRYPT_WEP;
             else
                 setencryp->encpType = 0;
-        }
-        else if(strcasecmp(str, "key1") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy((char *)setencryp->keys[0], str, 26);
-            DPRINT_INFO(WFA_OUT, "%s\n", setencryp->keys[0]);
-            setencryp->activeKeyIdx = 0;
-        }
-        else if(strcasecmp(str, "key2") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy((char *)setencryp->keys[1], str, 26);
-            DPRINT_INFO(WFA_OUT, "%s\n", setencryp->keys[1]);
-        }
-        else if(strcasecmp(str, "key3") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy((char *)setencryp->keys[2], str, 26);
-            DPRINT_INFO(WFA_OUT, "%s\n", setencryp->keys[2]);
-        }
-        else if(strcasecmp(str, "key4") == 0)
+            break;
+
+        case CAPI_KW_KEY1:
+        case CAPI_KW_KEY2:
+        case CAPI_KW_KEY3:
+        case CAPI_KW_KEY4:
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy((char *)setencryp->keys[3], str, 26);
-            DPRINT_INFO(WFA_OUT, "%s\n", setencryp->keys[3]);
+            int k = parms.parm[i].type - CAPI_KW_KEY1;
+
+            wfaCapiStrCpy((char *)setencryp->keys[k], sizeof(setencryp->keys[k]), str);
+            DPRINT_INFO(WFA_OUT, "%s\n", setencryp->keys[k]);
+            if(k == 0)
+                setencryp->activeKeyIdx = 0;
+            break;
         }
-        else if(strcasecmp(str, "activeKey") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+
+        case CAPI_KW_ACTIVEKEY:
             setencryp->activeKeyIdx =  atoi(str);
-        }
-        else
-        {
+            break;
+
+        default:
             DPRINT_INFO(WFA_WNG, "Incorrect Command, check syntax\n");
         }
     }
@@ -1336,7 +1605,9 @@ int xcCmdProcStaSetPSK(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     caStaSetPSK_t *setencryp = (caStaSetPSK_t *) (aBuf+sizeof(wfaTLV));
 #ifndef WFA_PC_CONSOLE
+    wfaCapiParms_t parms;
     char *str;
+    int i;
     caStaSetPSK_t defparams = {"", "", "", "", 0, WFA_DISABLED};
 
     if(aBuf == NULL)
@@ -1345,48 +1616,41 @@ int xcCmdProcStaSetPSK(char *pcmdStr, BYTE *aBuf, int *aLen)
     memset(aBuf, 0, *aLen);
     memcpy((void *)setencryp, (void *)&defparams, sizeof(caStaSetPSK_t));
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "interface") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setencryp->intf, str, 15);
-        }
-        else if(strcasecmp(str, "ssid") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setencryp->ssid, str, 64);
+        case CAPI_KW_INTERFACE:
+            wfaCapiStrCpy(setencryp->intf, sizeof(setencryp->intf), str);
+            break;
+
+        case CAPI_KW_SSID:
+            wfaCapiStrCpy(setencryp->ssid, sizeof(setencryp->ssid), str);
             DPRINT_INFO(WFA_OUT, "ssid %s\n", setencryp->ssid);
-        }
-        else if(strcasecmp(str, "passPhrase") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy((char *)setencryp->passphrase, str, 63);
-        }
-        else if(strcasecmp(str, "keyMgmtType") == 0)
-        {
-            str=strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setencryp->keyMgmtType, str, 15);
-        }
-        else if(strcasecmp(str, "encpType") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_PASSPHRASE:
+            wfaCapiStrCpy((char *)setencryp->passphrase, sizeof(setencryp->passphrase), str);
+            break;
+
+        case CAPI_KW_KEYMGMTTYPE:
+            wfaCapiStrCpy(setencryp->keyMgmtType, sizeof(setencryp->keyMgmtType), str);
+            break;
 
+        case CAPI_KW_ENCPTYPE:
             if(strcasecmp(str, "tkip") == 0)
                 setencryp->encpType = ENCRYPT_TKIP;
             else if(strcasecmp(str, "aes-ccmp") == 0)
                 setencryp->encpType = ENCRYPT_AESCCMP;
             else if (strcasecmp(str, "aes-ccmp-tkip") == 0)
                 setencryp->encpType = ENCRYPT_AESCCMP_TKIP;
-        }
-        else if(strcasecmp(str, "pmf") == 0)
-        {
-            str = strtok_r (NULL, ",", &pcmdStr);
+            break;
 
+        case CAPI_KW_PMF:
             if(strcasecmp(str, "enable") == 0
                     || strcasecmp(str, "optional") == 0)
                 setencryp->pmf = WFA_ENABLED;
@@ -1394,24 +1658,25 @@ int xcCmdProcStaSetPSK(char *pcmdStr, BYTE *aBuf, int *aLen)
                 setencryp->pmf = WFA_REQUIRED;
             else
                 setencryp->pmf = WFA_DISABLED;
-        }
-        else if (strcasecmp(str, "micAlg") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_MICALG:
             if (strcasecmp(str, "SHA-1") != 0)
-                strncpy(setencryp->micAlg, str, 15);
+                wfaCapiStrCpy(setencryp->micAlg, sizeof(setencryp->micAlg), str);
             else
-                strncpy(setencryp->micAlg, "SHA-1", 15);
-        }
-        else if (strcasecmp(str, "Prog") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setencryp->prog, str, 15);
-        }
-        else if (strcasecmp(str, "Prefer") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+                wfaCapiStrCpy(setencryp->micAlg, sizeof(setencryp->micAlg), "SHA-1");
+            break;
+
+        case CAPI_KW_PROG:
+            wfaCapiStrCpy(setencryp->prog, sizeof(setencryp->prog), str);
+            break;
+
+        case CAPI_KW_PREFER:
             setencryp->prefer = (atoi(str) == 1)?1:0;
+            break;
+
+        default:
+            ;
         }
     }
 #endif
@@ -1426,7 +1691,9 @@ int xcCmdProcStaSetEapTLS(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     caStaSetEapTLS_t *setsec = (caStaSetEapTLS_t *) (aBuf+sizeof(wfaTLV));
 #ifndef WFA_PC_CONSOLE
+    wfaCapiParms_t parms;
     char *str;
+    int i;
     caStaSetEapTLS_t defparams = {"", "", "", "", "", "", "", 0, ""};
 
     if(aBuf == NULL)
@@ -1435,51 +1702,43 @@ int xcCmdProcStaSetEapTLS(char *pcmdStr, BYTE *aBuf, int *aLen)
     memset(aBuf, 0, *aLen);
     memcpy((void *)setsec, (void *)&defparams, sizeof(caStaSetEapTLS_t));
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "interface") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->intf, str, 15);
-        }
-        else if(strcasecmp(str, "ssid") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->ssid, str, 64);
-        }
-        else if(strcasecmp(str, "username") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->username, str);
-        }
-        else if(strcasecmp(str, "keyMgmtType") == 0)
-        {
-            str=strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->keyMgmtType, str, 8);
-        }
-        else if(strcasecmp(str, "encpType") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->encrptype, str, 8);
-        }
-        else if(strcasecmp(str, "trustedRootCA") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->trustedRootCA, str);
-        }
-        else if(strcasecmp(str, "clientCertificate") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->clientCertificate, str);
-        }
-        else if(strcasecmp(str, "pmf") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r (NULL, ",", &pcmdStr);
+        case CAPI_KW_INTERFACE:
+            wfaCapiStrCpy(setsec->intf, sizeof(setsec->intf), str);
+            break;
 
+        case CAPI_KW_SSID:
+            wfaCapiStrCpy(setsec->ssid, sizeof(setsec->ssid), str);
+            break;
+
+        case CAPI_KW_USERNAME:
+            wfaCapiStrCpy(setsec->username, sizeof(setsec->username), str);
+            break;
+
+        case CAPI_KW_KEYMGMTTYPE:
+            wfaCapiStrCpy(setsec->keyMgmtType, sizeof(setsec->keyMgmtType), str);
+            break;
+
+        case CAPI_KW_ENCPTYPE:
+            wfaCapiStrCpy(setsec->encrptype, sizeof(setsec->encrptype), str);
+            break;
+
+        case CAPI_KW_TRUSTEDROOTCA:
+            wfaCapiStrCpy(setsec->trustedRootCA, sizeof(setsec->trustedRootCA), str);
+            break;
+
+        case CAPI_KW_CLIENTCERT:
+            wfaCapiStrCpy(setsec->clientCertificate, sizeof(setsec->clientCertificate), str);
+            break;
+
+        case CAPI_KW_PMF:
             if(strcasecmp(str, "enable") == 0
                     || strcasecmp(str, "optional") == 0)
                 setsec->pmf = WFA_ENABLED;
@@ -1491,14 +1750,17 @@ int xcCmdProcStaSetEapTLS(char *pcmdStr, BYTE *aBuf, int *aLen)
                 setsec->pmf = WFA_F_DISABLED;
             else
                 setsec->pmf = WFA_DISABLED;
-        }
-        else if(strcasecmp(str, "micAlg") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_MICALG:
             if(strcasecmp(str, "SHA-1") != 0)
-                strncpy(setsec->micAlg, str, 15);
+                wfaCapiStrCpy(setsec->micAlg, sizeof(setsec->micAlg), str);
             else
-                strncpy(setsec->micAlg, "SHA-1", 15);
+                wfaCapiStrCpy(setsec->micAlg, sizeof(setsec->micAlg), "SHA-1");
+            break;
+
+        default:
+            ;
         }
     }
 
@@ -1515,7 +1777,9 @@ int xcCmdProcStaSetEapTTLS(char *pcmdStr, BYTE *aBuf, int *aLen)
     caStaSetEapTTLS_t *setsec = (caStaSetEapTTLS_t *) (aBuf+sizeof(wfaTLV));
 #ifndef WFA_PC_CONSOLE
     caStaSetEapTTLS_t defparams = {"", "", "", "", "", "", "", ""};
+    wfaCapiParms_t parms;
     char *str;
+    int i;
 
     if(aBuf == NULL)
         return WFA_FAILURE;
@@ -1523,56 +1787,47 @@ int xcCmdProcStaSetEapTTLS(char *pcmdStr, BYTE *aBuf, int *aLen)
     memset(aBuf, 0, *aLen);
     memcpy((void *)setsec, (void *)&defparams, sizeof(caStaSetEapTTLS_t));
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "interface") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->intf, str, 15);
-        }
-        else if(strcasecmp(str, "ssid") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->ssid, str, 64);
-        }
-        else if(strcasecmp(str, "username") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->username, str);
-        }
-        else if(strcasecmp(str, "password") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->passwd, str);
-        }
-        else if(strcasecmp(str, "keyMgmtType") == 0)
-        {
-            str=strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->keyMgmtType, str, 7);
-        }
-        else if(strcasecmp(str, "encpType") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->encrptype, str, 8);
-        }
-        else if(strcasecmp(str, "trustedRootCA") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->trustedRootCA, str);
-        }
-        else if(strcasecmp(str, "clientCertificate") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->clientCertificate, str);
-        }
-        else if(strcasecmp(str, "pmf") == 0)
-        {
-            str = strtok_r (NULL, ",", &pcmdStr);
+        case CAPI_KW_INTERFACE:
+            wfaCapiStrCpy(setsec->intf, sizeof(setsec->intf), str);
+            break;
+
+        case CAPI_KW_SSID:
+            wfaCapiStrCpy(setsec->ssid, sizeof(setsec->ssid), str);
+            break;
+
+        case CAPI_KW_USERNAME:
+            wfaCapiStrCpy(setsec->username, sizeof(setsec->username), str);
+            break;
+
+        case CAPI_KW_PASSWORD:
+            wfaCapiStrCpy(setsec->passwd, sizeof(setsec->passwd), str);
+            break;
+
+        case CAPI_KW_KEYMGMTTYPE:
+            wfaCapiStrCpy(setsec->keyMgmtType, sizeof(setsec->keyMgmtType), str);
+            break;
 
+        case CAPI_KW_ENCPTYPE:
+            wfaCapiStrCpy(setsec->encrptype, sizeof(setsec->encrptype), str);
+            break;
+
+        case CAPI_KW_TRUSTEDROOTCA:
+            wfaCapiStrCpy(setsec->trustedRootCA, sizeof(setsec->trustedRootCA), str);
+            break;
+
+        case CAPI_KW_CLIENTCERT:
+            wfaCapiStrCpy(setsec->clientCertificate, sizeof(setsec->clientCertificate), str);
+            break;
+
+        case CAPI_KW_PMF:
             if(strcasecmp(str, "enable") == 0
                     || strcasecmp(str, "optional") == 0)
                 setsec->pmf = WFA_ENABLED;
@@ -1580,24 +1835,25 @@ int xcCmdProcStaSetEapTTLS(char *pcmdStr, BYTE *aBuf, int *aLen)
                 setsec->pmf = WFA_REQUIRED;
             else
                 setsec->pmf = WFA_DISABLED;
-        }
-        else if (strcasecmp(str, "micALg") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_MICALG:
             if (strcasecmp(str, "SHA-1") != 0)
-                strncpy(setsec->micAlg, str, 15);
+                wfaCapiStrCpy(setsec->micAlg, sizeof(setsec->micAlg), str);
             else
-                strncpy(setsec->micAlg, "SHA-1", 15);
-        }
-        else if (strcasecmp(str, "Prog") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->prog, str, 15);
-        }
-        else if (strcasecmp(str, "Prefer") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+                wfaCapiStrCpy(setsec->micAlg, sizeof(setsec->micAlg), "SHA-1");
+            break;
+
+        case CAPI_KW_PROG:
+            wfaCapiStrCpy(setsec->prog, sizeof(setsec->prog), str);
+            break;
+
+        case CAPI_KW_PREFER:
             setsec->prefer = (atoi(str) == 1)?1:0;
+            break;
+
+        default:
+            ;
         }
     }
 
@@ -1613,7 +1869,9 @@ int xcCmdProcStaSetEapSIM(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     caStaSetEapSIM_t *setsec = (caStaSetEapSIM_t *) (aBuf+sizeof(wfaTLV));
 #ifndef WFA_PC_CONSOLE
+    wfaCapiParms_t parms;
     char *str;
+    int i, t;
     caStaSetEapSIM_t defparams = {"", "", "", "", "", "", 0, {"", "", ""}};
 
     if(aBuf == NULL)
@@ -1622,67 +1880,48 @@ int xcCmdProcStaSetEapSIM(char *pcmdStr, BYTE *aBuf, int *aLen)
     memset(aBuf, 0, *aLen);
     memcpy((void *)setsec, (void *)&defparams, sizeof(caStaSetEapSIM_t));
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "interface") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->intf, str, 15);
-        }
-        else if(strcasecmp(str, "ssid") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->ssid, str, 64);
-        }
-        else if(strcasecmp(str, "username") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->username, str);
-        }
-        else if(strcasecmp(str, "password") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->passwd, str);
-        }
-        else if(strcasecmp(str, "keyMgmtType") == 0)
-        {
-            str=strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->keyMgmtType, str, 7);
-        }
-        else if(strcasecmp(str, "encpType") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->encrptype, str,8);
-        }
-        else if(strcasecmp(str, "triplet1") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy((char *)setsec->tripletSet[0], str, 63);
-            DPRINT_INFO(WFA_OUT, "Triplet1 : %s\n", setsec->tripletSet[0]);
-            setsec->tripletCount = 1;
-        }
-        else if(strcasecmp(str, "triplet2") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy((char *)setsec->tripletSet[1], str, 63);
-            DPRINT_INFO(WFA_OUT, "Triplet2 : %s\n", setsec->tripletSet[1]);
-            setsec->tripletCount=2;
-        }
-        else if(strcasecmp(str, "triplet3") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy((char *)setsec->tripletSet[2], str, 63);
-            DPRINT_INFO(WFA_OUT, "Triplet1 : %s\n", setsec->tripletSet[2]);
-            setsec->tripletCount = 3;
-        }
-        else if(strcasecmp(str, "pmf") == 0)
-        {
-            str = strtok_r (NULL, ",", &pcmdStr);
+        case CAPI_KW_INTERFACE:
+            wfaCapiStrCpy(setsec->intf, sizeof(setsec->intf), str);
+            break;
 
+        case CAPI_KW_SSID:
+            wfaCapiStrCpy(setsec->ssid, sizeof(setsec->ssid), str);
+            break;
+
+        case CAPI_KW_USERNAME:
+            wfaCapiStrCpy(setsec->username, sizeof(setsec->username), str);
+            break;
+
+        case CAPI_KW_PASSWORD:
+            wfaCapiStrCpy(setsec->passwd, sizeof(setsec->passwd), str);
+            break;
+
+        case CAPI_KW_KEYMGMTTYPE:
+            wfaCapiStrCpy(setsec->keyMgmtType, sizeof(setsec->keyMgmtType), str);
+            break;
+
+        case CAPI_KW_ENCPTYPE:
+            wfaCapiStrCpy(setsec->encrptype, sizeof(setsec->encrptype), str);
+            break;
+
+        case CAPI_KW_TRIPLET1:
+        case CAPI_KW_TRIPLET2:
+        case CAPI_KW_TRIPLET3:
+            t = parms.parm[i].type - CAPI_KW_TRIPLET1;
+            wfaCapiStrCpy((char *)setsec->tripletSet[t], sizeof(setsec->tripletSet[t]), str);
+            DPRINT_INFO(WFA_OUT, "Triplet%i : %s\n", t+1, setsec->tripletSet[t]);
+            setsec->tripletCount = t+1;
+            break;
+
+        case CAPI_KW_PMF:
             if(strcasecmp(str, "enable") == 0
                     || strcasecmp(str, "optional") == 0)
                 setsec->pmf = WFA_ENABLED;
@@ -1690,6 +1929,10 @@ int xcCmdProcStaSetEapSIM(char *pcmdStr, BYTE *aBuf, int *aLen)
                 setsec->pmf = WFA_REQUIRED;
             else
                 setsec->pmf = WFA_DISABLED;
+            break;
+
+        default:
+            ;
         }
     }
 
@@ -1705,7 +1948,9 @@ int xcCmdProcStaSetPEAP(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     caStaSetEapPEAP_t *setsec = (caStaSetEapPEAP_t *) (aBuf+sizeof(wfaTLV));
 #ifndef WFA_PC_CONSOLE
+    wfaCapiParms_t parms;
     char *str;
+    int i;
     caStaSetEapPEAP_t defparams = {"", "", "", "", "", "", "", "", 0};
 
     if(aBuf == NULL)
@@ -1714,61 +1959,51 @@ int xcCmdProcStaSetPEAP(char *pcmdStr, BYTE *aBuf, int *aLen)
     memset(aBuf, 0, *aLen);
     memcpy((void *)setsec, (void *)&defparams, sizeof(caStaSetEapPEAP_t));
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "interface") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->intf, str, 15);
-        }
-        else if(strcasecmp(str, "ssid") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->ssid, str, 64);
-        }
-        else if(strcasecmp(str, "username") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->username, str);
-        }
-        else if(strcasecmp(str, "password") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->passwd, str);
-        }
-        else if(strcasecmp(str, "keyMgmtType") == 0)
-        {
-            str=strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->keyMgmtType, str, 7);
-        }
-        else if(strcasecmp(str, "encpType") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->encrptype, str, 8);
-        }
-        else if(strcasecmp(str, "innerEAP") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strcpy(setsec->innerEAP, str);
-        }
-        else if(strcasecmp(str, "trustedRootCA") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setsec->trustedRootCA, str,31);
-        }
-        else if(strcasecmp(str, "peapVersion") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+        case CAPI_KW_INTERFACE:
+            wfaCapiStrCpy(setsec->intf, sizeof(setsec->intf), str);
+            break;
+
+        case CAPI_KW_SSID:
+            wfaCapiStrCpy(setsec->ssid, sizeof(setsec->ssid), str);
+            break;
+
+        case CAPI_KW_USERNAME:
+            wfaCapiStrCpy(setsec->username, sizeof(setsec->username), str);
+            break;
+
+        case CAPI_KW_PASSWORD:
+            wfaCapiStrCpy(setsec->passwd, sizeof(setsec->passwd), str);
+            break;
+
+        case CAPI_KW_KEYMGMTTYPE:
+            wfaCapiStrCpy(setsec->keyMgmtType, sizeof(setsec->keyMgmtType), str);
+            break;
+
+        case CAPI_KW_ENCPTYPE:
+            wfaCapiStrCpy(setsec->encrptype, sizeof(setsec->encrptype), str);
+            break;
+
+        case CAPI_KW_INNEREAP:
+            wfaCapiStrCpy(setsec->innerEAP, sizeof(setsec->innerEAP), str);
+            break;
+
+        case CAPI_KW_TRUSTEDROOTCA:
+            wfaCapiStrCpy(setsec->trustedRootCA, sizeof(setsec->trustedRootCA), str);
+            break;
+
+        case CAPI_KW_PEAPVERSION:
             setsec->peapVersion = atoi(str);
-        }
-        else if(strcasecmp(str, "pmf") == 0)
-        {
-            str = strtok_r (NULL, ",", &pcmdStr);
+            break;
 
+        case CAPI_KW_PMF:
             if(strcasecmp(str, "enable") == 0
                     || strcasecmp(str, "optional") == 0)
                 setsec->pmf = WFA_ENABLED;
@@ -1776,6 +2011,10 @@ int xcCmdProcStaSetPEAP(char *pcmdStr, BYTE *aBuf, int *aLen)
                 setsec->pmf = WFA_REQUIRED;
             else
                 setsec->pmf = WFA_DISABLED;
+            break;
+
+        default:
+            ;
         }
     }
 
@@ -1791,8 +2030,9 @@ int xcCmdProcStaSetPEAP(char *pcmdStr, BYTE *aBuf, int *aLen)
 int xcCmdProcStaSetIBSS(char *pcmdStr, BYTE *aBuf, int *aLen)
 {
     caStaSetIBSS_t *setibss = (caStaSetIBSS_t *) (aBuf+sizeof(wfaTLV));
+    wfaCapiParms_t parms;
     char *str;
-    int i = 0;
+    int i, k = 0;
     caStaSetIBSS_t defparams = {"", "", 0, 0, {"", "", "", ""}, 0xFF};
 
     if(aBuf == NULL)
@@ -1801,63 +2041,54 @@ int xcCmdProcStaSetIBSS(char *pcmdStr, BYTE *aBuf, int *aLen)
     memset(aBuf, 0, *aLen);
     memcpy((void *)setibss, (void *)&defparams, sizeof(caStaSetIBSS_t));
 
-    for(;;)
+    wfaCapiParse(pcmdStr, capiKwStr, CAPI_KW_NUM, &parms);
+
+    for(i = 0; i < parms.num; i++)
     {
-        str = strtok_r(NULL, ",", &pcmdStr);
-        if(str == NULL || str[0] == '\0')
-            break;
+        str = parms.parm[i].val;
 
-        if(strcasecmp(str, "interface") == 0)
+        switch(parms.parm[i].type)
         {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setibss->intf, str, 15);
+        case CAPI_KW_INTERFACE:
+            wfaCapiStrCpy(setibss->intf, sizeof(setibss->intf), str);
             DPRINT_INFO(WFA_OUT, "interface %s\n", setibss->intf);
+            break;
 
-        }
-        else if(strcasecmp(str, "ssid") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setibss->ssid, str, 64);
+        case CAPI_KW_SSID:
+            wfaCapiStrCpy(setibss->ssid, sizeof(setibss->ssid), str);
             DPRINT_INFO(WFA_OUT, "ssid %s\n", setibss->ssid);
-        }
-        else if(strcasecmp(str, "channel") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_CHANNEL:
             setibss->channel = atoi(str);
-        }
-        else if(strcasecmp(str, "encpType") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_ENCPTYPE:
             if(strcasecmp(str, "wep") == 0)
                 setibss->encpType = ENCRYPT_WEP;
             else
                 setibss->encpType = 0;
-        }
-        else if(strncasecmp(str, "key1", 4) == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setibss->keys[i++], str, 26);
-            setibss->activeKeyIdx = 0;
-        }
-        else if(strncasecmp(str, "key2", 4) == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setibss->keys[i++], str, 26);
-        }
-        else if(strncasecmp(str, "key3", 4) == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setibss->keys[i++], str, 26);
-        }
-        else if(strncasecmp(str, "key4", 4) == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
-            strncpy(setibss->keys[i++], str, 26);
-        }
-        else if(strcasecmp(str, "activeKey") == 0)
-        {
-            str = strtok_r(NULL, ",", &pcmdStr);
+            break;
+
+        case CAPI_KW_KEY1:
+        case CAPI_KW_KEY2:
+        case CAPI_KW_KEY3:
+        case CAPI_KW_KEY4:
+            /* keys are stored in the order they are given */
+            if(k == 4)
+                break;
+            wfaCapiStrCpy(setibss->keys[k], sizeof(setibss->keys[k]), str);
+            k++;
+            if(parms.parm[i].type == CAPI_KW_KEY1)
+                setibss->activeKeyIdx = 0;
+            break;
+
+        case CAPI_KW_ACTIVEKEY:
             setibss->activeKeyIdx = atoi(str);
+            break;
+
+        default:
+            ;
         }
     }
 
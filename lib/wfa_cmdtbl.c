@@ -61,7 +61,7 @@ xcCommandFuncPtr gWfaCmdFuncTbl[WFA_STA_COMMANDS_END] =
     wfaTGRecvStart,           /*    WFA_TRAFFIC_AGENT_RECV_START_TLV   (6) */
     wfaTGRecvStop,            /*    WFA_TRAFFIC_AGENT_RECV_STOP_TLV    (7) */
     wfaTGReset,               /*    WFA_TRAFFIC_AGENT_RESET_TLV        (8) */
-    NotDefinedYet,            /*    WFA_TRAFFIC_AGENT_STATUS_TLV       (9) */
+    wfaTGStatus,              /*    WFA_TRAFFIC_AGENT_STATUS_TLV       (9) */
 
     /* Control and Configuration Commands */
     wfaStaGetIpConfig,        /*    WFA_STA_GET_IP_CONFIG_TLV          (10)*/
@@ -159,6 +159,8 @@ xcCommandFuncPtr gWfaCmdFuncTbl[WFA_STA_COMMANDS_END] =
 	wfaStaGetEvents,         /*   WFA_STA_GET_EVENTS_TLV            (83)*/
 	wfaStaGetEventDetails,         /*   WFA_STA_GET_EVENT_DETAILS_TLV            (84)*/	
 	wfaStaExecAction,         /*   WFA_STA_EXEC_ACTION_TLV            (85)*/	
+	NotDefinedYet,            /*   WFA_STA_SET_EAPPWD_TLV             (86)*/
+	wfaTGConfigBatch,         /*   WFA_TRAFFIC_AGENT_CONFIG_BATCH_TLV (87)*/
 };
 
 
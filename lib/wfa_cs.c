@@ -24,8 +24,9 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
  *   The current implementation is to show how these functions
  *   should be defined in order to support the Agent Control/Test Manager
  *   control commands. To simplify the current work and avoid any GPL licenses,
- *   the functions mostly invoke shell commands by calling linux system call,
- *   system("<commands>").
+ *   the functions talk to the supplicant over its control socket, to the
+ *   kernel over rtnetlink, and run the remaining helper commands through
+ *   wfaRun(), without a shell and with a deadline.
  *
  *   It depends on the differnt device and platform, vendors can choice their
  *   own ways to interact its systems, supplicants and process these commands
@@ -37,11 +38,14 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <linux/types.h>
 #include <linux/socket.h>
 #include <poll.h>
+#include <pthread.h>
+#include <sys/utsname.h>
 
 #include "wfa_portall.h"
 #include "wfa_debug.h"
@@ -55,6 +59,13 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "wfa_cmds.h"
 #include "wfa_rsp.h"
 #include "wfa_utils.h"
+#include "wfa_wpactrl.h"
+#include "wfa_nl.h"
+#include "wfa_ping.h"
+#include "wfa_spawn.h"
+#include "wfa_cli.h"
+#include "wfa_ifcache.h"
+#include "wfa_events.h"
 #ifdef WFA_WMM_PS_EXT
 #include "wfa_wmmps.h"
 #endif
@@ -70,25 +81,14 @@ extern unsigned short wfa_defined_debug;
 int wfaExecuteCLI(char *CLI);
 
 /* Since the two definitions are used all over the CA function */
-char gCmdStr[WFA_CMD_STR_SZ];
-dutCmdResponse_t gGenericResp;
+wTHREAD_LOCAL char gCmdStr[WFA_CMD_STR_SZ];
+wTHREAD_LOCAL dutCmdResponse_t gGenericResp;
 int wfaTGSetPrio(int sockfd, int tgClass);
 void create_apts_msg(int msg, unsigned int txbuf[],int id);
 
-int sret = 0;
-
 extern char e2eResults[];
 
 FILE *e2efp = NULL;
-int chk_ret_status()
-{
-    char *ret = getenv(WFA_RET_ENV);
-
-    if(*ret == '1')
-        return WFA_SUCCESS;
-    else
-        return WFA_FAILURE;
-}
 
 /*
  * agtCmdProcGetVersion(): response "ca_get_version" command to controller
@@ -105,9 +105,7 @@ int agtCmdProcGetVersion(int len, BYTE *parms, int *respLen, BYTE *respBuf)
     getverResp->status = STATUS_COMPLETE;
     wSTRNCPY(getverResp->cmdru.version, WFA_SYSTEM_VER, WFA_VERNAM_LEN);
 
-    wfaEncodeTLV(WFA_GET_VERSION_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)getverResp, respBuf);
-
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_GET_VERSION_RESP_TLV, getverResp, sizeof(dutCmdResponse_t), respBuf);
 
     return WFA_SUCCESS;
 }
@@ -151,11 +149,10 @@ int wfaStaAssociate(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
       //sret = system(gCmdStr);
 
         /*
-         *  use 'wpa_cli' command to force a 802.11 re/associate
-         *  (wpa_supplicant specific)
+         *  ask the supplicant over its control socket to force a 802.11
+         *  re/associate (wpa_supplicant specific)
          */
-        sprintf(gCmdStr, "wpa_cli -i%s reassociate", ifname);
-        sret = system(gCmdStr);
+        wfaWpaCmd(ifname, "REASSOCIATE");
     }
 
     /*
@@ -201,18 +198,16 @@ int wfaStaReAssociate(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     else
     {
         /* use 'ifconfig' command to bring down the interface (linux specific) */
-        sprintf(gCmdStr, "ifconfig %s down", ifname);
-        sret = system(gCmdStr);
+        wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "ifconfig %s down", ifname);
 
         /* use 'ifconfig' command to bring up the interface (linux specific) */
-        sprintf(gCmdStr, "ifconfig %s up", ifname);
+        wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "ifconfig %s up", ifname);
 
         /*
-         *  use 'wpa_cli' command to force a 802.11 re/associate
-         *  (wpa_supplicant specific)
+         *  ask the supplicant over its control socket to force a 802.11
+         *  re/associate (wpa_supplicant specific)
          */
-        sprintf(gCmdStr, "wpa_cli -i%s reassociate", ifname);
-        sret = system(gCmdStr);
+        wfaWpaCmd(ifname, "REASSOCIATE");
     }
 
     /*
@@ -237,44 +232,33 @@ int wfaStaIsConnected(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     dutCommand_t *connStat = (dutCommand_t *)caCmdBuf;
     dutCmdResponse_t *staConnectResp = &gGenericResp;
     char *ifname = connStat->intf;
-    FILE *tmpfile = NULL;
     char result[32];
 
 
     DPRINT_INFO(WFA_OUT, "Entering isConnected ...\n");
 
 #ifdef WFA_NEW_CLI_FORMAT
-    sprintf(gCmdStr, "wfa_chkconnect %s\n", ifname);
-    sret = system(gCmdStr);
-
-    if(chk_ret_status() == WFA_SUCCESS)
+    /* the helper exits with 0 once the interface is associated */
+    if(wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wfa_chkconnect %s", ifname) == 0)
         staConnectResp->cmdru.connected = 1;
     else
         staConnectResp->cmdru.connected = 0;
 #else
     /*
-     * use 'wpa_cli' command to check the interface status
-     * none, scanning or complete (wpa_supplicant specific)
-     */
-    sprintf(gCmdStr, "/sbin/wpa_cli -i%s status | grep ^wpa_state= | cut -f2- -d= > /tmp/.isConnected", ifname);
-    sret = system(gCmdStr);
-
-    /*
-     * the status is saved in a file.  Open the file and check it.
+     * ask the supplicant for the interface status
+     * none, scanning or complete (wpa_supplicant specific),
+     * answered from the cache until the supplicant reports an event
      */
-    tmpfile = fopen("/tmp/.isConnected", "r+");
-    if(tmpfile == NULL)
+    if(wfaIfcWpaStatus(ifname, "wpa_state", result, sizeof(result)) != WFA_SUCCESS)
     {
         staConnectResp->status = STATUS_ERROR;
         wfaEncodeTLV(WFA_STA_IS_CONNECTED_RESP_TLV, 4, (BYTE *)staConnectResp, respBuf);
         *respLen = WFA_TLV_HDR_LEN + 4;
 
-        DPRINT_ERR(WFA_ERR, "file open failed\n");
+        DPRINT_ERR(WFA_ERR, "supplicant status failed\n");
         return WFA_FAILURE;
     }
 
-    sret = fscanf(tmpfile, "%s", (char *)result);
-
     if(strncmp(result, "COMPLETED", 9) == 0)
         staConnectResp->cmdru.connected = 1;
     else
@@ -286,8 +270,7 @@ int wfaStaIsConnected(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
      */
     staConnectResp->status = STATUS_COMPLETE;
 
-    wfaEncodeTLV(WFA_STA_IS_CONNECTED_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)staConnectResp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_STA_IS_CONNECTED_RESP_TLV, staConnectResp, sizeof(dutCmdResponse_t), respBuf);
 
     return WFA_SUCCESS;
 }
@@ -301,136 +284,41 @@ int wfaStaIsConnected(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
  *     4. primary-dns
  *     5. secondary-dns
  *
- *     The current implementation is to use a script to find these information
- *     and store them in a file.
+ *     The address comes from rtnetlink, kept in the interface cache until
+ *     it changes, the name servers from resolv.conf.
+ *     An address with a lease lifetime is taken as one from DHCP.
  */
 int wfaStaGetIpConfig(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
-    int slen, ret, i = 0;
     dutCommand_t *getIpConf = (dutCommand_t *)caCmdBuf;
     dutCmdResponse_t *ipconfigResp = &gGenericResp;
     char *ifname = getIpConf->intf;
     caStaGetIpConfigResp_t *ifinfo = &ipconfigResp->cmdru.getIfconfig;
 
-    FILE *tmpfd;
-    char string[256];
-    char *str;
+    wMEMSET(ifinfo, 0, sizeof(caStaGetIpConfigResp_t));
 
-    /*
-     * check a script file (the current implementation specific)
-     */
-    ret = access("/usr/local/sbin/getipconfig.sh", F_OK);
-    if(ret == -1)
+    if(wfaIfcGetIpv4(ifname, ifinfo->ipaddr, ifinfo->mask, &ifinfo->isDhcp) != WFA_SUCCESS)
     {
         ipconfigResp->status = STATUS_ERROR;
         wfaEncodeTLV(WFA_STA_GET_IP_CONFIG_RESP_TLV, 4, (BYTE *)ipconfigResp, respBuf);
         *respLen = WFA_TLV_HDR_LEN + 4;
 
-        DPRINT_ERR(WFA_ERR, "file not exist\n");
+        DPRINT_ERR(WFA_ERR, "no ip info of %s\n", ifname);
         return WFA_FAILURE;
-
     }
 
     strcpy(ifinfo->dns[0], "0");
     strcpy(ifinfo->dns[1], "0");
+    wfaResolvGet(ifinfo->dns, WFA_MAX_DNS_NUM);
 
-    /*
-     * Run the script file "getipconfig.sh" to check the ip status
-     * (current implementation  specific).
-     * note: "getipconfig.sh" is only defined for the current implementation
-     */
-    sprintf(gCmdStr, "getipconfig.sh /tmp/ipconfig.txt %s\n", ifname);
-
-    sret = system(gCmdStr);
-
-    /* open the output result and scan/retrieve the info */
-    tmpfd = fopen("/tmp/ipconfig.txt", "r+");
-
-    if(tmpfd == NULL)
-    {
-        ipconfigResp->status = STATUS_ERROR;
-        wfaEncodeTLV(WFA_STA_GET_IP_CONFIG_RESP_TLV, 4, (BYTE *)ipconfigResp, respBuf);
-        *respLen = WFA_TLV_HDR_LEN + 4;
-
-        DPRINT_ERR(WFA_ERR, "file open failed\n");
-        return WFA_FAILURE;
-    }
-
-    for(;;)
-    {
-        if(fgets(string, 256, tmpfd) == NULL)
-            break;
-
-        /* check dhcp enabled */
-        if(strncmp(string, "dhcpcli", 7) ==0)
-        {
-            str = strtok(string, "=");
-            str = strtok(NULL, "=");
-            if(str != NULL)
-                ifinfo->isDhcp = 1;
-            else
-                ifinfo->isDhcp = 0;
-        }
-
-        /* find out the ip address */
-        if(strncmp(string, "ipaddr", 6) == 0)
-        {
-            str = strtok(string, "=");
-            str = strtok(NULL, " ");
-            if(str != NULL)
-            {
-                wSTRNCPY(ifinfo->ipaddr, str, 15);
-
-                ifinfo->ipaddr[15]='\0';
-            }
-            else
-                wSTRNCPY(ifinfo->ipaddr, "none", 15);
-        }
-
-        /* check the mask */
-        if(strncmp(string, "mask", 4) == 0)
-        {
-            char ttstr[16];
-            char *ttp = ttstr;
-
-            str = strtok_r(string, "=", &ttp);
-            if(*ttp != '\0')
-            {
-                strcpy(ifinfo->mask, ttp);
-                slen = strlen(ifinfo->mask);
-                ifinfo->mask[slen-1] = '\0';
-            }
-            else
-                strcpy(ifinfo->mask, "none");
-        }
-
-        /* find out the dns server ip address */
-        if(strncmp(string, "nameserv", 8) == 0)
-        {
-            char ttstr[16];
-            char *ttp = ttstr;
-
-            str = strtok_r(string, " ", &ttp);
-            if(str != NULL && i < 2)
-            {
-                strcpy(ifinfo->dns[i], ttp);
-                slen = strlen(ifinfo->dns[i]);
-                ifinfo->dns[i][slen-1] = '\0';
-            }
-            else
-                strcpy(ifinfo->dns[i], "none");
-
-            i++;
-        }
-    }
+    if(wfaIfcGetMac(ifname, ifinfo->mac, sizeof(ifinfo->mac)) != WFA_SUCCESS)
+        ifinfo->mac[0] = '\0';
 
     /*
      * Report back the results
      */
     ipconfigResp->status = STATUS_COMPLETE;
-    wfaEncodeTLV(WFA_STA_GET_IP_CONFIG_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)ipconfigResp, respBuf);
-
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_STA_GET_IP_CONFIG_RESP_TLV, ipconfigResp, sizeof(dutCmdResponse_t), respBuf);
 
 #if 0
     DPRINT_INFO(WFA_OUT, "%i %i %s %s %s %s %i\n", ipconfigResp->status,
@@ -438,7 +326,6 @@ int wfaStaGetIpConfig(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
                 ifinfo->dns[0], ifinfo->dns[1], *respLen);
 #endif
 
-    fclose(tmpfd);
     return WFA_SUCCESS;
 }
 
@@ -458,32 +345,26 @@ int wfaStaSetIpConfig(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
     DPRINT_INFO(WFA_OUT, "entering wfaStaSetIpConfig ...\n");
 
-    /*
-     * Use command 'ifconfig' to configure the interface ip address, mask.
-     * (Linux specific).
-     */
-    sprintf(gCmdStr, "/sbin/ifconfig %s %s netmask %s > /dev/null 2>&1 ", ipconfig->intf, ipconfig->ipaddr, ipconfig->mask);
-    sret = system(gCmdStr);
+    staSetIpResp->status = STATUS_COMPLETE;
 
-    /* use command 'route add' to set set gatewway (linux specific) */
-    if(ipconfig->defGateway[0] != '\0')
-    {
-        sprintf(gCmdStr, "/sbin/route add default gw %s > /dev/null 2>&1", ipconfig->defGateway);
-        sret = system(gCmdStr);
-    }
+    /* replace the interface address and bring it up (rtnetlink) */
+    if(ipconfig->ipaddr[0] != '\0' &&
+            wfaNlSetIpv4(ipconfig->intf, ipconfig->ipaddr, ipconfig->mask) != WFA_SUCCESS)
+        staSetIpResp->status = STATUS_ERROR;
+
+    /* the default route through the gateway */
+    if(ipconfig->defGateway[0] != '\0' &&
+            wfaNlSetDefaultGw(ipconfig->defGateway) != WFA_SUCCESS)
+        staSetIpResp->status = STATUS_ERROR;
 
     /* set dns (linux specific) */
-    sprintf(gCmdStr, "cp /etc/resolv.conf /tmp/resolv.conf.bk");
-    sret = system(gCmdStr);
-    sprintf(gCmdStr, "echo nameserv %s > /etc/resolv.conf", ipconfig->pri_dns);
-    sret = system(gCmdStr);
-    sprintf(gCmdStr, "echo nameserv %s >> /etc/resolv.conf", ipconfig->sec_dns);
-    sret = system(gCmdStr);
+    if((ipconfig->pri_dns[0] != '\0' || ipconfig->sec_dns[0] != '\0') &&
+            wfaResolvSet(ipconfig->pri_dns, ipconfig->sec_dns) != WFA_SUCCESS)
+        staSetIpResp->status = STATUS_ERROR;
 
     /*
      * report status
      */
-    staSetIpResp->status = STATUS_COMPLETE;
     wfaEncodeTLV(WFA_STA_SET_IP_CONFIG_RESP_TLV, 4, (BYTE *)staSetIpResp, respBuf);
     *respLen = WFA_TLV_HDR_LEN + 4;
 
@@ -493,16 +374,14 @@ int wfaStaSetIpConfig(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 /*
  * wfaStaVerifyIpConnection():
  * The function is to verify if the station has IP connection with an AP by
- * send ICMP/pings to the AP.
+ * send ICMP/pings to the AP. Probes go out at a short interval and the
+ * first reply answers, the timeout only matters to a host that is down.
  */
 int wfaStaVerifyIpConnection(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
     dutCommand_t *verip = (dutCommand_t *)caCmdBuf;
     dutCmdResponse_t *verifyIpResp = &gGenericResp;
-
-#ifndef WFA_PING_UDP_ECHO_ONLY
-    char strout[64], *pcnt;
-    FILE *tmpfile;
+    int udpOnly = 0;
 
     DPRINT_INFO(WFA_OUT, "Entering wfaStaVerifyIpConnection ...\n");
 
@@ -512,107 +391,15 @@ int wfaStaVerifyIpConnection(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBu
         verip->cmdsu.verifyIp.timeout = 10;
     }
 
-    /* execute the ping command  and pipe the result to a tmp file */
-    sprintf(gCmdStr, "ping %s -c 3 -W %u | grep loss | cut -f3 -d, 1>& /tmp/pingout.txt", verip->cmdsu.verifyIp.dipaddr, verip->cmdsu.verifyIp.timeout);
-    sret = system(gCmdStr);
-
-    /* scan/check the output */
-    tmpfile = fopen("/tmp/pingout.txt", "r+");
-    if(tmpfile == NULL)
-    {
-        verifyIpResp->status = STATUS_ERROR;
-        wfaEncodeTLV(WFA_STA_VERIFY_IP_CONNECTION_RESP_TLV, 4, (BYTE *)verifyIpResp, respBuf);
-        *respLen = WFA_TLV_HDR_LEN + 4;
-
-        DPRINT_ERR(WFA_ERR, "file open failed\n");
-        return WFA_FAILURE;
-    }
-
-    verifyIpResp->status = STATUS_COMPLETE;
-    if(fscanf(tmpfile, "%s", strout) == EOF)
-        verifyIpResp->cmdru.connected = 0;
-    else
-    {
-        pcnt = strtok(strout, "%");
-
-        /* if the loss rate is 100%, not able to connect */
-        if(atoi(pcnt) == 100)
-            verifyIpResp->cmdru.connected = 0;
-        else
-            verifyIpResp->cmdru.connected = 1;
-    }
-
-    fclose(tmpfile);
-#else
-    int btSockfd;
-    struct pollfd fds[2];
-    int timeout = 2000;
-    char anyBuf[64];
-    struct sockaddr_in toAddr;
-    int done = 1, cnt = 0, ret, nbytes;
-
-    verifyIpResp->status = STATUS_COMPLETE;
-    verifyIpResp->cmdru.connected = 0;
-
-    btSockfd = wfaCreateUDPSock("127.0.0.1", WFA_UDP_ECHO_PORT);
-
-    if(btSockfd == -1)
-    {
-        verifyIpResp->status = STATUS_ERROR;
-        wfaEncodeTLV(WFA_STA_VERIFY_IP_CONNECTION_RESP_TLV, 4, (BYTE *)verifyIpResp, respBuf);
-        *respLen = WFA_TLV_HDR_LEN + 4;
-        return WFA_FAILURE;;
-    }
-
-    toAddr.sin_family = AF_INET;
-    toAddr.sin_addr.s_addr = inet_addr(verip->cmdsu.verifyIp.dipaddr);
-    toAddr.sin_port = htons(WFA_UDP_ECHO_PORT);
-
-    while(done)
-    {
-        wfaTrafficSendTo(btSockfd, (char *)anyBuf, 64, (struct sockaddr *)&toAddr);
-        cnt++;
-
-        fds[0].fd = btSockfd;
-        fds[0].events = POLLIN | POLLOUT;
-
-        ret = poll(fds, 1, timeout);
-        switch(ret)
-        {
-        case 0:
-            /* it is time out, count a packet lost*/
-            break;
-        case -1:
-        /* it is an error */
-        default:
-        {
-            switch(fds[0].revents)
-            {
-            case POLLIN:
-            case POLLPRI:
-            case POLLOUT:
-                nbytes = wfaTrafficRecv(btSockfd, (char *)anyBuf, (struct sockaddr *)&toAddr);
-                if(nbytes != 0)
-                    verifyIpResp->cmdru.connected = 1;
-                done = 0;
-                break;
-            default:
-                /* errors but not care */
-                ;
-            }
-        }
-        }
-        if(cnt == 3)
-        {
-            done = 0;
-        }
-    }
-
+#ifdef WFA_PING_UDP_ECHO_ONLY
+    udpOnly = 1;
 #endif
 
-    wfaEncodeTLV(WFA_STA_VERIFY_IP_CONNECTION_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)verifyIpResp, respBuf);
+    verifyIpResp->status = STATUS_COMPLETE;
+    verifyIpResp->cmdru.connected = wfaPingProbe(verip->cmdsu.verifyIp.dipaddr,
+                                    verip->cmdsu.verifyIp.timeout * 1000, udpOnly);
 
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_STA_VERIFY_IP_CONNECTION_RESP_TLV, verifyIpResp, sizeof(dutCmdResponse_t), respBuf);
 
     return WFA_SUCCESS;
 }
@@ -625,73 +412,139 @@ int wfaStaGetMacAddress(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
     dutCommand_t *getMac = (dutCommand_t *)caCmdBuf;
     dutCmdResponse_t *getmacResp = &gGenericResp;
-    char *str;
     char *ifname = getMac->intf;
 
-    FILE *tmpfd;
-    char string[257];
-
     DPRINT_INFO(WFA_OUT, "Entering wfaStaGetMacAddress ...\n");
     /*
-     * run the script "getipconfig.sh" to find out the mac
+     * the link address (rtnetlink), cached until the link changes
      */
-    sprintf(gCmdStr, "ifconfig %s > /tmp/ipconfig.txt ", ifname);
-    sret = system(gCmdStr);
-
-    tmpfd = fopen("/tmp/ipconfig.txt", "r+");
-    if(tmpfd == NULL)
+    if(wfaIfcGetMac(ifname, getmacResp->cmdru.mac, sizeof(getmacResp->cmdru.mac)) != WFA_SUCCESS)
     {
         getmacResp->status = STATUS_ERROR;
         wfaEncodeTLV(WFA_STA_GET_MAC_ADDRESS_RESP_TLV, 4, (BYTE *)getmacResp, respBuf);
         *respLen = WFA_TLV_HDR_LEN + 4;
 
-        DPRINT_ERR(WFA_ERR, "file open failed\n");
+        DPRINT_ERR(WFA_ERR, "no mac address of %s\n", ifname);
         return WFA_FAILURE;
     }
 
-    if(fgets((char *)&string[0], 256, tmpfd) == NULL)
-    {
-        getmacResp->status = STATUS_ERROR;
-    }
-
-    str = strtok(string, " ");
-    while(str && ((strcmp(str,"HWaddr")) != 0))
-    {
-        str = strtok(NULL, " ");
-    }
+    getmacResp->status = STATUS_COMPLETE;
+    *respLen = wfaEncodeResp(WFA_STA_GET_MAC_ADDRESS_RESP_TLV, getmacResp, sizeof(dutCmdResponse_t), respBuf);
 
-    /* get mac */
-    if(str)
-    {
-        str = strtok(NULL, " ");
-        strcpy(getmacResp->cmdru.mac, str);
-        getmacResp->status = STATUS_COMPLETE;
-    }
+    return WFA_SUCCESS;
+}
 
-    wfaEncodeTLV(WFA_STA_GET_MAC_ADDRESS_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)getmacResp, respBuf);
+/* the counters an interface had at its previous sta_get_stats */
+#define WFA_STATS_MAX_IFS      4
 
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+typedef struct _wfa_stats_base
+{
+    char ifname[WFA_IF_NAME_LEN];
+    struct timespec at;
+    wfaNlStats_t stats;
+} wfaStatsBase_t;
 
-    fclose(tmpfd);
-    return WFA_SUCCESS;
-}
+static wfaStatsBase_t statsBase[WFA_STATS_MAX_IFS];
+static int statsBaseNext = 0;
+static pthread_mutex_t statsMutex = PTHREAD_MUTEX_INITIALIZER;
 
 /*
  * wfaStaGetStats():
  * The function is to retrieve the statistics of the I/F's layer 2 txFrames,
- * rxFrames, txMulticast, rxMulticast, fcsErrors/crc, and txRetries.
- * Currently there is not definition how to use these info.
+ * rxFrames, txMulticast, rxMulticast, fcsErrors/crc, and txRetries, plus
+ * the drop, error and queue counters that tell where frames got lost.
+ * Every figure is the change since the previous call on the interface, so
+ * two calls bracket a traffic run; the first call reports the totals.
  */
 int wfaStaGetStats(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
+    dutCommand_t *getStats = (dutCommand_t *)caCmdBuf;
     dutCmdResponse_t *statsResp = &gGenericResp;
+    caStaGetStatsResp_t *ifStats = &statsResp->cmdru.ifStats;
+    static char *wlSrcNames[] = {"none", "nl80211", "wext"};
+    char *ifname = getStats->intf;
+    wfaStatsBase_t *base = NULL;
+    wfaNlStats_t cur, delta;
+    unsigned long long *c, *b, *d;
+    struct timespec now;
+    int i, wlSrc;
+
+    DPRINT_INFO(WFA_OUT, "Entering wfaStaGetStats ...\n");
+
+    if(wfaNlGetStats(ifname, &cur, &wlSrc) != WFA_SUCCESS)
+    {
+        statsResp->status = STATUS_ERROR;
+        wfaEncodeTLV(WFA_STA_GET_STATS_RESP_TLV, 4, (BYTE *)statsResp, respBuf);
+        *respLen = WFA_TLV_HDR_LEN + 4;
+
+        DPRINT_ERR(WFA_ERR, "no counters of %s\n", ifname);
+        return WFA_FAILURE;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    wMEMSET(ifStats, 0, sizeof(*ifStats));
+
+    wPT_MUTEX_LOCK(&statsMutex);
+    for(i = 0; i < WFA_STATS_MAX_IFS; i++)
+    {
+        if(strncmp(statsBase[i].ifname, ifname, WFA_IF_NAME_LEN) == 0)
+        {
+            base = &statsBase[i];
+            ifStats->intervalMs = (now.tv_sec - base->at.tv_sec) * 1000 +
+                                  (now.tv_nsec - base->at.tv_nsec) / 1000000;
+            break;
+        }
+    }
+
+    if(base == NULL)
+    {
+        base = &statsBase[statsBaseNext];
+        statsBaseNext = (statsBaseNext + 1) % WFA_STATS_MAX_IFS;
+        wMEMSET(base, 0, sizeof(*base));
+        snprintf(base->ifname, sizeof(base->ifname), "%s", ifname);
+    }
+
+    /* a counter that went back was reset, by a new station or interface */
+    c = (unsigned long long *)&cur;
+    b = (unsigned long long *)&base->stats;
+    d = (unsigned long long *)&delta;
+    for(i = 0; i < WFA_NL_STATS_NUM; i++)
+        d[i] = (c[i] >= b[i]) ? c[i] - b[i] : c[i];
+
+    base->stats = cur;
+    base->at = now;
+    wPT_MUTEX_UNLOCK(&statsMutex);
 
-    /* this is never used, you can skip this call */
+    ifStats->txFrames = (int)delta.txPackets;
+    ifStats->rxFrames = (int)delta.rxPackets;
+    ifStats->txMulticast = 0;               /* not counted by the kernel */
+    ifStats->rxMulticast = (int)delta.rxMulticast;
+    ifStats->fcsErrors = (int)delta.rxCrcErrors;
+    ifStats->txRetries = (int)delta.txRetries;
 
-    statsResp->status = STATUS_ERROR;
-    wfaEncodeTLV(WFA_STA_GET_STATS_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)statsResp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    wSTRNCPY(ifStats->wireless, wlSrcNames[wlSrc], sizeof(ifStats->wireless) - 1);
+    ifStats->txPackets = delta.txPackets;
+    ifStats->rxPackets = delta.rxPackets;
+    ifStats->txBytes = delta.txBytes;
+    ifStats->rxBytes = delta.rxBytes;
+    ifStats->txErrors = delta.txErrors;
+    ifStats->rxErrors = delta.rxErrors;
+    ifStats->txDropped = delta.txDropped;
+    ifStats->rxDropped = delta.rxDropped;
+    ifStats->rxMulticast64 = delta.rxMulticast;
+    ifStats->rxCrcErrors = delta.rxCrcErrors;
+    ifStats->rxFifoErrors = delta.rxFifoErrors;
+    ifStats->rxMissed = delta.rxMissed;
+    ifStats->txFifoErrors = delta.txFifoErrors;
+    ifStats->qdiscDrops = delta.qdiscDrops;
+    ifStats->qdiscRequeues = delta.qdiscRequeues;
+    ifStats->txRetries64 = delta.txRetries;
+    ifStats->txFailed = delta.txFailed;
+    ifStats->beaconLoss = delta.beaconLoss;
+    ifStats->rxDropMisc = delta.rxDropMisc;
 
+    statsResp->status = STATUS_COMPLETE;
+    *respLen = wfaEncodeResp(WFA_STA_GET_STATS_RESP_TLV, statsResp, sizeof(dutCmdResponse_t), respBuf);
 
     return WFA_SUCCESS;
 }
@@ -720,35 +573,33 @@ int wfaSetEncryption1(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
     caStaSetEncryption_t *setEncryp = (caStaSetEncryption_t *)caCmdBuf;
     dutCmdResponse_t *setEncrypResp = &gGenericResp;
+    wfaWpaTxn_t txn;
+
+    wfaWpaTxnBegin(&txn, setEncryp->intf, 0);
 
     /*
      * disable the network first
      */
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", setEncryp->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "DISABLE_NETWORK 0");
 
     /*
      * set SSID
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", setEncryp->intf, setEncryp->ssid);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "ssid", "\"%s\"", setEncryp->ssid);
 
     /*
      * Tell the supplicant for infrastructure mode (1)
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 mode 0", setEncryp->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "mode", "0");
 
     /*
      * set Key management to NONE (NO WPA) for plaintext or WEP
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt NONE", setEncryp->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "key_mgmt", "NONE");
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", setEncryp->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "ENABLE_NETWORK 0");
 
-    setEncrypResp->status = STATUS_COMPLETE;
+    setEncrypResp->status = (wfaWpaTxnCommit(&txn) == WFA_SUCCESS) ? STATUS_COMPLETE : STATUS_ERROR;
     wfaEncodeTLV(WFA_STA_SET_ENCRYPTION_RESP_TLV, 4, (BYTE *)setEncrypResp, respBuf);
     *respLen = WFA_TLV_HDR_LEN + 4;
 
@@ -763,31 +614,31 @@ int wfaSetEncryption(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
     caStaSetEncryption_t *setEncryp = (caStaSetEncryption_t *)caCmdBuf;
     dutCmdResponse_t *setEncrypResp = &gGenericResp;
+    wfaWpaTxn_t txn;
+    char var[WFA_BUFF_32];
     int i;
 
+    wfaWpaTxnBegin(&txn, setEncryp->intf, 0);
+
     /*
      * disable the network first
      */
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", setEncryp->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "DISABLE_NETWORK 0");
 
     /*
      * set SSID
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", setEncryp->intf, setEncryp->ssid);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "ssid", "\"%s\"", setEncryp->ssid);
 
     /*
      * Tell the supplicant for infrastructure mode (1)
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 mode 0", setEncryp->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "mode", "0");
 
     /*
      * set Key management to NONE (NO WPA) for plaintext or WEP
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt NONE", setEncryp->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "key_mgmt", "NONE");
 
     /* set keys */
     if(setEncryp->encpType == 1)
@@ -796,9 +647,8 @@ int wfaSetEncryption(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             if(setEncryp->keys[i][0] != '\0')
             {
-                sprintf(gCmdStr, "wpa_cli -i %s set_network 0 wep_key%i %s",
-                        setEncryp->intf, i, setEncryp->keys[i]);
-                sret = system(gCmdStr);
+                sprintf(var, "wep_key%i", i);
+                wfaWpaTxnSet(&txn, var, "%s", setEncryp->keys[i]);
             }
         }
 
@@ -806,9 +656,7 @@ int wfaSetEncryption(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         i = setEncryp->activeKeyIdx;
         if(setEncryp->keys[i][0] != '\0')
         {
-            sprintf(gCmdStr, "wpa_cli -i %s set_network 0 wep_tx_keyidx %i",
-                    setEncryp->intf, setEncryp->activeKeyIdx);
-            sret = system(gCmdStr);
+            wfaWpaTxnSet(&txn, "wep_tx_keyidx", "%i", setEncryp->activeKeyIdx);
         }
     }
     else /* clearly remove the keys -- reported by p.schwann */
@@ -816,15 +664,14 @@ int wfaSetEncryption(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
         for(i = 0; i < 4; i++)
         {
-            sprintf(gCmdStr, "wpa_cli -i %s set_network 0 wep_key%i \"\"", setEncryp->intf, i);
-            sret = system(gCmdStr);
+            sprintf(var, "wep_key%i", i);
+            wfaWpaTxnSet(&txn, var, "\"\"");
         }
     }
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", setEncryp->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "ENABLE_NETWORK 0");
 
-    setEncrypResp->status = STATUS_COMPLETE;
+    setEncrypResp->status = (wfaWpaTxnCommit(&txn) == WFA_SUCCESS) ? STATUS_COMPLETE : STATUS_ERROR;
     wfaEncodeTLV(WFA_STA_SET_ENCRYPTION_RESP_TLV, 4, (BYTE *)setEncrypResp, respBuf);
     *respLen = WFA_TLV_HDR_LEN + 4;
 
@@ -852,6 +699,9 @@ int wfaStaSetEapTLS(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     caStaSetEapTLS_t *setTLS = (caStaSetEapTLS_t *)caCmdBuf;
     char *ifname = setTLS->intf;
     dutCmdResponse_t *setEapTlsResp = &gGenericResp;
+#ifndef WFA_NEW_CLI_FORMAT
+    wfaWpaTxn_t txn;
+#endif
 
     DPRINT_INFO(WFA_OUT, "Entering wfaStaSetEapTLS ...\n");
 
@@ -859,16 +709,15 @@ int wfaStaSetEapTLS(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
      * need to store the trustedROOTCA and clientCertificate into a file first.
      */
 #ifdef WFA_NEW_CLI_FORMAT
-    sprintf(gCmdStr, "wfa_set_eaptls -i %s %s %s %s", ifname, setTLS->ssid, setTLS->trustedRootCA, setTLS->clientCertificate);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wfa_set_eaptls -i %s %s %s %s", ifname, setTLS->ssid, setTLS->trustedRootCA, setTLS->clientCertificate);
+    setEapTlsResp->status = STATUS_COMPLETE;
 #else
+    wfaWpaTxnBegin(&txn, ifname, 0);
 
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "DISABLE_NETWORK 0");
 
     /* ssid */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", ifname, setTLS->ssid);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "ssid", "\"%s\"", setTLS->ssid);
 
     /* key management */
     if(strcasecmp(setTLS->keyMgmtType, "wpa2-sha256") == 0)
@@ -883,7 +732,7 @@ int wfaStaSetEapTLS(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     }
     else if(strcasecmp(setTLS->keyMgmtType, "wpa") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-EAP", ifname);
+        wfaWpaTxnSet(&txn, "key_mgmt", "WPA-EAP");
     }
     else if(strcasecmp(setTLS->keyMgmtType, "wpa2") == 0)
     {
@@ -893,32 +742,25 @@ int wfaStaSetEapTLS(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     {
         // ??
     }
-    sret = system(gCmdStr);
 
     /* protocol WPA */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 proto WPA", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "proto", "WPA");
+
+    wfaWpaTxnSet(&txn, "eap", "TLS");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 eap TLS", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "ca_cert", "\"%s\"", setTLS->trustedRootCA);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ca_cert '\"%s\"'", ifname, setTLS->trustedRootCA);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "identity", "\"wifi-user@wifilabs.local\"");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 identity '\"wifi-user@wifilabs.local\"'", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "private_key", "\"%s/%s\"", CERTIFICATES_PATH, setTLS->clientCertificate);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 private_key '\"%s/%s\"'", ifname, CERTIFICATES_PATH, setTLS->clientCertificate);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "private_key_passwd", "\"wifi\"");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 private_key_passwd '\"wifi\"'", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "ENABLE_NETWORK 0");
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", ifname);
-    sret = system(gCmdStr);
+    setEapTlsResp->status = (wfaWpaTxnCommit(&txn) == WFA_SUCCESS) ? STATUS_COMPLETE : STATUS_ERROR;
 #endif
 
-    setEapTlsResp->status = STATUS_COMPLETE;
     wfaEncodeTLV(WFA_STA_SET_EAPTLS_RESP_TLV, 4, (BYTE *)setEapTlsResp, respBuf);
     *respLen = WFA_TLV_HDR_LEN + 4;
 
@@ -936,18 +778,21 @@ int wfaStaSetPSK(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
     /*Incompleted function*/
     dutCmdResponse_t *setPskResp = &gGenericResp;
+    int status = STATUS_COMPLETE;
 
 #ifndef WFA_PC_CONSOLE
     caStaSetPSK_t *setPSK = (caStaSetPSK_t *)caCmdBuf;
 #ifdef WFA_NEW_CLI_FORMAT
-    sprintf(gCmdStr, "wfa_set_psk %s %s %s", setPSK->intf, setPSK->ssid, setPSK->passphrase);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wfa_set_psk %s %s %s", setPSK->intf, setPSK->ssid, setPSK->passphrase);
 #else
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", setPSK->intf, setPSK->ssid);
-    sret = system(gCmdStr);
+    wfaWpaTxn_t txn;
+
+    wfaWpaTxnBegin(&txn, setPSK->intf, 0);
+
+    wfaWpaTxnSet(&txn, "ssid", "\"%s\"", setPSK->ssid);
 
     if(strcasecmp(setPSK->keyMgmtType, "wpa2-sha256") == 0)
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA2-SHA256", setPSK->intf);
+        wfaWpaTxnSet(&txn, "key_mgmt", "WPA-PSK-SHA256");
     else if(strcasecmp(setPSK->keyMgmtType, "wpa2") == 0)
     {
         // take all and device to pick it supported.
@@ -965,15 +810,11 @@ int wfaStaSetPSK(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
     }
     else
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-PSK", setPSK->intf);
-
-    sret = system(gCmdStr);
+        wfaWpaTxnSet(&txn, "key_mgmt", "WPA-PSK");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 psk '\"%s\"'", setPSK->intf, setPSK->passphrase);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "psk", "\"%s\"", setPSK->passphrase);
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", setPSK->intf);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "ENABLE_NETWORK 0");
 
     /* if PMF enable */
     if(setPSK->pmf == WFA_ENABLED || setPSK->pmf == WFA_OPTIONAL)
@@ -998,11 +839,13 @@ int wfaStaSetPSK(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
     }
 
+    if(wfaWpaTxnCommit(&txn) != WFA_SUCCESS)
+        status = STATUS_ERROR;
 #endif
 
 #endif
 
-    setPskResp->status = STATUS_COMPLETE;
+    setPskResp->status = status;
     wfaEncodeTLV(WFA_STA_SET_PSK_RESP_TLV, 4, (BYTE *)setPskResp, respBuf);
     *respLen = WFA_TLV_HDR_LEN + 4;
 
@@ -1046,29 +889,28 @@ int wfaStaSetEapTTLS(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     caStaSetEapTTLS_t *setTTLS = (caStaSetEapTTLS_t *)caCmdBuf;
     char *ifname = setTTLS->intf;
     dutCmdResponse_t *setEapTtlsResp = &gGenericResp;
+#ifndef WFA_NEW_CLI_FORMAT
+    wfaWpaTxn_t txn;
+#endif
 
 #ifdef WFA_NEW_CLI_FORMAT
-    sprintf(gCmdStr, "wfa_set_eapttls %s %s %s %s %s", ifname, setTTLS->ssid, setTTLS->username, setTTLS->passwd, setTTLS->trustedRootCA);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wfa_set_eapttls %s %s %s %s %s", ifname, setTTLS->ssid, setTTLS->username, setTTLS->passwd, setTTLS->trustedRootCA);
+    setEapTtlsResp->status = STATUS_COMPLETE;
 #else
+    wfaWpaTxnBegin(&txn, ifname, 0);
 
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "DISABLE_NETWORK 0");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", ifname, setTTLS->ssid);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "ssid", "\"%s\"", setTTLS->ssid);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 identity '\"%s\"'", ifname, setTTLS->username);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "identity", "\"%s\"", setTTLS->username);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 password '\"%s\"'", ifname, setTTLS->passwd);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "password", "\"%s\"", setTTLS->passwd);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-EAP", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "key_mgmt", "WPA-EAP");
 
     /* This may not need to set. if it is not set, default to take all */
-//   sprintf(cmdStr, "wpa_cli -i %s set_network 0 pairwise '\"%s\"", ifname, setTTLS->encrptype);
+//   wfaWpaTxnSet(&txn, "pairwise", "%s", setTTLS->encrptype);
     if(strcasecmp(setTTLS->keyMgmtType, "wpa2-sha256") == 0)
     {
     }
@@ -1091,25 +933,20 @@ int wfaStaSetEapTTLS(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     {
         // ??
     }
-    sret = system(gCmdStr);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 eap TTLS", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "eap", "TTLS");
+
+    wfaWpaTxnSet(&txn, "ca_cert", "\"%s/%s\"", CERTIFICATES_PATH, setTTLS->trustedRootCA);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ca_cert '\"%s/%s\"'", ifname, CERTIFICATES_PATH, setTTLS->trustedRootCA);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "proto", "WPA");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 proto WPA", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnSet(&txn, "phase2", "\"auth=MSCHAPV2\"");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 phase2 '\"auth=MSCHAPV2\"'", ifname);
-    sret = system(gCmdStr);
+    wfaWpaTxnCmd(&txn, "ENABLE_NETWORK 0");
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", ifname);
-    sret = system(gCmdStr);
+    setEapTtlsResp->status = (wfaWpaTxnCommit(&txn) == WFA_SUCCESS) ? STATUS_COMPLETE : STATUS_ERROR;
 #endif
 
-    setEapTtlsResp->status = STATUS_COMPLETE;
     wfaEncodeTLV(WFA_STA_SET_EAPTTLS_RESP_TLV, 4, (BYTE *)setEapTtlsResp, respBuf);
     *respLen = WFA_TLV_HDR_LEN + 4;
 
@@ -1132,47 +969,39 @@ int wfaStaSetEapSIM(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     dutCmdResponse_t *setEapSimResp = &gGenericResp;
 
 #ifdef WFA_NEW_CLI_FORMAT
-    sprintf(gCmdStr, "wfa_set_eapsim %s %s %s %s", ifname, setSIM->ssid, setSIM->username, setSIM->encrptype);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wfa_set_eapsim %s %s %s %s", ifname, setSIM->ssid, setSIM->username, setSIM->encrptype);
 #else
 
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaCmd(ifname, "DISABLE_NETWORK 0");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", ifname, setSIM->ssid);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "ssid", "\"%s\"", setSIM->ssid);
 
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 identity '\"%s\"'", ifname, setSIM->username);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "identity", "\"%s\"", setSIM->username);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 pairwise '\"%s\"'", ifname, setSIM->encrptype);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "pairwise", "\"%s\"", setSIM->encrptype);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 eap SIM", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "eap", "SIM");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 proto WPA", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "proto", "WPA");
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaCmd(ifname, "ENABLE_NETWORK 0");
 
     if(strcasecmp(setSIM->keyMgmtType, "wpa2-sha256") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-SHA256", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-SHA256");
     }
     else if(strcasecmp(setSIM->keyMgmtType, "wpa2-eap") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-EAP", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-EAP");
     }
     else if(strcasecmp(setSIM->keyMgmtType, "wpa2-ft") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-FT", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-FT");
     }
     else if(strcasecmp(setSIM->keyMgmtType, "wpa") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-EAP", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-EAP");
     }
     else if(strcasecmp(setSIM->keyMgmtType, "wpa2") == 0)
     {
@@ -1182,7 +1011,6 @@ int wfaStaSetEapSIM(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     {
         // ??
     }
-    sret = system(gCmdStr);
 
 #endif
 
@@ -1212,49 +1040,41 @@ int wfaStaSetPEAP(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     dutCmdResponse_t *setPeapResp = &gGenericResp;
 
 #ifdef WFA_NEW_CLI_FORMAT
-    sprintf(gCmdStr, "wfa_set_peap %s %s %s %s %s %s %i %s", ifname, setPEAP->ssid, setPEAP->username,
-            setPEAP->passwd, setPEAP->trustedRootCA,
-            setPEAP->encrptype, setPEAP->peapVersion,
-            setPEAP->innerEAP);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wfa_set_peap %s %s %s %s %s %s %i %s", ifname, setPEAP->ssid, setPEAP->username,
+           setPEAP->passwd, setPEAP->trustedRootCA,
+           setPEAP->encrptype, setPEAP->peapVersion,
+           setPEAP->innerEAP);
 #else
 
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaCmd(ifname, "DISABLE_NETWORK 0");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", ifname, setPEAP->ssid);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "ssid", "\"%s\"", setPEAP->ssid);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 eap PEAP", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "eap", "PEAP");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 anonymous_identity '\"anonymous\"' ", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "anonymous_identity", "\"anonymous\"");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 identity '\"%s\"'", ifname, setPEAP->username);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "identity", "\"%s\"", setPEAP->username);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 password '\"%s\"'", ifname, setPEAP->passwd);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "password", "\"%s\"", setPEAP->passwd);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ca_cert '\"%s/%s\"'", ifname, CERTIFICATES_PATH, setPEAP->trustedRootCA);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "ca_cert", "\"%s/%s\"", CERTIFICATES_PATH, setPEAP->trustedRootCA);
 
     if(strcasecmp(setPEAP->keyMgmtType, "wpa2-sha256") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-SHA256", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-SHA256");
     }
     else if(strcasecmp(setPEAP->keyMgmtType, "wpa2-eap") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-EAP", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-EAP");
     }
     else if(strcasecmp(setPEAP->keyMgmtType, "wpa2-ft") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-FT", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-FT");
     }
     else if(strcasecmp(setPEAP->keyMgmtType, "wpa") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-EAP", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-EAP");
     }
     else if(strcasecmp(setPEAP->keyMgmtType, "wpa2") == 0)
     {
@@ -1264,16 +1084,12 @@ int wfaStaSetPEAP(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     {
         // ??
     }
-    sret = system(gCmdStr);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 phase1 '\"peaplabel=%i\"'", ifname, setPEAP->peapVersion);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "phase1", "\"peaplabel=%i\"", setPEAP->peapVersion);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 phase2 '\"auth=%s\"'", ifname, setPEAP->innerEAP);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "phase2", "\"auth=%s\"", setPEAP->innerEAP);
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaCmd(ifname, "ENABLE_NETWORK 0");
 #endif
 
     setPeapResp->status = STATUS_COMPLETE;
@@ -1298,14 +1114,13 @@ int wfaStaSetUAPSD(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     caStaSetUAPSD_t *setUAPSD = (caStaSetUAPSD_t *)caCmdBuf;
     char *ifname = setUAPSD->intf;
     char tmpStr[10];
-    char line[100];
+    struct utsname uts;
     char *pathl="/etc/Wireless/RT61STA";
     BYTE acBE=1;
     BYTE acBK=1;
     BYTE acVO=1;
     BYTE acVI=1;
     BYTE APSDCapable;
-    FILE *pipe;
 
     /*
      * A series of setting need to be done before doing WMM-PS
@@ -1315,13 +1130,11 @@ int wfaStaSetUAPSD(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     /*
      * bring down the interface
      */
-    sprintf(gCmdStr, "ifconfig %s down",ifname);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "ifconfig %s down",ifname);
     /*
      * Unload the Driver
      */
-    sprintf(gCmdStr, "rmmod rt61");
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "rmmod rt61");
 #ifndef WFA_WMM_AC
     if(setUAPSD->acBE != 1)
         acBE=setUAPSD->acBE = 0;
@@ -1344,24 +1157,15 @@ int wfaStaSetUAPSD(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
      */
 
     sprintf(tmpStr,"%d;%d;%d;%d",setUAPSD->acBE,setUAPSD->acBK,setUAPSD->acVI,setUAPSD->acVO);
-    sprintf(gCmdStr, "sed -e \"s/APSDCapable=.*/APSDCapable=%d/g\" -e \"s/APSDAC=.*/APSDAC=%s/g\" %s/rt61sta.dat >/tmp/wfa_tmp",APSDCapable,tmpStr,pathl);
-    sret = system(gCmdStr);
-
-    sprintf(gCmdStr, "mv /tmp/wfa_tmp %s/rt61sta.dat",pathl);
-    sret = system(gCmdStr);
-    pipe = popen("uname -r", "r");
-    /* Read into line the output of uname*/
-    fscanf(pipe,"%s",line);
-    pclose(pipe);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "sed -i -e s/APSDCapable=.*/APSDCapable=%d/g -e s/APSDAC=.*/APSDAC=%s/g %s/rt61sta.dat",APSDCapable,tmpStr,pathl);
 
     /*
      * load the Driver
      */
-    sprintf(gCmdStr, "insmod /lib/modules/%s/extra/rt61.ko",line);
-    sret = system(gCmdStr);
+    uname(&uts);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "insmod /lib/modules/%s/extra/rt61.ko",uts.release);
 
-    sprintf(gCmdStr, "ifconfig %s up",ifname);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "ifconfig %s up",ifname);
 #endif
 
     setUAPSDResp->status = STATUS_COMPLETE;
@@ -1389,8 +1193,7 @@ int wfaDeviceGetInfo(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     }
 
     infoResp->status = STATUS_COMPLETE;
-    wfaEncodeTLV(WFA_DEVICE_GET_INFO_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)infoResp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_DEVICE_GET_INFO_RESP_TLV, infoResp, sizeof(dutCmdResponse_t), respBuf);
 
     return WFA_SUCCESS;
 
@@ -1442,8 +1245,7 @@ int wfaDeviceListIF(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     }
     }
 
-    wfaEncodeTLV(WFA_DEVICE_LIST_IF_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)infoResp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_DEVICE_LIST_IF_RESP_TLV, infoResp, sizeof(dutCmdResponse_t), respBuf);
 
     return WFA_SUCCESS;
 }
@@ -1461,8 +1263,7 @@ int wfaStaDebugSet(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         wfa_defined_debug = (~debugSet->cmdsu.dbg.level & wfa_defined_debug);
 
     debugResp->status = STATUS_COMPLETE;
-    wfaEncodeTLV(WFA_STA_GET_INFO_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)debugResp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_STA_GET_INFO_RESP_TLV, debugResp, sizeof(dutCmdResponse_t), respBuf);
 
 
     return WFA_SUCCESS;
@@ -1475,54 +1276,18 @@ int wfaStaDebugSet(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
  */
 int wfaStaGetBSSID(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
-    char string[64];
-    char *str;
-    FILE *tmpfd;
+    dutCommand_t *getBssid = (dutCommand_t *)caCmdBuf;
     dutCmdResponse_t *bssidResp = &gGenericResp;
 
     DPRINT_INFO(WFA_OUT, "Entering wfaStaGetBSSID ...\n");
-    /* retrieve the BSSID */
-    sprintf(gCmdStr, "wpa_cli status > /tmp/bssid.txt");
-
-    sret = system(gCmdStr);
+    /* retrieve the BSSID, none until the station is associated */
+    if(wfaIfcWpaStatus(getBssid->intf, "bssid", bssidResp->cmdru.bssid,
+                        sizeof(bssidResp->cmdru.bssid)) != WFA_SUCCESS)
+        strcpy(bssidResp->cmdru.bssid, "00:00:00:00:00:00");
 
-    tmpfd = fopen("/tmp/bssid.txt", "r+");
-    if(tmpfd == NULL)
-    {
-        bssidResp->status = STATUS_ERROR;
-        wfaEncodeTLV(WFA_STA_GET_BSSID_RESP_TLV, 4, (BYTE *)bssidResp, respBuf);
-        *respLen = WFA_TLV_HDR_LEN + 4;
-
-        DPRINT_ERR(WFA_ERR, "file open failed\n");
-        return WFA_FAILURE;
-    }
+    bssidResp->status = STATUS_COMPLETE;
+    *respLen = wfaEncodeResp(WFA_STA_GET_BSSID_RESP_TLV, bssidResp, sizeof(dutCmdResponse_t), respBuf);
 
-    for(;;)
-    {
-        if(fscanf(tmpfd, "%s", string) == EOF)
-        {
-            bssidResp->status = STATUS_COMPLETE;
-            strcpy(bssidResp->cmdru.bssid, "00:00:00:00:00:00");
-            break;
-        }
-
-        if(strncmp(string, "bssid", 5) == 0)
-        {
-            str = strtok(string, "=");
-            str = strtok(NULL, "=");
-            if(str != NULL)
-            {
-                strcpy(bssidResp->cmdru.bssid, str);
-                bssidResp->status = STATUS_COMPLETE;
-                break;
-            }
-        }
-    }
-
-    wfaEncodeTLV(WFA_STA_GET_BSSID_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)bssidResp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
-
-    fclose(tmpfd);
     return WFA_SUCCESS;
 }
 
@@ -1548,32 +1313,27 @@ int wfaStaSetIBSS(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     /*
      * disable the network first
      */
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", setIBSS->intf);
-    sret = system(gCmdStr);
+    wfaWpaCmd(setIBSS->intf, "DISABLE_NETWORK 0");
 
     /*
      * set SSID
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", setIBSS->intf, setIBSS->ssid);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(setIBSS->intf, 0, "ssid", "\"%s\"", setIBSS->ssid);
 
     /*
      * Set channel for IBSS
      */
-    sprintf(gCmdStr, "iwconfig %s channel %i", setIBSS->intf, setIBSS->channel);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "iwconfig %s channel %i", setIBSS->intf, setIBSS->channel);
 
     /*
      * Tell the supplicant for IBSS mode (1)
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 mode 1", setIBSS->intf);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(setIBSS->intf, 0, "mode", "1");
 
     /*
      * set Key management to NONE (NO WPA) for plaintext or WEP
      */
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt NONE", setIBSS->intf);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(setIBSS->intf, 0, "key_mgmt", "NONE");
 
     if(setIBSS->encpType == 1)
     {
@@ -1581,23 +1341,18 @@ int wfaStaSetIBSS(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             if(strlen(setIBSS->keys[i]) ==5 || strlen(setIBSS->keys[i]) == 13)
             {
-                sprintf(gCmdStr, "wpa_cli -i %s set_network 0 wep_key%i \"%s\"",
-                        setIBSS->intf, i, setIBSS->keys[i]);
-                sret = system(gCmdStr);
+                wfaWpaCmd(setIBSS->intf, "SET_NETWORK 0 wep_key%i \"%s\"", i, setIBSS->keys[i]);
             }
         }
 
         i = setIBSS->activeKeyIdx;
         if(strlen(setIBSS->keys[i]) ==5 || strlen(setIBSS->keys[i]) == 13)
         {
-            sprintf(gCmdStr, "wpa_cli -i %s set_network 0 wep_tx_keyidx %i",
-                    setIBSS->intf, setIBSS->activeKeyIdx);
-            sret = system(gCmdStr);
+            wfaWpaSetNetwork(setIBSS->intf, 0, "wep_tx_keyidx", "%i", setIBSS->activeKeyIdx);
         }
     }
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", setIBSS->intf);
-    sret = system(gCmdStr);
+    wfaWpaCmd(setIBSS->intf, "ENABLE_NETWORK 0");
 
     setIbssResp->status = STATUS_COMPLETE;
     wfaEncodeTLV(WFA_STA_SET_IBSS_RESP_TLV, 4, (BYTE *)setIbssResp, respBuf);
@@ -1628,25 +1383,20 @@ int wfaStaSetMode(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     /*
      * bring down the interface
      */
-    sprintf(gCmdStr, "ifconfig %s down",setmode->intf);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "ifconfig %s down",setmode->intf);
 
     /*
      * distroy the interface
      */
-    sprintf(gCmdStr, "wlanconfig %s destroy",setmode->intf);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wlanconfig %s destroy",setmode->intf);
 
 
     /*
      * re-create the interface with the given mode
      */
-    if(setmode->mode == 1)
-        sprintf(gCmdStr, "wlanconfig %s create wlandev wifi0 wlanmode adhoc",setmode->intf);
-    else
-        sprintf(gCmdStr, "wlanconfig %s create wlandev wifi0 wlanmode managed",setmode->intf);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wlanconfig %s create wlandev wifi0 wlanmode %s",
+           setmode->intf, setmode->mode == 1 ? "adhoc" : "managed");
 
-    sret = system(gCmdStr);
     if(setmode->encpType == ENCRYPT_WEP)
     {
         int j = setmode->activeKeyIdx;
@@ -1654,39 +1404,34 @@ int wfaStaSetMode(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             if(setmode->keys[i][0] != '\0')
             {
-                sprintf(gCmdStr, "iwconfig  %s key  s:%s",
-                        setmode->intf, setmode->keys[i]);
-                sret = system(gCmdStr);
+                wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "iwconfig %s key s:%s",
+                       setmode->intf, setmode->keys[i]);
             }
-            /* set active key */
-            if(setmode->keys[j][0] != '\0')
-                sprintf(gCmdStr, "iwconfig  %s key  s:%s",
-                        setmode->intf, setmode->keys[j]);
-            sret = system(gCmdStr);
         }
 
+        /* set active key */
+        if(setmode->keys[j][0] != '\0')
+            wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "iwconfig %s key s:%s",
+                   setmode->intf, setmode->keys[j]);
     }
     /*
      * Set channel for IBSS
      */
     if(setmode->channel)
     {
-        sprintf(gCmdStr, "iwconfig %s channel %i", setmode->intf, setmode->channel);
-        sret = system(gCmdStr);
+        wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "iwconfig %s channel %i", setmode->intf, setmode->channel);
     }
 
 
     /*
      * set SSID
      */
-    sprintf(gCmdStr, "iwconfig %s essid %s", setmode->intf, setmode->ssid);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "iwconfig %s essid \"%s\"", setmode->intf, setmode->ssid);
 
     /*
      * bring up the interface
      */
-    sprintf(gCmdStr, "ifconfig %s up",setmode->intf);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "ifconfig %s up",setmode->intf);
 
     SetModeResp->status = STATUS_COMPLETE;
     wfaEncodeTLV(WFA_STA_SET_MODE_RESP_TLV, 4, (BYTE *)SetModeResp, respBuf);
@@ -1700,8 +1445,7 @@ int wfaStaSetPwrSave(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     caStaSetPwrSave_t *setps = (caStaSetPwrSave_t *)caCmdBuf;
     dutCmdResponse_t *SetPSResp = &gGenericResp;
 
-    sprintf(gCmdStr, "iwconfig %s power %s", setps->intf, setps->mode);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "iwconfig %s power %s", setps->intf, setps->mode);
 
 
     SetPSResp->status = STATUS_COMPLETE;
@@ -1761,8 +1505,7 @@ int wfaStaUpload(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         upld->nbytes = rbytes;
 
         upLoadResp->status = STATUS_COMPLETE;
-        wfaEncodeTLV(WFA_STA_UPLOAD_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)upLoadResp, respBuf);
-        *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+        *respLen = wfaEncodeResp(WFA_STA_UPLOAD_RESP_TLV, upLoadResp, sizeof(dutCmdResponse_t), respBuf);
     }
     else
     {
@@ -1873,7 +1616,7 @@ int wfaStaSetWMM(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
             //tspec should be set here.
 
-            sret = system(gCmdStr);
+            wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "%s", gCmdStr);
         }
         else if (setwmm->action == WMMAC_DELTS)
         {
@@ -1884,20 +1627,25 @@ int wfaStaSetWMM(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         break;
 
     case GROUP_WMMCONF:
-        sprintf(gCmdStr, "iwconfig %s rts %d",
-                ifname,setwmm->actions.config.rts_thr);
-
-        sret = system(gCmdStr);
-        sprintf(gCmdStr, "iwconfig %s frag %d",
-                ifname,setwmm->actions.config.frag_thr);
-
-        sret = system(gCmdStr);
-        sprintf(gCmdStr, "iwpriv %s wmmcfg %d",
-                ifname, setwmm->actions.config.wmm);
-
-        sret = system(gCmdStr);
+    {
+        wfaProc_t procs[3];
+        int num = 0;
+
+        /* the three settings do not depend on each other, run them side by side */
+        if(wfaSpawn(&procs[num], NULL, 0, "iwconfig %s rts %d",
+                    ifname,setwmm->actions.config.rts_thr) == WFA_SUCCESS)
+            num++;
+        if(wfaSpawn(&procs[num], NULL, 0, "iwconfig %s frag %d",
+                    ifname,setwmm->actions.config.frag_thr) == WFA_SUCCESS)
+            num++;
+        if(wfaSpawn(&procs[num], NULL, 0, "iwpriv %s wmmcfg %d",
+                    ifname, setwmm->actions.config.wmm) == WFA_SUCCESS)
+            num++;
+
+        wfaSpawnWait(procs, num, WFA_RUN_TMOUT_MS);
         setwmmResp->status = STATUS_COMPLETE;
         break;
+    }
 
     default:
         DPRINT_ERR(WFA_ERR, "The group %d is not supported\n",setwmm->group);
@@ -1935,23 +1683,18 @@ int wfaStaSetEapFAST(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     dutCmdResponse_t *setEapFastResp = &gGenericResp;
 
 #ifdef WFA_NEW_CLI_FORMAT
-    sprintf(gCmdStr, "wfa_set_eapfast %s %s %s %s %s %s", ifname, setFAST->ssid, setFAST->username,
-            setFAST->passwd, setFAST->pacFileName,
-            setFAST->innerEAP);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wfa_set_eapfast %s %s %s %s %s %s", ifname, setFAST->ssid, setFAST->username,
+           setFAST->passwd, setFAST->pacFileName,
+           setFAST->innerEAP);
 #else
 
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaCmd(ifname, "DISABLE_NETWORK 0");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", ifname, setFAST->ssid);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "ssid", "\"%s\"", setFAST->ssid);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 identity '\"%s\"'", ifname, setFAST->username);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "identity", "\"%s\"", setFAST->username);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 password '\"%s\"'", ifname, setFAST->passwd);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "password", "\"%s\"", setFAST->passwd);
 
     if(strcasecmp(setFAST->keyMgmtType, "wpa2-sha256") == 0)
     {
@@ -1965,7 +1708,7 @@ int wfaStaSetEapFAST(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     }
     else if(strcasecmp(setFAST->keyMgmtType, "wpa") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-EAP", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-EAP");
     }
     else if(strcasecmp(setFAST->keyMgmtType, "wpa2") == 0)
     {
@@ -1975,25 +1718,18 @@ int wfaStaSetEapFAST(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     {
         // ??
     }
-    sret = system(gCmdStr);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 eap FAST", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "eap", "FAST");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 pac_file '\"%s/%s\"'", ifname, CERTIFICATES_PATH,     setFAST->pacFileName);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "pac_file", "\"%s/%s\"", CERTIFICATES_PATH, setFAST->pacFileName);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 anonymous_identity '\"anonymous\"'", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "anonymous_identity", "\"anonymous\"");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 phase1 '\"fast_provisioning=1\"'", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "phase1", "\"fast_provisioning=1\"");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 phase2 '\"auth=%s\"'", ifname,setFAST->innerEAP);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "phase2", "\"auth=%s\"", setFAST->innerEAP);
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaCmd(ifname, "ENABLE_NETWORK 0");
 #endif
 
     setEapFastResp->status = STATUS_COMPLETE;
@@ -2010,15 +1746,12 @@ int wfaStaSetEapAKA(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     dutCmdResponse_t *setEapAkaResp = &gGenericResp;
 
 #ifdef WFA_NEW_CLI_FORMAT
-    sprintf(gCmdStr, "wfa_set_eapaka %s %s %s %s", ifname, setAKA->ssid, setAKA->username, setAKA->passwd);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "wfa_set_eapaka %s %s %s %s", ifname, setAKA->ssid, setAKA->username, setAKA->passwd);
 #else
 
-    sprintf(gCmdStr, "wpa_cli -i %s disable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaCmd(ifname, "DISABLE_NETWORK 0");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 ssid '\"%s\"'", ifname, setAKA->ssid);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "ssid", "\"%s\"", setAKA->ssid);
 
     if(strcasecmp(setAKA->keyMgmtType, "wpa2-sha256") == 0)
     {
@@ -2032,7 +1765,7 @@ int wfaStaSetEapAKA(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     }
     else if(strcasecmp(setAKA->keyMgmtType, "wpa") == 0)
     {
-        sprintf(gCmdStr, "wpa_cli -i %s set_network 0 key_mgmt WPA-EAP", ifname);
+        wfaWpaSetNetwork(ifname, 0, "key_mgmt", "WPA-EAP");
     }
     else if(strcasecmp(setAKA->keyMgmtType, "wpa2") == 0)
     {
@@ -2042,27 +1775,19 @@ int wfaStaSetEapAKA(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     {
         // ??
     }
-    sret = system(gCmdStr);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 proto WPA2", ifname);
-    sret = system(gCmdStr);
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 proto CCMP", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "proto", "WPA2");
+    wfaWpaSetNetwork(ifname, 0, "proto", "CCMP");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 eap AKA", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "eap", "AKA");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 phase1 \"result_ind=1\"", ifname);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "phase1", "\"result_ind=1\"");
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 identity '\"%s\"'", ifname, setAKA->username);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "identity", "\"%s\"", setAKA->username);
 
-    sprintf(gCmdStr, "wpa_cli -i %s set_network 0 password '\"%s\"'", ifname, setAKA->passwd);
-    sret = system(gCmdStr);
+    wfaWpaSetNetwork(ifname, 0, "password", "\"%s\"", setAKA->passwd);
 
-    sprintf(gCmdStr, "wpa_cli -i %s enable_network 0", ifname);
-    sret = system(gCmdStr);
+    wfaWpaCmd(ifname, "ENABLE_NETWORK 0");
 #endif
 
     setEapAkaResp->status = STATUS_COMPLETE;
@@ -2079,11 +1804,9 @@ int wfaStaSetSystime(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
     DPRINT_INFO(WFA_OUT, "Entering wfaStaSetSystime ...\n");
 
-    sprintf(gCmdStr, "date %d-%d-%d",systime->month,systime->date,systime->year);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "date %d-%d-%d",systime->month,systime->date,systime->year);
 
-    sprintf(gCmdStr, "time %d:%d:%d", systime->hours,systime->minutes,systime->seconds);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "time %d:%d:%d", systime->hours,systime->minutes,systime->seconds);
 
     setSystimeResp->status = STATUS_COMPLETE;
     wfaEncodeTLV(WFA_STA_SET_SYSTIME_RESP_TLV, 4, (BYTE *)setSystimeResp, respBuf);
@@ -2099,9 +1822,7 @@ int wfaStaPresetParams(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     caStaPresetParameters_t *presetParams = (caStaPresetParameters_t *)caCmdBuf;
     BYTE presetDone = 1;
     int st = 0;
-   char cmdStr[128];
    char string[256];
-   FILE *tmpfd = NULL;
    long val;
    char *endptr;
 
@@ -2109,42 +1830,28 @@ int wfaStaPresetParams(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
    if (presetParams->supplicant == eWpaSupplicant)
    {
-	st = access("/tmp/processid.txt", F_OK);
-	if (st != -1)
+	/* the script prints the pids it found, no file is needed to get them */
+	st = wfaRun(string, sizeof(string), WFA_RUN_TMOUT_MS, "/usr/local/sbin/findprocess.sh %s /dev/null", "wpa_supplicant");
+	if (st == WFA_RUN_FAILED)
 	{
-	    st = remove("/tmp/processid.txt");
+	    DPRINT_ERR(WFA_ERR, "findprocess.sh could not be run\n");
+	    return WFA_FAILURE;
 	}
-	
-	sprintf(cmdStr, "/usr/local/sbin/findprocess.sh %s /tmp/processid.txt\n", "wpa_supplicant");
-	st = system(cmdStr);
-	
-	tmpfd = fopen("/tmp/processid.txt", "r+");
-	if (tmpfd == NULL)
+
+	errno = 0;
+	val = strtol(string, &endptr, 10);
+	if (errno != 0 && val == 0)
 	{
-	    DPRINT_ERR(WFA_ERR, "process id file not exist\n");
+	    DPRINT_ERR(WFA_ERR, "strtol error\n");
 	    return WFA_FAILURE;
 	}
-	
-	for (;;)
-	{
-	    if (fgets(string, 256, tmpfd) == NULL)
-	        break;
-
-	    errno = 0;
-	    val = strtol(string, &endptr, 10);
-	    if (errno != 0 && val == 0)
-	    {
-		DPRINT_ERR(WFA_ERR, "strtol error\n");
-		return WFA_FAILURE;
-	    }
-	
-	    if (endptr == string)
-	    {
-		DPRINT_ERR(WFA_ERR, "No wpa_supplicant instance was found\n");
-	    }
 
-	    presetDone = 1;
+	if (endptr == string)
+	{
+	    DPRINT_ERR(WFA_ERR, "No wpa_supplicant instance was found\n");
 	}
+
+	presetDone = 1;
    }
 
     if(presetParams->wmmFlag)
@@ -2191,7 +1898,7 @@ int wfaStaPresetParams(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     {
 
         printf("%s\n", gCmdStr);
-        sret = system(gCmdStr);
+        wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "%s", gCmdStr);
     }
 
     /************the followings are used for Voice Enterprise **************/
@@ -2451,8 +2158,7 @@ int wfaStaResetDefault(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
 
     // need to make your own command available for this, here is only an example
-    sprintf(gCmdStr, "myresetdefault %s program %s", reset->intf, reset->prog);
-    sret = system(gCmdStr);
+    wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "myresetdefault %s program %s", reset->intf, reset->prog);
 
     ResetResp->status = STATUS_COMPLETE;
     wfaEncodeTLV(WFA_STA_RESET_DEFAULT_RESP_TLV, 4, (BYTE *)ResetResp, respBuf);
@@ -2747,165 +2453,18 @@ int wfaStaDisconnect(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     return WFA_SUCCESS;
 }
 
-/* Execute CLI, read the status from Environment variable */
+/* Execute CLI, its exit code is the status */
 int wfaExecuteCLI(char *CLI)
 {
-    char *retstr;
+    int st;
 
-    sret = system(CLI);
-
-    retstr = getenv("WFA_CLI_STATUS");
-    printf("cli status %s\n", retstr);
-    return atoi(retstr);
+    st = wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "%s", CLI);
+    printf("cli status %d\n", st);
+    return st;
 }
 
 /* Supporting Functions */
 
-void wfaSendPing(tgPingStart_t *staPing, float *interval, int streamid)
-{
-    int totalpkts, tos=-1;
-    char cmdStr[256];
-//    char *addr = staPing->dipaddr;
-#ifdef WFA_PC_CONSOLE
-    char addr[40];
-    char bflag[] = "-b";
-    char *tmpstr;
-    int inum=0;
-#else
-    char bflag[] = "  ";
-#endif
-
-    totalpkts = (int)(staPing->duration * staPing->frameRate);
-
-#ifdef WFA_PC_CONSOLE
-
-    printf("\nwfa_cs.c wfaSendPing CS : The Stream ID is %d",streamid);
-    
-    strcpy(addr,staPing->dipaddr);
-	printf("\nCS :the addr is %s ",addr);
-    printf("\nCS :Inside the WFA_PC_CONSLE BLOCK");
-    printf("\nCS :the addr is %s ",addr);
-    if (staPing->iptype == 2)
-    {
-        memset(bflag, 0, strlen(bflag));
-    }
-    else
-    {
-        tmpstr = strtok(addr, ".");
-        inum = atoi(tmpstr);
-
-        printf("interval %f\n", *interval);
-
-        if(inum >= 224 && inum <= 239) // multicast
-        {
-        }
-        else // if not MC, check if it is BC address
-        {
-            printf("\nCS :Inside the BC address BLOCK");
-            printf("\nCS :the inum %d",inum);
-            strtok(NULL, ".");
-            //strtok(NULL, ".");
-            tmpstr = strtok(NULL, ".");
-            printf("tmpstr %s\n", tmpstr);
-            inum = atoi(tmpstr);
-            printf("\nCS : The string is %s",tmpstr);
-            if(inum != 255)
-                memset(bflag, 0, strlen(bflag));
-        }
-    }
-#endif
-    if ( staPing->dscp >= 0)
-    {
-        tos= convertDscpToTos(staPing->dscp);
-        if (tos < 0)
-            printf("\nwfaSendPing invalid tos converted, dscp=%d",  staPing->dscp);
-    }
-    printf("\nwfa_cs.c wfaSendPing : The Stream ID=%d IPtype=%i\n",streamid, staPing->iptype);
-    printf("IPtype : %i  tos=%d",staPing->iptype, tos);
-
-    if (staPing->iptype == 2)
-    {
-        if ( tos>0)
-            sprintf(cmdStr, "echo streamid=%i > /tmp/spout_%d.txt;wfaping6.sh %s %s -i %f -c %i -Q %d -s %i -q >> /tmp/spout_%d.txt 2>/dev/null",
-                    streamid,streamid,bflag, staPing->dipaddr, *interval, totalpkts, tos,  staPing->frameSize,streamid);
-        else
-            sprintf(cmdStr, "echo streamid=%i > /tmp/spout_%d.txt;wfaping6.sh %s %s -i %f -c %i -s %i -q >> /tmp/spout_%d.txt 2>/dev/null",
-                    streamid,streamid,bflag, staPing->dipaddr, *interval, totalpkts, staPing->frameSize,streamid);
-        sret = system(cmdStr);
-        printf("\nCS : The command string is %s",cmdStr);
-    }
-    else
-    {
-        if (tos > 0)
-            sprintf(cmdStr, "echo streamid=%i > /tmp/spout_%d.txt;wfaping.sh %s %s -i %f -c %i  -Q %d -s %i -q >> /tmp/spout_%d.txt 2>/dev/null",
-                    streamid,streamid,bflag, staPing->dipaddr, *interval, totalpkts, tos, staPing->frameSize,streamid);
-        else
-            sprintf(cmdStr, "echo streamid=%i > /tmp/spout_%d.txt;wfaping.sh %s %s -i %f -c %i -s %i -q >> /tmp/spout_%d.txt 2>/dev/null",
-                    streamid,streamid,bflag, staPing->dipaddr, *interval, totalpkts, staPing->frameSize,streamid);
-        sret = system(cmdStr);
-        printf("\nCS : The command string is %s",cmdStr);
-    }
-    sprintf(cmdStr, "updatepid.sh /tmp/spout_%d.txt",streamid);
-    sret = system(cmdStr);
-    printf("\nCS : The command string is %s",cmdStr);
-
-}
-
-int wfaStopPing(dutCmdResponse_t *stpResp, int streamid)
-{
-    char strout[256];
-    FILE *tmpfile = NULL;
-    char cmdStr[128];
-    printf("\nwfa_cs.c wfaStopPing:: stream id=%d\n", streamid);
-    sprintf(cmdStr, "getpid.sh /tmp/spout_%d.txt /tmp/pid.txt",streamid);
-    sret = system(cmdStr);
-
-    printf("\nCS : The command string is %s",cmdStr);
-
-    sret = system("stoping.sh /tmp/pid.txt ; sleep 2");
-
-    sprintf(cmdStr, "getpstats.sh /tmp/spout_%d.txt",streamid);
-    sret = system(cmdStr);
-
-    printf("\nCS : The command string is %s",cmdStr);
-
-    tmpfile = fopen("/tmp/stpsta.txt", "r+");
-
-    if(tmpfile == NULL)
-    {
-        return WFA_FAILURE;
-    }
-
-    if(fscanf(tmpfile, "%s", strout) != EOF)
-    {
-        if(*strout == '\0')
-        {
-            stpResp->cmdru.pingStp.sendCnt = 0;
-        }
-
-        else
-            stpResp->cmdru.pingStp.sendCnt = atoi(strout);
-    }
-
-    printf("\nwfaStopPing after scan sent count %i\n", stpResp->cmdru.pingStp.sendCnt);
-
-
-    if(fscanf(tmpfile, "%s", strout) != EOF)
-    {
-        if(*strout == '\0')
-        {
-            stpResp->cmdru.pingStp.repliedCnt = 0;
-        }
-        else
-            stpResp->cmdru.pingStp.repliedCnt = atoi(strout);
-    }
-    printf("wfaStopPing after scan replied count %i\n", stpResp->cmdru.pingStp.repliedCnt);
-
-    fclose(tmpfile);
-
-    return WFA_SUCCESS;
-}
-
 /*
  * wfaStaGetP2pDevAddress():
  */
@@ -3365,8 +2924,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_addba_reject failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3379,8 +2937,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_ampdu failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3392,8 +2949,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_amsdu failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3405,8 +2961,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "_set_greenfield failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3419,8 +2974,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_mcs failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3432,8 +2986,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_mcs32 failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3445,8 +2998,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_mcs32 failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3459,8 +3011,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_rifs_test failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3473,8 +3024,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_sgi20 failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3502,8 +3052,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_smps failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3516,8 +3065,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_stbc_rx failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3530,8 +3078,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_11n_channel_width failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3544,8 +3091,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_40_intolerant failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3558,8 +3104,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_txsp_stream failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
 
@@ -3573,8 +3118,7 @@ int wfaStaSet11n(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         {
             v11nParamsResp->status = STATUS_ERROR;
             strcpy(v11nParamsResp->cmdru.info, "set_rxsp_stream failed");
-            wfaEncodeTLV(WFA_STA_SET_11N_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)v11nParamsResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+            *respLen = wfaEncodeResp(WFA_STA_SET_11N_RESP_TLV, v11nParamsResp, sizeof(dutCmdResponse_t), respBuf);
             return FALSE;
         }
     }
@@ -3696,25 +3240,33 @@ int wfaStaStartWfdConnection(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBu
 }
 /*
  * wfaStaCliCommand():
+ *    run a command listed in WFA_CLI_CMDS_FILE as a DUT command line
+ *    "name /param value ...". Its first line starting with a digit,
+ *    "<status>-<result>", is the answer; the helper is not waited for
+ *    once that has been read.
  */
 
 int wfaStaCliCommand(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
-    char cmdName[32];
-    char *pcmdStr=NULL, *str;
+    char *cmdName, *pcmdStr=NULL, *str;
     int  st = 1;
     char CmdStr[WFA_CMD_STR_SZ];
-    FILE *wfaCliFd;
-    char wfaCliBuff[64];
     char retstr[256];
+    char out[WFA_BUFF_1K];
     int CmdReturnFlag =0;
-    char tmp[256];
-    FILE * sh_pipe;
+    int cmdLen, tmoutMs = WFA_CLI_TMOUT_MS;
+    char *tstr;
+    wfaProc_t proc;
+    struct timespec deadline;
     caStaCliCmdResp_t infoResp;
 
     printf("\nEntry wfaStaCliCommand; command Received: %s\n",caCmdBuf);
-    memcpy(cmdName, strtok_r((char *)caCmdBuf, ",", (char **)&pcmdStr), 32);
-    sprintf(CmdStr, "%s",cmdName);
+    wMEMSET(&infoResp, 0, sizeof(infoResp));
+
+    cmdName = strtok_r((char *)caCmdBuf, ",", &pcmdStr);
+    if(cmdName == NULL || strlen(cmdName) >= 32)
+        goto cleanup;
+    cmdLen = snprintf(CmdStr, sizeof(CmdStr), "%s", cmdName);
 
     for(;;)
     {
@@ -3724,84 +3276,62 @@ int wfaStaCliCommand(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
             break;
         else
         {
-            sprintf(CmdStr, "%s /%s",CmdStr,str);
+            cmdLen += snprintf(CmdStr + cmdLen, sizeof(CmdStr) - cmdLen, " /%s", str);
             str = strtok_r(NULL, ",", &pcmdStr);
-            sprintf(CmdStr, "%s %s",CmdStr,str);
+            if(cmdLen < (int) sizeof(CmdStr))
+                cmdLen += snprintf(CmdStr + cmdLen, sizeof(CmdStr) - cmdLen, " %s", str != NULL ? str : "");
         }
-    }
-    // check the return process
-    wfaCliFd=fopen("/etc/WfaEndpoint/wfa_cli.txt","r");
-    if(wfaCliFd!= NULL)
-    {
-        while(fgets(wfaCliBuff, 64, wfaCliFd) != NULL)
+        if(cmdLen >= (int) sizeof(CmdStr))
         {
-            //printf("\nLine read from CLI file : %s",wfaCliBuff);
-            if(ferror(wfaCliFd))
-                break;
-
-            str=strtok(wfaCliBuff,"-");
-            if(strcmp(str,cmdName) == 0)
-            {
-                str=strtok(NULL,",");
-                if (str != NULL)
-                {
-                    if(strcmp(str,"TRUE") == 0)
-                        CmdReturnFlag =1;
-                }
-                else
-                    printf("ERR wfa_cli.txt, inside line format not end with , or missing TRUE/FALSE\n");
-                break;
-            }
+            DPRINT_ERR(WFA_ERR, "CLI command too long\n");
+            goto cleanup;
         }
-        fclose(wfaCliFd);
     }
-    else
+
+    // check the return process
+    if(!wfaCliCmdLookup(cmdName, &CmdReturnFlag))
     {
-        printf("/etc/WfaEndpoint/wfa_cli.txt is not exist\n");
+        printf("%s is not listed in %s\n", cmdName, WFA_CLI_CMDS_FILE);
         goto cleanup;
     }
 
-    //printf("\n Command Return Flag : %d",CmdReturnFlag);
-    memset(&retstr[0],'\0',255);
-    memset(&tmp[0],'\0',255);
-    sprintf(gCmdStr, "%s",  CmdStr);
-    printf("\nCLI Command -- %s\n", gCmdStr);
+    if((tstr = getenv(WFA_ENV_CLI_TMOUT)) != NULL && atoi(tstr) > 0)
+        tmoutMs = atoi(tstr) * 1000;
 
-    sh_pipe = popen(gCmdStr,"r");
-    if(!sh_pipe)
+    printf("\nCLI Command -- %s\n", CmdStr);
+    if(wfaSpawn(&proc, out, sizeof(out), "%s", CmdStr) != WFA_SUCCESS)
     {
-        printf ("Error in opening pipe\n");
+        printf ("Error in running CLI command\n");
         goto cleanup;
     }
 
-    sleep(5);
-    //tmp_val=getdelim(&retstr,255,"\n",sh_pipe);
-    if (fgets(&retstr[0], 255, sh_pipe) == NULL)
+    /* the output is taken line by line as it comes, up to the status */
+    wfaSpawnDeadline(&deadline, tmoutMs);
+    retstr[0] = '\0';
+    while(wfaSpawnReadLine(&proc, retstr, sizeof(retstr), &deadline) == WFA_SUCCESS)
     {
-        printf("Getting NULL string in popen return\n");
-        goto cleanup;
+        if(isdigit((unsigned char)retstr[0]))
+            break;
+        printf("CLI output: %s\n", retstr);
+        retstr[0] = '\0';
     }
-    else
-        printf("popen return str=%s\n",retstr);
 
-    sleep(2);
-    if(pclose(sh_pipe) == -1)
+    /* a command that never printed its status is not left behind */
+    wfaSpawnRelease(&proc, retstr[0] == '\0');
+
+    if(retstr[0] == '\0')
     {
-        printf("Error in closing shell cmd pipe\n");
+        printf("wfaStaCliCommand no return code found\n");
         goto cleanup;
     }
-    sleep(2);
+    printf("CLI return str=%s\n", retstr);
 
     // find status first in output
     str = strtok_r((char *)retstr, "-", (char **)&pcmdStr);
     if (str != NULL)
     {
-        memset(tmp, 0, 10);
-        memcpy(tmp, str,  2);
-        printf("cli status=%s\n",tmp);
-        if(strlen(tmp) > 0)
-            st = atoi(tmp);
-        else printf("Missing status code\n");
+        st = atoi(str);
+        printf("cli status=%d\n", st);
     }
     else
     {
@@ -3835,6 +3365,9 @@ cleanup:
     case 2:
         infoResp.status = STATUS_INVALID;
         break;
+    default:
+        infoResp.status = STATUS_ERROR;
+        break;
     }
 
     wfaEncodeTLV(WFA_STA_CLI_CMD_RESP_TLV, sizeof(infoResp), (BYTE *)&infoResp, respBuf);
@@ -4087,6 +3620,9 @@ int wfaStaInvokeCommand(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 	
 	 printf("\n Entry wfaStaInvokeCommand... ");
 
+	 /* what the command starts is answered by events, read them from now */
+	 wfaIfcWpaWatch(staInvokeCmd->intf);
+
 
 	 // based on the command type , invoke API or complete the required procedures
 	 // return the  defined parameters based on the command that is received ( example response below)
@@ -4143,107 +3679,206 @@ int wfaStaManageService(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
 
 	
+/* NAN events, as sta_get_events names them and where their instance IDs are */
+static struct
+{
+    char *ev;
+    char *name;
+    char *local;
+    char *remote;
+} nanEvs[] =
+{
+    { "NAN-DISCOVERY-RESULT",     "DiscoveryResult",     "subscribe_id", "publish_id" },
+    { "NAN-REPLIED",              "Replied",             "publish_id",   "subscribe_id" },
+    { "NAN-RECEIVE",              "FollowUp",            "id",           "peer_instance_id" },
+    { "NAN-PUBLISH-TERMINATED",   "PublishTerminated",   "publish_id",   NULL },
+    { "NAN-SUBSCRIBE-TERMINATED", "SubscribeTerminated", "subscribe_id", NULL },
+    { NULL,                       NULL,                  NULL,           NULL }
+};
+
+/*
+ * sta_get_events: the events are read by the interface cache thread as
+ * they come, here they are only taken from wfa_events.c.
+ *   WFDS: the types received since the last call, as a list.
+ *   NAN:  the newest NAN event since the last call, action Flush drops it.
+ */
 int wfaStaGetEvents(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
+    dutCmdResponse_t infoResp;
+    caStaGetEvents_t *staGetEvents = (caStaGetEvents_t *)caCmdBuf;
+    caStaGetEventsResp_t *nanResp = &infoResp.cmdru.getEvents;
+    char ev[WFA_EV_TEXT_SZ], val[WFA_BUFF_32];
+    wfaEvStats_t stats;
+    int i;
 
-	dutCmdResponse_t infoResp;
-	caStaGetEvents_t *staGetEvents = (caStaGetEvents_t *)caCmdBuf;  //uncomment and use it
-	
-	 printf("\n Entry wfaStaGetEvents... ");
-	 
-	 if(staGetEvents->program == PROG_TYPE_NAN)
-	{ 
-		// Get all the events from the Log file or stored events
-		// return the  received/recorded event details - eventName, remoteInstanceID, localInstanceID, mac
-	}
+    DPRINT_INFO(WFA_OUT, "Entering wfaStaGetEvents ...\n");
 
-	// Get all the event from the Log file or stored events
-	// return the  received/recorded events as space seperated list   ( example response below)
-	strcpy(infoResp.cmdru.staGetEvents.result, "SearchResult SearchTerminated AdvertiseStatus SessionRequest ConnectStatus SessionStatus PortStatus");
-	
-	infoResp.status = STATUS_COMPLETE;
-	wfaEncodeTLV(WFA_STA_GET_EVENTS_RESP_TLV, sizeof(infoResp), (BYTE *)&infoResp, respBuf); 
-	*respLen = WFA_TLV_HDR_LEN + sizeof(infoResp);
-	
-   return WFA_SUCCESS;
+    wMEMSET(&infoResp, 0, sizeof(infoResp));
+    wfaIfcWpaWatch(staGetEvents->intf);
+
+    if(staGetEvents->program == PROG_TYPE_NAN)
+    {
+        nanResp->program = PROG_TYPE_NAN;
+        if(wfaEvLatest(staGetEvents->intf, WFA_EV_NAN, 1, ev, sizeof(ev)) == WFA_SUCCESS &&
+                strcasecmp(staGetEvents->action, "flush") != 0)
+        {
+            for(i = 0; nanEvs[i].ev != NULL; i++)
+            {
+                if(strncmp(ev, nanEvs[i].ev, strlen(nanEvs[i].ev)) == 0)
+                    break;
+            }
+
+            if(nanEvs[i].ev != NULL)
+                wSTRNCPY(nanResp->eventName, nanEvs[i].name, sizeof(nanResp->eventName) - 1);
+            else
+                wfaEvWord(ev, 0, nanResp->eventName, sizeof(nanResp->eventName));
+
+            if(nanEvs[i].local != NULL && wfaEvField(ev, nanEvs[i].local, val, sizeof(val)) == WFA_SUCCESS)
+                nanResp->localInstanceID = atoi(val);
+            if(nanEvs[i].remote != NULL && wfaEvField(ev, nanEvs[i].remote, val, sizeof(val)) == WFA_SUCCESS)
+                nanResp->remoteInstanceID = atoi(val);
+            wfaEvField(ev, "address", nanResp->mac, sizeof(nanResp->mac));
+        }
+    }
+    else
+    {
+        infoResp.cmdru.staGetEvents.program = staGetEvents->program;
+        wfaEvList(staGetEvents->intf, infoResp.cmdru.staGetEvents.result,
+                  sizeof(infoResp.cmdru.staGetEvents.result));
+    }
+
+    wfaEvStatsGet(&stats);
+    DPRINT_INFO(WFA_OUT, "events: %u read, %u dropped, %u WFDS search results, %u NAN\n",
+                stats.pushed, stats.dropped, stats.counts[eSearchResult], stats.counts[WFA_EV_NAN]);
+
+    infoResp.status = STATUS_COMPLETE;
+    wfaEncodeTLV(WFA_STA_GET_EVENTS_RESP_TLV, sizeof(infoResp), (BYTE *)&infoResp, respBuf);
+    *respLen = WFA_TLV_HDR_LEN + sizeof(infoResp);
+
+    return WFA_SUCCESS;
+}
+
+/* a hex word of an event, 0 if it is not there */
+static long int wfaEvHex(char *ev, char *key, int word)
+{
+    char val[WFA_BUFF_32];
+
+    if((key != NULL ? wfaEvField(ev, key, val, sizeof(val)) :
+            wfaEvWord(ev, word, val, sizeof(val))) != WFA_SUCCESS)
+        return 0;
+
+    return strtol(val, NULL, 16);
 }
 
+/*
+ * sta_get_event_details: the newest event of the type asked for, as the
+ * supplicant sent it:
+ *   SearchResult      P2P-SERV-ASP-RESP <mac> <id> <adv_id> <status> <methods> <name> ...
+ *   SearchTerminated  P2P-FIND-STOPPED
+ *   SessionRequest    P2PS-PROV-START <mac> adv_id= session= mac= ...
+ *   SessionStatus     P2PS-PROV-DONE <mac> status=0 session= mac= ...
+ *   ConnectStatus     P2PS-PROV-DONE with another status, P2P-GROUP-STARTED
+ *                     or a group formation failure
+ * The supplicant has no event for AdvertiseStatus and PortStatus.
+ */
 int wfaStaGetEventDetails(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 {
+    dutCmdResponse_t infoResp;
+    caStaGetEventDetails_t *getStaGetEventDetails = (caStaGetEventDetails_t *)caCmdBuf;
+    caStaGetEventDetailsCmdResp_t *details = &infoResp.cmdru.staGetEventDetails;
+    char ev[WFA_EV_TEXT_SZ], val[WFA_BUFF_32];
 
-	dutCmdResponse_t infoResp;
-	caStaGetEventDetails_t *getStaGetEventDetails = (caStaMngServ_t *)caCmdBuf;  //uncomment and use it
-	
-	 printf("\n Entry wfaStaGetEventDetails... ");
+    DPRINT_INFO(WFA_OUT, "Entering wfaStaGetEventDetails ...\n");
 
+    wMEMSET(&infoResp, 0, sizeof(infoResp));
 
-	 // based on the Requested Event type
-	 // return the latest corresponding evnet detailed parameters  ( example response below)
+    /* only the WFDS types have details, NAN events come with get_events */
+    if(getStaGetEventDetails->eventId < eSearchResult || getStaGetEventDetails->eventId > ePortStatus)
+    {
+        infoResp.status = STATUS_INVALID;
+        wfaEncodeTLV(WFA_STA_GET_EVENT_DETAILS_RESP_TLV, 4, (BYTE *)&infoResp, respBuf);
+        *respLen = WFA_TLV_HDR_LEN + 4;
 
-	if(getStaGetEventDetails->eventId== eSearchResult )
-	{
-		// fetch from log file or event history for the search result event and return the parameters
-		infoResp.cmdru.staGetEventDetails.eventID= eSearchResult;
+        return WFA_SUCCESS;
+    }
 
-		infoResp.cmdru.staGetEventDetails.getEventDetails.searchResult.searchID = 0x00abcd;
-		strcpy(infoResp.cmdru.staGetEventDetails.getEventDetails.searchResult.serviceMac,"ab:cd:ef:gh:ij:kl");
-		infoResp.cmdru.staGetEventDetails.getEventDetails.searchResult.advID = 0x00dcba;
-		strcpy(infoResp.cmdru.staGetEventDetails.getEventDetails.searchResult.serviceName,"org.wi-fi.wfds.send.rx");
+    wfaIfcWpaWatch(getStaGetEventDetails->intf);
 
-		infoResp.cmdru.staGetEventDetails.getEventDetails.searchResult.serviceStatus = eServiceAvilable;
-	}
-	else if (getStaGetEventDetails->eventId == eSearchTerminated)
-	{		// fetch from log file or event history for the search terminated event and return the parameters
-		infoResp.cmdru.staGetEventDetails.eventID= eSearchTerminated;	
-		infoResp.cmdru.staGetEventDetails.getEventDetails.searchTerminated.searchID = 0x00abcd;
-	}
-	else if (getStaGetEventDetails->eventId == eAdvertiseStatus)
-	{// fetch from log file or event history for the Advertise Status event and return the parameters
-		infoResp.cmdru.staGetEventDetails.eventID= eAdvertiseStatus;	
-		infoResp.cmdru.staGetEventDetails.getEventDetails.advStatus.advID = 0x00dcba;
+    if(wfaEvLatest(getStaGetEventDetails->intf, getStaGetEventDetails->eventId, 0, ev, sizeof(ev)) != WFA_SUCCESS)
+    {
+        DPRINT_INFO(WFA_OUT, "no event %i received\n", getStaGetEventDetails->eventId);
+        infoResp.status = STATUS_ERROR;
+        wfaEncodeTLV(WFA_STA_GET_EVENT_DETAILS_RESP_TLV, 4, (BYTE *)&infoResp, respBuf);
+        *respLen = WFA_TLV_HDR_LEN + 4;
 
-		infoResp.cmdru.staGetEventDetails.getEventDetails.advStatus.status = eAdvertised;	
-	}	
-	else if (getStaGetEventDetails->eventId == eSessionRequest)
-	{// fetch from log file or event history for the session request event and return the parameters
-		infoResp.cmdru.staGetEventDetails.eventID= eSessionRequest;	
-		infoResp.cmdru.staGetEventDetails.getEventDetails.sessionReq.advID = 0x00dcba;
-		strcpy(infoResp.cmdru.staGetEventDetails.getEventDetails.sessionReq.sessionMac,"ab:cd:ef:gh:ij:kl");
-		infoResp.cmdru.staGetEventDetails.getEventDetails.sessionReq.sessionID = 0x00baba;	
-	}	
-	else if (getStaGetEventDetails->eventId ==eSessionStatus )
-	{// fetch from log file or event history for the session status event and return the parameters
-		infoResp.cmdru.staGetEventDetails.eventID= eSessionStatus;	
-		infoResp.cmdru.staGetEventDetails.getEventDetails.sessionStatus.sessionID = 0x00baba;	
-		strcpy(infoResp.cmdru.staGetEventDetails.getEventDetails.sessionStatus.sessionMac,"ab:cd:ef:gh:ij:kl");
-		infoResp.cmdru.staGetEventDetails.getEventDetails.sessionStatus.state = eSessionStateOpen;	
-	}	
-	else if (getStaGetEventDetails->eventId == eConnectStatus)
-	{
-		infoResp.cmdru.staGetEventDetails.eventID= eConnectStatus;	
-		infoResp.cmdru.staGetEventDetails.getEventDetails.connStatus.sessionID = 0x00baba;	
-		strcpy(infoResp.cmdru.staGetEventDetails.getEventDetails.connStatus.sessionMac,"ab:cd:ef:gh:ij:kl");
-		infoResp.cmdru.staGetEventDetails.getEventDetails.connStatus.status = eGroupFormationComplete;	
-	
-	}	
-	else if (getStaGetEventDetails->eventId == ePortStatus)
-	{
-		infoResp.cmdru.staGetEventDetails.eventID= ePortStatus;	
-		infoResp.cmdru.staGetEventDetails.getEventDetails.portStatus.sessionID = 0x00baba;	
-		strcpy(infoResp.cmdru.staGetEventDetails.getEventDetails.portStatus.sessionMac,"ab:cd:ef:gh:ij:kl");
-		infoResp.cmdru.staGetEventDetails.getEventDetails.portStatus.port = 1009;
-		infoResp.cmdru.staGetEventDetails.getEventDetails.portStatus.status = eLocalPortAllowed;	
-	}	
+        return WFA_SUCCESS;
+    }
 
+    details->eventID = getStaGetEventDetails->eventId;
+    switch(details->eventID)
+    {
+        case eSearchResult:
+        {
+            caStaSearchResultEvent_t *res = &details->getEventDetails.searchResult;
 
+            wfaEvWord(ev, 1, res->serviceMac, sizeof(res->serviceMac));
+            res->searchID = wfaEvHex(ev, NULL, 2);
+            res->advID = wfaEvHex(ev, NULL, 3);
+            res->serviceStatus = wfaEvHex(ev, NULL, 4) ? eServiceAvilable : eServiceNotAvailable;
+            wfaEvWord(ev, 6, res->serviceName, sizeof(res->serviceName));
+            break;
+        }
 
-	infoResp.status = STATUS_COMPLETE;
-	wfaEncodeTLV(WFA_STA_GET_EVENT_DETAILS_RESP_TLV, sizeof(infoResp), (BYTE *)&infoResp, respBuf); 
-	*respLen = WFA_TLV_HDR_LEN + sizeof(infoResp);
-	
-   return WFA_SUCCESS;
-}
+        case eSearchTerminated:
+            /* the supplicant does not say which search stopped */
+            details->getEventDetails.searchTerminated.searchID = 0;
+            break;
+
+        case eSessionRequest:
+            details->getEventDetails.sessionReq.advID = wfaEvHex(ev, "adv_id", 0);
+            details->getEventDetails.sessionReq.sessionID = wfaEvHex(ev, "session", 0);
+            wfaEvField(ev, "mac", details->getEventDetails.sessionReq.sessionMac,
+                       sizeof(details->getEventDetails.sessionReq.sessionMac));
+            break;
+
+        case eSessionStatus:
+            details->getEventDetails.sessionStatus.sessionID = wfaEvHex(ev, "session", 0);
+            wfaEvField(ev, "mac", details->getEventDetails.sessionStatus.sessionMac,
+                       sizeof(details->getEventDetails.sessionStatus.sessionMac));
+            details->getEventDetails.sessionStatus.state = eSessionStateInitiated;
+            break;
+
+        case eConnectStatus:
+        {
+            caStaConnectStatusEvent_t *conn = &details->getEventDetails.connStatus;
 
+            conn->sessionID = wfaEvHex(ev, "session", 0);
+            if(strncmp(ev, "P2PS-PROV-DONE", 14) == 0)
+            {
+                wfaEvField(ev, "mac", conn->sessionMac, sizeof(conn->sessionMac));
+                /* 12 is P2P_SC_FAIL_INFO_CURRENTLY_UNAVAILABLE, the peer defers */
+                wfaEvField(ev, "status", val, sizeof(val));
+                conn->status = (atoi(val) == 12) ? eServiceRequestDifferred : eServiceRequestFailed;
+            }
+            else if(strncmp(ev, "P2P-GROUP-STARTED", 17) == 0)
+            {
+                wfaEvField(ev, "go_dev_addr", conn->sessionMac, sizeof(conn->sessionMac));
+                conn->status = eGroupFormationComplete;
+            }
+            else
+            {
+                conn->status = eGroupFormationFailed;
+            }
+            break;
+        }
+    }
+
+    infoResp.status = STATUS_COMPLETE;
+    wfaEncodeTLV(WFA_STA_GET_EVENT_DETAILS_RESP_TLV, sizeof(infoResp), (BYTE *)&infoResp, respBuf);
+    *respLen = WFA_TLV_HDR_LEN + sizeof(infoResp);
+
+    return WFA_SUCCESS;
+}
 	
 
 
@@ -0,0 +1,313 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_events.c - supplicant events for sta_get_events and
+ *       sta_get_event_details.
+ *       The interface cache thread is the only producer: it sorts each
+ *       event it reads into a type and pushes it into a fixed ring,
+ *       never waiting. The command handlers are the consumers: they move
+ *       what is in the ring into the newest event kept per interface and
+ *       type, and answer from there. A full ring drops the new event and
+ *       counts it.
+ */
+#include <pthread.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_tg.h"
+#include "wfa_cmds.h"
+#include "wfa_events.h"
+
+extern unsigned short wfa_defined_debug;
+
+typedef struct _wfa_ev_if
+{
+    char ifname[WFA_IF_NAME_LEN];    /* empty when the slot is free */
+    unsigned int have;               /* bit per type, last[] is set */
+    unsigned int pending;            /* bit per type, not listed yet */
+    char last[WFA_EV_NUM_TYPES][WFA_EV_TEXT_SZ];
+} wfaEvIf_t;
+
+/*
+ * evHead is only written by the producer, evTail only by a consumer;
+ * the barriers order the entry against the index that hands it over.
+ */
+static wfaEv_t evRing[WFA_EV_RING_SZ];
+static volatile unsigned int evHead = 0;
+static volatile unsigned int evTail = 0;
+static wfaEvStats_t evStats;
+
+/* the consumers, and what they took out of the ring, belong to evMutex */
+static pthread_mutex_t evMutex = PTHREAD_MUTEX_INITIALIZER;
+static wfaEvIf_t evIfs[WFA_EV_MAX_IFS];
+static unsigned int evDropSeen = 0;
+
+static char *evNames[WFA_EV_NUM_TYPES] =
+{
+    "", "SearchResult", "SearchTerminated", "AdvertiseStatus",
+    "SessionRequest", "ConnectStatus", "SessionStatus", "PortStatus", "NAN"
+};
+
+static struct
+{
+    char *prefix;
+    int type;
+} evClasses[] =
+{
+    { "P2P-SERV-ASP-RESP ",           eSearchResult },
+    { "P2P-FIND-STOPPED",             eSearchTerminated },
+    { "P2PS-PROV-START ",             eSessionRequest },
+    { "P2PS-PROV-DONE ",              eSessionStatus },
+    { "P2P-GROUP-STARTED ",           eConnectStatus },
+    { "P2P-GO-NEG-FAILURE",           eConnectStatus },
+    { "P2P-GROUP-FORMATION-FAILURE",  eConnectStatus },
+    { "NAN-",                         WFA_EV_NAN },
+    { NULL,                           WFA_EV_OTHER }
+};
+
+static int wfaEvClassify(char *text)
+{
+    char status[WFA_BUFF_32];
+    int i;
+
+    for(i = 0; evClasses[i].prefix != NULL; i++)
+    {
+        if(strncmp(text, evClasses[i].prefix, strlen(evClasses[i].prefix)) == 0)
+            break;
+    }
+
+    /* a refused or deferred provisioning never opens a session */
+    if(evClasses[i].type == eSessionStatus &&
+            wfaEvField(text, "status", status, sizeof(status)) == WFA_SUCCESS &&
+            atoi(status) != 0)
+        return eConnectStatus;
+
+    return evClasses[i].type;
+}
+
+/*
+ * wfaEvPush(): keep one event of ifname. Only the interface cache
+ *              thread calls it.
+ */
+void wfaEvPush(char *ifname, char *text)
+{
+    unsigned int head = evHead;
+    wfaEv_t *ev;
+    int type = wfaEvClassify(text);
+
+    evStats.pushed++;
+    evStats.counts[type]++;
+    if(type == WFA_EV_OTHER)
+        return;
+
+    if(head - evTail >= WFA_EV_RING_SZ)
+    {
+        evStats.dropped++;
+        return;
+    }
+
+    ev = &evRing[head & (WFA_EV_RING_SZ - 1)];
+    ev->type = type;
+    snprintf(ev->ifname, sizeof(ev->ifname), "%s", ifname);
+    snprintf(ev->text, sizeof(ev->text), "%s", text);
+
+    /* the entry is complete before the consumer can see it */
+    wMEMORY_BARRIER();
+    evHead = head + 1;
+}
+
+/* evMutex held */
+static wfaEvIf_t *wfaEvIfFind(char *ifname, int claim)
+{
+    int i;
+
+    for(i = 0; i < WFA_EV_MAX_IFS; i++)
+    {
+        if(strncmp(evIfs[i].ifname, ifname, WFA_IF_NAME_LEN) == 0)
+            return &evIfs[i];
+    }
+
+    for(i = 0; i < WFA_EV_MAX_IFS && claim; i++)
+    {
+        if(evIfs[i].ifname[0] == '\0')
+        {
+            wSTRNCPY(evIfs[i].ifname, ifname, WFA_IF_NAME_LEN - 1);
+            return &evIfs[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* move the ring into evIfs, evMutex held */
+static void wfaEvDrain(void)
+{
+    unsigned int tail = evTail, head = evHead;
+    wfaEvIf_t *evIf;
+    wfaEv_t *ev;
+
+    /* the entries are read after the index that published them */
+    wMEMORY_BARRIER();
+
+    for(; tail != head; tail++)
+    {
+        ev = &evRing[tail & (WFA_EV_RING_SZ - 1)];
+        if((evIf = wfaEvIfFind(ev->ifname, 1)) == NULL)
+        {
+            DPRINT_WARNING(WFA_WNG, "events of %s not kept, no slot\n", ev->ifname);
+            continue;
+        }
+
+        strcpy(evIf->last[ev->type], ev->text);
+        evIf->have |= 1 << ev->type;
+        evIf->pending |= 1 << ev->type;
+    }
+
+    /* and are done with before the producer may reuse them */
+    wMEMORY_BARRIER();
+    evTail = tail;
+
+    if(evStats.dropped != evDropSeen)
+    {
+        DPRINT_WARNING(WFA_WNG, "event ring full, %u events dropped\n",
+                       evStats.dropped - evDropSeen);
+        evDropSeen = evStats.dropped;
+    }
+}
+
+/*
+ * wfaEvList(): the names of the WFDS event types received on ifname
+ *              since the last call, separated by spaces.
+ * return:  the number of names
+ */
+int wfaEvList(char *ifname, char *names, int namesSz)
+{
+    wfaEvIf_t *evIf;
+    int type, n = 0, used = 0;
+
+    names[0] = '\0';
+
+    wPT_MUTEX_LOCK(&evMutex);
+    wfaEvDrain();
+    evIf = wfaEvIfFind(ifname, 0);
+    for(type = eSearchResult; evIf != NULL && type <= ePortStatus; type++)
+    {
+        if(!(evIf->pending & (1 << type)))
+            continue;
+
+        used += snprintf(names + used, namesSz - used, "%s%s", n ? " " : "", evNames[type]);
+        if(used >= namesSz)
+            break;
+
+        evIf->pending &= ~(1 << type);
+        n++;
+    }
+    wPT_MUTEX_UNLOCK(&evMutex);
+
+    return n;
+}
+
+/*
+ * wfaEvLatest(): the newest event of type received on ifname. With take
+ *                set it is forgotten, the next call waits for a new one.
+ * return:  WFA_SUCCESS if there is one
+ */
+int wfaEvLatest(char *ifname, int type, int take, char *text, int textSz)
+{
+    wfaEvIf_t *evIf;
+    int ret = WFA_FAILURE;
+
+    if(type <= WFA_EV_OTHER || type >= WFA_EV_NUM_TYPES)
+        return WFA_FAILURE;
+
+    wPT_MUTEX_LOCK(&evMutex);
+    wfaEvDrain();
+    evIf = wfaEvIfFind(ifname, 0);
+    if(evIf != NULL && (evIf->have & (1 << type)))
+    {
+        snprintf(text, textSz, "%s", evIf->last[type]);
+        if(take)
+        {
+            evIf->have &= ~(1 << type);
+            evIf->pending &= ~(1 << type);
+        }
+        ret = WFA_SUCCESS;
+    }
+    wPT_MUTEX_UNLOCK(&evMutex);
+
+    return ret;
+}
+
+/*
+ * wfaEvStatsGet(): the producer counters. They are read while it runs,
+ *                  each one is exact but not all from the same moment.
+ */
+void wfaEvStatsGet(wfaEvStats_t *stats)
+{
+    wMEMCPY(stats, &evStats, sizeof(wfaEvStats_t));
+}
+
+/*
+ * wfaEvField(): the value of a key=value word of an event.
+ * return:  WFA_SUCCESS if the key is there
+ */
+int wfaEvField(char *text, char *key, char *val, int valSz)
+{
+    char *p = text;
+    int keyLen = strlen(key);
+
+    while(p != NULL && *p != '\0')
+    {
+        if(strncmp(p, key, keyLen) == 0 && p[keyLen] == '=')
+        {
+            p += keyLen + 1;
+            snprintf(val, valSz, "%.*s", (int)strcspn(p, " "), p);
+            return WFA_SUCCESS;
+        }
+
+        if((p = strchr(p, ' ')) != NULL)
+            p++;
+    }
+
+    return WFA_FAILURE;
+}
+
+/*
+ * wfaEvWord(): word n of an event, the event name being word 0.
+ * return:  WFA_SUCCESS if there are that many
+ */
+int wfaEvWord(char *text, int n, char *val, int valSz)
+{
+    char *p = text;
+
+    while(n-- > 0 && p != NULL)
+    {
+        if((p = strchr(p, ' ')) != NULL)
+            p++;
+    }
+
+    if(p == NULL || *p == '\0')
+        return WFA_FAILURE;
+
+    snprintf(val, valSz, "%.*s", (int)strcspn(p, " "), p);
+    return WFA_SUCCESS;
+}
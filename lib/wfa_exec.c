@@ -0,0 +1,428 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_exec.c - DUT control command executor.
+ *       Commands received on the control link are sorted into classes.
+ *       Each class owns a worker thread and a FIFO queue so that commands
+ *       of one class complete in the order they were received, while a
+ *       slow command of one class (a supplicant reconfiguration, or a
+ *       receive-stop waiting for a sender to drain) does not hold up the
+ *       control loop or the other class. Short traffic agent commands are
+ *       still run on the control loop thread when nothing is pending for
+ *       the traffic class. Each handler's response is sent back on the
+ *       control link as soon as it completes.
+ */
+#include <pthread.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_tlv.h"
+#include "wfa_tg.h"
+#include "wfa_sock.h"
+#include "wfa_agt.h"
+#include "wfa_rsp.h"
+#include "wfa_exec.h"
+
+extern xcCommandFuncPtr gWfaCmdFuncTbl[];
+extern tgStream_t *findStreamProfile(int);
+extern int gxcSockfd;
+extern unsigned short wfa_defined_debug;
+
+extern wTHREAD_LOCAL char gCmdStr[];
+extern wTHREAD_LOCAL dutCmdResponse_t gGenericResp;
+
+static wfaExecQueue_t execQueues[WFA_EXEC_CLASS_NUM];
+
+wTHREAD_LOCAL WORD gCtrlReqId;
+
+/* gxcSockfd changes and the sends through it are under the link mutex */
+static pthread_mutex_t execLinkMutex = PTHREAD_MUTEX_INITIALIZER;
+static wfaExecResult_t execResults[WFA_EXEC_MAX_RESULTS];
+static unsigned int execResultSeq;
+
+/*
+ * wfaExecKeepResult(): hold a stream result for the next control link.
+ *                      Link mutex held.
+ */
+static void wfaExecKeepResult(int streamId, WORD reqId, BYTE *buf, int len)
+{
+    wfaExecResult_t *r = NULL;
+    int i;
+
+    if(len > WFA_RESP_BUF_SZ)
+        return;
+
+    /* the stream's own slot, else a free one, else the oldest */
+    for(i = 0; i < WFA_EXEC_MAX_RESULTS && r == NULL; i++)
+    {
+        if(execResults[i].streamId == streamId)
+            r = &execResults[i];
+    }
+
+    for(i = 0; i < WFA_EXEC_MAX_RESULTS && r == NULL; i++)
+    {
+        if(execResults[i].streamId == 0)
+            r = &execResults[i];
+    }
+
+    if(r == NULL)
+    {
+        r = &execResults[0];
+        for(i = 1; i < WFA_EXEC_MAX_RESULTS; i++)
+        {
+            if(execResults[i].seq < r->seq)
+                r = &execResults[i];
+        }
+
+        DPRINT_WARNING(WFA_WNG, "result of stream %i dropped, too many kept\n", r->streamId);
+    }
+
+    r->streamId = streamId;
+    r->seq = ++execResultSeq;
+    r->reqId = reqId;
+    r->len = len;
+    wMEMCPY(r->buf, buf, len);
+
+    DPRINT_INFO(WFA_OUT, "control link down, result of stream %i kept\n", streamId);
+}
+
+/*
+ * wfaExecSendResp(): send a response or report to the control agent.
+ *  input:   streamId -- the stream whose result it is, kept and sent
+ *                       again on the next link if this one is down;
+ *                       0 for anything not worth keeping
+ *  return:  WFA_SUCCESS if sent
+ */
+int wfaExecSendResp(int streamId, WORD reqId, BYTE *buf, int len)
+{
+    int ret = WFA_FAILURE;
+
+    wPT_MUTEX_LOCK(&execLinkMutex);
+    if(gxcSockfd != -1 && wfaCtrlSendFrame(gxcSockfd, reqId, buf, len) == len)
+        ret = WFA_SUCCESS;
+    else if(streamId > 0)
+        wfaExecKeepResult(streamId, reqId, buf, len);
+    wPT_MUTEX_UNLOCK(&execLinkMutex);
+
+    if(ret != WFA_SUCCESS)
+    {
+        DPRINT_WARNING(WFA_WNG, "response to request %u not sent\n", reqId);
+    }
+
+    return ret;
+}
+
+/*
+ * wfaExecLinkUp(): a control agent connected, it takes the place of the
+ *                  old link and gets the results kept meanwhile, oldest
+ *                  first.
+ */
+void wfaExecLinkUp(int sock)
+{
+    wfaExecResult_t *r;
+    int i, next;
+
+    wfaCtrlSockTune(sock);
+
+    wPT_MUTEX_LOCK(&execLinkMutex);
+    if(gxcSockfd != -1)
+    {
+        DPRINT_INFO(WFA_OUT, "control link replaced\n");
+        close(gxcSockfd);
+    }
+    gxcSockfd = sock;
+
+    for(;;)
+    {
+        next = -1;
+        for(i = 0; i < WFA_EXEC_MAX_RESULTS; i++)
+        {
+            if(execResults[i].streamId != 0 &&
+                    (next == -1 || execResults[i].seq < execResults[next].seq))
+                next = i;
+        }
+
+        if(next == -1)
+            break;
+
+        r = &execResults[next];
+        if(wfaCtrlSendFrame(gxcSockfd, r->reqId, r->buf, r->len) != r->len)
+            break;
+
+        DPRINT_INFO(WFA_OUT, "result of stream %i replayed\n", r->streamId);
+        r->streamId = 0;
+    }
+    wPT_MUTEX_UNLOCK(&execLinkMutex);
+}
+
+/*
+ * wfaExecLinkDown(): the control link is closed or broken
+ */
+void wfaExecLinkDown(void)
+{
+    wPT_MUTEX_LOCK(&execLinkMutex);
+    if(gxcSockfd != -1)
+    {
+        shutdown(gxcSockfd, SHUT_WR);
+        close(gxcSockfd);
+        gxcSockfd = -1;
+    }
+    wPT_MUTEX_UNLOCK(&execLinkMutex);
+}
+
+/*
+ * wfaExecStreamOf(): the stream a traffic command reports on, its first
+ *                    stream id, or 0
+ */
+static int wfaExecStreamOf(WORD tag, int len, BYTE *parms)
+{
+    int streamid = 0;
+
+    if((tag == WFA_TRAFFIC_AGENT_SEND_TLV || tag == WFA_TRAFFIC_AGENT_RECV_STOP_TLV) && len >= 4)
+        wMEMCPY(&streamid, parms, 4);
+
+    return streamid;
+}
+
+/*
+ * wfaExecRun(): run one command handler and send its response back
+ *               through the control link, tagged with the request id.
+ */
+static void wfaExecRun(WORD reqId, WORD tag, int len, BYTE *parms, BYTE *respBuf)
+{
+    int respLen = 0;
+
+    /* handlers that answer later keep it, see tgStream_t ctrlReqId */
+    gCtrlReqId = reqId;
+
+    /* reset the per-thread storages used by control functions */
+    wMEMSET(gCmdStr, 0, WFA_CMD_STR_SZ);
+    wMEMSET(&gGenericResp, 0, sizeof(dutCmdResponse_t));
+
+    if(tag != 0 && tag < WFA_STA_COMMANDS_END && gWfaCmdFuncTbl[tag] != NULL)
+    {
+        gWfaCmdFuncTbl[tag](len, parms, &respLen, respBuf);
+    }
+    else
+    {
+        // no command defined
+        gWfaCmdFuncTbl[0](len, parms, &respLen, respBuf);
+    }
+
+    /*
+     * a zero length response means the handler reports later by itself,
+     * e.g. traffic send statistics from the WMM threads.
+     */
+    if(respLen > 0)
+        wfaExecSendResp(wfaExecStreamOf(tag, len, parms), reqId, respBuf, respLen);
+}
+
+/*
+ * wfaExecWorker(): worker thread, takes the jobs of one class in order.
+ */
+static void *wfaExecWorker(void *arg)
+{
+    wfaExecQueue_t *q = (wfaExecQueue_t *)arg;
+    wfaExecJob_t job;
+
+    for(;;)
+    {
+        wPT_MUTEX_LOCK(&q->mutex);
+        while(q->count == 0)
+            wPT_COND_WAIT(&q->cond, &q->mutex);
+
+        wMEMCPY(&job, &q->jobs[q->head], sizeof(wfaExecJob_t));
+        q->head = (q->head + 1) % WFA_EXEC_QUEUE_DEPTH;
+        q->count--;
+        q->busy = 1;
+        wPT_MUTEX_UNLOCK(&q->mutex);
+
+        DPRINT_INFO(WFA_OUT, "exec class %i: running command %i\n", q->cls, job.tag);
+        wfaExecRun(job.reqId, job.tag, job.len, job.parms, q->respBuf);
+
+        wPT_MUTEX_LOCK(&q->mutex);
+        q->busy = 0;
+        wPT_MUTEX_UNLOCK(&q->mutex);
+    }
+
+    return NULL;
+}
+
+/*
+ * wfaExecInit(): create the command class workers.
+ * return:  WFA_SUCCESS or WFA_FAILURE
+ */
+int wfaExecInit(void)
+{
+    int i;
+    wfaExecQueue_t *q;
+
+    for(i = 0; i < WFA_EXEC_CLASS_NUM; i++)
+    {
+        q = &execQueues[i];
+        wMEMSET(q, 0, sizeof(wfaExecQueue_t));
+        q->cls = i;
+
+        q->respBuf = (BYTE *)wMALLOC(WFA_RESP_BUF_SZ);
+        if(q->respBuf == NULL)
+        {
+            DPRINT_ERR(WFA_ERR, "Failed to malloc executor response buffer\n");
+            return WFA_FAILURE;
+        }
+
+        wPT_MUTEX_INIT(&q->mutex, NULL);
+        wPT_COND_INIT(&q->cond, NULL);
+
+        if(wPT_CREATE(&q->thr, NULL, wfaExecWorker, q) != 0)
+        {
+            DPRINT_ERR(WFA_ERR, "Failed to create executor thread %i\n", i);
+            return WFA_FAILURE;
+        }
+    }
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaExecClassify(): map a command to its class.
+ */
+int wfaExecClassify(WORD tag, int len, BYTE *parms)
+{
+    switch(tag)
+    {
+    case WFA_GET_VERSION_TLV:
+        return WFA_EXEC_CLASS_INLINE;
+
+    case WFA_TRAFFIC_SEND_PING_TLV:
+    case WFA_TRAFFIC_STOP_PING_TLV:
+    case WFA_TRAFFIC_AGENT_CONFIG_TLV:
+    case WFA_TRAFFIC_AGENT_CONFIG_BATCH_TLV:
+    case WFA_TRAFFIC_AGENT_SEND_TLV:
+    case WFA_TRAFFIC_AGENT_RECV_START_TLV:
+    case WFA_TRAFFIC_AGENT_RECV_STOP_TLV:
+    case WFA_TRAFFIC_AGENT_RESET_TLV:
+    case WFA_TRAFFIC_AGENT_STATUS_TLV:
+        return WFA_EXEC_CLASS_TG;
+
+    default:
+        return WFA_EXEC_CLASS_STA;
+    }
+}
+
+/*
+ * wfaExecIsShort(): a traffic agent command that only updates the stream
+ *                   table or signals the WMM threads and returns at once.
+ */
+static int wfaExecIsShort(WORD tag, int len, BYTE *parms)
+{
+    int i, streamid;
+    tgStream_t *myStream;
+
+    switch(tag)
+    {
+    case WFA_TRAFFIC_AGENT_CONFIG_TLV:
+    case WFA_TRAFFIC_AGENT_CONFIG_BATCH_TLV:
+    case WFA_TRAFFIC_AGENT_RECV_START_TLV:
+    case WFA_TRAFFIC_AGENT_RESET_TLV:
+    case WFA_TRAFFIC_AGENT_STATUS_TLV:
+        return 1;
+
+    case WFA_TRAFFIC_AGENT_SEND_TLV:
+        /* the WMM-PS send runs the console for the whole test, not short */
+        for(i = 0; i < len/4; i++)
+        {
+            wMEMCPY(&streamid, parms+(4*i), 4);
+            myStream = findStreamProfile(streamid);
+            if(myStream != NULL && myStream->profile.profile == PROF_UAPSD)
+                return 0;
+        }
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+/*
+ * wfaExecDispatch(): run a command inline or queue it to its class worker,
+ *                    a command whose class queue is full is refused.
+ *  input:   reqId -- control link request id of the command
+ *  input:   tag, len, parms -- the decoded command TLV, len at most
+ *                              MAX_PARMS_BUFF
+ *  input:   respBuf -- response buffer for the inline case
+ *  return:  WFA_SUCCESS
+ */
+int wfaExecDispatch(WORD reqId, WORD tag, int len, BYTE *parms, BYTE *respBuf)
+{
+    int cls = wfaExecClassify(tag, len, parms);
+    wfaExecQueue_t *q;
+    wfaExecJob_t *job;
+
+    if(cls == WFA_EXEC_CLASS_INLINE)
+    {
+        wfaExecRun(reqId, tag, len, parms, respBuf);
+        return WFA_SUCCESS;
+    }
+
+    q = &execQueues[cls];
+
+    wPT_MUTEX_LOCK(&q->mutex);
+
+    /*
+     * Only the control loop adds jobs, so an idle class stays idle until
+     * this call returns and the inline run keeps the class order.
+     */
+    if(q->count == 0 && q->busy == 0 && wfaExecIsShort(tag, len, parms))
+    {
+        wPT_MUTEX_UNLOCK(&q->mutex);
+        wfaExecRun(reqId, tag, len, parms, respBuf);
+        return WFA_SUCCESS;
+    }
+
+    /*
+     * never run it here, it would overtake the queued commands of its
+     * class and race their worker; tag 0, see the control loop
+     */
+    if(q->count == WFA_EXEC_QUEUE_DEPTH)
+    {
+        int status = STATUS_ERROR;
+
+        wPT_MUTEX_UNLOCK(&q->mutex);
+        DPRINT_WARNING(WFA_WNG, "exec class %i queue full, command %i refused\n", cls, tag);
+        wfaEncodeTLV(0, 4, (BYTE *)&status, respBuf);
+        wfaExecSendResp(0, reqId, respBuf, WFA_TLV_HDR_LEN + 4);
+        return WFA_SUCCESS;
+    }
+
+    job = &q->jobs[q->tail];
+    job->reqId = reqId;
+    job->tag = tag;
+    job->len = len;
+    wMEMCPY(job->parms, parms, len);
+    q->tail = (q->tail + 1) % WFA_EXEC_QUEUE_DEPTH;
+    q->count++;
+
+    wPT_COND_SIGNAL(&q->cond);
+    wPT_MUTEX_UNLOCK(&q->mutex);
+
+    return WFA_SUCCESS;
+}
@@ -0,0 +1,445 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_ifcache.c - interface state answered from memory.
+ *       The MAC address, the IPv4 address and the supplicant STATUS of
+ *       an interface are read once and kept. A thread listens to the
+ *       kernel's link and address notifications and to the supplicant's
+ *       events, and drops exactly the entries they touch; nothing expires
+ *       by time. A query finding a notification not yet handled, or the
+ *       cache not running, reads the value the usual way.
+ *       The supplicant events read are handed on to wfa_events.c.
+ */
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <linux/rtnetlink.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_tg.h"
+#include "wfa_cmds.h"
+#include "wfa_nl.h"
+#include "wfa_wpactrl.h"
+#include "wfa_events.h"
+#include "wfa_ifcache.h"
+
+extern unsigned short wfa_defined_debug;
+
+/*
+ * The entries, and the monitor sockets while they are read, belong to
+ * ifcMutex. A query checks for pending notifications with it held, so it
+ * never sees a change read from a socket but not yet applied.
+ */
+static pthread_mutex_t ifcMutex = PTHREAD_MUTEX_INITIALIZER;
+static wfaIfcEntry_t ifcEnts[WFA_IFC_MAX_IFS];
+static int ifcState = 0;            /* 1 running, -1 could not start */
+static int ifcNlFd = -1;
+static int ifcWakeFd = -1;
+static pthread_t ifcThr;
+
+/* counted up by every change, a value read across one is not kept */
+static unsigned int ifcNlGen = 0;
+static unsigned int ifcWpaGen = 0;
+
+/* ifcMutex held */
+static wfaIfcEntry_t *wfaIfcFind(char *ifname, int claim)
+{
+    int i;
+
+    for(i = 0; i < WFA_IFC_MAX_IFS; i++)
+    {
+        if(strncmp(ifcEnts[i].ifname, ifname, WFA_IF_NAME_LEN) == 0)
+            return &ifcEnts[i];
+    }
+
+    for(i = 0; i < WFA_IFC_MAX_IFS && claim; i++)
+    {
+        if(ifcEnts[i].ifname[0] == '\0')
+        {
+            wMEMSET(&ifcEnts[i], 0, sizeof(wfaIfcEntry_t));
+            wSTRNCPY(ifcEnts[i].ifname, ifname, WFA_IF_NAME_LEN - 1);
+            ifcEnts[i].wpaFd = -1;
+            return &ifcEnts[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* a notification waiting on fd, ifcMutex held */
+static int wfaIfcPending(int fd)
+{
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    return poll(&pfd, 1, 0) != 0;
+}
+
+static void wfaIfcWake(void)
+{
+    uint64_t one = 1;
+
+    if(write(ifcWakeFd, &one, sizeof(one)) < 0)
+        DPRINT_WARNING(WFA_WNG, "interface cache wake: %i\n", errno);
+}
+
+/* wfaNlMonitorRead() callback, ifcMutex held */
+static void wfaIfcNlEvent(int type, int ifindex, void *arg)
+{
+    int i;
+
+    ifcNlGen++;
+    for(i = 0; i < WFA_IFC_MAX_IFS; i++)
+    {
+        if(ifcEnts[i].ifname[0] == '\0' || ifcEnts[i].ifindex != ifindex)
+            continue;
+
+        ifcEnts[i].ipOk = 0;
+
+        /* a link change may be a rename, the index is looked up again */
+        if(type == RTM_NEWLINK || type == RTM_DELLINK)
+        {
+            ifcEnts[i].macOk = 0;
+            ifcEnts[i].ifindex = 0;
+        }
+    }
+}
+
+/* drain the supplicant events of ent, ifcMutex held */
+static void wfaIfcWpaEvents(wfaIfcEntry_t *ent)
+{
+    char ev[WFA_BUFF_512];
+    unsigned int seq;
+    int n;
+
+    ent->wpaOk = 0;
+    ifcWpaGen++;
+
+    /* attached again since, what came in between is not known */
+    if(wfaWpaEventFd(ent->ifname, 0, &seq) != ent->wpaFd || seq != ent->wpaSeq)
+    {
+        ent->wpaFd = -1;
+        return;
+    }
+
+    while((n = wfaWpaEventRecv(ent->ifname, ev, sizeof(ev), 0)) > 0)
+    {
+        DPRINT_INFO(WFA_OUT, "%s: %s\n", ent->ifname, ev);
+        wfaEvPush(ent->ifname, ev);
+        if(strncmp(ev, "CTRL-EVENT-TERMINATING", 22) == 0)
+        {
+            /* the sockets are dead, the next query opens new ones */
+            ent->wpaFd = -1;
+            wfaWpaClose(ent->ifname);
+            return;
+        }
+    }
+
+    if(n < 0)
+        ent->wpaFd = -1;
+}
+
+static void *wfaIfcThread(void *arg)
+{
+    struct pollfd pfds[2 + WFA_IFC_MAX_IFS];
+    wfaIfcEntry_t *owner[2 + WFA_IFC_MAX_IFS];
+    uint64_t cnt;
+    int i, n;
+
+    for(;;)
+    {
+        pfds[0].fd = ifcNlFd;
+        pfds[1].fd = ifcWakeFd;
+        pfds[0].events = pfds[1].events = POLLIN;
+        n = 2;
+
+        wPT_MUTEX_LOCK(&ifcMutex);
+        for(i = 0; i < WFA_IFC_MAX_IFS; i++)
+        {
+            if(ifcEnts[i].wpaFd >= 0)
+            {
+                pfds[n].fd = ifcEnts[i].wpaFd;
+                pfds[n].events = POLLIN;
+                owner[n++] = &ifcEnts[i];
+            }
+        }
+        wPT_MUTEX_UNLOCK(&ifcMutex);
+
+        if(poll(pfds, n, -1) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            DPRINT_ERR(WFA_ERR, "interface cache poll: %i\n", errno);
+            break;
+        }
+
+        wPT_MUTEX_LOCK(&ifcMutex);
+        if(pfds[0].revents != 0 &&
+                wfaNlMonitorRead(ifcNlFd, wfaIfcNlEvent, NULL) != WFA_SUCCESS)
+        {
+            /* changes were lost, none of the kernel state can be trusted */
+            ifcNlGen++;
+            for(i = 0; i < WFA_IFC_MAX_IFS; i++)
+                ifcEnts[i].macOk = ifcEnts[i].ipOk = ifcEnts[i].ifindex = 0;
+        }
+
+        if(pfds[1].revents != 0 && read(ifcWakeFd, &cnt, sizeof(cnt)) < 0)
+            DPRINT_WARNING(WFA_WNG, "interface cache wake: %i\n", errno);
+
+        for(i = 2; i < n; i++)
+        {
+            if(pfds[i].revents != 0 && owner[i]->wpaFd == pfds[i].fd)
+                wfaIfcWpaEvents(owner[i]);
+        }
+        wPT_MUTEX_UNLOCK(&ifcMutex);
+    }
+
+    /* from here on every query reads the value itself */
+    wPT_MUTEX_LOCK(&ifcMutex);
+    ifcState = -1;
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    return NULL;
+}
+
+/* start the monitor thread on first use, returns 1 if it is running */
+static int wfaIfcStart(void)
+{
+    int running;
+
+    wPT_MUTEX_LOCK(&ifcMutex);
+    if(ifcState == 0)
+    {
+        ifcState = -1;
+        ifcNlFd = wfaNlMonitorOpen();
+        ifcWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(ifcNlFd >= 0 && ifcWakeFd >= 0 &&
+                wPT_CREATE(&ifcThr, NULL, wfaIfcThread, NULL) == 0)
+        {
+            pthread_detach(ifcThr);
+            ifcState = 1;
+        }
+        else
+        {
+            DPRINT_WARNING(WFA_WNG, "interface cache not started, queries are not cached\n");
+        }
+    }
+    running = (ifcState == 1);
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    return running;
+}
+
+/*
+ * wfaIfcGetMac(): wfaNlGetMac(), answered from the cache until the link
+ *                 of ifname changes.
+ */
+int wfaIfcGetMac(char *ifname, char *mac, int macSz)
+{
+    wfaIfcEntry_t *ent;
+    char val[WFA_MAC_ADDR_STR_LEN];
+    unsigned int gen;
+    int ifindex;
+
+    if(!wfaIfcStart())
+        return wfaNlGetMac(ifname, mac, macSz);
+
+    wPT_MUTEX_LOCK(&ifcMutex);
+    ent = wfaIfcFind(ifname, 0);
+    if(ent != NULL && ent->macOk && !wfaIfcPending(ifcNlFd))
+    {
+        snprintf(mac, macSz, "%s", ent->mac);
+        wPT_MUTEX_UNLOCK(&ifcMutex);
+        return WFA_SUCCESS;
+    }
+    gen = ifcNlGen;
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    ifindex = if_nametoindex(ifname);
+    if(wfaNlGetMac(ifname, val, sizeof(val)) != WFA_SUCCESS)
+        return WFA_FAILURE;
+
+    wPT_MUTEX_LOCK(&ifcMutex);
+    if(ifindex != 0 && gen == ifcNlGen && !wfaIfcPending(ifcNlFd) &&
+            (ent = wfaIfcFind(ifname, 1)) != NULL)
+    {
+        if(ent->ifindex != ifindex)
+        {
+            ent->ipOk = 0;
+            ent->ifindex = ifindex;
+        }
+        strcpy(ent->mac, val);
+        ent->macOk = 1;
+    }
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    snprintf(mac, macSz, "%s", val);
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaIfcGetIpv4(): wfaNlGetIpv4(), answered from the cache until an
+ *                  address of ifname is added or removed.
+ */
+int wfaIfcGetIpv4(char *ifname, char *ipaddr, char *mask, int *isDynamic)
+{
+    wfaIfcEntry_t *ent;
+    char addr[WFA_IP_ADDR_STR_LEN], netmask[WFA_IP_MASK_STR_LEN];
+    unsigned int gen;
+    int ifindex, dynamic = 0;
+
+    if(!wfaIfcStart())
+        return wfaNlGetIpv4(ifname, ipaddr, mask, isDynamic);
+
+    wPT_MUTEX_LOCK(&ifcMutex);
+    ent = wfaIfcFind(ifname, 0);
+    if(ent != NULL && ent->ipOk && !wfaIfcPending(ifcNlFd))
+    {
+        strcpy(ipaddr, ent->ipaddr);
+        strcpy(mask, ent->mask);
+        if(isDynamic != NULL)
+            *isDynamic = ent->isDynamic;
+        wPT_MUTEX_UNLOCK(&ifcMutex);
+        return WFA_SUCCESS;
+    }
+    gen = ifcNlGen;
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    ifindex = if_nametoindex(ifname);
+    if(wfaNlGetIpv4(ifname, addr, netmask, &dynamic) != WFA_SUCCESS)
+        return WFA_FAILURE;
+
+    wPT_MUTEX_LOCK(&ifcMutex);
+    if(ifindex != 0 && gen == ifcNlGen && !wfaIfcPending(ifcNlFd) &&
+            (ent = wfaIfcFind(ifname, 1)) != NULL)
+    {
+        if(ent->ifindex != ifindex)
+        {
+            ent->macOk = 0;
+            ent->ifindex = ifindex;
+        }
+        strcpy(ent->ipaddr, addr);
+        strcpy(ent->mask, netmask);
+        ent->isDynamic = dynamic;
+        ent->ipOk = 1;
+    }
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    strcpy(ipaddr, addr);
+    strcpy(mask, netmask);
+    if(isDynamic != NULL)
+        *isDynamic = dynamic;
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaIfcWpaStatus(): wfaWpaStatusGet(), answered from the last STATUS
+ *                    reply until the supplicant sends an event for
+ *                    ifname. Without its event socket nothing is kept.
+ */
+int wfaIfcWpaStatus(char *ifname, char *key, char *val, int valSz)
+{
+    wfaIfcEntry_t *ent;
+    char status[WFA_IFC_STATUS_SZ];
+    unsigned int gen, seq;
+    int fd, n, ret, wake = 0;
+
+    if(!wfaIfcStart() || (fd = wfaWpaEventFd(ifname, 1, &seq)) < 0)
+        return wfaWpaStatusGet(ifname, key, val, valSz);
+
+    wPT_MUTEX_LOCK(&ifcMutex);
+    ent = wfaIfcFind(ifname, 0);
+    if(ent != NULL && ent->wpaOk && ent->wpaFd == fd && ent->wpaSeq == seq &&
+            !wfaIfcPending(fd))
+    {
+        ret = wfaWpaStatusField(ent->status, key, val, valSz);
+        wPT_MUTEX_UNLOCK(&ifcMutex);
+        return ret;
+    }
+    gen = ifcWpaGen;
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    n = wfaWpaRequest(ifname, status, sizeof(status), "STATUS");
+    if(n <= 0)
+        return WFA_FAILURE;
+
+    wPT_MUTEX_LOCK(&ifcMutex);
+    if((ent = wfaIfcFind(ifname, 1)) != NULL)
+    {
+        /* the thread watches the socket from now on, stored or not */
+        if(ent->wpaFd != fd || ent->wpaSeq != seq)
+        {
+            ent->wpaOk = 0;
+            ent->wpaFd = fd;
+            ent->wpaSeq = seq;
+            wake = 1;
+        }
+        else if(n < (int)sizeof(status) - 1 && gen == ifcWpaGen && !wfaIfcPending(fd))
+        {
+            wMEMCPY(ent->status, status, n + 1);
+            ent->wpaOk = 1;
+        }
+    }
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    if(wake)
+        wfaIfcWake();
+
+    return wfaWpaStatusField(status, key, val, valSz);
+}
+
+/*
+ * wfaIfcWpaWatch(): have the thread read the supplicant events of ifname
+ *                   from now on, for wfaEvList() and wfaEvLatest().
+ * return:  WFA_SUCCESS if they are read
+ */
+int wfaIfcWpaWatch(char *ifname)
+{
+    wfaIfcEntry_t *ent;
+    unsigned int seq;
+    int fd, wake = 0;
+
+    if(!wfaIfcStart() || (fd = wfaWpaEventFd(ifname, 1, &seq)) < 0)
+        return WFA_FAILURE;
+
+    wPT_MUTEX_LOCK(&ifcMutex);
+    if((ent = wfaIfcFind(ifname, 1)) != NULL && (ent->wpaFd != fd || ent->wpaSeq != seq))
+    {
+        ent->wpaOk = 0;
+        ent->wpaFd = fd;
+        ent->wpaSeq = seq;
+        wake = 1;
+    }
+    wPT_MUTEX_UNLOCK(&ifcMutex);
+
+    if(wake)
+        wfaIfcWake();
+
+    return (ent != NULL) ? WFA_SUCCESS : WFA_FAILURE;
+}
@@ -200,3 +200,108 @@ int wfa_estimate_timer_latency()
 
     return latency = (t2.tv_sec - tp2.tv_sec) * 1000000 + (t2.tv_usec - tp2.tv_usec);
 }
+
+/*
+ * wfaLatHistBucket(): bucket index of a latency value in microseconds.
+ *   values below 8 usec map one to one, above that each power of two is
+ *   split into WFA_LAT_SUB_BUCKETS linear buckets.
+ */
+static int wfaLatHistBucket(unsigned int usec)
+{
+    int exp = 0;
+    unsigned int v = usec;
+
+    if(usec < WFA_LAT_SUB_BUCKETS)
+        return usec;
+
+    while(v >>= 1)
+        exp++;
+
+    if(exp >= WFA_LAT_MAX_EXP)
+        return WFA_LAT_BUCKETS - 1;
+
+    return (exp - WFA_LAT_SUB_BITS + 1) * WFA_LAT_SUB_BUCKETS
+           + ((usec >> (exp - WFA_LAT_SUB_BITS)) & (WFA_LAT_SUB_BUCKETS - 1));
+}
+
+/*
+ * wfaLatHistBucketTop(): the highest value held by a bucket
+ */
+static unsigned int wfaLatHistBucketTop(int idx)
+{
+    int exp;
+
+    if(idx < WFA_LAT_SUB_BUCKETS)
+        return idx;
+
+    exp = idx / WFA_LAT_SUB_BUCKETS + WFA_LAT_SUB_BITS - 1;
+
+    return ((WFA_LAT_SUB_BUCKETS + idx % WFA_LAT_SUB_BUCKETS + 1) << (exp - WFA_LAT_SUB_BITS)) - 1;
+}
+
+void wfaLatHistReset(tgLatHist_t *hist)
+{
+    wMEMSET(hist, 0, sizeof(tgLatHist_t));
+}
+
+void wfaLatHistAdd(tgLatHist_t *hist, unsigned int usec)
+{
+    if(hist->count == 0 || usec < hist->minUs)
+        hist->minUs = usec;
+    if(usec > hist->maxUs)
+        hist->maxUs = usec;
+
+    hist->count++;
+    hist->sumUs += usec;
+    hist->bucket[wfaLatHistBucket(usec)]++;
+}
+
+/*
+ * wfaLatHistPercentile(): the value below which pct percent of the
+ *                         samples fall, bounded by the recorded max.
+ */
+unsigned int wfaLatHistPercentile(tgLatHist_t *hist, int pct)
+{
+    unsigned long long target, seen = 0;
+    unsigned int top;
+    int i;
+
+    if(hist->count == 0)
+        return 0;
+
+    target = ((unsigned long long)hist->count * pct + 99) / 100;
+    if(target == 0)
+        target = 1;
+
+    for(i = 0; i < WFA_LAT_BUCKETS; i++)
+    {
+        seen += hist->bucket[i];
+        if(seen >= target)
+        {
+            top = wfaLatHistBucketTop(i);
+            return (top > hist->maxUs) ? hist->maxUs : top;
+        }
+    }
+
+    return hist->maxUs;
+}
+
+/*
+ * wfaLatHistSummary(): fill in the round trip fields of the stream stats
+ */
+void wfaLatHistSummary(tgLatHist_t *hist, tgStats_t *stats)
+{
+    if(hist->count == 0)
+    {
+        stats->rttMin = stats->rttAvg = stats->rttMax = 0;
+        stats->rttP50 = stats->rttP95 = stats->rttP99 = 0;
+        return;
+    }
+
+    stats->rttMin = hist->minUs;
+    stats->rttMax = hist->maxUs;
+    stats->rttAvg = (unsigned int)(hist->sumUs / hist->count);
+    stats->rttP50 = wfaLatHistPercentile(hist, 50);
+    stats->rttP95 = wfaLatHistPercentile(hist, 95);
+    stats->rttP99 = wfaLatHistPercentile(hist, 99);
+}
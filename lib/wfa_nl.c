@@ -0,0 +1,979 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_nl.c - interface configuration over rtnetlink.
+ *       Each call opens a NETLINK_ROUTE socket, sends one request and
+ *       reads the answer up to its ACK or the end of the dump. Nothing
+ *       is forked and nothing depends on the output format of a tool.
+ *       A monitor socket subscribed to link and address changes lets
+ *       the callers learn when what they read is out of date.
+ *       Interface counters come from the link and qdisc dumps, the
+ *       wireless ones from nl80211 over generic netlink.
+ *       Name servers are read from and written to resolv.conf.
+ */
+#include <stddef.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+#include <linux/pkt_sched.h>
+#include <linux/gen_stats.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_nl.h"
+
+extern unsigned short wfa_defined_debug;
+
+/* primary addresses replaced by a new one */
+#define WFA_NL_MAX_ADDRS       8
+
+typedef struct _wfa_nl_req
+{
+    struct nlmsghdr hdr;
+    union
+    {
+        struct ifinfomsg link;
+        struct ifaddrmsg addr;
+        struct rtmsg route;
+        struct ndmsg neigh;
+        struct tcmsg tc;
+        struct genlmsghdr genl;
+    } u;
+    char attrs[256];
+} wfaNlReq_t;
+
+/* what the address dump found on one interface */
+typedef struct _wfa_nl_addrs
+{
+    int ifindex;
+    int num;
+    struct in_addr addr[WFA_NL_MAX_ADDRS];
+    unsigned char plen[WFA_NL_MAX_ADDRS];
+    unsigned char flags[WFA_NL_MAX_ADDRS];
+} wfaNlAddrs_t;
+
+typedef int (*wfaNlCb_t)(struct nlmsghdr *msg, void *arg);
+
+static unsigned int nlSeq = 0;
+static int nl80211Id = 0;
+
+static int wfaNlOpen(int proto)
+{
+    struct sockaddr_nl local;
+    struct timeval tmout;
+    int fd;
+
+    if((fd = socket(AF_NETLINK, SOCK_RAW, proto)) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "netlink socket() failed: %i\n", errno);
+        return -1;
+    }
+
+    wMEMSET(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    if(bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "netlink bind() failed: %i\n", errno);
+        close(fd);
+        return -1;
+    }
+
+    tmout.tv_sec = WFA_NL_TMOUT_MS / 1000;
+    tmout.tv_usec = (WFA_NL_TMOUT_MS % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tmout, sizeof(tmout));
+
+    return fd;
+}
+
+static void wfaNlAddAttr(struct nlmsghdr *hdr, int type, void *data, int alen)
+{
+    struct rtattr *rta = (struct rtattr *)((char *)hdr + NLMSG_ALIGN(hdr->nlmsg_len));
+
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH(alen);
+    wMEMCPY(RTA_DATA(rta), data, alen);
+    hdr->nlmsg_len = NLMSG_ALIGN(hdr->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+/* the attributes of a message by type, nested flags masked off */
+static void wfaNlParseAttrs(struct rtattr *tb[], int max, struct rtattr *rta, int alen)
+{
+    int type;
+
+    wMEMSET(tb, 0, sizeof(struct rtattr *) * (max + 1));
+    for(; RTA_OK(rta, alen); rta = RTA_NEXT(rta, alen))
+    {
+        type = rta->rta_type & NLA_TYPE_MASK;
+        if(type <= max)
+            tb[type] = rta;
+    }
+}
+
+/*
+ * wfaNlTalkOn(): send one request on a socket of the netlink family proto
+ *                and hand every answer to cb until the dump is done or
+ *                the request is acknowledged.
+ * return:  WFA_SUCCESS, or WFA_FAILURE with errno set from the kernel
+ */
+static int wfaNlTalkOn(int proto, wfaNlReq_t *req, wfaNlCb_t cb, void *arg)
+{
+    char buf[WFA_NL_BUFF_SZ];
+    struct nlmsghdr *msg;
+    struct nlmsgerr *err;
+    int fd, n, ret = WFA_FAILURE;
+    unsigned int seq;
+
+    if((fd = wfaNlOpen(proto)) < 0)
+        return WFA_FAILURE;
+
+    seq = __sync_add_and_fetch(&nlSeq, 1);
+    req->hdr.nlmsg_seq = seq;
+    req->hdr.nlmsg_pid = 0;
+    if(!(req->hdr.nlmsg_flags & NLM_F_DUMP))
+        req->hdr.nlmsg_flags |= NLM_F_ACK;
+
+    if(send(fd, req, req->hdr.nlmsg_len, 0) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "netlink send() failed: %i\n", errno);
+        close(fd);
+        return WFA_FAILURE;
+    }
+
+    for(;;)
+    {
+        n = recv(fd, buf, sizeof(buf), 0);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            DPRINT_ERR(WFA_ERR, "netlink recv() failed: %i\n", errno);
+            break;
+        }
+
+        for(msg = (struct nlmsghdr *)buf; NLMSG_OK(msg, n); msg = NLMSG_NEXT(msg, n))
+        {
+            if(msg->nlmsg_seq != seq)
+                continue;
+
+            if(msg->nlmsg_type == NLMSG_DONE)
+            {
+                ret = WFA_SUCCESS;
+                goto done;
+            }
+
+            if(msg->nlmsg_type == NLMSG_ERROR)
+            {
+                err = (struct nlmsgerr *)NLMSG_DATA(msg);
+                if(err->error == 0)
+                    ret = WFA_SUCCESS;
+                else
+                    errno = -err->error;
+                goto done;
+            }
+
+            if(cb != NULL && cb(msg, arg) != WFA_SUCCESS)
+                goto done;
+        }
+    }
+
+done:
+    close(fd);
+    return ret;
+}
+
+static int wfaNlTalk(wfaNlReq_t *req, wfaNlCb_t cb, void *arg)
+{
+    return wfaNlTalkOn(NETLINK_ROUTE, req, cb, arg);
+}
+
+static int wfaNlIfindex(char *ifname)
+{
+    int ifindex = if_nametoindex(ifname);
+
+    if(ifindex == 0)
+        DPRINT_WARNING(WFA_WNG, "no interface %s\n", ifname);
+
+    return ifindex;
+}
+
+static int wfaNlLinkCb(struct nlmsghdr *msg, void *arg)
+{
+    struct ifinfomsg *ifi = (struct ifinfomsg *)NLMSG_DATA(msg);
+    struct rtattr *rta;
+    unsigned char *hw;
+    int alen = IFLA_PAYLOAD(msg);
+
+    if(msg->nlmsg_type != RTM_NEWLINK)
+        return WFA_SUCCESS;
+
+    for(rta = IFLA_RTA(ifi); RTA_OK(rta, alen); rta = RTA_NEXT(rta, alen))
+    {
+        if(rta->rta_type != IFLA_ADDRESS || RTA_PAYLOAD(rta) != 6)
+            continue;
+
+        hw = (unsigned char *)RTA_DATA(rta);
+        sprintf((char *)arg, "%02x:%02x:%02x:%02x:%02x:%02x",
+                hw[0], hw[1], hw[2], hw[3], hw[4], hw[5]);
+    }
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaNlGetMac(): the hardware address of an interface, "xx:xx:xx:xx:xx:xx"
+ * return:  WFA_SUCCESS, or WFA_FAILURE if there is no such interface
+ *          or it has no ethernet address
+ */
+int wfaNlGetMac(char *ifname, char *mac, int macSz)
+{
+    wfaNlReq_t req;
+    char hw[WFA_MAC_ADDR_STR_LEN] = "";
+
+    wMEMSET(&req, 0, sizeof(req));
+    if((req.u.link.ifi_index = wfaNlIfindex(ifname)) == 0)
+        return WFA_FAILURE;
+
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.hdr.nlmsg_type = RTM_GETLINK;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST;
+    req.u.link.ifi_family = AF_UNSPEC;
+
+    if(wfaNlTalk(&req, wfaNlLinkCb, hw) != WFA_SUCCESS || hw[0] == '\0')
+        return WFA_FAILURE;
+
+    wSTRNCPY(mac, hw, macSz - 1);
+    mac[macSz - 1] = '\0';
+
+    return WFA_SUCCESS;
+}
+
+static int wfaNlAddrCb(struct nlmsghdr *msg, void *arg)
+{
+    wfaNlAddrs_t *addrs = (wfaNlAddrs_t *)arg;
+    struct ifaddrmsg *ifa = (struct ifaddrmsg *)NLMSG_DATA(msg);
+    struct rtattr *rta;
+    struct in_addr *local = NULL;
+    int alen = IFA_PAYLOAD(msg);
+
+    if(msg->nlmsg_type != RTM_NEWADDR || ifa->ifa_family != AF_INET ||
+            (int)ifa->ifa_index != addrs->ifindex || addrs->num == WFA_NL_MAX_ADDRS)
+        return WFA_SUCCESS;
+
+    /* IFA_LOCAL is the address itself, IFA_ADDRESS the peer on a p-t-p link */
+    for(rta = IFA_RTA(ifa); RTA_OK(rta, alen); rta = RTA_NEXT(rta, alen))
+    {
+        if(rta->rta_type == IFA_LOCAL || (rta->rta_type == IFA_ADDRESS && local == NULL))
+            local = (struct in_addr *)RTA_DATA(rta);
+    }
+
+    if(local == NULL)
+        return WFA_SUCCESS;
+
+    addrs->addr[addrs->num] = *local;
+    addrs->plen[addrs->num] = ifa->ifa_prefixlen;
+    addrs->flags[addrs->num] = ifa->ifa_flags;
+    addrs->num++;
+
+    return WFA_SUCCESS;
+}
+
+static int wfaNlDumpIpv4(int ifindex, wfaNlAddrs_t *addrs)
+{
+    wfaNlReq_t req;
+
+    wMEMSET(addrs, 0, sizeof(wfaNlAddrs_t));
+    addrs->ifindex = ifindex;
+
+    wMEMSET(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+    req.hdr.nlmsg_type = RTM_GETADDR;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.u.addr.ifa_family = AF_INET;
+
+    return wfaNlTalk(&req, wfaNlAddrCb, addrs);
+}
+
+static void wfaNlPlenToMask(int plen, char *mask)
+{
+    struct in_addr m;
+
+    m.s_addr = plen == 0 ? 0 : htonl(0xffffffffU << (32 - plen));
+    strcpy(mask, inet_ntoa(m));
+}
+
+static int wfaNlMaskToPlen(char *mask)
+{
+    struct in_addr m;
+    unsigned int bits;
+    int plen = 0;
+
+    if(inet_aton(mask, &m) == 0)
+        return -1;
+
+    bits = ntohl(m.s_addr);
+    while(bits & 0x80000000U)
+    {
+        plen++;
+        bits <<= 1;
+    }
+
+    /* the ones have to be contiguous */
+    return bits == 0 ? plen : -1;
+}
+
+/*
+ * wfaNlGetIpv4(): the primary IPv4 address and mask of an interface,
+ *                 "none" for both if it has none. An address the kernel
+ *                 ages out (not permanent) was leased, by DHCP.
+ * return:  WFA_SUCCESS, or WFA_FAILURE if the interface can't be read
+ */
+int wfaNlGetIpv4(char *ifname, char *ipaddr, char *mask, int *isDynamic)
+{
+    wfaNlAddrs_t addrs;
+    int ifindex, i;
+
+    if((ifindex = wfaNlIfindex(ifname)) == 0)
+        return WFA_FAILURE;
+
+    if(wfaNlDumpIpv4(ifindex, &addrs) != WFA_SUCCESS)
+        return WFA_FAILURE;
+
+    strcpy(ipaddr, "none");
+    strcpy(mask, "none");
+    *isDynamic = 0;
+
+    for(i = 0; i < addrs.num; i++)
+    {
+        if(addrs.flags[i] & IFA_F_SECONDARY)
+            continue;
+
+        strcpy(ipaddr, inet_ntoa(addrs.addr[i]));
+        wfaNlPlenToMask(addrs.plen[i], mask);
+        *isDynamic = !(addrs.flags[i] & IFA_F_PERMANENT);
+        break;
+    }
+
+    return WFA_SUCCESS;
+}
+
+static int wfaNlAddr(int type, int flags, int ifindex, struct in_addr *addr, int plen)
+{
+    wfaNlReq_t req;
+    struct in_addr bcast;
+
+    wMEMSET(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+    req.hdr.nlmsg_type = type;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | flags;
+    req.u.addr.ifa_family = AF_INET;
+    req.u.addr.ifa_prefixlen = plen;
+    req.u.addr.ifa_index = ifindex;
+
+    wfaNlAddAttr(&req.hdr, IFA_LOCAL, addr, sizeof(struct in_addr));
+    wfaNlAddAttr(&req.hdr, IFA_ADDRESS, addr, sizeof(struct in_addr));
+    if(type == RTM_NEWADDR && plen < 31)
+    {
+        bcast.s_addr = addr->s_addr | (plen == 0 ? 0xffffffffU : htonl(0xffffffffU >> plen));
+        wfaNlAddAttr(&req.hdr, IFA_BROADCAST, &bcast, sizeof(struct in_addr));
+    }
+
+    return wfaNlTalk(&req, NULL, NULL);
+}
+
+/*
+ * wfaNlSetIpv4(): replace the IPv4 address of an interface, as ifconfig
+ *                 does, and bring the interface up.
+ * return:  WFA_SUCCESS or WFA_FAILURE
+ */
+int wfaNlSetIpv4(char *ifname, char *ipaddr, char *mask)
+{
+    wfaNlAddrs_t addrs;
+    wfaNlReq_t req;
+    struct in_addr addr;
+    int ifindex, plen, i;
+
+    if((ifindex = wfaNlIfindex(ifname)) == 0)
+        return WFA_FAILURE;
+
+    plen = (mask == NULL || mask[0] == '\0') ? 24 : wfaNlMaskToPlen(mask);
+    if(inet_aton(ipaddr, &addr) == 0 || plen < 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "bad address %s/%s\n", ipaddr, mask);
+        return WFA_FAILURE;
+    }
+
+    /* the secondaries go away with their primary */
+    if(wfaNlDumpIpv4(ifindex, &addrs) == WFA_SUCCESS)
+    {
+        for(i = 0; i < addrs.num; i++)
+        {
+            if(!(addrs.flags[i] & IFA_F_SECONDARY))
+                wfaNlAddr(RTM_DELADDR, 0, ifindex, &addrs.addr[i], addrs.plen[i]);
+        }
+    }
+
+    if(wfaNlAddr(RTM_NEWADDR, NLM_F_CREATE | NLM_F_REPLACE, ifindex, &addr, plen) != WFA_SUCCESS)
+    {
+        DPRINT_ERR(WFA_ERR, "set %s/%i on %s failed: %i\n", ipaddr, plen, ifname, errno);
+        return WFA_FAILURE;
+    }
+
+    wMEMSET(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.hdr.nlmsg_type = RTM_NEWLINK;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST;
+    req.u.link.ifi_family = AF_UNSPEC;
+    req.u.link.ifi_index = ifindex;
+    req.u.link.ifi_flags = IFF_UP;
+    req.u.link.ifi_change = IFF_UP;
+
+    return wfaNlTalk(&req, NULL, NULL);
+}
+
+/*
+ * wfaNlSetDefaultGw(): the default route of the main table goes through
+ *                      gwaddr, an existing one is replaced.
+ * return:  WFA_SUCCESS or WFA_FAILURE
+ */
+int wfaNlSetDefaultGw(char *gwaddr)
+{
+    wfaNlReq_t req;
+    struct in_addr gw;
+
+    if(inet_aton(gwaddr, &gw) == 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "bad gateway %s\n", gwaddr);
+        return WFA_FAILURE;
+    }
+
+    wMEMSET(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.hdr.nlmsg_type = RTM_NEWROUTE;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_CREATE | NLM_F_REPLACE;
+    req.u.route.rtm_family = AF_INET;
+    req.u.route.rtm_table = RT_TABLE_MAIN;
+    req.u.route.rtm_protocol = RTPROT_BOOT;
+    req.u.route.rtm_scope = RT_SCOPE_UNIVERSE;
+    req.u.route.rtm_type = RTN_UNICAST;
+
+    wfaNlAddAttr(&req.hdr, RTA_GATEWAY, &gw, sizeof(struct in_addr));
+
+    if(wfaNlTalk(&req, NULL, NULL) != WFA_SUCCESS)
+    {
+        DPRINT_ERR(WFA_ERR, "default gw %s failed: %i\n", gwaddr, errno);
+        return WFA_FAILURE;
+    }
+
+    return WFA_SUCCESS;
+}
+
+/* what the neighbour dump is looking for, and what it found */
+typedef struct _wfa_nl_neigh
+{
+    struct in_addr addr;
+    int reachable;
+} wfaNlNeigh_t;
+
+static int wfaNlNeighCb(struct nlmsghdr *msg, void *arg)
+{
+    wfaNlNeigh_t *neigh = (wfaNlNeigh_t *)arg;
+    struct ndmsg *ndm = (struct ndmsg *)NLMSG_DATA(msg);
+    struct rtattr *rta;
+    int alen = msg->nlmsg_len - NLMSG_LENGTH(sizeof(struct ndmsg));
+
+    if(msg->nlmsg_type != RTM_NEWNEIGH || ndm->ndm_family != AF_INET ||
+            !(ndm->ndm_state & (NUD_REACHABLE | NUD_PERMANENT)))
+        return WFA_SUCCESS;
+
+    for(rta = (struct rtattr *)((char *)ndm + NLMSG_ALIGN(sizeof(struct ndmsg)));
+            RTA_OK(rta, alen); rta = RTA_NEXT(rta, alen))
+    {
+        if(rta->rta_type == NDA_DST && RTA_PAYLOAD(rta) == sizeof(struct in_addr) &&
+                memcmp(RTA_DATA(rta), &neigh->addr, sizeof(struct in_addr)) == 0)
+            neigh->reachable = 1;
+    }
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaNlNeighReachable(): did an on-link IPv4 host answer ARP lately?
+ * return:  1 if its neighbour entry is reachable, 0 if not or unknown
+ */
+int wfaNlNeighReachable(struct in_addr *addr)
+{
+    wfaNlReq_t req;
+    wfaNlNeigh_t neigh;
+
+    neigh.addr = *addr;
+    neigh.reachable = 0;
+
+    wMEMSET(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    req.hdr.nlmsg_type = RTM_GETNEIGH;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.u.neigh.ndm_family = AF_INET;
+
+    if(wfaNlTalk(&req, wfaNlNeighCb, &neigh) != WFA_SUCCESS)
+        return 0;
+
+    return neigh.reachable;
+}
+
+/* a counter of wfaNlStats_t by its sysfs name */
+typedef struct _wfa_nl_sys_stat
+{
+    char *name;
+    int off;
+} wfaNlSysStat_t;
+
+static wfaNlSysStat_t nlSysStats[] =
+{
+    {"rx_packets",       offsetof(wfaNlStats_t, rxPackets)},
+    {"tx_packets",       offsetof(wfaNlStats_t, txPackets)},
+    {"rx_bytes",         offsetof(wfaNlStats_t, rxBytes)},
+    {"tx_bytes",         offsetof(wfaNlStats_t, txBytes)},
+    {"rx_errors",        offsetof(wfaNlStats_t, rxErrors)},
+    {"tx_errors",        offsetof(wfaNlStats_t, txErrors)},
+    {"rx_dropped",       offsetof(wfaNlStats_t, rxDropped)},
+    {"tx_dropped",       offsetof(wfaNlStats_t, txDropped)},
+    {"multicast",        offsetof(wfaNlStats_t, rxMulticast)},
+    {"rx_crc_errors",    offsetof(wfaNlStats_t, rxCrcErrors)},
+    {"rx_fifo_errors",   offsetof(wfaNlStats_t, rxFifoErrors)},
+    {"rx_missed_errors", offsetof(wfaNlStats_t, rxMissed)},
+    {"tx_fifo_errors",   offsetof(wfaNlStats_t, txFifoErrors)},
+};
+
+typedef struct _wfa_nl_stats_arg
+{
+    int ifindex;
+    int found;                      /* the link had IFLA_STATS64 */
+    wfaNlStats_t *stats;
+} wfaNlStatsArg_t;
+
+static int wfaNlLinkStatsCb(struct nlmsghdr *msg, void *arg)
+{
+    wfaNlStatsArg_t *sa = (wfaNlStatsArg_t *)arg;
+    wfaNlStats_t *st = sa->stats;
+    struct ifinfomsg *ifi = (struct ifinfomsg *)NLMSG_DATA(msg);
+    struct rtattr *tb[IFLA_MAX + 1];
+    struct rtnl_link_stats64 ls;
+    int len;
+
+    if(msg->nlmsg_type != RTM_NEWLINK)
+        return WFA_SUCCESS;
+
+    wfaNlParseAttrs(tb, IFLA_MAX, IFLA_RTA(ifi), IFLA_PAYLOAD(msg));
+    if(tb[IFLA_STATS64] == NULL)
+        return WFA_SUCCESS;
+
+    /* copied out, the attribute is only 4 byte aligned */
+    len = RTA_PAYLOAD(tb[IFLA_STATS64]);
+    wMEMSET(&ls, 0, sizeof(ls));
+    wMEMCPY(&ls, RTA_DATA(tb[IFLA_STATS64]), len < sizeof(ls) ? len : sizeof(ls));
+
+    st->rxPackets = ls.rx_packets;
+    st->txPackets = ls.tx_packets;
+    st->rxBytes = ls.rx_bytes;
+    st->txBytes = ls.tx_bytes;
+    st->rxErrors = ls.rx_errors;
+    st->txErrors = ls.tx_errors;
+    st->rxDropped = ls.rx_dropped;
+    st->txDropped = ls.tx_dropped;
+    st->rxMulticast = ls.multicast;
+    st->rxCrcErrors = ls.rx_crc_errors;
+    st->rxFifoErrors = ls.rx_fifo_errors;
+    st->rxMissed = ls.rx_missed_errors;
+    st->txFifoErrors = ls.tx_fifo_errors;
+    sa->found = 1;
+
+    return WFA_SUCCESS;
+}
+
+/* the link counters from sysfs, for kernels without IFLA_STATS64 */
+static void wfaNlSysStats(char *ifname, wfaNlStats_t *st)
+{
+    char path[WFA_BUFF_128];
+    unsigned long long val;
+    FILE *fp;
+    int i;
+
+    for(i = 0; i < sizeof(nlSysStats) / sizeof(nlSysStats[0]); i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s/statistics/%s", WFA_SYS_NET_DIR, ifname, nlSysStats[i].name);
+        if((fp = fopen(path, "r")) == NULL)
+            continue;
+
+        if(fscanf(fp, "%llu", &val) == 1)
+            *(unsigned long long *)((char *)st + nlSysStats[i].off) = val;
+        fclose(fp);
+    }
+}
+
+static int wfaNlQdiscCb(struct nlmsghdr *msg, void *arg)
+{
+    wfaNlStatsArg_t *sa = (wfaNlStatsArg_t *)arg;
+    struct tcmsg *tcm = (struct tcmsg *)NLMSG_DATA(msg);
+    struct rtattr *tb[TCA_MAX + 1], *qs[TCA_STATS_MAX + 1];
+    struct gnet_stats_queue q;
+    int len;
+
+    if(msg->nlmsg_type != RTM_NEWQDISC || tcm->tcm_ifindex != sa->ifindex ||
+            tcm->tcm_parent != TC_H_ROOT)
+        return WFA_SUCCESS;
+
+    wfaNlParseAttrs(tb, TCA_MAX, TCA_RTA(tcm), TCA_PAYLOAD(msg));
+    if(tb[TCA_STATS2] == NULL)
+        return WFA_SUCCESS;
+
+    wfaNlParseAttrs(qs, TCA_STATS_MAX, (struct rtattr *)RTA_DATA(tb[TCA_STATS2]), RTA_PAYLOAD(tb[TCA_STATS2]));
+    if(qs[TCA_STATS_QUEUE] == NULL)
+        return WFA_SUCCESS;
+
+    len = RTA_PAYLOAD(qs[TCA_STATS_QUEUE]);
+    wMEMSET(&q, 0, sizeof(q));
+    wMEMCPY(&q, RTA_DATA(qs[TCA_STATS_QUEUE]), len < sizeof(q) ? len : sizeof(q));
+
+    /* a multiqueue root sums up its children */
+    sa->stats->qdiscDrops = q.drops;
+    sa->stats->qdiscRequeues = q.requeues;
+
+    return WFA_SUCCESS;
+}
+
+static int wfaNlFamilyCb(struct nlmsghdr *msg, void *arg)
+{
+    struct genlmsghdr *gh = (struct genlmsghdr *)NLMSG_DATA(msg);
+    struct rtattr *tb[CTRL_ATTR_MAX + 1];
+
+    wfaNlParseAttrs(tb, CTRL_ATTR_MAX, (struct rtattr *)((char *)gh + GENL_HDRLEN),
+            msg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+    if(tb[CTRL_ATTR_FAMILY_ID] != NULL)
+        *(int *)arg = *(unsigned short *)RTA_DATA(tb[CTRL_ATTR_FAMILY_ID]);
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaNl80211Id(): the generic netlink family of nl80211, looked up until
+ *                 cfg80211 is there.
+ * return:  the family id, 0 if there is none
+ */
+static int wfaNl80211Id(void)
+{
+    wfaNlReq_t req;
+    int id = 0;
+
+    if(nl80211Id > 0)
+        return nl80211Id;
+
+    wMEMSET(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    req.hdr.nlmsg_type = GENL_ID_CTRL;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST;
+    req.u.genl.cmd = CTRL_CMD_GETFAMILY;
+    req.u.genl.version = 1;
+    wfaNlAddAttr(&req.hdr, CTRL_ATTR_FAMILY_NAME, NL80211_GENL_NAME, sizeof(NL80211_GENL_NAME));
+
+    if(wfaNlTalkOn(NETLINK_GENERIC, &req, wfaNlFamilyCb, &id) == WFA_SUCCESS)
+        nl80211Id = id;
+
+    return id;
+}
+
+static int wfaNlStationCb(struct nlmsghdr *msg, void *arg)
+{
+    wfaNlStats_t *st = (wfaNlStats_t *)arg;
+    struct genlmsghdr *gh = (struct genlmsghdr *)NLMSG_DATA(msg);
+    struct rtattr *tb[NL80211_ATTR_MAX + 1], *si[NL80211_STA_INFO_MAX + 1];
+    unsigned long long drop;
+
+    wfaNlParseAttrs(tb, NL80211_ATTR_MAX, (struct rtattr *)((char *)gh + GENL_HDRLEN),
+            msg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN));
+    if(tb[NL80211_ATTR_STA_INFO] == NULL)
+        return WFA_SUCCESS;
+
+    wfaNlParseAttrs(si, NL80211_STA_INFO_MAX, (struct rtattr *)RTA_DATA(tb[NL80211_ATTR_STA_INFO]),
+            RTA_PAYLOAD(tb[NL80211_ATTR_STA_INFO]));
+
+    if(si[NL80211_STA_INFO_TX_RETRIES] != NULL)
+        st->txRetries += *(unsigned int *)RTA_DATA(si[NL80211_STA_INFO_TX_RETRIES]);
+    if(si[NL80211_STA_INFO_TX_FAILED] != NULL)
+        st->txFailed += *(unsigned int *)RTA_DATA(si[NL80211_STA_INFO_TX_FAILED]);
+    if(si[NL80211_STA_INFO_BEACON_LOSS] != NULL)
+        st->beaconLoss += *(unsigned int *)RTA_DATA(si[NL80211_STA_INFO_BEACON_LOSS]);
+    if(si[NL80211_STA_INFO_RX_DROP_MISC] != NULL)
+    {
+        wMEMCPY(&drop, RTA_DATA(si[NL80211_STA_INFO_RX_DROP_MISC]), sizeof(drop));
+        st->rxDropMisc += drop;
+    }
+
+    return WFA_SUCCESS;
+}
+
+/* the wireless counters summed over the stations of a cfg80211 interface */
+static int wfaNlWlStats(int ifindex, wfaNlStats_t *st)
+{
+    wfaNlReq_t req;
+    unsigned int idx = ifindex;
+
+    wMEMSET(&req, 0, sizeof(req));
+    if((req.hdr.nlmsg_type = wfaNl80211Id()) == 0)
+        return WFA_FAILURE;
+
+    req.hdr.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.u.genl.cmd = NL80211_CMD_GET_STATION;
+    wfaNlAddAttr(&req.hdr, NL80211_ATTR_IFINDEX, &idx, sizeof(idx));
+
+    return wfaNlTalkOn(NETLINK_GENERIC, &req, wfaNlStationCb, st);
+}
+
+/*
+ * wfaNlWextStats(): the discard counters of the wireless extensions.
+ *                   There is no retry count, frames discarded after too
+ *                   many retries go to txFailed.
+ */
+static int wfaNlWextStats(char *ifname, wfaNlStats_t *st)
+{
+    char line[WFA_BUFF_512], name[WFA_IF_NAME_LEN];
+    unsigned long long nwid, crypt, frag, retry, misc, beacon;
+    int ret = WFA_FAILURE;
+    FILE *fp;
+
+    if((fp = fopen(WFA_PROC_NET_WIRELESS, "r")) == NULL)
+        return WFA_FAILURE;
+
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        if(sscanf(line, " %15[^:]: %*s %*s %*s %*s %llu %llu %llu %llu %llu %llu",
+                    name, &nwid, &crypt, &frag, &retry, &misc, &beacon) != 7 ||
+                strcmp(name, ifname) != 0)
+            continue;
+
+        st->txFailed = retry;
+        st->rxDropMisc = nwid + crypt + frag + misc;
+        st->beaconLoss = beacon;
+        ret = WFA_SUCCESS;
+        break;
+    }
+
+    fclose(fp);
+    return ret;
+}
+
+/*
+ * wfaNlGetStats(): the counters of an interface. The link counters come
+ *                  from IFLA_STATS64, or from sysfs on kernels without it,
+ *                  the wireless ones from nl80211 or else the wireless
+ *                  extensions. wlSrc tells which, WFA_NL_WL_xxx.
+ * return:  WFA_SUCCESS, or WFA_FAILURE if there is no such interface
+ */
+int wfaNlGetStats(char *ifname, wfaNlStats_t *stats, int *wlSrc)
+{
+    wfaNlReq_t req;
+    wfaNlStatsArg_t sa;
+
+    wMEMSET(stats, 0, sizeof(*stats));
+    *wlSrc = WFA_NL_WL_NONE;
+
+    sa.stats = stats;
+    sa.found = 0;
+    if((sa.ifindex = wfaNlIfindex(ifname)) == 0)
+        return WFA_FAILURE;
+
+    wMEMSET(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.hdr.nlmsg_type = RTM_GETLINK;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST;
+    req.u.link.ifi_family = AF_UNSPEC;
+    req.u.link.ifi_index = sa.ifindex;
+    wfaNlTalk(&req, wfaNlLinkStatsCb, &sa);
+    if(!sa.found)
+        wfaNlSysStats(ifname, stats);
+
+    wMEMSET(&req, 0, sizeof(req));
+    req.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(struct tcmsg));
+    req.hdr.nlmsg_type = RTM_GETQDISC;
+    req.hdr.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.u.tc.tcm_family = AF_UNSPEC;
+    req.u.tc.tcm_ifindex = sa.ifindex;
+    wfaNlTalk(&req, wfaNlQdiscCb, &sa);
+
+    if(wfaNlWlStats(sa.ifindex, stats) == WFA_SUCCESS)
+        *wlSrc = WFA_NL_WL_NL80211;
+    else if(wfaNlWextStats(ifname, stats) == WFA_SUCCESS)
+        *wlSrc = WFA_NL_WL_WEXT;
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaNlMonitorOpen(): a socket the kernel sends its link and IPv4 address
+ *                     changes to, for wfaNlMonitorRead().
+ * return:  the socket or -1
+ */
+int wfaNlMonitorOpen(void)
+{
+    struct sockaddr_nl local;
+    int fd, rcvSz = WFA_NL_MON_RCVBUF;
+
+    if((fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE)) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "netlink socket() failed: %i\n", errno);
+        return -1;
+    }
+
+    wMEMSET(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    local.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+    if(bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "netlink bind() failed: %i\n", errno);
+        close(fd);
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvSz, sizeof(rcvSz));
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    return fd;
+}
+
+/*
+ * wfaNlMonitorRead(): hand every change queued on the monitor socket to
+ *                     cb, with its message type and interface index.
+ * return:  WFA_FAILURE if the socket overran and changes were lost
+ */
+int wfaNlMonitorRead(int fd, wfaNlEvCb_t cb, void *arg)
+{
+    char buf[WFA_NL_BUFF_SZ];
+    struct nlmsghdr *msg;
+    int n, ifindex;
+
+    for(;;)
+    {
+        n = recv(fd, buf, sizeof(buf), 0);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            if(errno == EAGAIN)
+                return WFA_SUCCESS;
+
+            DPRINT_WARNING(WFA_WNG, "netlink monitor: %i\n", errno);
+            return WFA_FAILURE;
+        }
+
+        for(msg = (struct nlmsghdr *)buf; NLMSG_OK(msg, n); msg = NLMSG_NEXT(msg, n))
+        {
+            switch(msg->nlmsg_type)
+            {
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+                ifindex = ((struct ifinfomsg *)NLMSG_DATA(msg))->ifi_index;
+                break;
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                ifindex = ((struct ifaddrmsg *)NLMSG_DATA(msg))->ifa_index;
+                break;
+            default:
+                continue;
+            }
+
+            cb(msg->nlmsg_type, ifindex, arg);
+        }
+    }
+}
+
+/*
+ * wfaResolvGet(): the first name servers of resolv.conf
+ * return:  how many were found
+ */
+int wfaResolvGet(char dns[][WFA_IP_ADDR_STR_LEN], int maxDns)
+{
+    FILE *fp;
+    char line[WFA_BUFF_512];
+    char addr[WFA_BUFF_64];
+    int num = 0;
+
+    if((fp = fopen(WFA_RESOLV_CONF, "r")) == NULL)
+        return 0;
+
+    while(num < maxDns && fgets(line, sizeof(line), fp) != NULL)
+    {
+        /* the reply has room for IPv4 servers only */
+        if(sscanf(line, " nameserver %63s", addr) != 1 ||
+                strlen(addr) >= WFA_IP_ADDR_STR_LEN)
+            continue;
+
+        strcpy(dns[num], addr);
+        num++;
+    }
+
+    fclose(fp);
+    return num;
+}
+
+/*
+ * wfaResolvSet(): resolv.conf gets the given name servers only. The old
+ *                 file is kept in WFA_RESOLV_CONF_BK.
+ * return:  WFA_SUCCESS or WFA_FAILURE
+ */
+int wfaResolvSet(char *priDns, char *secDns)
+{
+    FILE *in, *out;
+    char line[WFA_BUFF_512];
+
+    if((in = fopen(WFA_RESOLV_CONF, "r")) != NULL)
+    {
+        if((out = fopen(WFA_RESOLV_CONF_BK, "w")) != NULL)
+        {
+            while(fgets(line, sizeof(line), in) != NULL)
+                fputs(line, out);
+            fclose(out);
+        }
+        fclose(in);
+    }
+
+    /* written in place, the file may be a link into a resolver's run dir */
+    if((out = fopen(WFA_RESOLV_CONF, "w")) == NULL)
+    {
+        DPRINT_ERR(WFA_ERR, "open %s failed: %i\n", WFA_RESOLV_CONF, errno);
+        return WFA_FAILURE;
+    }
+
+    if(priDns != NULL && priDns[0] != '\0')
+        fprintf(out, "nameserver %s\n", priDns);
+    if(secDns != NULL && secDns[0] != '\0')
+        fprintf(out, "nameserver %s\n", secDns);
+
+    fclose(out);
+    return WFA_SUCCESS;
+}
@@ -0,0 +1,658 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_ping.c - the ICMP echo engine behind traffic_send_ping.
+ *       A session sends on an ICMP datagram socket, which needs no
+ *       privilege (net.ipv4.ping_group_range) and only sees its own
+ *       replies, or on a raw socket when datagram ones are not allowed.
+ *       Sends are paced by a timerfd armed on an absolute schedule, so a
+ *       late wakeup does not shift the ones after it. One thread polls the
+ *       timers and sockets of all sessions. Stop takes the counters and
+ *       the round trip histogram as they are, nothing is waited for.
+ */
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_tg.h"
+#include "wfa_cmds.h"
+#include "wfa_rsp.h"
+#include "wfa_nl.h"
+#include "wfa_ping.h"
+
+extern unsigned short wfa_defined_debug;
+
+static pthread_mutex_t pingMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t pingThr;
+static int pingStarted = 0;
+static int pingWakeFd = -1;
+static wfaPingSess_t pingSess[WFA_PING_MAX_SESSIONS];
+
+static void wfaPingWake(void)
+{
+    uint64_t one = 1;
+
+    if(pingWakeFd != -1 && write(pingWakeFd, &one, sizeof(one)) < 0)
+        DPRINT_WARNING(WFA_WNG, "ping wake failed: %i\n", errno);
+}
+
+static unsigned short wfaPingCksum(BYTE *data, int len)
+{
+    unsigned int sum = 0;
+    int i;
+
+    for(i = 0; i + 1 < len; i += 2)
+        sum += (data[i] << 8) | data[i + 1];
+    if(len & 1)
+        sum += data[len - 1] << 8;
+
+    while(sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+
+    return htons((unsigned short)~sum);
+}
+
+/*
+ * wfaPingSend(): one echo request of a session, its send time is kept
+ *                by sequence number
+ * return:  0, or the errno of a failed send
+ */
+static int wfaPingSend(wfaPingSess_t *sess)
+{
+    BYTE pingTxBuf[sizeof(struct icmphdr) + WFA_PING_MAX_PAYLOAD];
+    wfaPingSent_t *slot;
+    int len = sess->payload;
+    unsigned short seq = ++sess->seq;
+
+    if(sess->family == AF_INET)
+    {
+        struct icmphdr *icmp = (struct icmphdr *)pingTxBuf;
+
+        icmp->type = ICMP_ECHO;
+        icmp->code = 0;
+        icmp->checksum = 0;
+        icmp->un.echo.id = htons(sess->ident);
+        icmp->un.echo.sequence = htons(seq);
+        len += sizeof(struct icmphdr);
+        /* the kernel redoes it on a datagram socket, a raw one needs it */
+        icmp->checksum = wfaPingCksum(pingTxBuf, len);
+    }
+    else
+    {
+        struct icmp6_hdr *icmp6 = (struct icmp6_hdr *)pingTxBuf;
+
+        /* the checksum covers the IPv6 pseudo header, the kernel does it */
+        icmp6->icmp6_type = ICMP6_ECHO_REQUEST;
+        icmp6->icmp6_code = 0;
+        icmp6->icmp6_cksum = 0;
+        icmp6->icmp6_id = htons(sess->ident);
+        icmp6->icmp6_seq = htons(seq);
+        len += sizeof(struct icmp6_hdr);
+    }
+    wMEMSET(pingTxBuf + len - sess->payload, 0, sess->payload);
+
+    slot = &sess->ring[seq % WFA_PING_SEQ_RING];
+    slot->seq = seq;
+    slot->pending = 1;
+    clock_gettime(CLOCK_MONOTONIC, &slot->at);
+
+    sess->sent++;
+    if(sendto(sess->fd, pingTxBuf, len, 0, (struct sockaddr *)&sess->dst, sess->dstLen) < 0)
+    {
+        /* counted as sent and lost, as ping does */
+        slot->pending = 0;
+        DPRINT_WARNING(WFA_WNG, "ping %i send failed: %i\n", sess->id, errno);
+        return errno;
+    }
+
+    return 0;
+}
+
+/*
+ * wfaPingRecv(): take the replies waiting on a session's socket
+ * return:  0, or the error the socket reported (an ICMP unreachable)
+ */
+static int wfaPingRecv(wfaPingSess_t *sess)
+{
+    BYTE pingRxBuf[WFA_BUFF_4K + 64];
+    wfaPingSent_t *slot;
+    struct timespec now;
+    BYTE *icmp;
+    int n, hlen;
+    unsigned short id, seq;
+    long long rttUs;
+
+    for(;;)
+    {
+        n = recv(sess->fd, pingRxBuf, sizeof(pingRxBuf), MSG_DONTWAIT);
+        if(n < 0)
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : errno;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        icmp = pingRxBuf;
+
+        if(sess->family == AF_INET)
+        {
+            /* a raw IPv4 socket gets the IP header too */
+            if(sess->raw)
+            {
+                hlen = ((struct iphdr *)pingRxBuf)->ihl * 4;
+                if(n < hlen)
+                    continue;
+                icmp += hlen;
+                n -= hlen;
+            }
+
+            if(n < (int)sizeof(struct icmphdr) || ((struct icmphdr *)icmp)->type != ICMP_ECHOREPLY)
+                continue;
+
+            id = ntohs(((struct icmphdr *)icmp)->un.echo.id);
+            seq = ntohs(((struct icmphdr *)icmp)->un.echo.sequence);
+        }
+        else
+        {
+            if(n < (int)sizeof(struct icmp6_hdr) || ((struct icmp6_hdr *)icmp)->icmp6_type != ICMP6_ECHO_REPLY)
+                continue;
+
+            id = ntohs(((struct icmp6_hdr *)icmp)->icmp6_id);
+            seq = ntohs(((struct icmp6_hdr *)icmp)->icmp6_seq);
+        }
+
+        /* a datagram socket only gets its own, the kernel picked the id */
+        if(sess->raw && id != sess->ident)
+            continue;
+
+        slot = &sess->ring[seq % WFA_PING_SEQ_RING];
+        if(!slot->pending || slot->seq != seq)
+            continue;              /* a duplicate, or too late to time */
+
+        slot->pending = 0;
+        sess->replied++;
+
+        rttUs = (now.tv_sec - slot->at.tv_sec) * 1000000LL + (now.tv_nsec - slot->at.tv_nsec) / 1000;
+        wfaLatHistAdd(&sess->rtt, rttUs < 0 ? 0 : (unsigned int)rttUs);
+    }
+}
+
+/*
+ * wfaPingTick(): the timer of a session expired, once or more if the
+ *                engine was late. A few sends catch up, the rest are
+ *                skipped rather than sent in a burst.
+ */
+static void wfaPingTick(wfaPingSess_t *sess)
+{
+    struct itimerspec off;
+    uint64_t expired = 0;
+    int i;
+
+    if(read(sess->tfd, &expired, sizeof(expired)) != sizeof(expired))
+        return;
+
+    if(expired > WFA_PING_MAX_BURST)
+        expired = WFA_PING_MAX_BURST;
+
+    for(i = 0; i < (int)expired && sess->sent < sess->total; i++)
+        wfaPingSend(sess);
+
+    if(sess->sent >= sess->total)
+    {
+        /* all sent, the socket stays for the last replies */
+        wMEMSET(&off, 0, sizeof(off));
+        timerfd_settime(sess->tfd, 0, &off, NULL);
+    }
+}
+
+static void *wfaPingThread(void *arg)
+{
+    struct pollfd fds[1 + 2 * WFA_PING_MAX_SESSIONS];
+    int ids[1 + 2 * WFA_PING_MAX_SESSIONS];
+    wfaPingSess_t *sess;
+    uint64_t cnt;
+    int i, j, n;
+
+    for(;;)
+    {
+        fds[0].fd = pingWakeFd;
+        fds[0].events = POLLIN;
+        n = 1;
+
+        wPT_MUTEX_LOCK(&pingMutex);
+        for(i = 0; i < WFA_PING_MAX_SESSIONS; i++)
+        {
+            if(pingSess[i].id == 0)
+                continue;
+
+            fds[n].fd = pingSess[i].tfd;
+            fds[n].events = POLLIN;
+            ids[n++] = i;
+            fds[n].fd = pingSess[i].fd;
+            fds[n].events = POLLIN;
+            ids[n++] = i;
+        }
+        wPT_MUTEX_UNLOCK(&pingMutex);
+
+        if(poll(fds, n, -1) < 0)
+        {
+            if(errno != EINTR)
+            {
+                DPRINT_ERR(WFA_ERR, "ping poll failed: %i\n", errno);
+            }
+            continue;
+        }
+
+        if(fds[0].revents & POLLIN)
+        {
+            if(read(pingWakeFd, &cnt, sizeof(cnt)) < 0)
+                DPRINT_WARNING(WFA_WNG, "ping wake read failed: %i\n", errno);
+        }
+
+        wPT_MUTEX_LOCK(&pingMutex);
+        for(j = 1; j < n; j++)
+        {
+            if(!(fds[j].revents & POLLIN))
+                continue;
+
+            /* the session may have been stopped while polling */
+            sess = &pingSess[ids[j]];
+            if(sess->id == 0)
+                continue;
+
+            if(fds[j].fd == sess->tfd)
+                wfaPingTick(sess);
+            else if(fds[j].fd == sess->fd)
+                wfaPingRecv(sess);
+        }
+        wPT_MUTEX_UNLOCK(&pingMutex);
+    }
+
+    return NULL;
+}
+
+/*
+ * wfaPingSock(): an ICMP datagram socket, or a raw one if those are not
+ *                permitted to this user
+ */
+static int wfaPingSock(int family, int *raw)
+{
+    int proto = (family == AF_INET) ? IPPROTO_ICMP : IPPROTO_ICMPV6;
+    int fd;
+
+    *raw = 0;
+    fd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, proto);
+    if(fd >= 0)
+        return fd;
+
+    fd = socket(family, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, proto);
+    if(fd >= 0)
+    {
+        *raw = 1;
+        return fd;
+    }
+
+    DPRINT_ERR(WFA_ERR, "no ICMP socket allowed: %i\n", errno);
+    return -1;
+}
+
+/*
+ * wfaPingAddr(): the destination of a session, IPv4 or IPv6 by its form
+ * return:  WFA_SUCCESS, or WFA_FAILURE if it is not an address
+ */
+static int wfaPingAddr(wfaPingSess_t *sess, char *dipaddr)
+{
+    struct sockaddr_in *dst4 = (struct sockaddr_in *)&sess->dst;
+    struct sockaddr_in6 *dst6 = (struct sockaddr_in6 *)&sess->dst;
+
+    if(inet_pton(AF_INET, dipaddr, &dst4->sin_addr) == 1)
+    {
+        sess->family = dst4->sin_family = AF_INET;
+        sess->dstLen = sizeof(struct sockaddr_in);
+        return WFA_SUCCESS;
+    }
+
+    if(inet_pton(AF_INET6, dipaddr, &dst6->sin6_addr) == 1)
+    {
+        sess->family = dst6->sin6_family = AF_INET6;
+        sess->dstLen = sizeof(struct sockaddr_in6);
+        return WFA_SUCCESS;
+    }
+
+    DPRINT_ERR(WFA_ERR, "ping to a bad address %s\n", dipaddr);
+    return WFA_FAILURE;
+}
+
+static void wfaPingClose(wfaPingSess_t *sess)
+{
+    if(sess->fd != -1)
+        close(sess->fd);
+    if(sess->tfd != -1)
+        close(sess->tfd);
+
+    sess->fd = sess->tfd = -1;
+    sess->id = 0;
+}
+
+/*
+ * wfaPingStart(): start sending echo requests to staPing->dipaddr,
+ *                 duration * frameRate of them at frameRate per second.
+ * return:  WFA_SUCCESS, or WFA_FAILURE if the session could not be set up
+ */
+int wfaPingStart(int streamid, tgPingStart_t *staPing)
+{
+    wfaPingSess_t *sess = NULL;
+    struct itimerspec its;
+    long long intervalNs;
+    int i, tos, on = 1;
+
+    if(staPing->frameRate <= 0 || staPing->duration <= 0)
+        return WFA_FAILURE;
+
+    intervalNs = (long long)(1000000000.0 / staPing->frameRate);
+    if(intervalNs < WFA_PING_MIN_INTERVAL_NS)
+        intervalNs = WFA_PING_MIN_INTERVAL_NS;
+
+    wPT_MUTEX_LOCK(&pingMutex);
+
+    if(!pingStarted)
+    {
+        pingWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(pingWakeFd < 0 || wPT_CREATE(&pingThr, NULL, wfaPingThread, NULL) != 0)
+        {
+            DPRINT_ERR(WFA_ERR, "Failed to start the ping engine\n");
+            if(pingWakeFd >= 0)
+                close(pingWakeFd);
+            pingWakeFd = -1;
+            wPT_MUTEX_UNLOCK(&pingMutex);
+            return WFA_FAILURE;
+        }
+        pthread_detach(pingThr);
+        pingStarted = 1;
+    }
+
+    for(i = 0; i < WFA_PING_MAX_SESSIONS; i++)
+    {
+        if(pingSess[i].id == 0)
+        {
+            sess = &pingSess[i];
+            break;
+        }
+    }
+
+    if(sess == NULL)
+    {
+        wPT_MUTEX_UNLOCK(&pingMutex);
+        DPRINT_ERR(WFA_ERR, "too many pings running\n");
+        return WFA_FAILURE;
+    }
+
+    wMEMSET(sess, 0, sizeof(wfaPingSess_t));
+    sess->fd = sess->tfd = -1;
+
+    if(wfaPingAddr(sess, staPing->dipaddr) != WFA_SUCCESS)
+    {
+        wPT_MUTEX_UNLOCK(&pingMutex);
+        return WFA_FAILURE;
+    }
+
+    if((sess->fd = wfaPingSock(sess->family, &sess->raw)) < 0)
+        goto fail;
+
+    if(staPing->dscp >= 0 && (tos = convertDscpToTos(staPing->dscp)) > 0)
+    {
+        if(sess->family == AF_INET)
+            setsockopt(sess->fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+        else
+            setsockopt(sess->fd, IPPROTO_IPV6, IPV6_TCLASS, &tos, sizeof(tos));
+    }
+
+    /* a subnet broadcast is pinged the way "ping -b" does */
+    if(sess->family == AF_INET)
+        setsockopt(sess->fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+
+    sess->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(sess->tfd < 0)
+        goto fail;
+
+    sess->id = streamid;
+    sess->ident = (unsigned short)((getpid() << 8) ^ streamid);
+    sess->payload = staPing->frameSize;
+    if(sess->payload < 0)
+        sess->payload = 0;
+    if(sess->payload > WFA_PING_MAX_PAYLOAD)
+        sess->payload = WFA_PING_MAX_PAYLOAD;
+    sess->total = (unsigned int)(staPing->duration * staPing->frameRate);
+    if(sess->total == 0)
+        sess->total = 1;
+    wfaLatHistReset(&sess->rtt);
+
+    /* first send now, then on the grid from it */
+    clock_gettime(CLOCK_MONOTONIC, &its.it_value);
+    its.it_interval.tv_sec = intervalNs / 1000000000LL;
+    its.it_interval.tv_nsec = intervalNs % 1000000000LL;
+    if(timerfd_settime(sess->tfd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+        goto fail;
+
+    wPT_MUTEX_UNLOCK(&pingMutex);
+    wfaPingWake();
+
+    DPRINT_INFO(WFA_OUT, "ping %i to %s, %u requests every %lli usec%s\n", streamid,
+                staPing->dipaddr, sess->total, intervalNs / 1000, sess->raw ? " (raw)" : "");
+
+    return WFA_SUCCESS;
+
+fail:
+    DPRINT_ERR(WFA_ERR, "ping %i setup failed: %i\n", streamid, errno);
+    wfaPingClose(sess);
+    wPT_MUTEX_UNLOCK(&pingMutex);
+    return WFA_FAILURE;
+}
+
+/*
+ * wfaPingStop(): end a ping session and take what it counted
+ * return:  WFA_SUCCESS, or WFA_FAILURE if there is no such session
+ */
+int wfaPingStop(int streamid, tgPingStopResp_t *stpResp)
+{
+    wfaPingSess_t *sess;
+    tgStats_t stats;
+    int i;
+
+    wMEMSET(stpResp, 0, sizeof(tgPingStopResp_t));
+
+    wPT_MUTEX_LOCK(&pingMutex);
+    for(i = 0; i < WFA_PING_MAX_SESSIONS; i++)
+    {
+        sess = &pingSess[i];
+        if(sess->id != streamid || streamid == 0)
+            continue;
+
+        stpResp->sendCnt = sess->sent;
+        stpResp->repliedCnt = sess->replied;
+
+        wfaLatHistSummary(&sess->rtt, &stats);
+        stpResp->rttMin = stats.rttMin;
+        stpResp->rttAvg = stats.rttAvg;
+        stpResp->rttP50 = stats.rttP50;
+        stpResp->rttP95 = stats.rttP95;
+        stpResp->rttP99 = stats.rttP99;
+        stpResp->rttMax = stats.rttMax;
+
+        wfaPingClose(sess);
+        wPT_MUTEX_UNLOCK(&pingMutex);
+        wfaPingWake();
+
+        DPRINT_INFO(WFA_OUT, "ping %i sent %i replies %i rtt usec min %u avg %u p99 %u max %u\n",
+                    streamid, stpResp->sendCnt, stpResp->repliedCnt, stpResp->rttMin,
+                    stpResp->rttAvg, stpResp->rttP99, stpResp->rttMax);
+        return WFA_SUCCESS;
+    }
+    wPT_MUTEX_UNLOCK(&pingMutex);
+
+    return WFA_FAILURE;
+}
+
+/*
+ * wfaPingStopAll(): a traffic agent reset ends every session
+ */
+void wfaPingStopAll(void)
+{
+    int i;
+
+    wPT_MUTEX_LOCK(&pingMutex);
+    for(i = 0; i < WFA_PING_MAX_SESSIONS; i++)
+    {
+        if(pingSess[i].id != 0)
+            wfaPingClose(&pingSess[i]);
+    }
+    wPT_MUTEX_UNLOCK(&pingMutex);
+
+    wfaPingWake();
+}
+
+/* an error that settles a probe: the host or its network is unreachable */
+static int wfaPingUnreach(int err)
+{
+    return (err == EHOSTUNREACH || err == ENETUNREACH) ? -1 : 0;
+}
+
+/*
+ * wfaPingProbeUdp(): one UDP echo probe on a connected socket, and what
+ *                    came back of the earlier ones
+ * return:  1 up, 0 unknown yet, -1 the kernel found the host unreachable
+ */
+static int wfaPingProbeUdp(int fd, int sendNow)
+{
+    char buf[WFA_BUFF_64];
+
+    if(sendNow)
+    {
+        wMEMSET(buf, 0, sizeof(buf));
+        if(send(fd, buf, sizeof(buf), 0) < 0 && errno != ECONNREFUSED)
+            return wfaPingUnreach(errno);
+    }
+
+    if(recv(fd, buf, sizeof(buf), MSG_DONTWAIT) >= 0)
+        return 1;
+
+    /* a port unreachable comes from the host itself */
+    if(errno == ECONNREFUSED)
+        return 1;
+
+    return wfaPingUnreach(errno);
+}
+
+/*
+ * wfaPingProbe(): is dipaddr up? A probe goes out every
+ *                 WFA_PING_PROBE_MS and the first answer ends it, an
+ *                 unreachable from the kernel too. ICMP echo when an ICMP
+ *                 socket is allowed, else (or udpOnly) UDP echo, where an
+ *                 on-link IPv4 host that resolved its ARP counts as up.
+ * return:  1 if the host answered within timeoutMs, 0 if not
+ */
+int wfaPingProbe(char *dipaddr, int timeoutMs, int udpOnly)
+{
+    wfaPingSess_t sess;
+    struct sockaddr_in *dst4 = (struct sockaddr_in *)&sess.dst;
+    struct sockaddr_in6 *dst6 = (struct sockaddr_in6 *)&sess.dst;
+    struct pollfd pfd;
+    struct timespec now;
+    long long startMs, nowMs, nextMs, waitMs;
+    int state = 0, useUdp = udpOnly;
+
+    wMEMSET(&sess, 0, sizeof(sess));
+    sess.fd = sess.tfd = -1;
+    if(wfaPingAddr(&sess, dipaddr) != WFA_SUCCESS)
+        return 0;
+
+    if(!useUdp && (sess.fd = wfaPingSock(sess.family, &sess.raw)) < 0)
+        useUdp = 1;
+
+    if(useUdp)
+    {
+        if(sess.family == AF_INET)
+            dst4->sin_port = htons(WFA_UDP_ECHO_PORT);
+        else
+            dst6->sin6_port = htons(WFA_UDP_ECHO_PORT);
+        sess.fd = socket(sess.family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(sess.fd < 0 || connect(sess.fd, (struct sockaddr *)&sess.dst, sess.dstLen) < 0)
+        {
+            DPRINT_ERR(WFA_ERR, "udp probe to %s failed: %i\n", dipaddr, errno);
+            wfaPingClose(&sess);
+            return 0;
+        }
+    }
+
+    sess.id = -1;
+    sess.ident = (unsigned short)(getpid() ^ (long)pthread_self());
+    sess.payload = WFA_PING_PROBE_SIZE;
+    sess.total = (unsigned int)-1;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    startMs = nextMs = now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+    nowMs = startMs;
+
+    while(state == 0 && nowMs - startMs < timeoutMs)
+    {
+        if(nowMs >= nextMs)
+        {
+            if(useUdp)
+            {
+                state = wfaPingProbeUdp(sess.fd, 1);
+                if(state == 0 && sess.family == AF_INET && wfaNlNeighReachable(&dst4->sin_addr))
+                    state = 1;
+            }
+            else
+                state = wfaPingUnreach(wfaPingSend(&sess));
+
+            nextMs += WFA_PING_PROBE_MS;
+        }
+
+        waitMs = (nextMs < startMs + timeoutMs ? nextMs : startMs + timeoutMs) - nowMs;
+        pfd.fd = sess.fd;
+        pfd.events = POLLIN;
+        if(state == 0 && poll(&pfd, 1, waitMs < 0 ? 0 : (int)waitMs) > 0)
+        {
+            if(useUdp)
+                state = wfaPingProbeUdp(sess.fd, 0);
+            else if((state = wfaPingUnreach(wfaPingRecv(&sess))) == 0 && sess.replied > 0)
+                state = 1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        nowMs = now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+    }
+
+    DPRINT_INFO(WFA_OUT, "probe %s by %s: %s after %lli ms, %u sent\n", dipaddr,
+                useUdp ? "udp" : "icmp", state > 0 ? "up" : "down", nowMs - startMs, sess.sent);
+
+    wfaPingClose(&sess);
+    return state > 0;
+}
@@ -0,0 +1,287 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_report.c - interval statistics of the running streams.
+ *       traffic_agent_status sets a report period. A reporter thread then
+ *       sends a WFA_TRAFFIC_AGENT_REPORT_RESP_TLV every period, request id
+ *       0, with what each active stream did since the previous report. The
+ *       stream threads never wait for it, their counters are copied under
+ *       the stream's stats sequence.
+ */
+#include <sys/time.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_tlv.h"
+#include "wfa_tg.h"
+#include "wfa_rsp.h"
+#include "wfa_sock.h"
+#include "wfa_miscs.h"
+#include "wfa_exec.h"
+
+extern unsigned short wfa_defined_debug;
+extern tgStream_t gStreams[];
+extern int gxcSockfd;
+extern wTHREAD_LOCAL dutCmdResponse_t gGenericResp;
+
+/* copies tried before a stream is left out of one report */
+#define WFA_STATS_SNAPSHOT_TRIES   8
+
+/* what a stream had at the previous report */
+typedef struct _tg_report_prev
+{
+    int id;
+    tgStats_t stats;
+    tgLatHist_t rtt;
+} tgReportPrev_t;
+
+static pthread_mutex_t reportMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reportCond = PTHREAD_COND_INITIALIZER;
+static pthread_t reportThr;
+static int reportStarted = 0;
+static int reportPeriodMs = 0;
+
+/* used by the reporter thread only */
+static tgReportPrev_t reportPrev[WFA_MAX_TRAFFIC_STREAMS];
+static tgReport_t reportBuf;
+static BYTE reportTlv[WFA_TLV_HDR_LEN + sizeof(tgReport_t)];
+
+/*
+ * wfaTGStatsSnapshot(): a consistent copy of the stats and the latency
+ *                       histogram of a stream that may be running.
+ *  input:   rtt -- NULL if the histogram is not wanted
+ *  return:  WFA_SUCCESS, or WFA_FAILURE if the stream kept changing
+ */
+int wfaTGStatsSnapshot(tgStream_t *myStream, tgStats_t *stats, tgLatHist_t *rtt)
+{
+    unsigned int seq;
+    int i;
+
+    for(i = 0; i < WFA_STATS_SNAPSHOT_TRIES; i++)
+    {
+        seq = myStream->statsSeq;
+        wMEMORY_BARRIER();
+        if(seq & 1)
+            continue;
+
+        wMEMCPY(stats, &myStream->stats, sizeof(tgStats_t));
+        if(rtt != NULL)
+            wMEMCPY(rtt, &myStream->transc.rtt, sizeof(tgLatHist_t));
+
+        wMEMORY_BARRIER();
+        if(myStream->statsSeq == seq)
+            return WFA_SUCCESS;
+    }
+
+    return WFA_FAILURE;
+}
+
+/*
+ * wfaReportStream(): the interval stats of one stream, from its current
+ *                    counters and those of the previous report
+ */
+static void wfaReportStream(tgReportPrev_t *prev, tgStats_t *cur, tgLatHist_t *rtt,
+                            tgIntervalStats_t *ist)
+{
+    static tgLatHist_t delta;
+    int i;
+
+    ist->txFrames = cur->txFrames - prev->stats.txFrames;
+    ist->rxFrames = cur->rxFrames - prev->stats.rxFrames;
+    ist->txBytes = (unsigned int)(cur->txPayloadBytes - prev->stats.txPayloadBytes);
+    ist->rxBytes = (unsigned int)(cur->rxPayloadBytes - prev->stats.rxPayloadBytes);
+
+    /* a late frame takes back a loss, a report never goes negative */
+    if(cur->lostPkts > prev->stats.lostPkts)
+        ist->lostPkts = cur->lostPkts - prev->stats.lostPkts;
+    else
+        ist->lostPkts = 0;
+
+    ist->jitter = (unsigned int)cur->jitter;
+
+    /* the percentiles of the frames added since the previous report */
+    wMEMSET(&delta, 0, sizeof(delta));
+    delta.count = rtt->count - prev->rtt.count;
+    delta.maxUs = rtt->maxUs;
+    for(i = 0; i < WFA_LAT_BUCKETS; i++)
+        delta.bucket[i] = rtt->bucket[i] - prev->rtt.bucket[i];
+
+    ist->latP50 = wfaLatHistPercentile(&delta, 50);
+    ist->latP99 = wfaLatHistPercentile(&delta, 99);
+
+    wMEMCPY(&prev->stats, cur, sizeof(tgStats_t));
+    wMEMCPY(&prev->rtt, rtt, sizeof(tgLatHist_t));
+}
+
+/*
+ * wfaReportSend(): one report of the active streams. Nothing is sent
+ *                  while no stream runs.
+ */
+static void wfaReportSend(int intervalMs)
+{
+    static tgStats_t stats;
+    static tgLatHist_t rtt;
+    tgStream_t *myStream;
+    tgReportPrev_t *prev;
+    int i, len;
+
+    wMEMSET(&reportBuf, 0, sizeof(reportBuf));
+    reportBuf.intervalMs = intervalMs;
+
+    for(i = 0; i < WFA_MAX_TRAFFIC_STREAMS && reportBuf.numStreams < WFA_TG_MAX_REPORT; i++)
+    {
+        myStream = &gStreams[i];
+        prev = &reportPrev[i];
+
+        if(myStream->id == 0 ||
+                (myStream->state != WFA_STREAM_ACTIVE && !myStream->transc.running))
+            continue;
+
+        if(wfaTGStatsSnapshot(myStream, &stats, &rtt) != WFA_SUCCESS)
+            continue;
+
+        /* a new stream in the slot starts from zero */
+        if(prev->id != myStream->id)
+        {
+            wMEMSET(prev, 0, sizeof(tgReportPrev_t));
+            prev->id = myStream->id;
+        }
+
+        reportBuf.streams[reportBuf.numStreams].streamId = myStream->id;
+        wfaReportStream(prev, &stats, &rtt, &reportBuf.streams[reportBuf.numStreams]);
+        reportBuf.numStreams++;
+    }
+
+    if(reportBuf.numStreams == 0 || gxcSockfd == -1)
+        return;
+
+    len = sizeof(reportBuf) - (WFA_TG_MAX_REPORT - reportBuf.numStreams) * sizeof(tgIntervalStats_t);
+    wfaEncodeTLV(WFA_TRAFFIC_AGENT_REPORT_RESP_TLV, len, (BYTE *)&reportBuf, reportTlv);
+    /* a report is only good for now, it is not kept for the next link */
+    wfaExecSendResp(0, 0, reportTlv, WFA_TLV_HDR_LEN + len);
+}
+
+/*
+ * wfaReportThread(): wait out the period, report, and again. A new period
+ *                    takes effect at once.
+ */
+static void *wfaReportThread(void *arg)
+{
+    struct timespec due;
+    struct timeval last, now;
+    int period, ret;
+
+    wGETTIMEOFDAY(&last, NULL);
+
+    wPT_MUTEX_LOCK(&reportMutex);
+    for(;;)
+    {
+        period = reportPeriodMs;
+        if(period == 0)
+        {
+            wPT_COND_WAIT(&reportCond, &reportMutex);
+            wGETTIMEOFDAY(&last, NULL);
+            continue;
+        }
+
+        due.tv_sec = last.tv_sec + period / 1000;
+        due.tv_nsec = (last.tv_usec + (period % 1000) * 1000) * 1000L;
+        if(due.tv_nsec >= 1000000000L)
+        {
+            due.tv_sec++;
+            due.tv_nsec -= 1000000000L;
+        }
+
+        ret = pthread_cond_timedwait(&reportCond, &reportMutex, &due);
+        if(ret != ETIMEDOUT)
+        {
+            /* the period changed, start it over from now */
+            if(reportPeriodMs != period)
+                wGETTIMEOFDAY(&last, NULL);
+            continue;
+        }
+
+        wPT_MUTEX_UNLOCK(&reportMutex);
+
+        wGETTIMEOFDAY(&now, NULL);
+        wfaReportSend(wfa_itime_diff(&last, &now) / 1000);
+        last = now;
+
+        wPT_MUTEX_LOCK(&reportMutex);
+    }
+
+    return NULL;
+}
+
+/*
+ * wfaTGStatus(): subscribe to the interval reports of the running
+ *                streams, or stop them with a period of 0.
+ * input:    parms -- tgStatusReq_t
+ * response: status of the request, the reports follow on their own
+ * return:   success or fail
+ */
+int wfaTGStatus(int len, BYTE *parms, int *respLen, BYTE *respBuf)
+{
+    tgStatusReq_t *req = (tgStatusReq_t *)parms;
+    dutCmdResponse_t *statusResp = &gGenericResp;
+    int period;
+
+    statusResp->status = STATUS_INVALID;
+
+    if(len == sizeof(tgStatusReq_t) && req->periodMs >= 0)
+    {
+        period = req->periodMs;
+        if(period != 0 && period < WFA_TG_REPORT_MIN_MS)
+            period = WFA_TG_REPORT_MIN_MS;
+
+        wPT_MUTEX_LOCK(&reportMutex);
+        if(!reportStarted && period != 0)
+        {
+            if(wPT_CREATE(&reportThr, NULL, wfaReportThread, NULL) == 0)
+            {
+                pthread_detach(reportThr);
+                reportStarted = 1;
+            }
+            else
+            {
+                DPRINT_ERR(WFA_ERR, "Failed to create the report thread\n");
+            }
+        }
+
+        if(reportStarted || period == 0)
+        {
+            reportPeriodMs = period;
+            wPT_COND_SIGNAL(&reportCond);
+            statusResp->status = STATUS_COMPLETE;
+        }
+        wPT_MUTEX_UNLOCK(&reportMutex);
+
+        DPRINT_INFO(WFA_OUT, "interval reports every %i ms\n", period);
+    }
+
+    *respLen = wfaEncodeResp(WFA_TRAFFIC_AGENT_STATUS_RESP_TLV, statusResp, sizeof(dutCmdResponse_t), respBuf);
+
+    return WFA_SUCCESS;
+}
@@ -33,6 +33,8 @@
 #include <sched.h>
 #endif
 
+#include <netinet/tcp.h>
+
 #include "wfa_portall.h"
 #include "wfa_stdincs.h"
 #include "wfa_debug.h"
@@ -170,14 +172,48 @@ int wfaAcceptTCPConn(int servSock)
     if ((clntSock = wACCEPT(servSock, (struct sockaddr *) &clntAddr,
                             &clntLen)) < 0)
     {
-        DPRINT_ERR(WFA_ERR, "accept() failed");
-        exit(1);
+        /* a peer that gave up before the accept, wait for the next one */
+        DPRINT_ERR(WFA_ERR, "accept() failed: %i\n", errno);
+        return -1;
     }
 
     /* clntSock is connected to a client! */
     return clntSock;
 }
 
+/*
+ * wfaCtrlSockTune(): notice a dead control link in seconds, not hours.
+ *                    Keepalive probes find a silent peer, the user timeout
+ *                    gives up on data the peer does not acknowledge.
+ */
+int wfaCtrlSockTune(int sock)
+{
+    int on = 1;
+    int idle = WFA_CTRL_KEEPIDLE, intvl = WFA_CTRL_KEEPINTVL, cnt = WFA_CTRL_KEEPCNT;
+
+    if(wSETSOCKOPT(sock, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on)) < 0 ||
+            wSETSOCKOPT(sock, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle)) < 0 ||
+            wSETSOCKOPT(sock, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl)) < 0 ||
+            wSETSOCKOPT(sock, IPPROTO_TCP, TCP_KEEPCNT, &cnt, sizeof(cnt)) < 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "control link keepalive not set: %i\n", errno);
+        return WFA_FAILURE;
+    }
+
+#ifdef TCP_USER_TIMEOUT
+    {
+        unsigned int tmout = WFA_CTRL_USER_TMOUT;
+
+        wSETSOCKOPT(sock, IPPROTO_TCP, TCP_USER_TIMEOUT, &tmout, sizeof(tmout));
+    }
+#endif
+
+    /* commands and responses are small and waited for */
+    wSETSOCKOPT(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    return WFA_SUCCESS;
+}
+
 struct timeval *wfaSetTimer(int secs, int usecs, struct timeval *tv)
 {
     struct timeval *mytv;
@@ -226,15 +262,6 @@ void wfaSetSockFiDesc(fd_set *fdset, int *maxfdn1, struct sockfds *fds)
         *maxfdn1 = max(*maxfdn1-1, *fds->cafd) + 1;
     }
 
-#ifdef WFA_WMM_PS_EXT
-    /* if the power save socket port valid */
-    if(*fds->psfd != -1)
-    {
-        FD_SET(*fds->psfd, fdset);
-        *maxfdn1 = max(*maxfdn1-1, *fds->psfd) + 1;
-    }
-#endif
-
     /* if any of wmm traffic stream socket fd valid */
     for(i = 0; i < WFA_MAX_TRAFFIC_STREAMS; i++)
     {
@@ -248,6 +275,32 @@ void wfaSetSockFiDesc(fd_set *fdset, int *maxfdn1, struct sockfds *fds)
     return;
 }
 
+/*
+ * wfaCtrlSendAll(): write the whole buffer, the caller holds the send lock.
+ */
+static pthread_mutex_t ctrlSendMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int wfaCtrlSendAll(int sock, unsigned char *buf, int bufLen)
+{
+    int bytesSent = 0, ret;
+
+    while(bytesSent < bufLen)
+    {
+        ret = wSEND(sock, buf + bytesSent, bufLen - bytesSent, MSG_NOSIGNAL);
+        if(ret == -1)
+        {
+            if(errno == EINTR)
+                continue;
+
+            DPRINT_WARNING(WFA_WNG, "Error sending tcp packet\n");
+            return -1;
+        }
+        bytesSent += ret;
+    }
+
+    return bytesSent;
+}
+
 /*
  * wfaCtrlSend(): Send control message/response through
  *                control link.
@@ -255,35 +308,180 @@ void wfaSetSockFiDesc(fd_set *fdset, int *maxfdn1, struct sockfds *fds)
  */
 int wfaCtrlSend(int sock, unsigned char *buf, int bufLen)
 {
-    int bytesSent = 0;
+    int bytesSent;
 
     if(bufLen == 0)
         return WFA_FAILURE;
 
-    bytesSent = wSEND(sock, buf, bufLen, 0);
+    /*
+     * responses may come from several command threads, keep each
+     * message whole on the link
+     */
+    wPT_MUTEX_LOCK(&ctrlSendMutex);
+    bytesSent = wfaCtrlSendAll(sock, buf, bufLen);
+    wPT_MUTEX_UNLOCK(&ctrlSendMutex);
+
+    return bytesSent;
+}
 
-    if(bytesSent == -1)
+/*
+ * wfaCtrlSendFrame(): Send one TLV as a frame on the control link
+ *                     between control agent and DUT agent.
+ *  input:   reqId -- request id, a response carries the one of its command
+ *  return:  bufLen on success, -1 on a link error
+ */
+int wfaCtrlSendFrame(int sock, unsigned short reqId, unsigned char *buf, int bufLen)
+{
+    wfaCtrlHdr_t hdr;
+    unsigned char hdrBuf[WFA_CTRL_HDR_LEN];
+    int ret = -1;
+
+    if(bufLen <= 0 || bufLen > WFA_CTRL_MAX_TLV)
     {
-        DPRINT_WARNING(WFA_WNG, "Error sending tcp packet\n");
+        DPRINT_WARNING(WFA_WNG, "wfaCtrlSendFrame: bad length %i\n", bufLen);
+        return -1;
     }
 
-    return bytesSent;
+    hdr.reqId = htons(reqId);
+    hdr.flags = 0;
+    hdr.len = htonl(bufLen);
+    wMEMCPY(hdrBuf, &hdr, WFA_CTRL_HDR_LEN);
+
+    wPT_MUTEX_LOCK(&ctrlSendMutex);
+    if(wfaCtrlSendAll(sock, hdrBuf, WFA_CTRL_HDR_LEN) == WFA_CTRL_HDR_LEN)
+        ret = wfaCtrlSendAll(sock, buf, bufLen);
+    wPT_MUTEX_UNLOCK(&ctrlSendMutex);
+
+    return ret;
+}
+
+void wfaCtrlLineReset(wfaCtrlLine_t *ln)
+{
+    ln->len = 0;
 }
 
 /*
- * wfaCtrlRecv(): Receive control message/response through
- *                control link.
+ * wfaCtrlRecvLine(): Receive what is pending on a command line link into
+ *                    its line buffer, without waiting for the end of the
+ *                    line. wfaCtrlNextLine() takes the lines out.
  *  Note: the function used to wfaTcpRecv().
+ *  return:  bytes received, 0 when the peer closed, -1 on error
  */
-int wfaCtrlRecv(int sock, unsigned char *buf)
+int wfaCtrlRecvLine(int sock, wfaCtrlLine_t *ln)
 {
-    int bytesRecvd = 0;
+    int bytesRecvd;
+
+    do
+    {
+        bytesRecvd = wRECV(sock, ln->buf + ln->len, WFA_CAPI_CMD_SZ - 1 - ln->len, 0);
+    } while(bytesRecvd == -1 && errno == EINTR);
 
-    bytesRecvd = wRECV(sock, buf, WFA_BUFF_1K-1, 0);
+    if(bytesRecvd > 0)
+        ln->len += bytesRecvd;
 
     return bytesRecvd;
 }
 
+/*
+ * wfaCtrlNextLine(): Take the next complete line, '\n' included, out of
+ *                    the line buffer. A line as long as the buffer is
+ *                    taken as it is, so the buffer never stays full.
+ *  input:   buf -- WFA_CAPI_CMD_SZ bytes, the line is terminated
+ *  return:  line length, 0 if no complete line is buffered yet
+ */
+int wfaCtrlNextLine(wfaCtrlLine_t *ln, unsigned char *buf)
+{
+    unsigned char *nl;
+    int len;
+
+    nl = memchr(ln->buf, '\n', ln->len);
+    if(nl != NULL)
+        len = nl - ln->buf + 1;
+    else if(ln->len >= WFA_CAPI_CMD_SZ - 1)
+        len = ln->len;
+    else
+        return 0;
+
+    wMEMCPY(buf, ln->buf, len);
+    buf[len] = '\0';
+
+    ln->len -= len;
+    wMEMMOVE(ln->buf, ln->buf + len, ln->len);
+
+    return len;
+}
+
+void wfaCtrlRxReset(wfaCtrlRx_t *rx)
+{
+    rx->head = 0;
+    rx->tail = 0;
+}
+
+/*
+ * wfaCtrlRecvFrames(): Receive what is pending on a framed control link
+ *                      into its reassembly buffer.
+ *  return:  bytes received, 0 when the peer closed, -1 on error
+ */
+int wfaCtrlRecvFrames(int sock, wfaCtrlRx_t *rx)
+{
+    int bytesRecvd;
+
+    /* move a partial frame to the front to make room */
+    if(rx->head > 0)
+    {
+        wMEMMOVE(rx->buf, rx->buf + rx->head, rx->tail - rx->head);
+        rx->tail -= rx->head;
+        rx->head = 0;
+    }
+
+    do
+    {
+        bytesRecvd = wRECV(sock, rx->buf + rx->tail, WFA_CTRL_RX_BUF_SZ - rx->tail, 0);
+    } while(bytesRecvd == -1 && errno == EINTR);
+
+    if(bytesRecvd > 0)
+        rx->tail += bytesRecvd;
+
+    return bytesRecvd;
+}
+
+/*
+ * wfaCtrlNextFrame(): Take the next complete frame out of the reassembly
+ *                     buffer.
+ *  output:  reqId -- request id of the frame
+ *           buf   -- the TLV
+ *  return:  TLV length, 0 if no complete frame is buffered yet, -1 if the
+ *           frame cannot be valid and the link has to be dropped
+ */
+int wfaCtrlNextFrame(wfaCtrlRx_t *rx, unsigned short *reqId, unsigned char *buf, int bufSize)
+{
+    wfaCtrlHdr_t hdr;
+    int len;
+
+    if(rx->tail - rx->head < WFA_CTRL_HDR_LEN)
+        return 0;
+
+    wMEMCPY(&hdr, rx->buf + rx->head, WFA_CTRL_HDR_LEN);
+    len = (int)ntohl(hdr.len);
+    if(len <= 0 || len > WFA_CTRL_MAX_TLV || len > bufSize)
+    {
+        DPRINT_WARNING(WFA_WNG, "wfaCtrlNextFrame: bad frame length %i\n", len);
+        return -1;
+    }
+
+    if(rx->tail - rx->head < WFA_CTRL_HDR_LEN + len)
+        return 0;
+
+    *reqId = ntohs(hdr.reqId);
+    wMEMCPY(buf, rx->buf + rx->head + WFA_CTRL_HDR_LEN, len);
+
+    rx->head += WFA_CTRL_HDR_LEN + len;
+    if(rx->head == rx->tail)
+        rx->head = rx->tail = 0;
+
+    return len;
+}
+
 /*
  * wfaTrafficSendTo(): Send Traffic through through traffic interface.
  *  Note: the function used to wfaUdpSendTo().
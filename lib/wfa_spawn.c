@@ -0,0 +1,719 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_spawn.c - runs the external helpers (iwconfig, iwpriv, the
+ *       vendor scripts, ...) the DUT still depends on.
+ *       The command line is split into words here and started with
+ *       posix_spawnp(), so no shell is forked in between. Stdout and
+ *       stderr come back over pipes into memory instead of temporary
+ *       files, and a helper that hangs is killed at its deadline rather
+ *       than stalling the control agent. The exit status is returned as
+ *       it is, no environment variable is needed to pass it back.
+ */
+#include <stdarg.h>
+#include <spawn.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_spawn.h"
+
+extern unsigned short wfa_defined_debug;
+extern char **environ;
+
+/*
+ * helpers let go of while still running; a thread keeps reading their
+ * pipes, so they neither block on a full one nor die of SIGPIPE, and
+ * reaps them at exit
+ */
+static wfaProc_t orphans[WFA_RUN_MAX_PROCS];
+static pthread_mutex_t orphanMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t orphanThr;
+static int orphanState;             /* 0 not started, 1 running, -1 failed */
+static int orphanWakeFd = -1;
+
+/*
+ * Split a command line in place into words on blanks. Single and double
+ * quotes group a word the way the shell would, without any expansion.
+ */
+static int wfaSpawnSplit(char *line, char **argv, int maxArgs)
+{
+    char *rd = line, *wr = line;
+    char quote;
+    int argc = 0;
+
+    while(*rd != '\0')
+    {
+        while(*rd == ' ' || *rd == '\t' || *rd == '\n')
+            rd++;
+        if(*rd == '\0')
+            break;
+
+        if(argc == maxArgs - 1)
+        {
+            DPRINT_ERR(WFA_ERR, "too many arguments in \"%s\"\n", argv[0]);
+            return WFA_FAILURE;
+        }
+
+        argv[argc++] = wr;
+        quote = '\0';
+        while(*rd != '\0')
+        {
+            if(quote != '\0')
+            {
+                if(*rd == quote)
+                    quote = '\0';
+                else
+                    *wr++ = *rd;
+            }
+            else if(*rd == '"' || *rd == '\'')
+                quote = *rd;
+            else if(*rd == ' ' || *rd == '\t' || *rd == '\n')
+                break;
+            else
+                *wr++ = *rd;
+            rd++;
+        }
+
+        /* the separator is consumed before the word is terminated */
+        if(*rd != '\0')
+            rd++;
+        *wr++ = '\0';
+    }
+
+    argv[argc] = NULL;
+    return argc;
+}
+
+/*
+ * neither end may leak into a helper started by another thread, so the
+ * flag comes with the pipe; pipe2() is not declared without _GNU_SOURCE
+ */
+static int wfaSpawnPipe(int fds[2])
+{
+    if(syscall(SYS_pipe2, fds, O_CLOEXEC) < 0)
+        return WFA_FAILURE;
+
+    return WFA_SUCCESS;
+}
+
+static void wfaSpawnClose(int *fd)
+{
+    if(*fd >= 0)
+    {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+/*
+ * Start one helper. "out" receives its stdout up to outSz - 1 bytes,
+ * stdout goes to /dev/null when out is NULL. The helper runs until
+ * wfaSpawnWait() collects it.
+ */
+int wfaSpawn(wfaProc_t *proc, char *out, int outSz, const char *fmt, ...)
+{
+    char line[WFA_BUFF_1K];
+    char *argv[WFA_RUN_MAX_ARGS];
+    int outPipe[2] = {-1, -1}, errPipe[2] = {-1, -1};
+    posix_spawn_file_actions_t acts;
+    posix_spawnattr_t attr;
+    sigset_t sigs;
+    va_list ap;
+    int ret;
+
+    wMEMSET(proc, 0, sizeof(wfaProc_t));
+    proc->pidFd = proc->outFd = proc->errFd = -1;
+    proc->status = WFA_RUN_FAILED;
+    proc->out = out;
+    proc->outSz = outSz;
+    if(out != NULL && outSz > 0)
+        out[0] = '\0';
+
+    va_start(ap, fmt);
+    ret = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if(ret < 0 || ret >= (int) sizeof(line))
+    {
+        DPRINT_ERR(WFA_ERR, "command line too long\n");
+        return WFA_FAILURE;
+    }
+
+    if(wfaSpawnSplit(line, argv, WFA_RUN_MAX_ARGS) <= 0)
+        return WFA_FAILURE;
+    wSTRNCPY(proc->name, argv[0], sizeof(proc->name) - 1);
+
+    if((out != NULL && wfaSpawnPipe(outPipe) != WFA_SUCCESS) || wfaSpawnPipe(errPipe) != WFA_SUCCESS)
+    {
+        DPRINT_ERR(WFA_ERR, "pipe for %s: %s\n", proc->name, strerror(errno));
+        wfaSpawnClose(&outPipe[0]);
+        wfaSpawnClose(&outPipe[1]);
+        return WFA_FAILURE;
+    }
+
+    posix_spawn_file_actions_init(&acts);
+    posix_spawn_file_actions_addopen(&acts, 0, "/dev/null", O_RDONLY, 0);
+    if(out != NULL)
+        posix_spawn_file_actions_adddup2(&acts, outPipe[1], 1);
+    else
+        posix_spawn_file_actions_addopen(&acts, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_adddup2(&acts, errPipe[1], 2);
+
+    /* the agent's blocked signals and ignored SIGPIPE are not inherited */
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    sigemptyset(&sigs);
+    posix_spawnattr_setsigmask(&attr, &sigs);
+    sigaddset(&sigs, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &sigs);
+
+    ret = posix_spawnp(&proc->pid, argv[0], &acts, &attr, argv, environ);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&acts);
+    wfaSpawnClose(&outPipe[1]);
+    wfaSpawnClose(&errPipe[1]);
+
+    if(ret != 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "cannot run %s: %s\n", proc->name, strerror(ret));
+        proc->pid = 0;
+        wfaSpawnClose(&outPipe[0]);
+        wfaSpawnClose(&errPipe[0]);
+        return WFA_FAILURE;
+    }
+
+    proc->outFd = outPipe[0];
+    proc->errFd = errPipe[0];
+    if(proc->outFd >= 0)
+        fcntl(proc->outFd, F_SETFL, O_NONBLOCK);
+    fcntl(proc->errFd, F_SETFL, O_NONBLOCK);
+
+#ifdef SYS_pidfd_open
+    proc->pidFd = syscall(SYS_pidfd_open, proc->pid, 0);
+#endif
+
+    DPRINT_INFO(WFA_OUT, "run %s (pid %d)\n", proc->name, (int) proc->pid);
+    return WFA_SUCCESS;
+}
+
+/*
+ * Drain whatever the helper has written so far. Output beyond the
+ * caller's buffer is read and dropped so the helper never blocks on a
+ * full pipe.
+ */
+static void wfaSpawnRead(wfaProc_t *proc, int *fd)
+{
+    char scratch[WFA_BUFF_512];
+    char *dst;
+    int room, n;
+
+    while(*fd >= 0)
+    {
+        if(*fd == proc->outFd && proc->outLen < proc->outSz - 1)
+        {
+            dst = proc->out + proc->outLen;
+            room = proc->outSz - 1 - proc->outLen;
+        }
+        else if(*fd == proc->errFd && proc->errLen < WFA_RUN_ERR_SZ - 1)
+        {
+            dst = proc->err + proc->errLen;
+            room = WFA_RUN_ERR_SZ - 1 - proc->errLen;
+        }
+        else
+        {
+            dst = scratch;
+            room = sizeof(scratch);
+        }
+
+        n = read(*fd, dst, room);
+        if(n > 0)
+        {
+            if(dst == scratch)
+                continue;
+            if(*fd == proc->outFd)
+            {
+                proc->outLen += n;
+                proc->out[proc->outLen] = '\0';
+            }
+            else
+            {
+                proc->errLen += n;
+                proc->err[proc->errLen] = '\0';
+            }
+            continue;
+        }
+
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n < 0 && errno == EAGAIN)
+            return;
+
+        wfaSpawnClose(fd);
+    }
+}
+
+static void wfaSpawnReap(wfaProc_t *proc, int block)
+{
+    int wstatus;
+    pid_t ret;
+
+    do
+    {
+        ret = waitpid(proc->pid, &wstatus, block ? 0 : WNOHANG);
+    } while(ret < 0 && errno == EINTR);
+
+    if(ret == 0)
+        return;
+
+    if(ret < 0)
+        proc->status = WFA_RUN_FAILED;
+    else if(proc->status == WFA_RUN_KILLED)
+        ;
+    else if(WIFEXITED(wstatus))
+        proc->status = WEXITSTATUS(wstatus);
+    else if(WIFSIGNALED(wstatus))
+        proc->status = 128 + WTERMSIG(wstatus);
+
+    proc->pid = 0;
+    wfaSpawnClose(&proc->pidFd);
+
+    /*
+     * Everything the helper wrote is in the pipes by now. A daemon it
+     * left behind may still hold them open, so they are not read to EOF.
+     */
+    wfaSpawnRead(proc, &proc->outFd);
+    wfaSpawnRead(proc, &proc->errFd);
+    wfaSpawnClose(&proc->outFd);
+    wfaSpawnClose(&proc->errFd);
+
+    if(proc->status != 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "%s exited with %d %s\n", proc->name, proc->status, proc->err);
+    }
+}
+
+/* an absolute time tmoutMs from now, for the calls that wait */
+void wfaSpawnDeadline(struct timespec *deadline, int tmoutMs)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += tmoutMs / 1000;
+    deadline->tv_nsec += (tmoutMs % 1000) * 1000000L;
+    if(deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+static long wfaSpawnMsLeft(struct timespec *deadline)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (deadline->tv_sec - now.tv_sec) * 1000 +
+           (deadline->tv_nsec - now.tv_nsec) / 1000000;
+}
+
+/*
+ * Collect helpers started by wfaSpawn(), all of them running side by
+ * side. Those still alive after tmoutMs are killed and get the status
+ * WFA_RUN_KILLED. Returns WFA_FAILURE if any did not exit with 0.
+ */
+int wfaSpawnWait(wfaProc_t *procs, int num, int tmoutMs)
+{
+    struct pollfd pfds[WFA_RUN_MAX_PROCS * 3];
+    wfaProc_t *owner[WFA_RUN_MAX_PROCS * 3];
+    int *fdOf[WFA_RUN_MAX_PROCS * 3];
+    struct timespec deadline;
+    int i, n, alive, tick, ret = WFA_SUCCESS;
+    long left;
+
+    if(num > WFA_RUN_MAX_PROCS)
+        num = WFA_RUN_MAX_PROCS;
+    if(tmoutMs <= 0)
+        tmoutMs = WFA_RUN_TMOUT_MS;
+
+    wfaSpawnDeadline(&deadline, tmoutMs);
+
+    for(;;)
+    {
+        n = alive = tick = 0;
+        for(i = 0; i < num; i++)
+        {
+            wfaProc_t *proc = &procs[i];
+
+            if(proc->pid <= 0)
+                continue;
+
+            if(proc->pidFd < 0)
+            {
+                /* no pidfd on this kernel, the exit is found by polling */
+                wfaSpawnReap(proc, 0);
+                if(proc->pid <= 0)
+                    continue;
+                tick = 1;
+            }
+            alive++;
+
+            if(proc->pidFd >= 0)
+            {
+                pfds[n].fd = proc->pidFd;
+                fdOf[n] = &proc->pidFd;
+                owner[n] = proc;
+                pfds[n++].events = POLLIN;
+            }
+            if(proc->outFd >= 0)
+            {
+                pfds[n].fd = proc->outFd;
+                fdOf[n] = &proc->outFd;
+                owner[n] = proc;
+                pfds[n++].events = POLLIN;
+            }
+            if(proc->errFd >= 0)
+            {
+                pfds[n].fd = proc->errFd;
+                fdOf[n] = &proc->errFd;
+                owner[n] = proc;
+                pfds[n++].events = POLLIN;
+            }
+        }
+
+        if(alive == 0)
+            break;
+
+        left = wfaSpawnMsLeft(&deadline);
+        if(left <= 0)
+        {
+            for(i = 0; i < num; i++)
+            {
+                if(procs[i].pid <= 0)
+                    continue;
+                DPRINT_WARNING(WFA_WNG, "%s still running after %d ms, killed\n", procs[i].name, tmoutMs);
+                kill(procs[i].pid, SIGKILL);
+                procs[i].status = WFA_RUN_KILLED;
+                wfaSpawnReap(&procs[i], 1);
+            }
+            break;
+        }
+        if(tick && left > WFA_RUN_TICK_MS)
+            left = WFA_RUN_TICK_MS;
+
+        if(poll(pfds, n, (int) left) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            DPRINT_ERR(WFA_ERR, "poll: %s\n", strerror(errno));
+            deadline.tv_sec = 0;
+            continue;
+        }
+
+        for(i = 0; i < n; i++)
+        {
+            if(pfds[i].revents == 0 || *fdOf[i] != pfds[i].fd)
+                continue;
+            if(fdOf[i] == &owner[i]->pidFd)
+                wfaSpawnReap(owner[i], 1);
+            else
+                wfaSpawnRead(owner[i], fdOf[i]);
+        }
+    }
+
+    for(i = 0; i < num; i++)
+    {
+        if(procs[i].status != 0)
+            ret = WFA_FAILURE;
+    }
+
+    return ret;
+}
+
+/*
+ * Hand back the next line the helper writes on stdout, without its end
+ * of line, as soon as it is complete. The last line may end at EOF
+ * instead. Returns WFA_FAILURE at EOF or once the deadline has passed;
+ * the helper is left running either way.
+ */
+int wfaSpawnReadLine(wfaProc_t *proc, char *line, int lineSz, struct timespec *deadline)
+{
+    struct pollfd pfds[3];
+    int *fdOf[3];
+    char *eol;
+    int i, n, len;
+    long left;
+
+    if(proc->out == NULL || lineSz <= 0)
+        return WFA_FAILURE;
+
+    for(;;)
+    {
+        eol = memchr(proc->out, '\n', proc->outLen);
+        if(eol != NULL || (proc->outLen > 0 &&
+                (proc->outFd < 0 || proc->outLen == proc->outSz - 1)))
+        {
+            len = (eol != NULL) ? eol - proc->out : proc->outLen;
+            n = (len < lineSz - 1) ? len : lineSz - 1;
+            wMEMCPY(line, proc->out, n);
+            line[n] = '\0';
+            if(n > 0 && line[n - 1] == '\r')
+                line[n - 1] = '\0';
+
+            /* the line and its '\n' are taken out of the buffer */
+            if(eol != NULL)
+                len++;
+            proc->outLen -= len;
+            memmove(proc->out, proc->out + len, proc->outLen);
+            proc->out[proc->outLen] = '\0';
+            return WFA_SUCCESS;
+        }
+
+        if(proc->outFd < 0)
+            return WFA_FAILURE;
+
+        left = wfaSpawnMsLeft(deadline);
+        if(left <= 0)
+            return WFA_FAILURE;
+
+        n = 0;
+        if(proc->pid > 0 && proc->pidFd < 0)
+        {
+            wfaSpawnReap(proc, 0);
+            if(left > WFA_RUN_TICK_MS)
+                left = WFA_RUN_TICK_MS;
+        }
+        if(proc->pidFd >= 0)
+        {
+            pfds[n].fd = proc->pidFd;
+            fdOf[n] = &proc->pidFd;
+            pfds[n++].events = POLLIN;
+        }
+        if(proc->outFd >= 0)
+        {
+            pfds[n].fd = proc->outFd;
+            fdOf[n] = &proc->outFd;
+            pfds[n++].events = POLLIN;
+        }
+        if(proc->errFd >= 0)
+        {
+            pfds[n].fd = proc->errFd;
+            fdOf[n] = &proc->errFd;
+            pfds[n++].events = POLLIN;
+        }
+
+        if(poll(pfds, n, (int) left) < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            DPRINT_ERR(WFA_ERR, "poll: %s\n", strerror(errno));
+            return WFA_FAILURE;
+        }
+
+        for(i = 0; i < n; i++)
+        {
+            if(pfds[i].revents == 0 || *fdOf[i] != pfds[i].fd)
+                continue;
+            if(fdOf[i] == &proc->pidFd)
+                wfaSpawnReap(proc, 1);
+            else
+                wfaSpawnRead(proc, fdOf[i]);
+        }
+    }
+}
+
+/* wfaSpawnOrphanThread(): drain and reap the released helpers */
+static void *wfaSpawnOrphanThread(void *arg)
+{
+    struct pollfd pfds[WFA_RUN_MAX_PROCS * 3 + 1];
+    wfaProc_t *owner[WFA_RUN_MAX_PROCS * 3 + 1];
+    int *fdOf[WFA_RUN_MAX_PROCS * 3 + 1];
+    uint64_t wake;
+    int i, n, tick;
+
+    (void) arg;
+
+    for(;;)
+    {
+        pfds[0].fd = orphanWakeFd;
+        pfds[0].events = POLLIN;
+        n = 1;
+        tick = 0;
+
+        wPT_MUTEX_LOCK(&orphanMutex);
+        for(i = 0; i < WFA_RUN_MAX_PROCS; i++)
+        {
+            wfaProc_t *proc = &orphans[i];
+
+            if(proc->pid > 0 && proc->pidFd < 0)
+            {
+                wfaSpawnReap(proc, 0);
+                tick = 1;
+            }
+            if(proc->pid <= 0)
+                continue;
+
+            if(proc->pidFd >= 0)
+            {
+                pfds[n].fd = proc->pidFd;
+                fdOf[n] = &proc->pidFd;
+                owner[n] = proc;
+                pfds[n++].events = POLLIN;
+            }
+            if(proc->outFd >= 0)
+            {
+                pfds[n].fd = proc->outFd;
+                fdOf[n] = &proc->outFd;
+                owner[n] = proc;
+                pfds[n++].events = POLLIN;
+            }
+            if(proc->errFd >= 0)
+            {
+                pfds[n].fd = proc->errFd;
+                fdOf[n] = &proc->errFd;
+                owner[n] = proc;
+                pfds[n++].events = POLLIN;
+            }
+        }
+        wPT_MUTEX_UNLOCK(&orphanMutex);
+
+        if(poll(pfds, n, tick ? WFA_RUN_TICK_MS : -1) < 0)
+            continue;
+
+        if(pfds[0].revents != 0 && read(orphanWakeFd, &wake, sizeof(wake)) < 0)
+            DPRINT_WARNING(WFA_WNG, "orphan wake: %i\n", errno);
+
+        /* only this thread closes an orphan's descriptors */
+        wPT_MUTEX_LOCK(&orphanMutex);
+        for(i = 1; i < n; i++)
+        {
+            if(pfds[i].revents == 0 || *fdOf[i] != pfds[i].fd)
+                continue;
+            if(fdOf[i] == &owner[i]->pidFd)
+                wfaSpawnReap(owner[i], 1);
+            else
+                wfaSpawnRead(owner[i], fdOf[i]);
+        }
+        wPT_MUTEX_UNLOCK(&orphanMutex);
+    }
+
+    return NULL;
+}
+
+/*
+ * Hand a running helper over to the orphan thread, with its pipes still
+ * open. Called with orphanMutex held; fails if the thread cannot be
+ * started or every slot is taken.
+ */
+static int wfaSpawnOrphan(wfaProc_t *proc)
+{
+    uint64_t one = 1;
+    int i;
+
+    if(orphanState == 0)
+    {
+        orphanState = -1;
+        orphanWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(orphanWakeFd >= 0 && wPT_CREATE(&orphanThr, NULL, wfaSpawnOrphanThread, NULL) == 0)
+        {
+            pthread_detach(orphanThr);
+            orphanState = 1;
+        }
+    }
+    if(orphanState != 1)
+        return WFA_FAILURE;
+
+    for(i = 0; i < WFA_RUN_MAX_PROCS && orphans[i].pid > 0; i++)
+        ;
+    if(i == WFA_RUN_MAX_PROCS)
+        return WFA_FAILURE;
+
+    /* whatever it writes from now on is read and dropped */
+    orphans[i] = *proc;
+    orphans[i].out = NULL;
+    orphans[i].outSz = orphans[i].outLen = 0;
+    if(write(orphanWakeFd, &one, sizeof(one)) < 0)
+        DPRINT_WARNING(WFA_WNG, "orphan wake: %i\n", errno);
+
+    proc->pid = 0;
+    proc->pidFd = proc->outFd = proc->errFd = -1;
+    return WFA_SUCCESS;
+}
+
+/*
+ * Done with a helper before it has exited. With "stop" it is killed,
+ * otherwise it may finish in its own time and is reaped later on.
+ */
+void wfaSpawnRelease(wfaProc_t *proc, int stop)
+{
+    if(proc->pid > 0)
+        wfaSpawnReap(proc, 0);
+
+    if(proc->pid > 0 && !stop)
+    {
+        wPT_MUTEX_LOCK(&orphanMutex);
+        wfaSpawnOrphan(proc);
+        wPT_MUTEX_UNLOCK(&orphanMutex);
+    }
+
+    if(proc->pid > 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "%s still running, killed\n", proc->name);
+        kill(proc->pid, SIGKILL);
+        proc->status = WFA_RUN_KILLED;
+        wfaSpawnReap(proc, 1);
+    }
+
+    wfaSpawnClose(&proc->pidFd);
+    wfaSpawnClose(&proc->outFd);
+    wfaSpawnClose(&proc->errFd);
+}
+
+/*
+ * Run one helper to the end. Returns its exit status, WFA_RUN_FAILED if
+ * it could not be started or WFA_RUN_KILLED if it hit tmoutMs. "out",
+ * when given, holds its stdout.
+ */
+int wfaRun(char *out, int outSz, int tmoutMs, const char *fmt, ...)
+{
+    char line[WFA_BUFF_1K];
+    wfaProc_t proc;
+    va_list ap;
+    int ret;
+
+    va_start(ap, fmt);
+    ret = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if(ret < 0 || ret >= (int) sizeof(line))
+    {
+        DPRINT_ERR(WFA_ERR, "command line too long\n");
+        return WFA_RUN_FAILED;
+    }
+
+    if(wfaSpawn(&proc, out, outSz, "%s", line) != WFA_SUCCESS)
+        return WFA_RUN_FAILED;
+
+    wfaSpawnWait(&proc, 1, tmoutMs);
+    return proc.status;
+}
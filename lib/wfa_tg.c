@@ -42,10 +42,10 @@
 #include "wfa_rsp.h"
 #include "wfa_wmmps.h"
 #include "wfa_miscs.h"
+#include "wfa_ping.h"
+#include "wfa_spawn.h"
 
 extern tgStream_t gStreams[];
-extern BOOL gtgRecv;
-extern BOOL gtgSend;
 extern BOOL gtgTransac;
 extern int gtimeOut;
 extern int gRegSec;
@@ -57,8 +57,6 @@ int adj_latency;
 extern tgStream_t *findStreamProfile(int);
 extern int wfaTrafficSendTo(int, char *, int, struct sockaddr *);
 extern int wfaTrafficRecv(int, char *, struct sockaddr *);
-extern void wfaSendPing(tgPingStart_t *staPing, float *interval, int streamid);
-extern int wfaStopPing(dutCmdResponse_t *stpResp, int streamid);
 extern unsigned short wfa_defined_debug;
 extern int tgSockfds[];
 
@@ -72,7 +70,6 @@ extern int bigEndianBuff2Int(char *buff);
 #ifdef WFA_WMM_PS_EXT
 extern int gtgWmmPS;
 extern wfaWmmPS_t wmmps_info;
-extern tgWMM_t wmmps_mutex_info;
 
 extern int psSockfd;
 extern unsigned int psTxMsg[];
@@ -81,19 +78,17 @@ extern int gtgPsPktRecvd;
 
 extern void wfaSetDUTPwrMgmt(int mode);
 void wmmps_wait_state_proc();
-extern void wfaWmmpsInitFlag();
 
 #endif
 
 
 
 static int streamId = 0;
-static int totalTranPkts = 0, sentTranPkts = 0;
 int slotCnt = 0;
 
 extern int usedThread;
 extern int runLoop;
-extern int sendThrId;
+extern int sendThrCnt;
 
 char e2eResults[124];
 #if 0  /* for test purpose only */
@@ -101,7 +96,8 @@ char *e2eResults = "/tmp/e2e1198798626.txt";
 #endif
 
 
-extern dutCmdResponse_t gGenericResp;
+extern wTHREAD_LOCAL dutCmdResponse_t gGenericResp;
+extern wTHREAD_LOCAL WORD gCtrlReqId;
 static int  tableDscpToTos[15] [2] = {{0,0},{8,32},{10,40},{14,56},{18,72},{22,88},{24,96},{28,112},{34,136},{36,144},{38,152},{40,160},{46,184},{48,192},{56,224}};
 
 
@@ -193,9 +189,10 @@ int wfaTGSendPing(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     case WFA_PING_ICMP_ECHO:
 #ifndef WFA_PING_UDP_ECHO_ONLY
         
-        wfaSendPing(staPing, &interval, streamId);
-
-        spresp->status = STATUS_COMPLETE;
+        if(wfaPingStart(streamid, staPing) == WFA_SUCCESS)
+            spresp->status = STATUS_COMPLETE;
+        else
+            spresp->status = STATUS_ERROR;
         spresp->streamId = streamid;
 #else
         printf("Only support UDP ECHO\n");
@@ -219,9 +216,7 @@ int wfaTGSendPing(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
         if((btSockfd = wfaConnectUDPPeer(btSockfd, staPing->dipaddr, WFA_UDP_ECHO_PORT)) > 0)
         {
             gtgTransac = streamid;
-            gtgSend = streamid;
-            totalTranPkts = 512;
-            sentTranPkts = 0;
+            myStream->transc.running = 1;
 
             /*
              * the framerate here is used to derive the timeout
@@ -246,8 +241,7 @@ int wfaTGSendPing(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
     }
 
 
-    wfaEncodeTLV(WFA_TRAFFIC_SEND_PING_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)spresp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_TRAFFIC_SEND_PING_RESP_TLV, spresp, sizeof(dutCmdResponse_t), respBuf);
 
     return WFA_SUCCESS;
 }
@@ -272,38 +266,24 @@ int wfaTGStopPing(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
     printf("\nthe stream id is %d",streamid);
 
-    if( gtgTransac == streamid&&gtgSend == streamid)
+    myStream = findStreamProfile(streamid);
+    if(myStream != NULL && myStream->transc.running)
     {
-        gtgTransac =0;
-        gtgSend = 0;
-        gtgRecv = 0;
+        gtgTransac = 0;
+        myStream->transc.running = 0;
         alarm(0);
 
-        myStream = findStreamProfile(streamid);
-        if(myStream == NULL)
-        {
-            stpResp->status = STATUS_INVALID;
-        }
-
+        wMEMSET(&stpResp->cmdru.pingStp, 0, sizeof(tgPingStopResp_t));
         stpResp->cmdru.pingStp.sendCnt = myStream->stats.txFrames;
         stpResp->cmdru.pingStp.repliedCnt = myStream->stats.rxFrames;
     }
     else
     {
-#if 0
-        if(wfaStopPing(stpResp, streamid)== WFA_FAILURE)
-        {
-            stpResp->status = STATUS_COMPLETE;
-
-            wfaEncodeTLV(WFA_TRAFFIC_STOP_PING_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)stpResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
-        }
-#endif
-        wfaStopPing(stpResp, streamid);
+        /* an unknown stream reports nothing sent */
+        wfaPingStop(streamid, &stpResp->cmdru.pingStp);
     }
 
-    wfaEncodeTLV(WFA_TRAFFIC_STOP_PING_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)stpResp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_TRAFFIC_STOP_PING_RESP_TLV, stpResp, sizeof(dutCmdResponse_t), respBuf);
 
     return WFA_SUCCESS;
 }
@@ -345,13 +325,117 @@ int wfaTGConfig(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
 
     confResp->status = STATUS_COMPLETE;
     confResp->streamId = myStream->id;
-    wfaEncodeTLV(WFA_TRAFFIC_AGENT_CONFIG_RESP_TLV, sizeof(dutCmdResponse_t), (BYTE *)confResp, respBuf);
-    *respLen = WFA_TLV_HDR_LEN + sizeof(dutCmdResponse_t);
+    *respLen = wfaEncodeResp(WFA_TRAFFIC_AGENT_CONFIG_RESP_TLV, confResp, sizeof(dutCmdResponse_t), respBuf);
 
 
     return ret;
 }
 
+/*
+ * wfaTGConfigBatchCheck(): a profile of a batch is stored as is, so its
+ *                          types and addresses are checked before any
+ *                          of the batch is taken
+ */
+static int wfaTGConfigBatchCheck(tgProfile_t *pf)
+{
+    if(pf->profile <= 0 || pf->profile >= PROF_LAST)
+        return WFA_FAILURE;
+
+    if(pf->direction != DIRECT_SEND && pf->direction != DIRECT_RECV &&
+            pf->direction != DIRECT_BIDIR)
+        return WFA_FAILURE;
+
+    if(memchr(pf->dipaddr, '\0', sizeof(pf->dipaddr)) == NULL ||
+            memchr(pf->sipaddr, '\0', sizeof(pf->sipaddr)) == NULL ||
+            memchr(pf->WmmpsTagName, '\0', sizeof(pf->WmmpsTagName)) == NULL)
+        return WFA_FAILURE;
+
+    if((pf->dipaddr[0] != '\0' && inet_addr(pf->dipaddr) == INADDR_NONE) ||
+            (pf->sipaddr[0] != '\0' && inet_addr(pf->sipaddr) == INADDR_NONE))
+        return WFA_FAILURE;
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaTGConfigBatch(): store a batch of traffic profiles in one go.
+ *           The batch is taken whole or not at all: every profile is
+ *           checked first, and a batch that does not fit in the free
+ *           slots resets the table only if no stream in it is active.
+ * input: caCmdBuf -- array of tgProfile_t
+ * response: the stream ids of the profiles, in order
+ * return: success or fail
+ */
+int wfaTGConfigBatch(int len, BYTE *caCmdBuf, int *respLen, BYTE *respBuf)
+{
+    tgProfile_t *pf = (tgProfile_t *)caCmdBuf;
+    tgConfigBatchResp_t batchResp;
+    tgStream_t *myStream;
+    int num = len/sizeof(tgProfile_t);
+    int i;
+
+    DPRINT_INFO(WFA_OUT, "entering wfaTGConfigBatch, %i profiles\n", num);
+
+    wMEMSET(&batchResp, 0, sizeof(batchResp));
+    batchResp.status = STATUS_INVALID;
+
+    if(num <= 0 || len % sizeof(tgProfile_t) != 0 ||
+            num > WFA_MAX_TRAFFIC_STREAMS || num > WFA_TG_MAX_BATCH)
+    {
+        DPRINT_ERR(WFA_ERR, "batch of %i bytes is not 1 to %i profiles\n", len, WFA_MAX_TRAFFIC_STREAMS);
+        goto done;
+    }
+
+    for(i = 0; i < num; i++)
+    {
+        if(wfaTGConfigBatchCheck(&pf[i]) != WFA_SUCCESS)
+        {
+            DPRINT_ERR(WFA_ERR, "profile %i of the batch is invalid\n", i+1);
+            goto done;
+        }
+    }
+
+    if(slotCnt + num > WFA_MAX_TRAFFIC_STREAMS)
+    {
+        for(i = 0; i < slotCnt; i++)
+        {
+            if(gStreams[i].state == WFA_STREAM_ACTIVE || gStreams[i].transc.running)
+            {
+                DPRINT_ERR(WFA_ERR, "no room for the batch, stream %i is active\n", gStreams[i].id);
+                goto done;
+            }
+        }
+
+        slotCnt = 0;
+    }
+
+    if(slotCnt == 0)
+    {
+        printf("resetting stream table\n");
+        wMEMSET(gStreams, 0, WFA_MAX_TRAFFIC_STREAMS*sizeof(tgStream_t));
+    }
+
+    for(i = 0; i < num; i++)
+    {
+        myStream = &gStreams[slotCnt++];
+        wMEMSET(myStream, 0, sizeof(tgStream_t));
+        wMEMCPY(&myStream->profile, &pf[i], sizeof(tgProfile_t));
+        myStream->id = ++streamId;
+        myStream->tblidx = slotCnt-1;
+
+        batchResp.streamIds[i] = myStream->id;
+    }
+
+    batchResp.status = STATUS_COMPLETE;
+    batchResp.numStreams = num;
+
+done:
+    wfaEncodeTLV(WFA_TRAFFIC_AGENT_CONFIG_BATCH_RESP_TLV, sizeof(batchResp), (BYTE *)&batchResp, respBuf);
+    *respLen = WFA_TLV_HDR_LEN + sizeof(batchResp);
+
+    return WFA_SUCCESS;
+}
+
 /* RecvStart: instruct traffic generator to start receiving
  *                 based on a profile
  * input:      cmd -- not used
@@ -397,6 +481,10 @@ int wfaTGRecvStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
         else
             myStream->fmInterval = 0;
 
+        /* a bidirectional stream receives from traffic_agent_send on */
+        if(theProfile->direction == DIRECT_BIDIR)
+            continue;
+
         if(theProfile->direction != DIRECT_RECV)
         {
             status = STATUS_INVALID;
@@ -404,9 +492,11 @@ int wfaTGRecvStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
         }
 
         wMEMSET(&myStream->stats, 0, sizeof(tgStats_t));
+        wMEMSET(&myStream->transc, 0, sizeof(tgTransc_t));
 
         // mark the stream active
         myStream->state = WFA_STREAM_ACTIVE;
+        myStream->ctrlReqId = gCtrlReqId;
 
         switch(theProfile->profile)
         {
@@ -414,7 +504,6 @@ int wfaTGRecvStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
         case PROF_MCAST:
         case PROF_FILE_TX:
             btSockfd = wfaCreateUDPSock(theProfile->dipaddr, theProfile->dport);
-            gtgRecv = streamid;
 
             if(btSockfd < 0)
                 status = STATUS_ERROR;
@@ -431,11 +520,10 @@ int wfaTGRecvStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
 
         case PROF_TRANSC:
         case PROF_CALI_RTD:  /* Calibrate roundtrip delay */
-            gtgTransac = streamid;
+            myStream->transc.running = 1;
         case PROF_MCAST:
         case PROF_FILE_TX:
         case PROF_IPTV:
-            gtgRecv = streamid;
             wmm_thr[usedThread].thr_flag = streamid;
             wPT_MUTEX_LOCK(&wmm_thr[usedThread].thr_flag_mutex);
             wPT_COND_SIGNAL(&wmm_thr[usedThread].thr_flag_cond);
@@ -470,22 +558,24 @@ int wfaTGRecvStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
             usedThread++;
 #endif // remove for now.
             status = STATUS_COMPLETE;
-            wfaWmmpsInitFlag();
             theProfile->trafficClass = 0;  // init to no traffic Class set
             // from STA point view, in the WMMPS, source addr is PCEnd also as dest address to send to
             strcpy(theProfile->dipaddr, theProfile->sipaddr);
 
-            memset(&wmmps_info.psToAddr, 0, sizeof(wmmps_info.psToAddr));
-            wmmps_info.psToAddr.sin_family = AF_INET;
-            wmmps_info.psToAddr.sin_addr.s_addr = inet_addr(theProfile->sipaddr);
-            wmmps_info.psToAddr.sin_port = htons(theProfile->sport);
-            wmmps_info.streamid = streamid;
+            {
+                struct sockaddr_in psToAddr;
 
-            wmmps_mutex_info.thr_flag = streamid;
-            gtgWmmPS = streamid;
-            pthread_cond_signal(&wmmps_mutex_info.thr_flag_cond);//Aaron's//Wake up the wfa_wmmps_thread
+                memset(&psToAddr, 0, sizeof(psToAddr));
+                psToAddr.sin_family = AF_INET;
+                psToAddr.sin_addr.s_addr = inet_addr(theProfile->sipaddr);
+                psToAddr.sin_port = htons(theProfile->sport);
+
+                /* the WMM-PS event loop owns the test case from here */
+                if(wfaWmmpsStart(streamid, &psToAddr) != WFA_SUCCESS)
+                    status = STATUS_ERROR;
+            }
             DPRINT_INFO(WFA_OUT, "wfaTGRecvStart PROF_UAPSD srcIPAddr=%s desIPAddr=%s streamId=%d\n",
-                        theProfile->sipaddr, theProfile->dipaddr, wmmps_info.streamid );
+                        theProfile->sipaddr, theProfile->dipaddr, streamid );
             gtimeOut = MINISECONDS/10;  /* in msec */
 
 #endif   /* WFA_WMM_PS_EXT */
@@ -520,8 +610,17 @@ int wfaTGRecvStop(int len, BYTE *parms, int *respLen, BYTE *respBuf)
 
     DPRINT_INFO(WFA_OUT, "entering tgRecvStop with length %d\n",len);
 
+    /* a bidirectional stream is stopped early, its send side with it */
+    for(i=0; i<numStreams; i++)
+    {
+        wMEMCPY(&streamid, parms+(4*i), 4);
+        myStream = findStreamProfile(streamid);
+        if(myStream != NULL && myStream->profile.direction == DIRECT_BIDIR)
+            myStream->transc.running = 0;
+    }
+
     /* in case that send-stream not done yet, an optional delay */
-    while(sendThrId != 0)
+    while(sendThrCnt > 0)
         sleep(1);
 
     /*
@@ -554,7 +653,7 @@ int wfaTGRecvStop(int len, BYTE *parms, int *respLen, BYTE *respBuf)
             return WFA_SUCCESS;
         }
 
-        if(theProfile->direction != DIRECT_RECV)
+        if(theProfile->direction != DIRECT_RECV && theProfile->direction != DIRECT_BIDIR)
         {
             status = STATUS_INVALID;
             wfaEncodeTLV(WFA_TRAFFIC_AGENT_RECV_STOP_RESP_TLV, 4, (BYTE *)&status, respBuf);
@@ -568,11 +667,17 @@ int wfaTGRecvStop(int len, BYTE *parms, int *respLen, BYTE *respBuf)
         {
         case PROF_TRANSC:
         case PROF_CALI_RTD:
-            gtgTransac = 0;
+            myStream->transc.running = 0;
         case PROF_MCAST:
         case PROF_FILE_TX:
         case PROF_IPTV:
-            gtgRecv = 0;
+            if(theProfile->direction == DIRECT_BIDIR)
+            {
+                /* the bidirectional worker owns its socket */
+                myStream->transc.running = 0;
+                break;
+            }
+
             if(tgSockfds[myStream->tblidx] != -1)
             {
                 wCLOSE(tgSockfds[myStream->tblidx]);
@@ -598,17 +703,7 @@ int wfaTGRecvStop(int len, BYTE *parms, int *respLen, BYTE *respBuf)
 #endif // remove old code
 
             DPRINT_INFO(WFA_OUT, "entering tgRecvStop PROF_UAPSD\n");
-            if(psSockfd  > 0)
-            {
-                wCLOSE(psSockfd);
-                psSockfd = -1;
-            }
-            wMEMSET(&wmmps_info, 0, sizeof(wfaWmmPS_t));
-
-            wfaSetDUTPwrMgmt(PS_OFF);
-            wSLEEP(3);
-            gtgWmmPS = 0;
-            gtgPsPktRecvd = 0;
+            wfaWmmpsStop();
 #endif /* WFA_WMM_PS_EXT */
             break;
 
@@ -649,9 +744,8 @@ int wfaTGRecvStop(int len, BYTE *parms, int *respLen, BYTE *respBuf)
  */
 int wfaTGSendStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
 {
-    int i=0, streamid=0;
+    int i=0, streamid=0, numThreads=0;
     int numStreams = len/4;
-    char gCmdStr[WFA_CMD_STR_SZ];
 
     tgProfile_t *theProfile;
     tgStream_t *myStream = NULL;
@@ -659,6 +753,8 @@ int wfaTGSendStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
     dutCmdResponse_t staSendResp;
 
     DPRINT_INFO(WFA_OUT, "Entering tgSendStart for %i streams ...\n", numStreams);
+
+    /* all streams are checked before any starts, the threads are counted */
     for(i=0; i<numStreams; i++)
     {
         wMEMCPY(&streamid, parms+(4*i), 4);
@@ -672,7 +768,11 @@ int wfaTGSendStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
         }
 
         theProfile = &myStream->profile;
-        if(theProfile == NULL)
+
+        /* only the plain traffic profiles can run both ways */
+        if((theProfile->direction != DIRECT_SEND && theProfile->direction != DIRECT_BIDIR) ||
+                (theProfile->direction == DIRECT_BIDIR && theProfile->profile != PROF_FILE_TX &&
+                 theProfile->profile != PROF_IPTV))
         {
             staSendResp.status = STATUS_INVALID;
             wfaEncodeTLV(WFA_TRAFFIC_AGENT_SEND_RESP_TLV, 4, (BYTE *)&staSendResp, respBuf);
@@ -681,34 +781,40 @@ int wfaTGSendStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
             return WFA_SUCCESS;
         }
 
-        if(theProfile->direction != DIRECT_SEND)
-        {
-            staSendResp.status = STATUS_INVALID;
-            wfaEncodeTLV(WFA_TRAFFIC_AGENT_SEND_RESP_TLV, 4, (BYTE *)&staSendResp, respBuf);
-            *respLen = WFA_TLV_HDR_LEN + 4;
+        /* the profiles the switch below hands to a WMM thread */
+        if(theProfile->profile == PROF_FILE_TX || theProfile->profile == PROF_MCAST ||
+                theProfile->profile == PROF_TRANSC || theProfile->profile == PROF_CALI_RTD ||
+                theProfile->profile == PROF_IPTV)
+            numThreads++;
+    }
 
-            return WFA_SUCCESS;
-        }
+    /* a short stream cannot answer before the others have started */
+    __sync_add_and_fetch(&sendThrCnt, numThreads);
+
+    for(i=0; i<numStreams; i++)
+    {
+        wMEMCPY(&streamid, parms+(4*i), 4);
+        myStream = findStreamProfile(streamid);
+        theProfile = &myStream->profile;
 
         /*
          * need to reset the stats
          */
         wMEMSET(&myStream->stats, 0, sizeof(tgStats_t));
+        wMEMSET(&myStream->transc, 0, sizeof(tgTransc_t));
 
         // mark the stream active;
         myStream->state = WFA_STREAM_ACTIVE;
+        myStream->ctrlReqId = gCtrlReqId;
 
         switch(theProfile->profile)
         {
         case PROF_FILE_TX:
         case PROF_MCAST:
         case PROF_TRANSC:
-            gtgTransac = streamid;
-            gtgSend = streamid;
         case PROF_CALI_RTD:
             gtgCaliRTD = streamid;
         case PROF_IPTV:
-            gtgSend = streamid;
             /*
              * singal the thread to Sending WMM traffic
              */
@@ -726,8 +832,8 @@ int wfaTGSendStart(int len, BYTE *parms, int *respLen, BYTE *respBuf)
             int ttout = 20;
 
             printf(" Run wfa_con timer = %d sec\n", ttout);
-            sprintf(gCmdStr,"/usr/bin/wfa_con -t %d %s",ttout,theProfile->WmmpsTagName);
-            if(system(gCmdStr))
+            /* a few seconds beyond its own timer before it is given up */
+            if(wfaRun(NULL, 0, (ttout + 5) * 1000, "/usr/bin/wfa_con -t %d %s", ttout, theProfile->WmmpsTagName))
                 printf("Done with wfa_con\n");
 
             staSendResp.status = STATUS_COMPLETE;
@@ -771,32 +877,20 @@ int wfaTGReset(int len, BYTE *parms, int *respLen, BYTE *respBuf)
     wALARM(0);
 
     /* just reset the flags for the command */
-    gtgRecv = 0;
-    gtgSend = 0;
     gtgTransac = 0;
+    wfaTranscStopAll();
+    wfaPingStopAll();
 #ifdef WFA_VOICE_EXT
     gtgCaliRTD = 0;
     min_rttime = 0xFFFFFFFF;
     gtgPktRTDelay = 0xFFFFFFFF;
 #endif
 
-    totalTranPkts = 0;
-
     runLoop = 0;
 
     usedThread = 0;
 #ifdef WFA_WMM_PS_EXT
-    gtgWmmPS = 0;
-    gtgPsPktRecvd = 0;
-
-    if(psSockfd != -1)
-    {
-        wCLOSE(psSockfd);
-        psSockfd = -1;
-    }
-
-    wMEMSET(&wmmps_info, 0, sizeof(wfaWmmPS_t));
-
+    wfaWmmpsStop();
 #endif
 
     e2eResults[0] = '\0';
@@ -1080,8 +1174,10 @@ int wfaSendLongFile(int mySockfd, int streamid, BYTE *aRespBuf, int *aRespLen)
 
             if(bytesSent != -1)
             {
+                WFA_STATS_BEGIN(myStream);
                 myStream->stats.txPayloadBytes += bytesSent;
                 myStream->stats.txFrames++ ;
+                WFA_STATS_END(myStream);
             }
             else
             {
@@ -1093,7 +1189,9 @@ int wfaSendLongFile(int mySockfd, int streamid, BYTE *aRespBuf, int *aRespLen)
                     DPRINT_ERR(WFA_ERR, "send error\n");
                     wUSLEEP(1000);             /* hold for 1 ms */
                     counter-- ;
+                    WFA_STATS_BEGIN(myStream);
                     myStream->stats.txFrames--;
+                    WFA_STATS_END(myStream);
                     break;
                 case ECONNRESET:
                     runLoop = 0;
@@ -1128,8 +1226,6 @@ int wfaSendLongFile(int mySockfd, int streamid, BYTE *aRespBuf, int *aRespLen)
         return DONE;
     }
 
-    gtgSend = 0;
-
     /* free the buffer */
     wFREE(packBuf);
 
@@ -1164,14 +1260,12 @@ int wfaSendShortFile(int mySockfd, int streamid, BYTE *sendBuf, int pksize, BYTE
     if(mySockfd == -1)
     {
         /* stop */
-        gtgTransac = 0;
-        gtgRecv = 0;
-        gtgSend = 0;
         printf("stop short traffic\n");
 
         myStream = findStreamProfile(streamid);
         if(myStream != NULL)
         {
+            myStream->transc.running = 0;
             sendResp.status = STATUS_COMPLETE;
             sendResp.streamId = streamid;
             wMEMCPY(&sendResp.cmdru.stats, &myStream->stats, sizeof(tgStats_t));
@@ -1203,31 +1297,34 @@ int wfaSendShortFile(int mySockfd, int streamid, BYTE *sendBuf, int pksize, BYTE
     else
         packLen = pksize;
 
+    /*
+     * the requester sends to the destination, the responder answers the
+     * source of the stream profile
+     */
     wMEMSET(&toAddr, 0, sizeof(toAddr));
     toAddr.sin_family = AF_INET;
-    toAddr.sin_addr.s_addr = inet_addr(theProf->sipaddr);
-    toAddr.sin_port = htons(theProf->sport);
-
-    if(gtgRecv && gtgTransac)
-    {
-        toAddr.sin_addr.s_addr = inet_addr(theProf->sipaddr);
-        toAddr.sin_port = htons(theProf->sport);
-    }
-    else if(gtgSend && gtgTransac)
+    if(theProf->direction == DIRECT_SEND)
     {
         toAddr.sin_addr.s_addr = inet_addr(theProf->dipaddr);
         toAddr.sin_port = htons(theProf->dport);
     }
+    else
+    {
+        toAddr.sin_addr.s_addr = inet_addr(theProf->sipaddr);
+        toAddr.sin_port = htons(theProf->sport);
+    }
 
-    int2BuffBigEndian(myStream->stats.txFrames, &((tgHeader_t *)packBuf)->hdr[8]);
+    int2BuffBigEndian(myStream->stats.txFrames, &((tgHeader_t *)packBuf)->hdr[TG_HDR_SN]);
 
     if(mySockfd != -1)
         bytesSent = wfaTrafficSendTo(mySockfd, (char *)packBuf, packLen, (struct sockaddr *)&toAddr);
 
     if(bytesSent != -1)
     {
+        WFA_STATS_BEGIN(myStream);
         myStream->stats.txFrames++;
         myStream->stats.txPayloadBytes += bytesSent;
+        WFA_STATS_END(myStream);
     }
     else
     {
@@ -1238,18 +1335,51 @@ int wfaSendShortFile(int mySockfd, int streamid, BYTE *sendBuf, int pksize, BYTE
         case ENOBUFS:
             DPRINT_ERR(WFA_ERR, "send error\n");
             wUSLEEP(1000);             /* hold for 1 ms */
+            WFA_STATS_BEGIN(myStream);
             myStream->stats.txFrames--;
+            WFA_STATS_END(myStream);
             break;
         default:
             ;;
         }
     }
 
-    sentTranPkts++;
+    myStream->transc.sentPkts++;
 
     return WFA_SUCCESS;
 }
 
+/*
+ * wfaRecvJitter(): interarrival jitter of the stream as in RFC 3550, from
+ *                  the send time in the frame header. The clocks of the
+ *                  two ends need not agree, only the change in transit
+ *                  time counts.
+ */
+static void wfaRecvJitter(tgStream_t *myStream, char *packBuf)
+{
+    struct timeval now;
+    long long transitUs, d, jitter = myStream->stats.jitter;
+    int sec = bigEndianBuff2Int(&((tgHeader_t *)packBuf)->hdr[TG_HDR_TV_SEC]);
+    int usec = bigEndianBuff2Int(&((tgHeader_t *)packBuf)->hdr[TG_HDR_TV_USEC]);
+
+    if(sec == 0)
+        return;
+
+    wGETTIMEOFDAY(&now, NULL);
+    transitUs = ((long long)now.tv_sec - sec) * 1000000 + now.tv_usec - usec;
+
+    if(myStream->stats.rxFrames > 1)
+    {
+        d = transitUs - myStream->lastTransitUs;
+        if(d < 0)
+            d = -d;
+        jitter += (d - jitter) / 16;
+        myStream->stats.jitter = (unsigned long)jitter;
+    }
+
+    myStream->lastTransitUs = transitUs;
+}
+
 /* always receive from a specified IP address and Port */
 int wfaRecvFile(int mySockfd, int streamid, char *recvBuf)
 {
@@ -1278,15 +1408,12 @@ int wfaRecvFile(int mySockfd, int streamid, char *recvBuf)
 
     wMEMSET(&fromAddr, 0, sizeof(fromAddr));
     fromAddr.sin_family = AF_INET;
-    fromAddr.sin_addr.s_addr = inet_addr(theProf->dipaddr);
-    fromAddr.sin_port = htons(theProf->dport);
-
-    if(gtgRecv && gtgTransac)
+    if(theProf->direction == DIRECT_RECV && myStream->transc.running)
     {
         fromAddr.sin_addr.s_addr = inet_addr(theProf->sipaddr);
         fromAddr.sin_port = htons(theProf->sport);
     }
-    else if(gtgSend && gtgTransac)
+    else
     {
         fromAddr.sin_addr.s_addr = inet_addr(theProf->dipaddr);
         fromAddr.sin_port = htons(theProf->dport);
@@ -1298,6 +1425,7 @@ int wfaRecvFile(int mySockfd, int streamid, char *recvBuf)
     bytesRecvd = wfaTrafficRecv(mySockfd, packBuf, (struct sockaddr *)&fromAddr);
     if(bytesRecvd != -1)
     {
+        WFA_STATS_BEGIN(myStream);
         myStream->stats.rxFrames++;
         myStream->stats.rxPayloadBytes +=bytesRecvd;
 
@@ -1307,6 +1435,9 @@ int wfaRecvFile(int mySockfd, int streamid, char *recvBuf)
         lostPkts = bigEndianBuff2Int(&((tgHeader_t *)packBuf)->hdr[8]) - 1 - myStream->lastPktSN;
         myStream->stats.lostPkts += lostPkts;
         myStream->lastPktSN = bigEndianBuff2Int(&((tgHeader_t *)packBuf)->hdr[8]);
+
+        wfaRecvJitter(myStream, packBuf);
+        WFA_STATS_END(myStream);
     }
     else
     {
@@ -1318,6 +1449,42 @@ int wfaRecvFile(int mySockfd, int streamid, char *recvBuf)
     return (bytesRecvd);
 }
 
+/*
+ * wfaTranscRecvReply(): wait for the reply to the last transaction request
+ *   of a stream. Replies to earlier requests that already timed out are
+ *   dropped. A peer that does not echo the request number is taken as
+ *   plain stop-and-wait.
+ * return: bytes of the reply, or <= 0 on receive timeout
+ */
+int wfaTranscRecvReply(int mySockfd, tgStream_t *myStream, char *recvBuf)
+{
+    int nbytes, sn;
+
+    for(;;)
+    {
+        nbytes = wfaRecvFile(mySockfd, myStream->id, recvBuf);
+        if(nbytes <= 0)
+            return nbytes;
+
+        sn = bigEndianBuff2Int(&((tgHeader_t *)recvBuf)->hdr[TG_HDR_TRANSC_SN]);
+        if(sn == 0 || (unsigned int)sn >= myStream->transc.reqSN)
+            return nbytes;
+
+        myStream->transc.lateReplies++;
+    }
+}
+
+/*
+ * wfaTranscStopAll(): end the transaction loops of all streams
+ */
+void wfaTranscStopAll(void)
+{
+    int i;
+
+    for(i = 0; i < WFA_MAX_TRAFFIC_STREAMS; i++)
+        gStreams[i].transc.running = 0;
+}
+
 //  new add-on code to process limite bitrate data push
 //
 
@@ -1437,8 +1604,10 @@ int wfaSendBitrateData(int mySockfd, int streamId, BYTE *pRespBuf, int *pRespLen
                  (struct sockaddr *)&toAddr);
            if(bytesSent != -1)
            {
+               WFA_STATS_BEGIN(myStream);
                myStream->stats.txPayloadBytes += bytesSent; 
                myStream->stats.txFrames++ ;
+               WFA_STATS_END(myStream);
             }
            else
            {
@@ -37,6 +37,7 @@
 #include "wfa_rsp.h"
 #include "wfa_wmmps.h"
 #include "wfa_miscs.h"
+#include "wfa_exec.h"
 
 /*
  * external global thread sync variables
@@ -58,6 +59,7 @@ extern unsigned int recvThr;
 extern int tgWMMTestEnable;
 int num_stops=0;
 int num_hello=0;
+int num_cyclic=0;   /* L.1 packets sent, reset on entering a send state */
 
 BOOL gtgCaliRTD;
 
@@ -79,6 +81,7 @@ unsigned int psRxMsg[512];
 #endif /* WFA_WMM_PS_EXT */
 
 extern void tmout_stop_send(int);
+void wfaSentStatsResp(void);
 extern StationProcStatetbl_t stationProcStatetbl[LAST_TEST+1][11];
 
 int nsent;
@@ -86,12 +89,9 @@ int nsent;
 int runLoop = 0;
 int usedThread=0;
 BOOL gtgTransac = 0;
-BOOL gtgSend = 0;
-BOOL gtgRecv = 0;
 
 extern int slotCnt;
 extern int btSockfd;
-int totalTranPkts=0, sentTranPkts=0;
 BYTE *trafficBuf=NULL, *respBuf=NULL;
 
 #ifdef WFA_VOICE_EXT
@@ -99,7 +99,8 @@ double gtgPktRTDelay = 0xFFFFFFFF;
 double min_rttime = 0xFFFFFFFF;
 static double rttime = 0;
 #endif
-int sendThrId = 0;
+/* streams of the running send not finished yet, the last one answers it */
+int sendThrCnt = 0;
 
 /* this is to stop sending packets by timer       */
 void tmout_stop_send(int num)
@@ -130,15 +131,9 @@ void tmout_stop_send(int num)
     slotCnt = 0;
 
     /*
-     * The test is for DT3 transaction test.
-     * Timeout to stop it.
+     * transaction streams are not stopped here, each one keeps its own
+     * duration, see wfaTranscDue()
      */
-    if(gtgTransac != 0)
-    {
-        gtgSend = 0;
-        gtgRecv = 0;
-        gtgTransac = 0;
-    }
 
     /*
      * all WMM streams also stop
@@ -154,6 +149,35 @@ void tmout_stop_send(int num)
 
 
 
+/*
+ * wfaSendStreamDone(): a stream of the send is finished; the last one to
+ *                      finish, whatever its duration, sends the statistics.
+ */
+static void wfaSendStreamDone(void)
+{
+    if(__sync_sub_and_fetch(&sendThrCnt, 1) == 0)
+    {
+        wfaSentStatsResp();
+        printf("done stats\n");
+    }
+}
+
+/*
+ * wfaTranscDue(): a transaction stream run by its duration has reached it.
+ */
+static int wfaTranscDue(tgProfile_t *prof, struct timeval *start)
+{
+    struct timeval now;
+
+    if(prof->maxcnt != 0 || prof->duration <= 0)
+        return 0;
+
+    gettimeofday(&now, NULL);
+
+    return (long long)(now.tv_sec - start->tv_sec) * 1000000 + now.tv_usec - start->tv_usec >=
+           (long long)prof->duration * 1000000;
+}
+
 /*
  * wfaTGSetPrio(): This depends on the network interface card.
  *               So you might want to remap according to the driver
@@ -285,24 +309,29 @@ void wfaSetThreadPrio(int tid, int userPriority)
 
 /*
  * collects the traffic statistics from other threads and
- * sends the collected information to CA
+ * sends the collected information to CA, as the response to the
+ * send command that started the streams
  */
-void  wfaSentStatsResp(int sock, BYTE *buf)
+void  wfaSentStatsResp(void)
 {
     int i, total=0, pkLen;
+    WORD reqId = 0;
     tgStream_t *allStreams = gStreams;
-    dutCmdResponse_t *sendStatsResp = (dutCmdResponse_t *)buf, *first;
-    char buff[WFA_RESP_BUF_SZ];
-
-    if(sendStatsResp == NULL)
-        return;
+    dutCmdResponse_t statsResp[WFA_MAX_TRAFFIC_STREAMS];
+    dutCmdResponse_t *sendStatsResp = statsResp, *first;
+    BYTE buff[WFA_TLV_HDR_LEN + sizeof(statsResp)];
 
+    wMEMSET(statsResp, 0, sizeof(statsResp));
     first = sendStatsResp;
 
     for(i = 0; i < WFA_MAX_TRAFFIC_STREAMS; i++)
     {
-        if((allStreams->id != 0) && (allStreams->profile.direction == DIRECT_SEND) && (allStreams->state == WFA_STREAM_ACTIVE))
+        if((allStreams->id != 0) && (allStreams->profile.direction == DIRECT_SEND || allStreams->profile.direction == DIRECT_BIDIR) &&
+                (allStreams->state == WFA_STREAM_ACTIVE))
         {
+            if(total == 0)
+                reqId = allStreams->ctrlReqId;
+
             sendStatsResp->status = STATUS_COMPLETE;
             sendStatsResp->streamId = allStreams->id;
             printf("stats stream id %i\n", allStreams->id);
@@ -335,9 +364,10 @@ void  wfaSentStatsResp(int sock, BYTE *buf)
     printf("\n");
 #endif
 
-    if(wfaCtrlSend(sock, (BYTE *)buff, pkLen) != pkLen)
+    /* kept for the next control link if this one is down */
+    if(wfaExecSendResp(total ? first->streamId : 0, reqId, buff, pkLen) != WFA_SUCCESS)
     {
-        DPRINT_WARNING(WFA_WNG, "wfaCtrlSend Error\n");
+        DPRINT_WARNING(WFA_WNG, "wfaExecSendResp Error\n");
     }
 
     return;
@@ -346,17 +376,16 @@ void  wfaSentStatsResp(int sock, BYTE *buf)
 #ifdef WFA_WMM_PS_EXT
 /*
  * sender(): This is a generic function to send a packed for the given dsc
- *               (ac:VI/VO/BE/BK), before sending the packet the function
- *               puts the station into the PS mode indicated by psave and
- *               sends the packet after sleeping for sllep_period
+ *               (ac:VI/VO/BE/BK), the station is already in the PS mode
+ *               indicated by psave and the WMM-PS event loop calls this
+ *               once sleep_period has elapsed
  */
 int sender(char psave,int sleep_period, int userPriority)
 {
     int r;
 
-    PRINTF("\nsender::sleeping for %d userPriority=%d psSockFd=%d",sleep_period, userPriority, psSockfd);
+    PRINTF("\nsender::after %d userPriority=%d psSockFd=%d",sleep_period, userPriority, psSockfd);
     wfaSetDUTPwrMgmt(psave);
-    wUSLEEP(sleep_period);
     create_apts_msg(APTS_DEFAULT, psTxMsg,wmmps_info.my_sta_id);
     wfaTGSetPrio(psSockfd, userPriority);
     r = wSENDTO(psSockfd, psTxMsg, msgsize, 0, (struct sockaddr *)&wmmps_info.psToAddr, sizeof(struct sockaddr));
@@ -364,7 +393,7 @@ int sender(char psave,int sleep_period, int userPriority)
 }
 /*
  * wfaStaSndHello(): This function sends a Hello packet
- *                and sleeps for sleep_period, the idea is
+ *                every sleep_period, the idea is
  *                to keep sending hello packets till the console
  *                responds, the function keeps a check on the MAX
  *                Hellos and if number of Hellos exceed that it quits
@@ -373,7 +402,6 @@ int WfaStaSndHello(char psave,int sleep_period,int *state)
 {
     tgWMM_t *my_wmm = &wmm_thr[wmmps_info.ps_thread];
 
-    usleep(sleep_period);
     wfaSetDUTPwrMgmt(psave);
     if(!(num_hello++))
         create_apts_msg(APTS_HELLO, psTxMsg,0);
@@ -393,14 +421,7 @@ int WfaStaSndHello(char psave,int sleep_period,int *state)
     if(num_hello > MAXHELLO)
     {
         DPRINT_ERR(WFA_ERR, "Too many Hellos sent\n");
-        gtgWmmPS = 0;
-        num_hello=0;
-        if(psSockfd != -1)
-        {
-            wCLOSE(psSockfd);
-            psSockfd = -1;
-        }
-        wSIGNAL(SIGALRM, SIG_IGN);
+        wfaWmmpsFinish();
     }
 
     return 0;
@@ -519,26 +540,24 @@ int WfaStaSndBK(char psave,int sleep_period,int *state)
 
 /*
  * WfaStaSndVOCyclic(): The function is the traffic generator for the L.1 test
- *                      caseThis function sends 3000 AC_VO packet
- *                      after the time specified by sleep_period (20ms)
+ *                      case. It sends one AC_VO packet per sleep_period
+ *                      (20ms) and advances after 3000 of them
  */
 int WfaStaSndVOCyclic(char psave,int sleep_period,int *state)
 {
-    int i;
-    static int en=1;
-
-    for(i=0; i<3000; i++)
+    PRINTF("\r\nEnterring WfastasndVOCyclic %d",num_cyclic);
+    sender(psave,sleep_period,TG_WMM_AC_VO);
+    if(!(num_cyclic%50))
     {
-        PRINTF("\r\nEnterring WfastasndVOCyclic %d",en++);
-        sender(psave,sleep_period,TG_WMM_AC_VO);
-        if(!(i%50))
-        {
-            PRINTF(".");
-            fflush(stdout);
-        }
+        PRINTF(".");
+        fflush(stdout);
     }
 
-    (*state)++;
+    if(++num_cyclic >= 3000)
+    {
+        num_cyclic = 0;
+        (*state)++;
+    }
 
     return 0;
 }
@@ -551,9 +570,7 @@ int WfaStaSndVOCyclic(char psave,int sleep_period,int *state)
  */
 int WfaStaWaitStop(char psave,int sleep_period,int *state)
 {
-    int myid=wmmps_info.ps_thread;
     PRINTF("\n Entering Sendwait");
-    wUSLEEP(sleep_period);
     if(!num_stops)
     {
         wfaSetDUTPwrMgmt(psave);
@@ -565,21 +582,14 @@ int WfaStaWaitStop(char psave,int sleep_period,int *state)
     wSENDTO(psSockfd, psTxMsg, msgsize, 0, (struct sockaddr *)&wmmps_info.psToAddr, sizeof(struct sockaddr));
     mpx("STA msg",psTxMsg,64);
 
-    wmm_thr[myid].stop_flag = 1;
-    wPT_MUTEX_LOCK(&wmm_thr[myid].thr_stop_mutex);
-    wPT_COND_SIGNAL(&wmm_thr[myid].thr_stop_cond);
-    wPT_MUTEX_UNLOCK(&wmm_thr[myid].thr_stop_mutex);
-
-    if(num_stops > MAX_STOPS)
+    if(wmmps_info.stop_recvd)
+    {
+        wfaWmmpsFinish();
+    }
+    else if(num_stops > MAX_STOPS)
     {
         DPRINT_ERR(WFA_ERR, "Too many stops sent\n");
-        gtgWmmPS = 0;
-        if(psSockfd != -1)
-        {
-            wCLOSE(psSockfd);
-            psSockfd = -1;
-        }
-        wSIGNAL(SIGALRM, SIG_IGN);
+        wfaWmmpsFinish();
     }
 
     return 0;
@@ -652,11 +662,11 @@ void * wfa_wmm_thread(void *thr_param)
             if (mySock < 0)
             {
                DPRINT_INFO(WFA_OUT, "wfa_wmm_thread SEND ERROR failed create UDP socket! \n");
+               wfaSendStreamDone();
                break;
             }
 
             mySock = wfaConnectUDPPeer(mySock, myProfile->dipaddr, myProfile->dport);
-            sendThrId = myId;
             /*
              * Set packet/socket priority TOS field
              */
@@ -674,9 +684,11 @@ void * wfa_wmm_thread(void *thr_param)
             }
 
             /*
-             * set timer fire up
+             * set timer fire up; the alarm is shared by the process, so a
+             * transaction stream times itself instead
              */
-            if(myProfile->maxcnt == 0)
+            if(myProfile->maxcnt == 0 && myProfile->profile != PROF_TRANSC &&
+               myProfile->profile != PROF_START_SYNC && myProfile->profile != PROF_CALI_RTD)
             {
                 wSIGNAL(SIGALRM, tmout_stop_send);
                 wALARM(myProfile->duration );
@@ -718,10 +730,13 @@ void * wfa_wmm_thread(void *thr_param)
                 struct timeval nxtime, curtime;
                 int ioflags = wFCNTL(mySock, F_GETFL, 0);
 #endif
-                struct timeval tmout;
+                struct timeval tmout, tstart, reqtime, rsptime;
+                char tranBuf[MAX_RCV_BUF_LEN+1];
+                BYTE tranRespBuf[WFA_RESP_BUF_SZ];
+                tgTransc_t *myTransc = &myStream->transc;
+                long long elapsedUs;
 
-                gtgTransac = myStreamId;
-                sentTranPkts = 0;
+                myTransc->running = 1;
 
 #if 0
                 gettimeofday(&nxtime, NULL);
@@ -734,6 +749,7 @@ void * wfa_wmm_thread(void *thr_param)
                 wFCNTL(mySock, F_SETFL, ioflags | O_NONBLOCK);
 #endif
                 gettimeofday(&lstime,0);
+                tstart = lstime;
                 DPRINT_INFO(WFA_OUT, "Start sending traffic,at sec %d usec %d\n", (int )lstime.tv_sec, (int)lstime.tv_usec);
 
 
@@ -744,17 +760,30 @@ void * wfa_wmm_thread(void *thr_param)
                 rcvCount=0; sendFailCount=0;
                 j=0;  sendCount=0;
                 sleepTotal = 0;
-                while(gtgTransac != 0)
+
+                if(myProfile->window > 1)
+                {
+                    /* requests pipelined up to the window, see wfa_transc.c */
+                    rcvCount = wfaTranscWindowRun(mySock, myStream);
+                    sendCount = myTransc->sentPkts;
+                    myTransc->running = 0;
+                }
+
+                while(myTransc->running)
                 {
 					gettimeofday(&lstime, NULL);
+
+                    /* several transaction streams may run together, each ends on its own time */
+                    if(wfaTranscDue(myProfile, &tstart))
+                        break;
 #ifdef WFA_VOICE_EXT  					
                     /*
                      * If your device is BIG ENDIAN, you need to
                      * modify the the function calls
                      */
-                    int2BuffBigEndian(asn++, &((tgHeader_t *)trafficBuf)->hdr[8]);
-                    int2BuffBigEndian(lstime.tv_sec, &((tgHeader_t *)trafficBuf)->hdr[12]);
-                    int2BuffBigEndian(lstime.tv_usec, &((tgHeader_t *)trafficBuf)->hdr[16]);
+                    int2BuffBigEndian(asn++, &((tgHeader_t *)tranBuf)->hdr[8]);
+                    int2BuffBigEndian(lstime.tv_sec, &((tgHeader_t *)tranBuf)->hdr[12]);
+                    int2BuffBigEndian(lstime.tv_usec, &((tgHeader_t *)tranBuf)->hdr[16]);
 #else
                     j++;
                     i=0;
@@ -763,21 +792,27 @@ void * wfa_wmm_thread(void *thr_param)
 
 #endif /* WFA_VOICE_EXT */
 
-                        if(gtgTransac != 0/* && nbytes <= 0 */)
+                        if(myTransc->running && wfaTranscDue(myProfile, &tstart))
                         {
-                            if(respBuf == NULL)
-                            {
-                                DPRINT_INFO(WFA_OUT, "wfa_wmm_thread SEND,PROF_TRANSC::a Null respBuf\n");
-                            }
-                            memset(respBuf, 0, WFA_RESP_BUF_SZ);
+                            myTransc->running = 0;
+                            break;
+                        }
+
+                        if(myTransc->running)
+                        {
+                            memset(tranRespBuf, 0, WFA_RESP_BUF_SZ);
                             respLen = 0;
-                            memset(trafficBuf  ,0, MAX_UDP_LEN + 1);
+                            memset(tranBuf, 0, MAX_UDP_LEN + 1);
+
+                            /* number the request, the responder echoes it back */
+                            int2BuffBigEndian(++myTransc->reqSN, &((tgHeader_t *)tranBuf)->hdr[TG_HDR_TRANSC_SN]);
+                            gettimeofday(&reqtime, NULL);
                             if(wfaSendShortFile(mySock, myStreamId,
-                                trafficBuf, 0, respBuf, &respLen) == DONE)
+                                (BYTE *)tranBuf, 0, tranRespBuf, &respLen) == DONE)
                             {
-                                if(wfaCtrlSend(gxcSockfd, respBuf, respLen) != respLen)
+                                if(wfaExecSendResp(myStream->id, myStream->ctrlReqId, tranRespBuf, respLen) != WFA_SUCCESS)
                                 {
-                                    DPRINT_INFO(WFA_OUT, "wfa_wmm_thread SEND,PROF_TRANSC::wfaCtrlSend Error for wfaSendShortFile\n");
+                                    DPRINT_INFO(WFA_OUT, "wfa_wmm_thread SEND,PROF_TRANSC::wfaExecSendResp Error for wfaSendShortFile\n");
                                 }
                                 sendFailCount++;
                                 i--;
@@ -794,13 +829,14 @@ void * wfa_wmm_thread(void *thr_param)
                             if((myProfile->maxcnt>0) &&(sendCount == myProfile->maxcnt))
                             {
                                 DPRINT_INFO(WFA_OUT, "wfa_wmm_thread SEND,PROF_TRANSC::meet maxcnt=%d; end loop\n",myProfile->maxcnt);
-                                gtgTransac = 0; /* break snd/rcv wile loop  */
+                                myTransc->running = 0; /* break snd/rcv wile loop  */
                                 break;
                             }
 
-                            nbytes = wfaRecvFile(mySock, myStreamId, (char  *)trafficBuf);
+                            nbytes = wfaTranscRecvReply(mySock, myStream, tranBuf);
                             if(nbytes <= 0)
                             {/* Do not print any msg it will slow down process on snd/rcv  */
+                            myTransc->timeouts++;
                             //setsockopt(mySock, SOL_SOCKET, SO_RCVTIMEO, (char *)&tmout, (socklen_t) sizeof(tmout)); 
                             //printf("PROF_TRANSC::time out event, wfaRecvFile failed,resend a new packet ...\n");
 
@@ -825,10 +861,14 @@ void * wfa_wmm_thread(void *thr_param)
                             }
                             else
                             {
+                               gettimeofday(&rsptime, NULL);
+                               WFA_STATS_BEGIN(myStream);
+                               wfaLatHistAdd(&myTransc->rtt, wfa_itime_diff(&reqtime, &rsptime));
+                               WFA_STATS_END(myStream);
                                rcvCount++;
                                nbytes = 0;
                             }
-                        } /*  if gtgTransac != 0 */
+                        } /*  if myTransc->running */
 #ifdef WFA_VOICE_EXT 
                         /*
                         * Roundtrip time delay:
@@ -860,16 +900,17 @@ void * wfa_wmm_thread(void *thr_param)
                         /*  not voice case  */ 
                         /*  for do-while loop for frame rate per sec */ 
  
-                    }while ((i <= myProfile->rate + myProfile->rate/3) && (myProfile->rate !=0) && (gtgTransac != 0 )); 
+                    }while ((i <= myProfile->rate + myProfile->rate/3) && (myProfile->rate !=0) && myTransc->running); 
 
 					if(myProfile->maxcnt == 0)
                     {
 	                    gettimeofday(&lrtime, NULL);
 	                    rttime = wfa_itime_diff(&lstime, &lrtime);
 	                    /*  we cover frame rate = 0 case without any sleep to continue push data */
-	                    if (((difftime = 1000000 - rttime) > 0) && (myProfile->rate != 0))
+	                    if (((difftime = 1000000 - rttime) > 0) && (myProfile->rate != 0) && myTransc->running)
 	                    {
-	                        if ( j < myProfile->duration)
+	                        /* paced every second up to its own end */
+	                        if (!wfaTranscDue(myProfile, &tstart))
 	                        {
 	                           usleep (difftime);
 	                           sleepTotal = sleepTotal + difftime/1000;
@@ -891,24 +932,72 @@ void * wfa_wmm_thread(void *thr_param)
                 }
                 DPRINT_INFO(WFA_OUT, "wfa_wmm_thread SEND::Sending stats back, sendCount=%d rcvCount=%d sleepTotal in mil-sec=%d sendFailCount=%d frmRate=%d do count=%d\n", sendCount,rcvCount,sleepTotal,sendFailCount, myProfile->rate, j);
 
+                myTransc->running = 0;
+                gettimeofday(&lrtime, NULL);
+                elapsedUs = (long long)(lrtime.tv_sec - tstart.tv_sec) * 1000000 + lrtime.tv_usec - tstart.tv_usec;
+                if(elapsedUs > 0)
+                    myStream->stats.transPerSec = (unsigned int)((long long)rcvCount * 1000000 / elapsedUs);
+                myStream->stats.transTimeouts = myTransc->timeouts;
+                wfaLatHistSummary(&myTransc->rtt, &myStream->stats);
+                DPRINT_INFO(WFA_OUT, "stream %d %u trans/sec, %u timeouts, %u late replies\n",
+                            myStreamId, myStream->stats.transPerSec, myTransc->timeouts, myTransc->lateReplies);
+                DPRINT_INFO(WFA_OUT, "stream %d rtt usec min %u avg %u p50 %u p95 %u p99 %u max %u\n",
+                            myStreamId, myStream->stats.rttMin, myStream->stats.rttAvg, myStream->stats.rttP50,
+                            myStream->stats.rttP95, myStream->stats.rttP99, myStream->stats.rttMax);
+
             }/* else if(myProfile->profile == PROF_TRANSC || myProfile->profile == PROF_START_SYNC || myProfile->profile == PROF_CALI_RTD) */
 
             wMEMSET(respBuf, 0, WFA_RESP_BUF_SZ);
             wSLEEP(1);
 
             /*
-             * uses thread that is saved at last to pack the items and ships
+             * the thread that finishes last packs the items and ships
              * it to CA.
              */
+            wfaSendStreamDone();
 
-            if(myId == sendThrId)
+            break;
+
+        case DIRECT_BIDIR:
+        {
+            int ioflags, iOptVal, iOptLen;
+
+            /* both directions on the source port, the peer sends to it */
+            mySock = wfaCreateUDPSock(myProfile->sipaddr, myProfile->sport);
+            if(mySock < 0)
             {
-                wfaSentStatsResp(gxcSockfd, respBuf);
-                printf("done stats\n");
-                sendThrId = 0;
+                DPRINT_ERR(WFA_ERR, "wfa_wmm_thread BIDIR failed create UDP socket\n");
+                wfaSendStreamDone();
+                break;
             }
 
-            break;
+            wfaTGSetPrio(mySock, myProfile->trafficClass);
+            wfaSetThreadPrio(myId, myProfile->trafficClass);
+
+            ioflags = wFCNTL(mySock, F_GETFL, 0);
+            wFCNTL(mySock, F_SETFL, ioflags | O_NONBLOCK);
+
+            iOptLen = sizeof(iOptVal);
+            getsockopt(mySock, SOL_SOCKET, SO_SNDBUF, (char *)&iOptVal, (socklen_t *)&iOptLen);
+            iOptVal = iOptVal * 16;
+            setsockopt(mySock, SOL_SOCKET, SO_SNDBUF, (char *)&iOptVal, (socklen_t )iOptLen);
+            getsockopt(mySock, SOL_SOCKET, SO_RCVBUF, (char *)&iOptVal, (socklen_t *)&iOptLen);
+            iOptVal = iOptVal * 10;
+            setsockopt(mySock, SOL_SOCKET, SO_RCVBUF, (char *)&iOptVal, (socklen_t )iOptLen);
+
+            if(myProfile->startdelay > 0 && myProfile->startdelay<100)
+            {
+                wSLEEP(myProfile->startdelay);
+            }
+
+            wfaBidirRun(mySock, myStream);
+
+            wCLOSE(mySock);
+            mySock = -1;
+
+            wfaSendStreamDone();
+        }
+        break;
 
         case DIRECT_RECV:
             /*
@@ -1084,6 +1173,9 @@ void * wfa_wmm_thread(void *thr_param)
             else if(myProfile->profile == PROF_TRANSC || myProfile->profile == PROF_START_SYNC || myProfile->profile == PROF_CALI_RTD)
             {
                 struct timeval tmout;
+                char tranBuf[MAX_RCV_BUF_LEN+1];
+                BYTE tranRespBuf[WFA_RESP_BUF_SZ];
+                tgTransc_t *myTransc = &myStream->transc;
 
                 mySock = wfaCreateUDPSock(myProfile->sipaddr, myProfile->sport);
                 if(mySock < 0)
@@ -1095,31 +1187,26 @@ void * wfa_wmm_thread(void *thr_param)
 
                 tgSockfds[myStream->tblidx] = mySock;
 
-                totalTranPkts = 0xFFFFFFF0;
-                gtgTransac = myStreamId;
+                myTransc->running = 1;
 
                /* set timeout for blocking receive */
                tmout.tv_sec = 0;
                tmout.tv_usec = 400000;   /* set the receive time out to 400 ms, 200ms is too short */
                setsockopt(mySock, SOL_SOCKET, SO_RCVTIMEO, (char *)&tmout, (socklen_t) sizeof(tmout));
 
-               while(gtgTransac != 0)
+               while(myTransc->running)
                {
-                    memset(trafficBuf, 0, sizeof((char*)trafficBuf));
-
                     if(mySock != -1)
                     {
-                        int i = gtgTransac;
-
                       nbytes = 0;
 
                       /* check for data as long as we are in a transaction */
-                      while ((gtgTransac != 0) && (nbytes <= 0))
+                      while (myTransc->running && (nbytes <= 0))
                       {
-                          nbytes = wfaRecvFile(mySock, i, (char  *)trafficBuf);
+                          nbytes = wfaRecvFile(mySock, myStreamId, tranBuf);
                       }
                       /* It is the end of a transaction, go out of the loop */
-                      if (gtgTransac == 0) break;
+                      if (!myTransc->running) break;
                    }
                     else
                     {
@@ -1129,16 +1216,16 @@ void * wfa_wmm_thread(void *thr_param)
 #ifdef WFA_VOICE_EXT
                     /* for a transaction receiver, it just needs to send the local time back */
                     gettimeofday(&lstime, NULL);
-                    int2BuffBigEndian(lstime.tv_sec, &((tgHeader_t *)trafficBuf)->hdr[12]);
-                    int2BuffBigEndian(lstime.tv_usec, &((tgHeader_t *)trafficBuf)->hdr[16]);
+                    int2BuffBigEndian(lstime.tv_sec, &((tgHeader_t *)tranBuf)->hdr[12]);
+                    int2BuffBigEndian(lstime.tv_usec, &((tgHeader_t *)tranBuf)->hdr[16]);
 #endif
-                    memset(respBuf, 0, WFA_RESP_BUF_SZ);
+                    memset(tranRespBuf, 0, WFA_RESP_BUF_SZ);
                     respLen = 0;
-                    if(wfaSendShortFile(mySock, gtgTransac, trafficBuf, nbytes, respBuf, &respLen) == DONE)
+                    if(wfaSendShortFile(mySock, myStreamId, (BYTE *)tranBuf, nbytes, tranRespBuf, &respLen) == DONE)
                     {
-                        if(wfaCtrlSend(gxcSockfd, (BYTE *)respBuf, respLen)!=respLen)
+                        if(wfaExecSendResp(myStream->id, myStream->ctrlReqId, tranRespBuf, respLen) != WFA_SUCCESS)
                         {
-                            DPRINT_WARNING(WFA_WNG, "wfaCtrlSend Error\n");
+                            DPRINT_WARNING(WFA_WNG, "wfaExecSendResp Error\n");
                         }
                     }
                 }
@@ -62,27 +62,82 @@ BOOL wfaEncodeTLV(WORD the_tag, WORD the_len, BYTE *the_value, BYTE *tlv_data)
 
 BOOL wfaDecodeTLV(BYTE *tlv_data, int tlv_len, WORD *ptag, int *pval_len, BYTE *pvalue)
 {
-    wfaTLV *data = (wfaTLV *)tlv_data;
+    wfaTlvView_t view;
 
     if(pvalue == NULL)
     {
         DPRINT_ERR(WFA_ERR, "Parm buf invalid\n");
         return WFA_FAILURE;
     }
-    *ptag = data->tag;
-    *pval_len = data->len;
 
-    if(tlv_len < *pval_len)
+    if(wfaTlvView(tlv_data, tlv_len, &view) != WFA_SUCCESS || view.len > MAX_PARMS_BUFF)
         return WFA_FAILURE;
 
-    if(*pval_len != 0 && *pval_len < MAX_PARMS_BUFF)
+    *ptag = view.tag;
+    *pval_len = view.len;
+    if(view.len != 0)
+        wMEMCPY(pvalue, view.value, view.len);
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaTlvView(): decode a TLV in place, nothing is copied.
+ * input:  tlv_data - the TLV format packet buffer
+ *         tlv_len  - bytes in the buffer
+ * output: view - tag, length and where the value is in tlv_data
+ * return: WFA_FAILURE if the header or the value runs past tlv_len
+ */
+int wfaTlvView(BYTE *tlv_data, int tlv_len, wfaTlvView_t *view)
+{
+    wfaTLV *data = (wfaTLV *)tlv_data;
+
+    if(tlv_data == NULL || tlv_len < (int)WFA_TLV_HDR_LEN)
+        return WFA_FAILURE;
+
+    if(data->len > tlv_len - (int)WFA_TLV_HDR_LEN)
     {
-        wMEMCPY(pvalue, tlv_data+4, *pval_len);
+        DPRINT_WARNING(WFA_WNG, "TLV %u value of %u bytes, only %i came\n", data->tag, data->len,
+                       tlv_len - (int)WFA_TLV_HDR_LEN);
+        return WFA_FAILURE;
     }
 
+    view->tag = data->tag;
+    view->len = data->len;
+    view->value = tlv_data + WFA_TLV_HDR_LEN;
+
     return WFA_SUCCESS;
 }
 
+/*
+ * wfaEncodeResp(): encode a response without its unused tail. The
+ *                  trailing zero bytes are left out, the value keeps
+ *                  whole words and at least the status. The CA clears
+ *                  its buffer before each frame, so what is left out
+ *                  reads as zero there. Not for arrays of responses,
+ *                  their count comes from the length.
+ * input:  the_tag - response type
+ *         the_resp, the_size - the response structure
+ * output: tlv_data - encoded TLV, caller must allocate the_size more
+ *                    than the header
+ * return: the TLV length
+ */
+int wfaEncodeResp(WORD the_tag, void *the_resp, int the_size, BYTE *tlv_data)
+{
+    BYTE *resp = (BYTE *)the_resp;
+    int len = the_size;
+
+    while(len > 4 && resp[len - 1] == 0)
+        len--;
+    len = (len + 3) & ~3;
+    if(len > the_size)
+        len = the_size;
+
+    wfaEncodeTLV(the_tag, len, resp, tlv_data);
+
+    return WFA_TLV_HDR_LEN + len;
+}
+
 /*
  * wfaGetTLVTag(): the individual function to retrieve a TLV type.
  * input: tlv_data - TLV buffer
@@ -0,0 +1,279 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_transc.c - windowed request/response engine for the
+ *       transaction profile.
+ *       The stop-and-wait loop in wfa_wmm_thread() sends one request and
+ *       blocks for its reply, so its rate is bound by the round trip and
+ *       each lost reply costs a full receive timeout. With a "window"
+ *       set in the stream profile, up to that many requests are kept in
+ *       flight instead. Replies are matched to requests by the request
+ *       number echoed in the traffic header, and every request is timed
+ *       out on its own from a timer wheel of one millisecond ticks.
+ */
+#include <sys/time.h>
+#include <time.h>
+#include <poll.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_tg.h"
+#include "wfa_sock.h"
+#include "wfa_miscs.h"
+
+extern unsigned short wfa_defined_debug;
+
+typedef struct _tg_transc_win
+{
+    tgTranscReq_t req[WFA_TRANSC_MAX_WINDOW];
+    int wheel[WFA_TRANSC_WHEEL_SLOTS];     /* first request in each bucket */
+    unsigned int tick;                      /* last tick expired            */
+    int size;
+    int outstanding;
+} tgTranscWin_t;
+
+/* monotonic time in milliseconds, the wheel tick */
+static unsigned int wfaTranscNowTick(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (unsigned int)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static void wfaTranscWheelAdd(tgTranscWin_t *win, int idx)
+{
+    tgTranscReq_t *r = &win->req[idx];
+    int b = r->expTick % WFA_TRANSC_WHEEL_SLOTS;
+
+    r->prev = -1;
+    r->next = win->wheel[b];
+    if(r->next != -1)
+        win->req[r->next].prev = idx;
+    win->wheel[b] = idx;
+    win->outstanding++;
+}
+
+static void wfaTranscWheelDel(tgTranscWin_t *win, int idx)
+{
+    tgTranscReq_t *r = &win->req[idx];
+
+    if(r->prev != -1)
+        win->req[r->prev].next = r->next;
+    else
+        win->wheel[r->expTick % WFA_TRANSC_WHEEL_SLOTS] = r->next;
+
+    if(r->next != -1)
+        win->req[r->next].prev = r->prev;
+
+    r->sn = 0;
+    win->outstanding--;
+}
+
+/*
+ * wfaTranscWheelAdvance(): walk the buckets passed since the last call
+ *                          and give up the requests that are due.
+ */
+static void wfaTranscWheelAdvance(tgTranscWin_t *win, tgTransc_t *transc, unsigned int now)
+{
+    int idx, next, n;
+
+    for(n = 0; win->tick != now && n < WFA_TRANSC_WHEEL_SLOTS; n++)
+    {
+        win->tick++;
+        idx = win->wheel[win->tick % WFA_TRANSC_WHEEL_SLOTS];
+        while(idx != -1)
+        {
+            next = win->req[idx].next;
+            if((int)(win->req[idx].expTick - now) <= 0)
+            {
+                wfaTranscWheelDel(win, idx);
+                transc->timeouts++;
+            }
+            idx = next;
+        }
+    }
+
+    win->tick = now;
+}
+
+static int wfaTranscFind(tgTranscWin_t *win, unsigned int sn)
+{
+    int i;
+
+    for(i = 0; i < win->size; i++)
+    {
+        if(win->req[i].sn != 0 && win->req[i].sn == sn)
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+ * wfaTranscWindowRun(): run a transaction stream with profile->window
+ *                       requests in flight until its duration or maxcnt
+ *                       is reached, or the stream is stopped.
+ * input:   mySockfd -- the stream socket, connected to the responder
+ *          myStream -- the stream, its transc.running flag set
+ * return:  number of completed transactions
+ */
+int wfaTranscWindowRun(int mySockfd, tgStream_t *myStream)
+{
+    tgProfile_t *theProf = &myStream->profile;
+    tgTransc_t *transc = &myStream->transc;
+    tgTranscWin_t win;
+    tgTranscReq_t *r;
+    struct sockaddr_in toAddr;
+    struct pollfd pfd;
+    struct timeval start, now, rsptime;
+    char tranBuf[MAX_RCV_BUF_LEN+1];
+    unsigned long long elapsedUs, nextSendUs = 0, intervalUs = 0;
+    unsigned int sent = 0, completed = 0;
+    int i, idx, nbytes, bytesSent, packLen;
+
+    wMEMSET(&win, 0, sizeof(win));
+    for(i = 0; i < WFA_TRANSC_WHEEL_SLOTS; i++)
+        win.wheel[i] = -1;
+
+    win.size = theProf->window;
+    if(win.size > WFA_TRANSC_MAX_WINDOW)
+        win.size = WFA_TRANSC_MAX_WINDOW;
+
+    /* the profile rate is the offered transactions per second, 0 unpaced */
+    if(theProf->rate != 0)
+        intervalUs = 1000000 / theProf->rate;
+
+    packLen = theProf->pksize;
+    if(packLen < sizeof(tgHeader_t))
+        packLen = sizeof(tgHeader_t);
+    if(packLen > MAX_UDP_LEN)
+        packLen = MAX_UDP_LEN;
+
+    wMEMSET(&toAddr, 0, sizeof(toAddr));
+    toAddr.sin_family = AF_INET;
+    toAddr.sin_addr.s_addr = inet_addr(theProf->dipaddr);
+    toAddr.sin_port = htons(theProf->dport);
+
+    pfd.fd = mySockfd;
+    pfd.events = POLLIN;
+
+    DPRINT_INFO(WFA_OUT, "stream %d transaction window %d\n", myStream->id, win.size);
+
+    wGETTIMEOFDAY(&start, NULL);
+    win.tick = wfaTranscNowTick();
+
+    while(transc->running || win.outstanding > 0)
+    {
+        wGETTIMEOFDAY(&now, NULL);
+        elapsedUs = (unsigned long long)(now.tv_sec - start.tv_sec) * 1000000 + now.tv_usec - start.tv_usec;
+
+        /* no new requests past the end of the run, let the window drain */
+        if(transc->running)
+        {
+            if(theProf->maxcnt > 0 && sent >= theProf->maxcnt)
+                transc->running = 0;
+            else if(theProf->maxcnt == 0 && theProf->duration > 0 &&
+                    elapsedUs >= (unsigned long long)theProf->duration * 1000000)
+                transc->running = 0;
+        }
+
+        /* keep the window full, paced on absolute send times */
+        while(transc->running && win.outstanding < win.size &&
+              (theProf->maxcnt == 0 || sent < theProf->maxcnt) &&
+              (intervalUs == 0 || elapsedUs >= nextSendUs))
+        {
+            for(idx = 0; idx < win.size && win.req[idx].sn != 0; idx++)
+                ;
+            r = &win.req[idx];
+
+            wMEMSET(tranBuf, 0, packLen);
+            int2BuffBigEndian(++transc->reqSN, &((tgHeader_t *)tranBuf)->hdr[TG_HDR_TRANSC_SN]);
+            int2BuffBigEndian(myStream->stats.txFrames, &((tgHeader_t *)tranBuf)->hdr[TG_HDR_SN]);
+
+            wGETTIMEOFDAY(&r->sendTime, NULL);
+            bytesSent = wfaTrafficSendTo(mySockfd, tranBuf, packLen, (struct sockaddr *)&toAddr);
+            if(bytesSent == -1)
+            {
+                /* socket queue full, try again on the next pass */
+                break;
+            }
+
+            WFA_STATS_BEGIN(myStream);
+            myStream->stats.txFrames++;
+            myStream->stats.txPayloadBytes += bytesSent;
+            WFA_STATS_END(myStream);
+            transc->sentPkts++;
+            sent++;
+
+            r->sn = transc->reqSN;
+            r->expTick = wfaTranscNowTick() + WFA_TRANSC_REQ_TMOUT;
+            wfaTranscWheelAdd(&win, idx);
+
+            if(intervalUs != 0)
+            {
+                /*
+                 * catch up on the 1 ms poll granularity, but do not burst
+                 * to make up for time spent with the window full
+                 */
+                if(elapsedUs > nextSendUs + intervalUs + 1000)
+                    nextSendUs = elapsedUs;
+                nextSendUs += intervalUs;
+            }
+        }
+
+        if(poll(&pfd, 1, 1) > 0 && (pfd.revents & POLLIN))
+        {
+            /* pick up all the replies already queued */
+            do
+            {
+                nbytes = wfaRecvFile(mySockfd, myStream->id, tranBuf);
+                if(nbytes <= 0)
+                    break;
+
+                idx = wfaTranscFind(&win, bigEndianBuff2Int(&((tgHeader_t *)tranBuf)->hdr[TG_HDR_TRANSC_SN]));
+                if(idx < 0)
+                {
+                    transc->lateReplies++;
+                    continue;
+                }
+
+                wGETTIMEOFDAY(&rsptime, NULL);
+                WFA_STATS_BEGIN(myStream);
+                wfaLatHistAdd(&transc->rtt, wfa_itime_diff(&win.req[idx].sendTime, &rsptime));
+                WFA_STATS_END(myStream);
+                wfaTranscWheelDel(&win, idx);
+                completed++;
+            } while(poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN));
+        }
+
+        wfaTranscWheelAdvance(&win, transc, wfaTranscNowTick());
+    }
+
+    if(completed == 0 && transc->lateReplies > 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "stream %d: replies do not carry the request number, the peer needs window 1\n", myStream->id);
+    }
+
+    return completed;
+}
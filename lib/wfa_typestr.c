@@ -23,20 +23,26 @@
  *
  */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include "wfa_debug.h"
 #include "wfa_types.h"
 #include "wfa_tlv.h"
 #include "wfa_tg.h"
 #include "wfa_cmds.h"
 #include "wfa_agtctrl.h"
 
+extern unsigned short wfa_defined_debug;
 extern int cmdProcNotDefinedYet(char *, BYTE *, int *);
 extern int xcCmdProcGetVersion(char *, BYTE *, int *);
 extern int xcCmdProcAgentConfig(char *, BYTE *, int *);
+extern int xcCmdProcAgentConfigBatch(char *, BYTE *, int *);
 extern int xcCmdProcAgentSend(char *, BYTE *, int *);
 extern int xcCmdProcAgentRecvStart(char *, BYTE *, int *);
 extern int xcCmdProcAgentRecvStop(char *, BYTE *, int *);
 extern int xcCmdProcAgentReset(char *, BYTE *, int *);
+extern int xcCmdProcAgentStatus(char *, BYTE *, int *);
 extern int xcCmdProcStaGetIpConfig(char *, BYTE *, int *);
 extern int xcCmdProcStaSetIpConfig(char *, BYTE *, int *);
 extern int xcCmdProcStaGetMacAddress(char *pcmdStr, BYTE *, int *);
@@ -138,8 +144,10 @@ typeNameStr_t nameStr[] =
     {WFA_TRAFFIC_SEND_PING_TLV, "traffic_send_ping", xcCmdProcAgentSendPing},
     {WFA_TRAFFIC_STOP_PING_TLV, "traffic_stop_ping", xcCmdProcAgentStopPing},
     {WFA_TRAFFIC_AGENT_CONFIG_TLV, "traffic_agent_config", xcCmdProcAgentConfig},
+    {WFA_TRAFFIC_AGENT_CONFIG_BATCH_TLV, "traffic_agent_config_batch", xcCmdProcAgentConfigBatch},
     {WFA_TRAFFIC_AGENT_SEND_TLV, "traffic_agent_send", xcCmdProcAgentSend},
     {WFA_TRAFFIC_AGENT_RESET_TLV, "traffic_agent_reset", xcCmdProcAgentReset},
+    {WFA_TRAFFIC_AGENT_STATUS_TLV, "traffic_agent_status", xcCmdProcAgentStatus},
     {WFA_TRAFFIC_AGENT_RECV_START_TLV, "traffic_agent_receive_start", xcCmdProcAgentRecvStart},
     {WFA_TRAFFIC_AGENT_RECV_STOP_TLV, "traffic_agent_receive_stop", xcCmdProcAgentRecvStop},
     /* Control Commands */
@@ -230,3 +238,53 @@ typeNameStr_t nameStr[] =
       
    {-1, "", NULL},
 };
+
+static int nameStrNum;
+
+static int wfaNameStrCmp(const void *a, const void *b)
+{
+    return strcmp(((typeNameStr_t *)a)->name, ((typeNameStr_t *)b)->name);
+}
+
+/*
+ * wfaNameStrInit(): sort the command names once so that the lookup for
+ *                   each command is a binary search. Entry 0 and the
+ *                   terminator stay in place.
+ * return:  WFA_SUCCESS, or WFA_FAILURE if a name is listed twice
+ */
+int wfaNameStrInit(void)
+{
+    int i;
+
+    for(nameStrNum = 0; nameStr[nameStrNum + 1].type != -1; nameStrNum++)
+        ;
+
+    qsort(&nameStr[1], nameStrNum, sizeof(typeNameStr_t), wfaNameStrCmp);
+
+    for(i = 2; i <= nameStrNum; i++)
+    {
+        if(strcmp(nameStr[i-1].name, nameStr[i].name) == 0)
+        {
+            DPRINT_ERR(WFA_ERR, "command %s defined twice\n", nameStr[i].name);
+            return WFA_FAILURE;
+        }
+    }
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaNameStrLookup(): find a CAPI command by its name.
+ * return:  the table entry or NULL
+ */
+typeNameStr_t *wfaNameStrLookup(char *name)
+{
+    typeNameStr_t key;
+
+    if(name == NULL || strlen(name) >= sizeof(key.name))
+        return NULL;
+
+    strcpy(key.name, name);
+
+    return (typeNameStr_t *)bsearch(&key, &nameStr[1], nameStrNum, sizeof(typeNameStr_t), wfaNameStrCmp);
+}
@@ -36,17 +36,22 @@
 #include "wfa_wmmps.h"
 #include "wfa_main.h"
 #include "wfa_debug.h"
+#include "wfa_spawn.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
 extern int psSockfd;
 extern int num_stops;
 extern int num_hello;
+extern int num_cyclic;
 extern tgWMM_t wmm_thr[];
 
 extern unsigned int psTxMsg[WMMPS_MSG_BUF_SIZE];
 extern unsigned int psRxMsg[WMMPS_MSG_BUF_SIZE];
 extern int msgsize;
 
-char gCmdStr[WFA_CMD_STR_SZ];
+extern wTHREAD_LOCAL char gCmdStr[];
 int resetsnd=0;
 int reset_recd=0;
 int resetrcv=0;
@@ -57,12 +62,16 @@ struct timeval time_ap;
 struct timeval time_ul;
 
 wfaWmmPS_t  wmmps_info;
-tgWMM_t     wmmps_mutex_info;
+static wfaWmmpsEngine_t wfaEngine = { -1, -1, -1 };
 extern int gtgWmmPS;
 /*  function declaration */
 extern int wfaTGSetPrio(int sockfd, int tgClass);
 void wmmps_wait_state_proc();
-void* wfa_wmmps_send_thread(void* input);
+void wfaWmmpsInitFlag(void);
+void WfaStaResetAll();
+void BUILD_APTS_MSG(int msg, unsigned long *txbuf);
+void wfaSetDUTPwrMgmt(int mode);
+void mpx(char *m, void *buf_v, int len);
 
 /* APTS messages*/
 struct apts_msg apts_msgs[] =
@@ -217,121 +226,122 @@ StationRecvProcStatetbl_t stationRecvProcStatetbl[LAST_TEST+10][6] =
 
 
 
-/* The DUT send table for each of the test cases*/
+/* The DUT send table for each of the test cases, sleep_period is how long
+** the station waits in the power mode of a state before it fires*/
 StationProcStatetbl_t stationProcStatetbl[LAST_TEST+1][11] =
 {
     /* Dummy*/{{0},{0},{0},{0},{0},{0},{0},{0},{0},{0},{0}},
-    /* B.D*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* B.D*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVO,P_ON,LII / 2}   ,{WfaStaSndVO,P_ON,LII / 2}        ,{WfaStaWaitStop,P_ON,LII / 2},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* B.H*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* B.H*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVO,P_ON,LII / 2}   ,{WfaStaSndVO,P_ON,LII / 2}        ,{WfaStaWaitStop,P_ON,LII / 2},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* B.B*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* B.B*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVO,P_ON,LII / 2}   ,{WfaStaSndVI,P_ON,LII / 2}        ,{WfaStaSndBE,P_ON,LII / 2}     ,{WfaStaSndBK,P_ON,LII / 2}    ,{WfaStaWaitStop,P_ON,LII / 2},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* B.M*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* B.M*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,30000000},{WfaStaWaitStop,P_ON,LII / 2}     ,{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* M.D*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* M.D*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndVI,P_ON,LII / 2}        ,{WfaStaSndVI,P_ON,LII / 2}     ,{WfaStaSndVI,P_ON,LII / 2}    ,{WfaStaWaitStop,P_ON,LII / 2},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* B.Z*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* B.Z*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVO,P_ON,LII / 2 }  ,{WfaStaWaitStop,P_ON,LII / 2}     ,{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* M.Y*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* M.Y*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndVO,P_ON,LII / 2}        ,{WfaStaSndBE,P_ON,LII / 2}     ,{WfaStaSndBE,P_ON,LII / 2}    ,{WfaStaWaitStop,P_ON,LII / 2},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* L.1*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* L.1*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVOCyclic,P_ON,20000},{WfaStaWaitStop,P_ON,LII / 2 }
     },
 
-    /* A.Y*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* A.Y*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndVO,P_ON,LII / 2}        ,{WfaStaSndBE,P_ON,LII / 2}     ,{WfaStaSndBE,P_OFF,LII / 2}    ,{WfaStaSndBE,P_ON,LII / 2}   ,{WfaStaWaitStop,P_ON,LII / 2},{0,0,0},{0,0,0}
     },
 
-    /* B.W*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* B.W*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndVI,P_ON,LII / 2}        ,{WfaStaSndVI,P_ON,LII / 2}    ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* A.J*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* A.J*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVO,P_ON,LII / 2}   ,{WfaStaSndVO,P_OFF,LII / 2},{WfaStaWaitStop	,P_ON,LII / 2},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* M.V*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* M.V*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndBE,P_ON,LII / 2}        ,{WfaStaSndVI,P_ON,LII / 2}    ,{WfaStaWaitStop	,P_ON,LII / 2} ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* M.U*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* M.U*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndBE,P_ON,LII / 2}        ,{WfaStaSnd2VO,P_ON,LII / 2}   ,{WfaStaWaitStop	,P_ON,LII / 2} ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* A.U*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* A.U*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}  ,{WfaStaSndBE,P_OFF,LII / 2}      ,{WfaStaSndBE,P_ON,LII / 2}    ,{WfaStaSndBE,P_OFF,LII / 2}   ,{WfaStaSndVO,P_ON,LII / 2}   ,{WfaStaSndVO,P_OFF,LII / 2} ,{WfaStaWaitStop ,P_ON,LII / 2},{0,0,0}
     },
 
-    /* M.L*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* M.L*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndBE,P_ON,LII / 2}   ,{WfaStaWaitStop,P_ON,LII / 2}     ,{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* B.K*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* B.K*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndBE,P_ON,LII / 2}        ,{WfaStaSndVI,P_ON,LII / 2}    ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* M.B*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* M.B*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVO,P_ON,LII / 2}   ,{WfaStaSndVI,P_ON,LII / 2}        ,{WfaStaSndBE,P_ON,LII / 2}     ,{WfaStaSndBK,P_ON,LII / 2}    ,{WfaStaWaitStop,P_ON,LII / 2} ,{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* M.K*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* M.K*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndBE,P_ON,LII / 2}        ,{WfaStaSndVI,P_ON,LII / 2}    ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* M.W*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2},
+    /* M.W*/  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0},
         {WfaStaSndVI,P_ON,LII / 2}   ,{WfaStaSndBE,P_ON,LII / 2}        ,{WfaStaSndVI,P_ON,LII / 2}    ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}
     }
 #ifdef WFA_WMM_AC
-    /* WMMAC_422_T02B */  ,{{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,1000000}, {WfaStaSndVO,P_ON,1000000}, {WfaStaSndVO,P_ON,1000000}, {WfaStaWaitStop,P_ON,LII / 2}, {0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* WMMAC_422_T02B */  ,{{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,1000000}, {WfaStaSndVO,P_ON,1000000}, {WfaStaSndVO,P_ON,1000000}, {WfaStaWaitStop,P_ON,LII / 2}, {0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
-    /* WMMAC_422_T03B */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
+    /* WMMAC_422_T03B */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 422_T04B/ATC7 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
+    /* 422_T04B/ATC7 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 422_T05B/ATC8 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVO,P_ON,lis_int}   ,{WfaStaSndVI,P_ON,lis_int+2*becon_int} ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 422_T05B/ATC8 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVO,P_ON,lis_int}   ,{WfaStaSndVI,P_ON,lis_int+2*becon_int} ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 422_T06B/ATC9 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndBE,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndBE,P_ON,becon_int}  ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
+    /* 422_T06B/ATC9 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndBE,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndBE,P_ON,becon_int}  ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 422_T07B/ATC10 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndBE,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaSndBK,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
+    /* 422_T07B/ATC10 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndBE,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaSndBK,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 422_T08B/ATC11 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndBE,P_ON,becon_int}   ,{WfaStaSndVI,P_ON,lis_int}        ,{WfaStaSndBE,P_ON,becon_int}  ,{WfaStaSndVO,P_ON,lis_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
+    /* 422_T08B/ATC11 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndBE,P_ON,becon_int}   ,{WfaStaSndVI,P_ON,lis_int}        ,{WfaStaSndBE,P_ON,becon_int}  ,{WfaStaSndVO,P_ON,lis_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 423_T04 */  {{WfaStaSndHello,P_OFF, 1000000}, {WfaStaSndConfirm,P_ON, 1}
+    /* 423_T04 */  {{WfaStaSndHello,P_OFF, 1000000}, {WfaStaSndConfirm,P_ON, 0}
         ,{WfaStaSndVO,P_ON,1000000}    ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0}, {0,0,0},{0,0,0},{0,0,0},{0,0,0}
     },
 
-    /* 424_T07t14 */ {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 424_T07t14 */ {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 425_T04t06 */ {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndBE,P_ON,becon_int}   ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0}, {0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 425_T04t06 */ {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndBE,P_ON,becon_int}   ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0}, {0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 521_T03 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndBE,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 521_T03 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndBE,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 521_T05 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndBE,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 521_T05 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndBE,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 522_T04 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndBE,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 522_T04 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndBE,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 522_T06 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVI,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaSndVI,P_ON,lis_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
-    /* 522_T06o */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVO,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaSndVO,P_ON,lis_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
+    /* 522_T06 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVI,P_ON,lis_int}        ,{WfaStaSndVI,P_ON,becon_int}  ,{WfaStaSndVI,P_ON,lis_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
+    /* 522_T06o */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVO,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,becon_int}  ,{WfaStaSndVO,P_ON,lis_int}  ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 524_T03 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVO,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,lis_int} ,{WfaStaWaitStop,P_ON,LII / 2},  {0,0,0},{0,0,0},{0,0,0},{0,0,0}},
-    /* 524_T03i */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVI,P_ON,lis_int}  ,{WfaStaSndVI,P_ON,lis_int}       ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 524_T03 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVO,P_ON,becon_int}   ,{WfaStaSndVO,P_ON,lis_int}        ,{WfaStaSndVO,P_ON,lis_int} ,{WfaStaWaitStop,P_ON,LII / 2},  {0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 524_T03i */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaSndVI,P_ON,lis_int}  ,{WfaStaSndVI,P_ON,lis_int}       ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
-    /* 525_T07t10 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, LII / 2}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
+    /* 525_T07t10 */  {{WfaStaSndHello,P_OFF, 1000000},{WfaStaSndConfirm,P_ON, 0}, {WfaStaSndVI,P_ON,becon_int}   ,{WfaStaWaitStop,P_ON,LII / 2}  ,{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0},{0,0,0}},
 
 #endif
 
@@ -639,7 +649,6 @@ int WfaRcvVOCyclic(unsigned int *rmsg,int length,int *state)
 {
 
     int r;
-    tgWMM_t *my_wmm = &wmm_thr[wmmps_info.ps_thread];
 
     if(rmsg[10] != APTS_STOP)
     {
@@ -650,32 +659,18 @@ int WfaRcvVOCyclic(unsigned int *rmsg,int length,int *state)
     }
     else
     {
-        wPT_MUTEX_LOCK(&my_wmm->thr_stop_mutex);
-        while(!my_wmm->stop_flag)
-        {
-            wPT_COND_WAIT(&my_wmm->thr_stop_cond, &my_wmm->thr_stop_mutex);
-        }
-        wPT_MUTEX_UNLOCK(&my_wmm->thr_stop_mutex);
-        my_wmm->stop_flag = 0;
-        gtgWmmPS = 0;
-        wCLOSE(psSockfd);
-        psSockfd = -1;
-        wSIGNAL(SIGALRM, SIG_IGN);
-        //wfaSetDUTPwrMgmt(PS_OFF);
-        wSLEEP(1);
+        /* finish now if our STOP is out, else once WfaStaWaitStop sends it */
+        wmmps_info.stop_recvd = 1;
+        if(num_stops > 0)
+            wfaWmmpsFinish();
     }
 
     return 0;
 }
 /* WfaRcvStop: This function receives the stop message from the
-** console, it waits for the sending thread to have sent the stop before
-** quitting*/
+** console, the test case ends once the station has sent its own stop*/
 int WfaRcvStop(unsigned int *rmsg,int length,int *state)
 {
-
-    tgWMM_t *my_wmm = &wmm_thr[wmmps_info.ps_thread];
-
-    my_wmm->stop_flag = 0;
     PRINTF("\r\nEnterring WfaRcvStop\n");
 
     if(rmsg[10] != APTS_STOP)
@@ -685,21 +680,12 @@ int WfaRcvStop(unsigned int *rmsg,int length,int *state)
     }
     else
     {
-        pthread_mutex_lock(&my_wmm->thr_stop_mutex);
-        while(!my_wmm->stop_flag)
-        {
-            pthread_cond_wait(&my_wmm->thr_stop_cond, &my_wmm->thr_stop_mutex);
-        }
-        num_stops=0;
-        pthread_mutex_unlock(&my_wmm->thr_stop_mutex);
-        my_wmm->stop_flag = 0;
-        gtgWmmPS = 0;
-        wCLOSE(psSockfd);
-        psSockfd = -1;
-        signal(SIGALRM, SIG_IGN);
-        //wfaSetDUTPwrMgmt(PS_OFF);
-        wSLEEP(1);
+        /* finish now if our STOP is out, else once WfaStaWaitStop sends it */
+        wmmps_info.stop_recvd = 1;
+        if(num_stops > 0)
+            wfaWmmpsFinish();
     }
+
     return 0;
 }
 
@@ -785,8 +771,7 @@ void wfaSetDUTPwrMgmt(int mode)
     if(mode == PS_OFF)
     {
         //sprintf(gCmdStr, "iwpriv %s set PSMode=CAM", iface);
-        sprintf(gCmdStr, "iwconfig %s power off", iface);
-        if( system(gCmdStr) < 0)
+        if(wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "iwconfig %s power off", iface) != 0)
         {
             DPRINT_ERR(WFA_ERR, "Cant Set PS OFF\n");
         }
@@ -796,8 +781,7 @@ void wfaSetDUTPwrMgmt(int mode)
     else
     {
         //sprintf(gCmdStr, "iwpriv %s set PSMode=MAX_PSP", iface);
-        sprintf(gCmdStr, "iwconfig %s power on", iface);
-        if( system(gCmdStr) < 0)
+        if(wfaRun(NULL, 0, WFA_RUN_TMOUT_MS, "iwconfig %s power on", iface) != 0)
         {
             DPRINT_ERR(WFA_ERR, "Cant Set PS ON\n");
         }
@@ -900,6 +884,7 @@ void wfaWmmpsInitFlag(void)
     resetsnd = 0;
     num_hello=0;
     num_stops=0;
+    num_cyclic=0;
 
     wmmps_info.sta_test=1; /* test case index,   */
     wmmps_info.rcv_state=0;
@@ -912,220 +897,421 @@ void wfaWmmpsInitFlag(void)
     //pthread_mutex_lock(&wmmps_mutex_info.thr_flag_mutex);
     DPRINT_INFO(WFA_OUT,"wfaWmmpsInitFlag::reset all flags\n");
 }
-/* following routine replace wfaWmmPowerSaveProcess  */
-void* wfa_wmmps_thread(void* input) //Aaron's//The main thread runs the wmmps process
+/*
+ * Absolute deadlines on CLOCK_MONOTONIC for the send states, so the
+ * processing time of a state does not stretch the power save timing.
+ */
+static void wfaWmmpsArm(int usec)
 {
-    int rbytes=0;
-    int sta_test=1;
-    struct sockaddr from;
-    int len;
-    StationRecvProcStatetbl_t *rcvstatarray;
-    StationRecvProcStatetbl_t func;
-    pthread_t   sendThreadHandle = 0;
-    //int   sendThreadId = 0;
-    len=sizeof(from);
+    struct itimerspec its;
+    struct timespec now;
 
+    wfaEngine.deadline.tv_sec += usec / 1000000;
+    wfaEngine.deadline.tv_nsec += (usec % 1000000) * 1000;
+    if(wfaEngine.deadline.tv_nsec >= 1000000000)
+    {
+        wfaEngine.deadline.tv_sec++;
+        wfaEngine.deadline.tv_nsec -= 1000000000;
+    }
+
+    /* a slow power mode switch must not turn into a burst to catch up */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(wfaEngine.deadline.tv_sec < now.tv_sec ||
+            (wfaEngine.deadline.tv_sec == now.tv_sec && wfaEngine.deadline.tv_nsec < now.tv_nsec))
+        wfaEngine.deadline = now;
 
-    while(1)
+    wMEMSET(&its, 0, sizeof(its));
+    its.it_value = wfaEngine.deadline;
+    if(timerfd_settime(wfaEngine.tmrfd, TFD_TIMER_ABSTIME, &its, NULL) != 0)
     {
-        if (sendThreadHandle != 0)
+        DPRINT_ERR(WFA_ERR, "wfaWmmpsArm: timerfd_settime failed %i\n", errno);
+    }
+}
+
+static void wfaWmmpsDisarm(void)
+{
+    struct itimerspec its;
+
+    wMEMSET(&its, 0, sizeof(its));
+    timerfd_settime(wfaEngine.tmrfd, 0, &its, NULL);
+}
+
+/*
+ * wfaWmmpsFinish(): end the running test case, called on the engine
+ *                   thread once both sides have seen a STOP or a retry
+ *                   limit is hit.
+ */
+void wfaWmmpsFinish(void)
+{
+    wfaWmmpsDisarm();
+
+    if(psSockfd != -1)
+    {
+        epoll_ctl(wfaEngine.epfd, EPOLL_CTL_DEL, psSockfd, NULL);
+        wCLOSE(psSockfd);
+        psSockfd = -1;
+    }
+
+    gtgWmmPS = 0;
+    num_stops = 0;
+    num_hello = 0;
+    num_cyclic = 0;
+
+    wPT_MUTEX_LOCK(&wfaEngine.mutex);
+    wfaEngine.running = 0;
+    wPT_COND_SIGNAL(&wfaEngine.idleCond);
+    wPT_MUTEX_UNLOCK(&wfaEngine.mutex);
+
+    DPRINT_INFO(WFA_OUT, "wfaWmmpsFinish: test case %d done\n", wmmps_info.sta_test);
+}
+
+/* enter the current send state: set the power mode and wait its period */
+static void wfaWmmpsEnterState(void)
+{
+    StationProcStatetbl_t *curr = &stationProcStatetbl[wmmps_info.sta_test][state_num];
+
+    if(curr->statefunc == NULL)
+    {
+        /* all sent, the console STOP ends the test case */
+        wfaWmmpsDisarm();
+        return;
+    }
+
+    /* a repeating state starts its count over, also after a reset */
+    num_cyclic = 0;
+    wfaSetDUTPwrMgmt(curr->pw_offon);
+    wfaWmmpsArm(curr->sleep_period);
+}
+
+static void wfaWmmpsSendHello(void)
+{
+    wMEMSET(psTxMsg, 0, sizeof(psTxMsg));
+    BUILD_APTS_MSG(APTS_HELLO, (unsigned long *)psTxMsg);
+    wfaTrafficSendTo(psSockfd, (char *)psTxMsg, WMMPS_MSG_BUF_SIZE/2, (struct sockaddr *) &wmmps_info.psToAddr);
+    num_hello++;
+    wmmps_info.sta_state = 0;
+    wmmps_info.wait_state = WFA_WAIT_STAUT_00;
+    DPRINT_INFO(WFA_OUT, "wfaWmmpsSendHello: hello %d\n", num_hello);
+}
+
+/* deadline expired: either the next hello or the current send state fires */
+static void wfaWmmpsTimer(void)
+{
+    StationProcStatetbl_t *curr;
+    int prev;
+
+    if(wmmps_info.rcv_state <= 0)
+    {
+        if(num_hello >= MAXHELLO)
         {
-            sendThreadHandle = 0;
+            DPRINT_WARNING(WFA_WNG, "wfaWmmpsTimer: sent hello too many %d. Restart test script or dut/ca in STA\n", num_hello);
+            wmmps_info.resetWMMPS = 1;
+            WfaStaResetAll();
+            wfaSetDUTPwrMgmt(PS_OFF);
+            wfaWmmpsFinish();
+            return;
         }
-        pthread_mutex_lock(&wmmps_mutex_info.thr_flag_mutex);
-        DPRINT_INFO(WFA_OUT, "wfa_wmmps_thread::wait...\n");
-        pthread_cond_wait(&wmmps_mutex_info.thr_flag_cond,&wmmps_mutex_info.thr_flag_mutex);
-        pthread_mutex_unlock(&wmmps_mutex_info.thr_flag_mutex);
 
-        if(pthread_create(&sendThreadHandle, NULL, wfa_wmmps_send_thread, &wmmps_info))
+        wfaWmmpsSendHello();
+        wfaWmmpsArm(WFA_WMMPS_HELLO_PERIOD);
+        return;
+    }
+
+    curr = &stationProcStatetbl[wmmps_info.sta_test][state_num];
+    if(curr->statefunc == NULL)
+        return;
+
+    prev = state_num;
+    curr->statefunc(curr->pw_offon, curr->sleep_period, &state_num);
+    if(!wfaEngine.running)
+        return;
+
+    if(state_num != prev)
+        wfaWmmpsEnterState();
+    else
+        wfaWmmpsArm(curr->sleep_period);    /* repeating state, e.g. L.1 or STOP */
+}
+
+/* console packet: run the receive state table for the current test */
+static void wfaWmmpsRecv(void)
+{
+    StationRecvProcStatetbl_t func;
+    struct sockaddr from;
+    int len, rbytes, prevRcv;
+
+    while(psSockfd != -1)
+    {
+        len = sizeof(from);
+        rbytes = recvfrom(psSockfd, (char *)psRxMsg, WMMPS_MSG_BUF_SIZE-4, MSG_DONTWAIT, &from, (socklen_t *)&len);
+        if(rbytes <= 0)
+            break;
+
+        DPRINT_INFO(WFA_OUT, "wfaWmmpsRecv: sta_test=%d rbytes=%d rcv_state=%d rmsg[10]=%d\n",
+                    wmmps_info.sta_test, rbytes, wmmps_info.rcv_state, psRxMsg[10]);
+
+        wmmps_info.my_cookie = psRxMsg[0];
+        if(wmmps_info.sta_test != L_1)
+            mpx("RX msg", psRxMsg, 64);
+
+        if(psRxMsg[10] == APTS_STOP)
         {
-            DPRINT_INFO(WFA_OUT, "wfa_wmmps_thread::create sending thread failed\n");
-            return NULL;
+            if(wmmps_info.rcv_state > 0)
+            {
+                WfaRcvStop(psRxMsg, rbytes, &wmmps_info.rcv_state);
+                continue;
+            }
+
+            DPRINT_INFO(WFA_OUT, "wfaWmmpsRecv: stop before test case, ignored\n");
         }
-        //sendThreadHandle = CreateThread(NULL, 0, wfa_wmmps_send_thread, (PVOID)&wmmps_info, 0,&sendThreadId);
-        wSLEEP(1);
 
-        DPRINT_INFO(WFA_OUT, "wfa_wmmps_thread::run...gtgWmmPS=%d psSockfd=%d\n", gtgWmmPS, psSockfd);
-        while(gtgWmmPS>0)
+        if(psRxMsg[10] == APTS_RESET)
         {
+            reset_recd = 1;
+            WfaStaResetAll();
+            continue;
+        }
 
-            if(resetsnd)//When the testcase ends, WfaStaResetAll() sets the resetsnd to 1
-            {
-                //wfaWmmpsInitFlag();
-                DPRINT_INFO(WFA_OUT, "wfa_wmmps_thread::got resetsnd on, set off of it\n");
-                resetsnd = 0;
-            }
-            else
-            {
+        /* after a reset we sent, ignore everything until its response */
+        if(resetrcv)
+        {
+            if(!reset_recd && psRxMsg[10] != APTS_RESET_RESP)
+                continue;
+            resetrcv = 0;
+            reset_recd = 0;
+        }
 
-                /* then receive  */
-                if ( psSockfd > 0)
-                {
-                    memset( psRxMsg, 0, WMMPS_MSG_BUF_SIZE);
-                    rbytes = 0;
-                    rbytes=recvfrom(psSockfd,(char*)psRxMsg,WMMPS_MSG_BUF_SIZE-4,0,&from,(socklen_t *)&len);
-                }
-
-                if(rbytes>0) /*  only when we really get data from PC_Endpoint */
-                {
-                    DPRINT_INFO(WFA_OUT, "wfa_wmmps_thread::sta_test(tst case#)=%d rbytes=%d rcv_state=%d rmsg[10]=%d\n",sta_test, rbytes, wmmps_info.rcv_state, psRxMsg[10]);
-
-                    wmmps_info.my_cookie=psRxMsg[0];
-                    sta_test=wmmps_info.sta_test;
-                    if((sta_test!=L_1))
-                    {
-                        mpx("RX msg",psRxMsg,64);
-                    }
-                    if(psRxMsg[10]==APTS_STOP)
-                    {
-                        if ( wmmps_info.rcv_state > 0)
-                        {
-                            DPRINT_INFO(WFA_OUT, "\r\nwfa_wmmps_thread::stop rcv rcv_state=%d\n", (wmmps_info.rcv_state));
-                            resetsnd = 1; // by Qiuming word, benz, use STOP as super state to stop test case.
-                            WfaRcvStop(psRxMsg,rbytes,&(wmmps_info.rcv_state));
-                            rbytes =0;
-                            continue;
-                        }/* else will ignore */
-                        else
-                        {
-                            DPRINT_INFO(WFA_OUT, "\r\nwfa_wmmps_thread::stop rcv rcv_state=%d ERR\n", (wmmps_info.rcv_state));
-
-                        }
-
-                    }
-                    if(psRxMsg[10]==APTS_RESET)
-                    {
-                        reset_recd=1;
-                        DPRINT_INFO(WFA_OUT, "\r\nwfa_wmmps_thread:: rcv RESET call WfaStaResetAll\n");
-                        WfaStaResetAll();
-                        //return 0;  //aaron did
-                        rbytes = 0;
-                        continue;    // benz
-                    }
-
-                    rcvstatarray=stationRecvProcStatetbl[sta_test];//receive functions
-                    func=rcvstatarray[(wmmps_info.rcv_state)];
-                    if (func.statefunc != NULL)
-                    {
-                        DPRINT_INFO(WFA_OUT, "wfa_wmmps_thread:: call state func in state=%d\n",wmmps_info.rcv_state);
-                        func.statefunc(psRxMsg,rbytes, &(wmmps_info.rcv_state));
-                    }
-                    else
-                    {
-                        DPRINT_INFO(WFA_OUT, "wfa_wmmps_thread::Detected NULL func pt in rcv func table vcs_state=%d\n",wmmps_info.rcv_state);
-                    }
-                    rbytes=0;
-                }
-            }
+        if(wmmps_info.sta_test > LAST_TEST)
+            continue;
 
-            if(num_hello > MAXHELLO)
-            {
-                resetsnd=1;
-                DPRINT_INFO(WFA_OUT,"wfa_wmmps_thread::sent hello too many %d. Restart test script or dut/ca in STA\n", num_hello);
-                wmmps_info.resetWMMPS = 1;
-
-                WfaStaResetAll();
-                wCLOSE(psSockfd);
-                psSockfd = -1;
-                wfaSetDUTPwrMgmt(PS_OFF);
-                gtgWmmPS = 0; /* exit this internal loop */
-            }
-            wUSLEEP(100000);
+        func = stationRecvProcStatetbl[wmmps_info.sta_test][wmmps_info.rcv_state];
+        if(func.statefunc == NULL)
+        {
+            DPRINT_INFO(WFA_OUT, "wfaWmmpsRecv: no recv func in rcv_state=%d\n", wmmps_info.rcv_state);
+            continue;
+        }
 
-        }/* while(gtgWmmPS>0)  */
-    }/*  while loop */
-    return NULL;
-}/* wfa_wmmps_thread */
+        prevRcv = wmmps_info.rcv_state;
+        func.statefunc(psRxMsg, rbytes, &wmmps_info.rcv_state);
 
-void* wfa_wmmps_send_thread(void* input)
+        if(prevRcv == 0 && wmmps_info.rcv_state > 0 && wfaEngine.running)
+        {
+            /* test case named by the console, start the send states now */
+            clock_gettime(CLOCK_MONOTONIC, &wfaEngine.deadline);
+            wfaWmmpsEnterState();
+        }
+    }
+}
+
+/* start/stop requests posted by the traffic generator */
+static void wfaWmmpsControl(void)
 {
-    StationProcStatetbl_t *sendstate,curr_state;
-    tgProfile_t *pTGProfile = findTGProfile(wmmps_info.streamid);
-    int iOptVal=0, iOptLen =sizeof(int);
+    tgProfile_t *pTGProfile;
+    struct epoll_event ev;
+    int req, streamid;
+    struct sockaddr_in toAddr;
+
+    wPT_MUTEX_LOCK(&wfaEngine.mutex);
+    req = wfaEngine.req;
+    streamid = wfaEngine.reqStreamId;
+    toAddr = wfaEngine.reqToAddr;
+    wfaEngine.req = WFA_WMMPS_REQ_NONE;
+    wPT_MUTEX_UNLOCK(&wfaEngine.mutex);
+
+    if(req == WFA_WMMPS_REQ_NONE)
+        return;
+
+    if(wfaEngine.running)
+        wfaWmmpsFinish();
 
-    DPRINT_INFO(WFA_OUT,"wfa_wmmps_send_thread Start\n");
-    if ( pTGProfile == NULL)
+    if(req == WFA_WMMPS_REQ_STOP)
     {
-        DPRINT_INFO(WFA_OUT, "wfa_wmmps_send_thread: ERR TG frofile is NULL, exit\n");
-        return NULL;
+        wMEMSET(&wmmps_info, 0, sizeof(wfaWmmPS_t));
+        wfaSetDUTPwrMgmt(PS_OFF);
+        gtgPsPktRecvd = 0;
+
+        wPT_MUTEX_LOCK(&wfaEngine.mutex);
+        wPT_COND_SIGNAL(&wfaEngine.idleCond);
+        wPT_MUTEX_UNLOCK(&wfaEngine.mutex);
+        return;
     }
-    if (psSockfd > 0)
+
+    wfaWmmpsInitFlag();
+    wmmps_info.psToAddr = toAddr;
+    wmmps_info.streamid = streamid;
+    wmmps_info.stop_recvd = 0;
+
+    pTGProfile = findTGProfile(streamid);
+    if(pTGProfile == NULL)
     {
-        DPRINT_INFO(WFA_OUT, "wmmps_send_thread: WMMPS early socket not closed\n");
-        wCLOSE(psSockfd);
-        psSockfd = 0;
+        DPRINT_ERR(WFA_ERR, "wfaWmmpsControl: no profile for stream %d\n", streamid);
+        return;
     }
-    // send data only socket
-    //wfaCreateUDPSockWmmpsSend(pTGProfile->dipaddr);
 
-    // used for receive data and send hello only
+    /* used for receive data and send hello */
     psSockfd = wfaCreateUDPSock(pTGProfile->dipaddr, WFA_WMMPS_UDP_PORT);
-    if (psSockfd > 0)
+    if(psSockfd < 0)
     {
-        DPRINT_INFO(WFA_OUT, "wfaCreateUDPSock: WMMPS profile create UDP socket for RCV OK psSockfd=%d\n", psSockfd);
-    }
-    else
-    {
-        DPRINT_INFO(WFA_OUT, "wfaCreateUDPSock: WMMPS profile create UDP RCV socket failed\n");
+        DPRINT_ERR(WFA_ERR, "wfaWmmpsControl: create UDP socket failed\n");
+        psSockfd = -1;
+        return;
     }
 
-    if (getsockopt(psSockfd, SOL_SOCKET, SO_SNDBUF, (char*)&iOptVal, (socklen_t *)&iOptLen) == 0)
+    wMEMSET(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = psSockfd;
+    if(epoll_ctl(wfaEngine.epfd, EPOLL_CTL_ADD, psSockfd, &ev) != 0)
     {
-        DPRINT_INFO(WFA_OUT, "wfa_wmmps_send_thread:: get SO_SNDBUF Value=%d\n", iOptVal);
+        DPRINT_ERR(WFA_ERR, "wfaWmmpsControl: epoll add failed %i\n", errno);
+        wCLOSE(psSockfd);
+        psSockfd = -1;
+        return;
     }
 
-    wSLEEP(1);
-    while(gtgWmmPS>0 && psSockfd>0)
+    gtgWmmPS = streamid;
+    wPT_MUTEX_LOCK(&wfaEngine.mutex);
+    wfaEngine.running = 1;
+    wPT_MUTEX_UNLOCK(&wfaEngine.mutex);
+
+    DPRINT_INFO(WFA_OUT, "wfaWmmpsControl: start stream %d psSockfd=%d\n", streamid, psSockfd);
+
+    /* hello right away, then once per period until the console answers */
+    wfaWmmpsSendHello();
+    clock_gettime(CLOCK_MONOTONIC, &wfaEngine.deadline);
+    wfaWmmpsArm(WFA_WMMPS_HELLO_PERIOD);
+}
+
+/*
+ * wfa_wmmps_thread(): the WMM-PS station event loop. All the state of a
+ *                     test case is only touched here; other threads post
+ *                     requests through wfaWmmpsStart()/wfaWmmpsStop().
+ */
+void* wfa_wmmps_thread(void* input)
+{
+    struct epoll_event evs[4];
+    unsigned long long cnt;
+    int i, n;
+
+    for(;;)
     {
-        if (wmmps_info.rcv_state > 0)/*  check state forwarded */
+        n = epoll_wait(wfaEngine.epfd, evs, 4, -1);
+        if(n < 0)
         {
-            DPRINT_INFO(WFA_OUT,"1-send state_num=%d sta_test=%d\n",state_num, wmmps_info.sta_test);
-            sendstate =  stationProcStatetbl[wmmps_info.sta_test];
-            curr_state = sendstate[state_num];
-            if ( curr_state.statefunc != NULL)
+            if(errno == EINTR)
+                continue;
+            DPRINT_ERR(WFA_ERR, "wfa_wmmps_thread: epoll_wait failed %i\n", errno);
+            break;
+        }
+
+        for(i = 0; i < n; i++)
+        {
+            if(evs[i].data.fd == wfaEngine.kickfd)
             {
-                curr_state.statefunc(curr_state.pw_offon,curr_state.sleep_period,&(state_num));//send functions
-                //DPRINT_INFOL(WFA_OUT,"2-send state_num=%d sta_test=%d\n",state_num, wmmps_info.sta_test);
+                if(read(wfaEngine.kickfd, &cnt, sizeof(cnt)) == sizeof(cnt))
+                    wfaWmmpsControl();
             }
-            else
+            else if(evs[i].data.fd == wfaEngine.tmrfd)
             {
-                // nothing to do.
-
-                DPRINT_INFO(WFA_OUT, "wfa_wmmps_send_thread, state Func is NULL, exit loop\n");
-                break;
+                if(read(wfaEngine.tmrfd, &cnt, sizeof(cnt)) == sizeof(cnt) && wfaEngine.running)
+                    wfaWmmpsTimer();
             }
-        }
-        else
-        {
-            /* For WMM-Power Save
-            * periodically send HELLO to Console for initial setup if not rcv pkt from PCE as rcv_state==0.
-            */
-            if((psSockfd != -1) && (num_hello <= MAXHELLO) && (wmmps_info.rcv_state <=0))
+            else if(psSockfd != -1 && evs[i].data.fd == psSockfd)
             {
-                //wfaSetDUTPwrMgmt(P_OFF); /* added for hello begin */
-                memset( psTxMsg, 0, WMMPS_MSG_BUF_SIZE);
-                BUILD_APTS_MSG(APTS_HELLO, (unsigned long *)psTxMsg);
-                wfaTrafficSendTo(psSockfd, (char *)psTxMsg, WMMPS_MSG_BUF_SIZE/2, (struct sockaddr *) &wmmps_info.psToAddr);
-                num_hello++;
-                DPRINT_INFO(WFA_OUT,"wmmps_send_thread::sent hello \n");
-                wmmps_info.sta_state = 0;
-                wmmps_info.wait_state = WFA_WAIT_STAUT_00;
-                wSLEEP(1);
+                wfaWmmpsRecv();
             }
-
-        }
-        if (wmmps_info.resetWMMPS == 1)
-        {
-            DPRINT_WARNING(WFA_OUT,"wfa_wmmps_send_thread end with resetWMMPS on\n");
-            break;
         }
-    }/*  while(gtgWmmPS>0 && psSockfd>0)  */
+    }
 
-    wSLEEP(1);
-    DPRINT_INFO(WFA_OUT,"wfa_wmmps_send_thread end\n");
     return NULL;
 }
 
+static int wfaWmmpsKick(void)
+{
+    unsigned long long one = 1;
+
+    return (write(wfaEngine.kickfd, &one, sizeof(one)) == sizeof(one)) ? WFA_SUCCESS : WFA_FAILURE;
+}
+
+/*
+ * wfaWmmpsInit(): set up the epoll set and start the WMM-PS event loop.
+ */
+int wfaWmmpsInit(void)
+{
+    struct epoll_event ev;
+
+    wMEMSET(&wfaEngine, 0, sizeof(wfaEngine));
+    wPT_MUTEX_INIT(&wfaEngine.mutex, NULL);
+    wPT_COND_INIT(&wfaEngine.idleCond, NULL);
+
+    wfaEngine.epfd = epoll_create1(EPOLL_CLOEXEC);
+    wfaEngine.kickfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    wfaEngine.tmrfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if(wfaEngine.epfd < 0 || wfaEngine.kickfd < 0 || wfaEngine.tmrfd < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "wfaWmmpsInit: epoll/eventfd/timerfd failed %i\n", errno);
+        return WFA_FAILURE;
+    }
+
+    wMEMSET(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = wfaEngine.kickfd;
+    epoll_ctl(wfaEngine.epfd, EPOLL_CTL_ADD, wfaEngine.kickfd, &ev);
+    ev.data.fd = wfaEngine.tmrfd;
+    epoll_ctl(wfaEngine.epfd, EPOLL_CTL_ADD, wfaEngine.tmrfd, &ev);
+
+    if(wPT_CREATE(&wfaEngine.thr, NULL, wfa_wmmps_thread, NULL) != 0)
+    {
+        DPRINT_ERR(WFA_ERR, "wfaWmmpsInit: create thread failed\n");
+        return WFA_FAILURE;
+    }
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaWmmpsStart(): ask the event loop to run a test case against the
+ *                  console at toAddr.
+ */
+int wfaWmmpsStart(int streamid, struct sockaddr_in *toAddr)
+{
+    wPT_MUTEX_LOCK(&wfaEngine.mutex);
+    wfaEngine.req = WFA_WMMPS_REQ_START;
+    wfaEngine.reqStreamId = streamid;
+    wfaEngine.reqToAddr = *toAddr;
+    wPT_MUTEX_UNLOCK(&wfaEngine.mutex);
+
+    return wfaWmmpsKick();
+}
+
+/*
+ * wfaWmmpsStop(): stop any running test case and wait, bounded, until the
+ *                 event loop has released the socket and power save.
+ */
+void wfaWmmpsStop(void)
+{
+    struct timespec until;
+
+    if(wfaEngine.kickfd < 0)
+        return;
+
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += WFA_WMMPS_STOP_WAIT;
+
+    wPT_MUTEX_LOCK(&wfaEngine.mutex);
+    wfaEngine.req = WFA_WMMPS_REQ_STOP;
+    if(wfaWmmpsKick() == WFA_SUCCESS)
+    {
+        while(wfaEngine.req != WFA_WMMPS_REQ_NONE || wfaEngine.running)
+        {
+            if(pthread_cond_timedwait(&wfaEngine.idleCond, &wfaEngine.mutex, &until) != 0)
+            {
+                DPRINT_WARNING(WFA_WNG, "wfaWmmpsStop: event loop did not stop in time\n");
+                break;
+            }
+        }
+    }
+    wPT_MUTEX_UNLOCK(&wfaEngine.mutex);
+}
+
 #endif /* WFA_WMM_PS_EXT */
 
 
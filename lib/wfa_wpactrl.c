@@ -0,0 +1,726 @@
+/****************************************************************************
+*
+* Copyright (c) 2016 Wi-Fi Alliance
+*
+* Permission to use, copy, modify, and/or distribute this software for any
+* purpose with or without fee is hereby granted, provided that the above
+* copyright notice and this permission notice appear in all copies.
+*
+* THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+* WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+* MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+* SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+* RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+* NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+* USE OR PERFORMANCE OF THIS SOFTWARE.
+*
+*****************************************************************************/
+
+/*
+ * File: wfa_wpactrl.c - wpa_supplicant control interface client.
+ *       The supplicant listens on a UNIX datagram socket per interface
+ *       and answers each request to the address it came from. The DUT
+ *       keeps one socket per interface open and talks to it directly, a
+ *       command is one round trip instead of a wpa_cli process. A second
+ *       socket, attached on first use, receives the unsolicited events.
+ *       A supplicant that restarted is reconnected on the next request.
+ *       A transaction sends the settings of a command back to back and
+ *       puts the old values back if one of them is refused.
+ */
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "wfa_portall.h"
+#include "wfa_stdincs.h"
+#include "wfa_debug.h"
+#include "wfa_main.h"
+#include "wfa_types.h"
+#include "wfa_wpactrl.h"
+
+extern unsigned short wfa_defined_debug;
+
+/* the table and the sockets are shared by the command workers */
+static pthread_mutex_t wpaMutex = PTHREAD_MUTEX_INITIALIZER;
+static wfaWpaConn_t wpaConns[WFA_WPA_MAX_IFS];
+static int wpaInited = 0;
+static unsigned int wpaSockSeq = 0;
+
+static void wfaWpaSockClose(int *fd, char *path)
+{
+    if(*fd != -1)
+    {
+        close(*fd);
+        *fd = -1;
+    }
+
+    if(path[0] != '\0')
+    {
+        unlink(path);
+        path[0] = '\0';
+    }
+}
+
+/*
+ * wfaWpaSockOpen(): a datagram socket bound to its own path and
+ *                   connected to the supplicant's socket of ifname.
+ * return:  the socket or -1
+ */
+static int wfaWpaSockOpen(char *ifname, char *path, int pathSz)
+{
+    struct sockaddr_un local, dest;
+    char *dir;
+    int fd;
+
+    if((dir = getenv(WFA_ENV_WPA_CTRL_DIR)) == NULL)
+        dir = WFA_WPA_CTRL_DIR;
+
+    if((fd = socket(PF_UNIX, SOCK_DGRAM, 0)) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "wpa ctrl socket() failed: %i\n", errno);
+        return -1;
+    }
+
+    wMEMSET(&local, 0, sizeof(local));
+    local.sun_family = AF_UNIX;
+    snprintf(local.sun_path, sizeof(local.sun_path), "%s/wfa_wpa_%i-%u",
+             WFA_WPA_CLIENT_DIR, (int)getpid(), ++wpaSockSeq);
+    unlink(local.sun_path);
+
+    wMEMSET(&dest, 0, sizeof(dest));
+    dest.sun_family = AF_UNIX;
+    snprintf(dest.sun_path, sizeof(dest.sun_path), "%s/%s", dir, ifname);
+
+    if(bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0)
+    {
+        DPRINT_ERR(WFA_ERR, "wpa ctrl bind(%s) failed: %i\n", local.sun_path, errno);
+        close(fd);
+        return -1;
+    }
+
+    if(connect(fd, (struct sockaddr *)&dest, sizeof(dest)) < 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "wpa ctrl connect(%s) failed: %i\n", dest.sun_path, errno);
+        close(fd);
+        unlink(local.sun_path);
+        return -1;
+    }
+
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    snprintf(path, pathSz, "%s", local.sun_path);
+
+    return fd;
+}
+
+/*
+ * wfaWpaConnGet(): the connection of ifname, opened if it is not yet.
+ *                  wpaMutex held.
+ */
+static wfaWpaConn_t *wfaWpaConnGet(char *ifname)
+{
+    wfaWpaConn_t *conn = NULL;
+    int i;
+
+    if(ifname == NULL || ifname[0] == '\0')
+        return NULL;
+
+    if(!wpaInited)
+    {
+        for(i = 0; i < WFA_WPA_MAX_IFS; i++)
+        {
+            wpaConns[i].reqFd = -1;
+            wpaConns[i].evFd = -1;
+        }
+        wpaInited = 1;
+    }
+
+    for(i = 0; i < WFA_WPA_MAX_IFS && conn == NULL; i++)
+    {
+        if(strncmp(wpaConns[i].ifname, ifname, WFA_IF_NAME_LEN) == 0)
+            conn = &wpaConns[i];
+    }
+
+    for(i = 0; i < WFA_WPA_MAX_IFS && conn == NULL; i++)
+    {
+        if(wpaConns[i].ifname[0] == '\0')
+        {
+            conn = &wpaConns[i];
+            wSTRNCPY(conn->ifname, ifname, WFA_IF_NAME_LEN - 1);
+            conn->ifname[WFA_IF_NAME_LEN - 1] = '\0';
+        }
+    }
+
+    if(conn == NULL)
+    {
+        DPRINT_ERR(WFA_ERR, "wpa ctrl: more than %i interfaces\n", WFA_WPA_MAX_IFS);
+        return NULL;
+    }
+
+    if(conn->reqFd == -1)
+        conn->reqFd = wfaWpaSockOpen(conn->ifname, conn->reqPath, sizeof(conn->reqPath));
+
+    return (conn->reqFd != -1) ? conn : NULL;
+}
+
+/*
+ * wfaWpaRecv(): wait for one datagram.
+ * return:  its length, 0 on timeout, -1 on error
+ */
+static int wfaWpaRecv(int fd, char *buf, int bufSz, int tmoutMs)
+{
+    struct pollfd pfd;
+    int n;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    do
+    {
+        n = poll(&pfd, 1, tmoutMs);
+    } while(n < 0 && errno == EINTR);
+
+    if(n <= 0)
+        return n;
+
+    n = recv(fd, buf, bufSz - 1, 0);
+    if(n < 0)
+        return -1;
+
+    buf[n] = '\0';
+    return n;
+}
+
+/*
+ * wfaWpaExchange(): one request and its reply on the request socket.
+ *                   wpaMutex held.
+ * return:  reply length, or -1
+ */
+static int wfaWpaExchange(wfaWpaConn_t *conn, char *cmd, int cmdLen, char *reply, int replySz)
+{
+    char stale[WFA_BUFF_128];
+    int n;
+
+    /* a reply that came after its request timed out is not this one's */
+    while(recv(conn->reqFd, stale, sizeof(stale), MSG_DONTWAIT) > 0)
+        ;
+
+    if(send(conn->reqFd, cmd, cmdLen, 0) != cmdLen)
+        return -1;
+
+    for(;;)
+    {
+        n = wfaWpaRecv(conn->reqFd, reply, replySz, WFA_WPA_TMOUT_MS);
+        if(n <= 0)
+        {
+            /* the command name only, the values may be keys */
+            DPRINT_WARNING(WFA_WNG, "wpa ctrl %s: no reply to %.*s\n", conn->ifname, (int)strcspn(cmd, " "), cmd);
+            return -1;
+        }
+
+        /* events are for the attached socket, not a reply */
+        if(reply[0] != '<')
+            return n;
+    }
+}
+
+/*
+ * wfaWpaVRequest(): send a request to the supplicant of ifname.
+ * return:  reply length, or -1
+ */
+static int wfaWpaVRequest(char *ifname, char *reply, int replySz, const char *fmt, va_list ap)
+{
+    char cmd[WFA_CMD_STR_SZ];
+    wfaWpaConn_t *conn;
+    int cmdLen, n = -1;
+
+    cmdLen = vsnprintf(cmd, sizeof(cmd), fmt, ap);
+    if(cmdLen < 0 || cmdLen >= (int)sizeof(cmd))
+    {
+        DPRINT_ERR(WFA_ERR, "wpa ctrl request too long\n");
+        return -1;
+    }
+
+    wPT_MUTEX_LOCK(&wpaMutex);
+    if((conn = wfaWpaConnGet(ifname)) != NULL)
+    {
+        n = wfaWpaExchange(conn, cmd, cmdLen, reply, replySz);
+        if(n < 0)
+        {
+            /* the supplicant may have restarted, its socket is new */
+            wfaWpaSockClose(&conn->reqFd, conn->reqPath);
+            wfaWpaSockClose(&conn->evFd, conn->evPath);
+            if((conn = wfaWpaConnGet(ifname)) != NULL)
+                n = wfaWpaExchange(conn, cmd, cmdLen, reply, replySz);
+        }
+    }
+    wPT_MUTEX_UNLOCK(&wpaMutex);
+
+    /* the command name only, the values may be keys */
+    DPRINT_INFO(WFA_OUT, "wpa ctrl %s: %.*s, reply %i bytes\n", ifname, (int)strcspn(cmd, " "), cmd, n);
+
+    return n;
+}
+
+/*
+ * wfaWpaRequest(): send a request, e.g. "STATUS", and get the reply.
+ * output:  reply -- zero terminated
+ * return:  reply length, or -1 if the supplicant could not be reached
+ */
+int wfaWpaRequest(char *ifname, char *reply, int replySz, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = wfaWpaVRequest(ifname, reply, replySz, fmt, ap);
+    va_end(ap);
+
+    return n;
+}
+
+/*
+ * wfaWpaCmd(): a request answered with OK or FAIL.
+ * return:  WFA_SUCCESS on OK
+ */
+int wfaWpaCmd(char *ifname, const char *fmt, ...)
+{
+    char reply[WFA_BUFF_128];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = wfaWpaVRequest(ifname, reply, sizeof(reply), fmt, ap);
+    va_end(ap);
+
+    if(n < 2 || strncmp(reply, "OK", 2) != 0)
+        return WFA_FAILURE;
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaWpaSetNetwork(): set one variable of a configured network. A string
+ *                     value is given with its quotes, e.g. "\"%s\"".
+ * return:  WFA_SUCCESS on OK
+ */
+int wfaWpaSetNetwork(char *ifname, int netId, char *var, const char *fmt, ...)
+{
+    char value[WFA_CMD_STR_SZ];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(value, sizeof(value), fmt, ap);
+    va_end(ap);
+
+    if(wfaWpaCmd(ifname, "SET_NETWORK %i %s %s", netId, var, value) != WFA_SUCCESS)
+    {
+        DPRINT_WARNING(WFA_WNG, "wpa ctrl %s: network %i %s not set\n", ifname, netId, var);
+        return WFA_FAILURE;
+    }
+
+    return WFA_SUCCESS;
+}
+
+/*
+ * wfaWpaStatusGet(): one field of the STATUS reply, e.g. wpa_state.
+ * return:  WFA_SUCCESS if the field is there
+ */
+int wfaWpaStatusGet(char *ifname, char *key, char *val, int valSz)
+{
+    char reply[WFA_WPA_REPLY_SZ];
+
+    if(wfaWpaRequest(ifname, reply, sizeof(reply), "STATUS") <= 0)
+        return WFA_FAILURE;
+
+    return wfaWpaStatusField(reply, key, val, valSz);
+}
+
+/*
+ * wfaWpaStatusField(): one field of a STATUS reply already received,
+ *                      the reply is left as it is.
+ * return:  WFA_SUCCESS if the field is there
+ */
+int wfaWpaStatusField(char *status, char *key, char *val, int valSz)
+{
+    char *line = status;
+    int keyLen = strlen(key);
+
+    while(line != NULL && *line != '\0')
+    {
+        if(strncmp(line, key, keyLen) == 0 && line[keyLen] == '=')
+        {
+            snprintf(val, valSz, "%.*s", (int)strcspn(line + keyLen + 1, "\n"), line + keyLen + 1);
+            return WFA_SUCCESS;
+        }
+
+        if((line = strchr(line, '\n')) != NULL)
+            line++;
+    }
+
+    return WFA_FAILURE;
+}
+
+/*
+ * wfaWpaAttach(): open the event socket of conn if it is not yet.
+ *                 wpaMutex held.
+ */
+static void wfaWpaAttach(wfaWpaConn_t *conn)
+{
+    char reply[WFA_BUFF_32];
+
+    if(conn->evFd != -1)
+        return;
+
+    conn->evFd = wfaWpaSockOpen(conn->ifname, conn->evPath, sizeof(conn->evPath));
+    if(conn->evFd == -1)
+        return;
+
+    if(send(conn->evFd, "ATTACH", 6, 0) != 6 ||
+            wfaWpaRecv(conn->evFd, reply, sizeof(reply), WFA_WPA_TMOUT_MS) < 2 ||
+            strncmp(reply, "OK", 2) != 0)
+    {
+        DPRINT_WARNING(WFA_WNG, "wpa ctrl %s: attach failed\n", conn->ifname);
+        wfaWpaSockClose(&conn->evFd, conn->evPath);
+        return;
+    }
+
+    conn->evSeq++;
+}
+
+/*
+ * wfaWpaEventFd(): the event socket of ifname, attached first if asked
+ *                  to, for a caller that polls it together with others.
+ *                  evSeq changes with every attach, events may have been
+ *                  lost in between.
+ * return:  the socket, or -1 if not attached
+ */
+int wfaWpaEventFd(char *ifname, int attach, unsigned int *evSeq)
+{
+    wfaWpaConn_t *conn = NULL;
+    int i, fd = -1;
+
+    wPT_MUTEX_LOCK(&wpaMutex);
+    if(attach && (conn = wfaWpaConnGet(ifname)) != NULL)
+        wfaWpaAttach(conn);
+
+    for(i = 0; i < WFA_WPA_MAX_IFS && wpaInited && conn == NULL; i++)
+    {
+        if(strncmp(wpaConns[i].ifname, ifname, WFA_IF_NAME_LEN) == 0)
+            conn = &wpaConns[i];
+    }
+
+    if(conn != NULL)
+    {
+        fd = conn->evFd;
+        if(evSeq != NULL)
+            *evSeq = conn->evSeq;
+    }
+    wPT_MUTEX_UNLOCK(&wpaMutex);
+
+    return fd;
+}
+
+/*
+ * wfaWpaEventRecv(): the next unsolicited event of ifname, without its
+ *                    <level> prefix. The event socket is attached on the
+ *                    first call, the events queue there from then on.
+ * return:  event length, 0 on timeout, -1 on error
+ */
+int wfaWpaEventRecv(char *ifname, char *buf, int bufSz, int tmoutMs)
+{
+    wfaWpaConn_t *conn;
+    char *ev;
+    int fd, n;
+
+    wPT_MUTEX_LOCK(&wpaMutex);
+    conn = wfaWpaConnGet(ifname);
+    if(conn != NULL)
+        wfaWpaAttach(conn);
+    fd = (conn != NULL) ? conn->evFd : -1;
+    wPT_MUTEX_UNLOCK(&wpaMutex);
+
+    if(fd == -1)
+        return -1;
+
+    /* only the caller waiting for events reads this socket */
+    n = wfaWpaRecv(fd, buf, bufSz, tmoutMs);
+    if(n <= 0)
+        return n;
+
+    ev = buf;
+    if(ev[0] == '<' && (ev = strchr(buf, '>')) != NULL)
+    {
+        ev++;
+        n -= ev - buf;
+        wMEMMOVE(buf, ev, n + 1);
+    }
+
+    return n;
+}
+
+/*
+ * wfaWpaClose(): drop the sockets of ifname, e.g. before the supplicant
+ *                is restarted.
+ */
+void wfaWpaClose(char *ifname)
+{
+    int i;
+
+    wPT_MUTEX_LOCK(&wpaMutex);
+    for(i = 0; i < WFA_WPA_MAX_IFS && wpaInited; i++)
+    {
+        if(strncmp(wpaConns[i].ifname, ifname, WFA_IF_NAME_LEN) == 0)
+        {
+            if(wpaConns[i].evFd != -1)
+                send(wpaConns[i].evFd, "DETACH", 6, 0);
+
+            wfaWpaSockClose(&wpaConns[i].reqFd, wpaConns[i].reqPath);
+            wfaWpaSockClose(&wpaConns[i].evFd, wpaConns[i].evPath);
+            wpaConns[i].ifname[0] = '\0';
+        }
+    }
+    wPT_MUTEX_UNLOCK(&wpaMutex);
+}
+
+/*
+ * wfaWpaTxnBegin(): start collecting the requests of a command for the
+ *                   network netId of ifname.
+ */
+void wfaWpaTxnBegin(wfaWpaTxn_t *txn, char *ifname, int netId)
+{
+    snprintf(txn->ifname, sizeof(txn->ifname), "%s", ifname);
+    txn->netId = netId;
+    txn->num = 0;
+    txn->used = 0;
+    txn->overflow = 0;
+}
+
+static int wfaWpaTxnVAdd(wfaWpaTxn_t *txn, char *var, const char *fmt, va_list ap)
+{
+    wfaWpaTxnReq_t *req;
+    int n, room = sizeof(txn->buf) - txn->used;
+
+    if(txn->num == WFA_WPA_TXN_MAX)
+    {
+        txn->overflow = 1;
+        return WFA_FAILURE;
+    }
+
+    n = vsnprintf(txn->buf + txn->used, room, fmt, ap);
+    if(n < 0 || n >= room || n >= WFA_CMD_STR_SZ)
+    {
+        txn->overflow = 1;
+        return WFA_FAILURE;
+    }
+
+    req = &txn->reqs[txn->num++];
+    req->off = txn->used;
+    req->len = n;
+    snprintf(req->var, sizeof(req->var), "%s", var);
+    txn->used += n + 1;
+
+    return WFA_SUCCESS;
+}
+
+static int wfaWpaTxnAdd(wfaWpaTxn_t *txn, char *var, const char *fmt, ...)
+{
+    va_list ap;
+    int ret;
+
+    va_start(ap, fmt);
+    ret = wfaWpaTxnVAdd(txn, var, fmt, ap);
+    va_end(ap);
+
+    return ret;
+}
+
+/*
+ * wfaWpaTxnSet(): queue SET_NETWORK of var, put back if the commit fails.
+ */
+int wfaWpaTxnSet(wfaWpaTxn_t *txn, char *var, const char *fmt, ...)
+{
+    char value[WFA_CMD_STR_SZ];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(value, sizeof(value), fmt, ap);
+    va_end(ap);
+
+    return wfaWpaTxnAdd(txn, var, "SET_NETWORK %i %s %s", txn->netId, var, value);
+}
+
+/*
+ * wfaWpaTxnCmd(): queue any other request answered with OK, e.g.
+ *                 "ENABLE_NETWORK 0".
+ */
+int wfaWpaTxnCmd(wfaWpaTxn_t *txn, const char *fmt, ...)
+{
+    va_list ap;
+    int ret;
+
+    va_start(ap, fmt);
+    ret = wfaWpaTxnVAdd(txn, "", fmt, ap);
+    va_end(ap);
+
+    return ret;
+}
+
+/*
+ * wfaWpaPipeline(): send the requests of txn with up to WFA_WPA_TXN_WINDOW
+ *                   of them in flight. The supplicant answers in order,
+ *                   reply i goes to replies + i * replySz. If checked, a
+ *                   reply other than OK stops the sending, and a request
+ *                   that sets nothing, e.g. ENABLE_NETWORK, waits for the
+ *                   replies before it. wpaMutex held.
+ * return:  how many replies came, fewer than txn->num on a timeout or
+ *          after a refusal
+ */
+static int wfaWpaPipeline(wfaWpaConn_t *conn, wfaWpaTxn_t *txn, char *replies, int replySz, int checked)
+{
+    char stale[WFA_BUFF_128];
+    wfaWpaTxnReq_t *req;
+    char *reply;
+    int sent = 0, got = 0, refused = 0, n;
+
+    while(recv(conn->reqFd, stale, sizeof(stale), MSG_DONTWAIT) > 0)
+        ;
+
+    while(got < sent || (sent < txn->num && !refused))
+    {
+        for(; !refused && sent < txn->num && sent - got < WFA_WPA_TXN_WINDOW; sent++)
+        {
+            req = &txn->reqs[sent];
+            if(checked && req->var[0] == '\0' && sent > got)
+                break;
+
+            if(send(conn->reqFd, txn->buf + req->off, req->len, 0) != req->len)
+                return got;
+        }
+
+        reply = replies + got * replySz;
+        n = wfaWpaRecv(conn->reqFd, reply, replySz, WFA_WPA_TMOUT_MS);
+        if(n <= 0)
+        {
+            DPRINT_WARNING(WFA_WNG, "wpa ctrl %s: no reply to request %i of %i\n", conn->ifname, got + 1, txn->num);
+            return got;
+        }
+
+        if(reply[0] == '<')
+            continue;
+
+        if(checked && strncmp(reply, "OK", 2) != 0)
+            refused = 1;
+        got++;
+    }
+
+    return got;
+}
+
+/*
+ * wfaWpaTxnCommit(): send the collected requests. The variables they set
+ *                    are read first; if a request is refused, they are
+ *                    put back and the network is enabled again as it
+ *                    was. A key the supplicant does not show, or a
+ *                    variable that was not set, cannot be put back, the
+ *                    network is then left disabled.
+ * return:  WFA_SUCCESS if every request was answered with OK
+ */
+int wfaWpaTxnCommit(wfaWpaTxn_t *txn)
+{
+    wfaWpaTxn_t undo, back;
+    char old[WFA_WPA_TXN_MAX][WFA_BUFF_128];
+    char reply[WFA_WPA_TXN_MAX][WFA_BUFF_32];
+    wfaWpaConn_t *conn;
+    int i, j, done, lost = 0, ret = WFA_FAILURE;
+
+    if(txn->overflow)
+    {
+        DPRINT_ERR(WFA_ERR, "wpa ctrl %s: transaction too large\n", txn->ifname);
+        return WFA_FAILURE;
+    }
+
+    /* the old values, and whether the network was enabled */
+    wfaWpaTxnBegin(&undo, txn->ifname, txn->netId);
+    for(i = 0; i < txn->num; i++)
+    {
+        if(txn->reqs[i].var[0] == '\0')
+            continue;
+
+        for(j = 0; j < undo.num && strcmp(undo.reqs[j].var, txn->reqs[i].var) != 0; j++)
+            ;
+        if(j == undo.num)
+            wfaWpaTxnAdd(&undo, txn->reqs[i].var, "GET_NETWORK %i %s", txn->netId, txn->reqs[i].var);
+    }
+    wfaWpaTxnAdd(&undo, "disabled", "GET_NETWORK %i disabled", txn->netId);
+    if(undo.overflow)
+    {
+        DPRINT_ERR(WFA_ERR, "wpa ctrl %s: transaction too large\n", txn->ifname);
+        return WFA_FAILURE;
+    }
+
+    wPT_MUTEX_LOCK(&wpaMutex);
+    conn = wfaWpaConnGet(txn->ifname);
+    if(conn != NULL && wfaWpaPipeline(conn, &undo, old[0], sizeof(old[0]), 0) != undo.num)
+    {
+        /* the supplicant may have restarted, its socket is new */
+        wfaWpaSockClose(&conn->reqFd, conn->reqPath);
+        wfaWpaSockClose(&conn->evFd, conn->evPath);
+        if((conn = wfaWpaConnGet(txn->ifname)) != NULL &&
+                wfaWpaPipeline(conn, &undo, old[0], sizeof(old[0]), 0) != undo.num)
+            conn = NULL;
+    }
+
+    if(conn == NULL)
+    {
+        wPT_MUTEX_UNLOCK(&wpaMutex);
+        DPRINT_WARNING(WFA_WNG, "wpa ctrl %s: transaction not sent\n", txn->ifname);
+        return WFA_FAILURE;
+    }
+
+    done = wfaWpaPipeline(conn, txn, reply[0], sizeof(reply[0]), 1);
+    for(i = 0; i < done && strncmp(reply[i], "OK", 2) == 0; i++)
+        ;
+
+    if(i == txn->num)
+    {
+        ret = WFA_SUCCESS;
+    }
+    else
+    {
+        wfaWpaTxnBegin(&back, txn->ifname, txn->netId);
+        for(j = 0; j < undo.num - 1; j++)
+        {
+            if(strncmp(old[j], "FAIL", 4) == 0 || strcmp(old[j], "*") == 0 ||
+                    strlen(old[j]) >= sizeof(old[j]) - 1)
+            {
+                lost++;
+                continue;
+            }
+
+            wfaWpaTxnAdd(&back, undo.reqs[j].var, "SET_NETWORK %i %s %s", txn->netId, undo.reqs[j].var, old[j]);
+        }
+
+        if(lost == 0 && strcmp(old[undo.num - 1], "0") == 0)
+            wfaWpaTxnAdd(&back, "", "ENABLE_NETWORK %i", txn->netId);
+        else
+            wfaWpaTxnAdd(&back, "", "DISABLE_NETWORK %i", txn->netId);
+
+        wfaWpaPipeline(conn, &back, reply[0], sizeof(reply[0]), 0);
+    }
+    wPT_MUTEX_UNLOCK(&wpaMutex);
+
+    if(ret != WFA_SUCCESS)
+    {
+        /* the command name and variable only, the values may be keys */
+        DPRINT_WARNING(WFA_WNG, "wpa ctrl %s: request %i %.*s %s refused, rolled back, %i not restorable\n",
+                       txn->ifname, i + 1, (int)strcspn(txn->buf + txn->reqs[i].off, " "),
+                       txn->buf + txn->reqs[i].off, txn->reqs[i].var, lost);
+    }
+    else
+    {
+        DPRINT_INFO(WFA_OUT, "wpa ctrl %s: %i requests in one transaction\n", txn->ifname, txn->num);
+    }
+
+    return ret;
+}
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2016 Wi-Fi Alliance
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted, provided that the above
+# copyright notice and this permission notice appear in all copies.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+# NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+# USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+
+#
+# test_ctrl.py - the control link: a command the DUT cannot decode and
+#   a traffic command refused by the DUT both reach the test manager as
+#   a failure, never as an empty COMPLETE.
+#
+
+import os
+import shutil
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+
+import wfa_mock
+
+# wfa_tlv.h and wfa_types.h
+TRAFFIC_AGENT_SEND = 5
+TRAFFIC_AGENT_RECV_STOP = 7
+STATUS_INVALID = 2
+STATUS_ERROR = 3
+
+# port of the mock DUT the control agent is pointed at
+MOCK_DUT_PORT = wfa_mock.DUT_PORT + 1
+
+
+def frame(reqId, tlv):
+    """wfaCtrlHdr_t, then the TLV"""
+    return struct.pack('!HHI', reqId, 0, len(tlv)) + tlv
+
+
+def tlv(tag, value, claim=None):
+    """a TLV, claim is the length written in its header"""
+    return struct.pack('=HH', tag, len(value) if claim is None else claim) + value
+
+
+def recvFrame(sock):
+    hdr = recvAll(sock, 8)
+    reqId, flags, n = struct.unpack('!HHI', hdr)
+    return reqId, recvAll(sock, n)
+
+
+def recvAll(sock, n):
+    data = b''
+    while len(data) < n:
+        more = sock.recv(n - len(data))
+        if not more:
+            raise RuntimeError('link closed')
+        data += more
+    return data
+
+
+class MockDut(object):
+    """answers each command with a status word alone, on tag or its own"""
+
+    def __init__(self, port, tag, status):
+        self.tag = tag
+        self.status = status
+        self.lsock = socket.socket()
+        self.lsock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.lsock.bind(('127.0.0.1', port))
+        self.lsock.listen(1)
+        self.thr = threading.Thread(target=self.serve)
+        self.thr.daemon = True
+        self.thr.start()
+
+    def serve(self):
+        try:
+            conn, addr = self.lsock.accept()
+            while True:
+                reqId, cmd = recvFrame(conn)
+                tag = struct.unpack('=H', cmd[:2])[0] if self.tag is None else self.tag
+                conn.sendall(frame(reqId, tlv(tag, struct.pack('=i', self.status))))
+        except (OSError, RuntimeError):
+            return
+
+    def close(self):
+        self.lsock.close()
+
+
+def checkDut(chk, logDir):
+    """a short frame straight to the DUT is answered on tag 0"""
+    dut = subprocess.Popen([wfa_mock.DUT, 'lo', str(wfa_mock.DUT_PORT)],
+                           stdout=open(os.path.join(logDir, 'dut.log'), 'w'), stderr=subprocess.STDOUT)
+    try:
+        wfa_mock.waitPort(wfa_mock.DUT_PORT)
+        sock = socket.create_connection(('127.0.0.1', wfa_mock.DUT_PORT))
+        sock.settimeout(10)
+
+        # the TLV says 100 bytes of stream ids, 4 came
+        sock.sendall(frame(7, tlv(TRAFFIC_AGENT_SEND, struct.pack('=i', 1), claim=100)))
+        reqId, resp = recvFrame(sock)
+        tag, n, status = struct.unpack('=HHi', resp[:8])
+        chk.expect('short frame answered', reqId, 7)
+        chk.expect('short frame answered on tag 0', tag, 0)
+        chk.expect('short frame status', status, STATUS_INVALID)
+        sock.close()
+    finally:
+        dut.terminate()
+        dut.wait()
+
+
+def checkCa(chk, logDir):
+    """a status word alone is a failure, on tag 0 or a traffic tag"""
+    cases = ((None, STATUS_INVALID, 'status,ERROR'),
+             (None, STATUS_ERROR, 'status,ERROR'),
+             (0, STATUS_INVALID, 'status,INVALID'),
+             (0, STATUS_ERROR, 'status,ERROR'))
+
+    for tag, status, want in cases:
+        what = 'status %d on %s' % (status, 'tag 0' if tag == 0 else 'the command tag')
+        mock = MockDut(MOCK_DUT_PORT, tag, status)
+        ca = subprocess.Popen([wfa_mock.CA, 'lo', '%d:127.0.0.1:%d' % (wfa_mock.CA_PORT, MOCK_DUT_PORT)],
+                              stdout=open(os.path.join(logDir, 'ca.log'), 'a'), stderr=subprocess.STDOUT)
+        try:
+            wfa_mock.waitPort(wfa_mock.CA_PORT)
+            tm = wfa_mock.TestManager(wfa_mock.CA_PORT)
+            chk.expect('traffic_agent_send, %s' % what, tm.capi('traffic_agent_send,streamID,1'), want)
+            chk.expect('traffic_agent_receive_stop, %s' % what,
+                       tm.capi('traffic_agent_receive_stop,streamID,1'), want)
+            tm.close()
+        finally:
+            ca.terminate()
+            ca.wait()
+            mock.close()
+
+
+def main(keep):
+    chk = wfa_mock.Checks('test_ctrl')
+    logDir = tempfile.mkdtemp(prefix='wfa_mock.')
+
+    try:
+        checkDut(chk, logDir)
+        checkCa(chk, logDir)
+    finally:
+        if keep or chk.failed:
+            print('output kept in %s' % logDir)
+        else:
+            shutil.rmtree(logDir, ignore_errors=True)
+
+    return chk.done()
+
+
+if __name__ == '__main__':
+    sys.exit(main('-k' in sys.argv[1:]))
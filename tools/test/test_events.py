@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2016 Wi-Fi Alliance
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted, provided that the above
+# copyright notice and this permission notice appear in all copies.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+# NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+# USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+
+#
+# test_events.py - the event ring of wfa_events.c against scripted mock
+#   events: the WFDS list and details parsed from the ASP/P2PS events,
+#   the NAN event of sta_get_events, and the drop count of a full ring.
+#
+
+import sys
+import time
+
+import wfa_mock
+
+# entries of WFA_EV_RING_SZ in wfa_events.h
+RING_SZ = 64
+BURST = 100
+
+# eSessionStatus in wfa_cmds.h
+SESSION_STATUS = 6
+
+PEER = '02:11:22:33:44:55'
+SESSION_MAC = '02:11:22:33:44:66'
+
+
+def details(agents, name):
+    return agents.capi('sta_get_event_details,interface,wlan0,program,WFDS,EventName,%s' % name)
+
+
+def main(keep):
+    chk = wfa_mock.Checks('test_events')
+    ctrlDir, mock, agents = wfa_mock.setup()
+
+    try:
+        # the first call has the DUT attach to the supplicant
+        chk.expect('nothing received yet', agents.capi('sta_get_events,interface,wlan0,program,WFDS'),
+                   'status,COMPLETE,EventList,')
+        chk.true('DUT attached', wfa_mock.waitFor(lambda: len(mock.attached) > 0))
+
+        mock.events(['P2P-SERV-ASP-RESP %s ab 1f 1 108 org.wi-fi.wfds.send.rx \'x\'' % PEER,
+                     'P2PS-PROV-START %s adv_id=1f adv_mac=02:00:00:00:00:01 conncap=1 session=2a '
+                     'mac=%s dev_passwd_id=8' % (PEER, SESSION_MAC),
+                     'P2PS-PROV-DONE %s status=12 adv_id=1f adv_mac=02:00:00:00:00:01 session=2a '
+                     'mac=%s' % (PEER, SESSION_MAC),
+                     'NAN-DISCOVERY-RESULT subscribe_id=3 publish_id=7 address=02:aa:bb:cc:dd:ee fsd=1',
+                     'P2P-FIND-STOPPED'])
+
+        # each type is listed once, in the order of wfa_cmds.h
+        want = 'status,COMPLETE,EventList,SearchResult SearchTerminated SessionRequest ConnectStatus'
+        got = []
+        chk.true('WFDS event list', wfa_mock.waitFor(
+            lambda: got.append(agents.capi('sta_get_events,interface,wlan0,program,WFDS')) or got[-1] == want),
+            repr(got[-1:]))
+        chk.expect('listed only once', agents.capi('sta_get_events,interface,wlan0,program,WFDS'),
+                   'status,COMPLETE,EventList,')
+
+        # the details are parsed from the newest event of each type
+        chk.expect('SearchResult details', details(agents, 'SearchResult'),
+                   'status,COMPLETE,SerchId,ab,Service_Mac,%s,AdvID,1f,Service_name,org.wi-fi.wfds.send.rx,'
+                   'service_status,0' % PEER)
+        chk.expect('SessionRequest details', details(agents, 'SessionRequest'),
+                   'status,COMPLETE,AdvID,1f,Session_Mac,%s,session_ID,2a' % SESSION_MAC)
+        chk.expect('deferred provisioning is a ConnectStatus', details(agents, 'ConnectStatus'),
+                   'status,COMPLETE,session_ID,2a,Session_Mac,%s,status,ServiceRequestDifferred' % SESSION_MAC)
+        # both are refused, the CA answers INVALID for any failure
+        chk.expect('no SessionStatus received', details(agents, 'SessionStatus'), 'status,INVALID')
+        chk.true('SessionStatus looked up', 'no event %d received' % SESSION_STATUS in agents.dutOutput())
+        chk.expect('no details for NAN', details(agents, 'NAN'), 'status,INVALID')
+        chk.true('NAN not looked up', 'no event 0 received' not in agents.dutOutput())
+
+        # NAN events come with sta_get_events, once
+        chk.expect('NAN event', agents.capi('sta_get_events,interface,wlan0,program,NAN,action,get'),
+                   'status,COMPLETE,EventName,DiscoveryResult,RemoteInstanceID,7,LocalInstanceID,3,'
+                   'mac,02:aa:bb:cc:dd:ee')
+        chk.expect('NAN event taken', agents.capi('sta_get_events,interface,wlan0,program,NAN,action,get'),
+                   'status,COMPLETE,EventName,,RemoteInstanceID,0,LocalInstanceID,0,mac,')
+
+        # nobody drains the ring during a burst, what does not fit is counted
+        mock.events(['P2P-FIND-STOPPED'] * BURST)
+        time.sleep(1)
+        agents.capi('sta_get_events,interface,wlan0,program,WFDS')
+        drops = 'event ring full, %d events dropped' % (BURST - RING_SZ)
+        chk.true('ring drops counted', wfa_mock.waitFor(lambda: drops in agents.dutOutput()),
+                 'no "%s" in the DUT output' % drops)
+    finally:
+        wfa_mock.teardown(ctrlDir, mock, agents, keep or chk.failed)
+
+    return chk.done()
+
+
+if __name__ == '__main__':
+    sys.exit(main('-k' in sys.argv[1:]))
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2016 Wi-Fi Alliance
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted, provided that the above
+# copyright notice and this permission notice appear in all copies.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+# NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+# USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+
+#
+# test_wpactrl.py - the station handlers against the mock supplicant:
+#   requests and replies on the control socket (wfa_wpactrl.c), the
+#   STATUS kept until an event says it changed, the rollback of a
+#   refused sta_set_* transaction, and no secret in the DUT output, also
+#   when a request times out.
+#
+
+import sys
+
+import wfa_mock
+
+
+def main(keep):
+    chk = wfa_mock.Checks('test_wpactrl')
+    ctrlDir, mock, agents = wfa_mock.setup()
+
+    try:
+        # request and reply
+        chk.expect('sta_is_connected', agents.capi('sta_is_connected,interface,wlan0'),
+                   'status,COMPLETE,connected,1')
+        chk.expect('sta_get_bssid', agents.capi('sta_get_bssid,interface,wlan0'),
+                   'status,COMPLETE,bssid,00:11:22:33:44:55')
+
+        # the STATUS reply is kept, the supplicant is asked once
+        n = len(mock.requests())
+        agents.capi('sta_is_connected,interface,wlan0')
+        chk.expect('STATUS answered from memory', mock.requests(n).count('STATUS'), 0)
+
+        # an event drops it, the next query asks again
+        mock.status['wpa_state'] = 'DISCONNECTED'
+        mock.events(['CTRL-EVENT-DISCONNECTED bssid=00:11:22:33:44:55 reason=3'])
+        chk.true('event reaches the DUT', wfa_mock.waitFor(
+            lambda: agents.capi('sta_is_connected,interface,wlan0') == 'status,COMPLETE,connected,0'))
+        mock.status['wpa_state'] = 'COMPLETED'
+
+        # settings go out as one transaction and enable the network
+        n = len(mock.requests())
+        chk.expect('sta_set_psk', agents.capi('sta_set_psk,interface,wlan0,ssid,newnet,passPhrase,12345678,'
+                                              'keyMgmtType,wpa2,encpType,aes-ccmp'), 'status,COMPLETE')
+        reqs = mock.requests(n)
+        chk.expect('ssid set', mock.net.get('ssid'), '"newnet"')
+        chk.expect('psk set', mock.net.get('psk'), '"12345678"')
+        chk.true('network enabled last', reqs and reqs[-1] == 'ENABLE_NETWORK 0', repr(reqs[-1:]))
+
+        # a refused setting puts back what was there and leaves it disabled
+        n = len(mock.requests())
+        chk.expect('sta_set_psk refused', agents.capi('sta_set_psk,interface,wlan0,ssid,other,passPhrase,'
+                                                      'failme123,keyMgmtType,wpa2,encpType,aes-ccmp'), 'status,ERROR')
+        reqs = mock.requests(n)
+        chk.expect('ssid rolled back', mock.net.get('ssid'), '"newnet"')
+        chk.true('no enable after the refusal', 'ENABLE_NETWORK 0' not in reqs, repr(reqs))
+        chk.expect('network disabled', mock.net.get('disabled'), '1')
+
+        # open network
+        chk.expect('sta_set_encryption', agents.capi('sta_set_encryption,interface,wlan0,ssid,open1,encpType,none'),
+                   'status,COMPLETE')
+        chk.expect('key_mgmt NONE', mock.net.get('key_mgmt'), 'NONE')
+        chk.expect('network enabled again', mock.net.get('disabled'), '0')
+
+        # a request without a reply times out, named but without its value
+        mock.silent = ('wep_key',)
+        agents.capi('sta_set_ibss,interface,wlan0,ssid,ibss1,channel,1,encpType,wep,key1,wepsecret1234')
+        mock.silent = ()
+        chk.true('WEP key request timed out', 'no reply to SET_NETWORK' in agents.dutOutput())
+
+        # secrets are never logged by the DUT
+        chk.true('passphrase not logged', '12345678' not in agents.dutOutput())
+        chk.true('WEP key not logged', 'wepsec' not in agents.dutOutput())
+    finally:
+        wfa_mock.teardown(ctrlDir, mock, agents, keep or chk.failed)
+
+    return chk.done()
+
+
+if __name__ == '__main__':
+    sys.exit(main('-k' in sys.argv[1:]))
@@ -0,0 +1,268 @@
+#
+# Copyright (c) 2016 Wi-Fi Alliance
+#
+# Permission to use, copy, modify, and/or distribute this software for any
+# purpose with or without fee is hereby granted, provided that the above
+# copyright notice and this permission notice appear in all copies.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+# WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+# SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+# RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+# NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE
+# USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+
+#
+# wfa_mock.py - a mock wpa_supplicant control socket and a wfa_dut/wfa_ca
+#               pair to drive against it, for the checks in this directory.
+#
+# The mock answers the requests the DUT sends on the control interface of
+# one interface, keeps one network, and sends scripted events to the
+# sockets that did ATTACH. A SET_NETWORK value containing "failme" is
+# refused, so rollbacks can be checked, and a request containing one of
+# the strings in silent is not answered, so timeouts can be.
+#
+
+import os
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+TOP = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+DUT = os.path.join(TOP, 'dut', 'wfa_dut')
+CA = os.path.join(TOP, 'ca', 'wfa_ca')
+
+# ports may be moved when the defaults are taken
+DUT_PORT = int(os.environ.get('WFA_TEST_DUT_PORT', '18600'))
+CA_PORT = int(os.environ.get('WFA_TEST_CA_PORT', '19600'))
+
+SECRETS = ('psk', 'password', 'wep_key0', 'wep_key1', 'wep_key2', 'wep_key3', 'private_key_passwd')
+
+
+class MockWpa(object):
+    """wpa_supplicant control interface of ifname, in ctrlDir"""
+
+    def __init__(self, ctrlDir, ifname='wlan0'):
+        self.path = os.path.join(ctrlDir, ifname)
+        self.status = {'wpa_state': 'COMPLETED', 'bssid': '00:11:22:33:44:55',
+                       'ssid': 'mocknet', 'address': '02:00:00:00:00:01'}
+        self.net = {'ssid': '"orig"', 'key_mgmt': 'WPA-PSK', 'disabled': '0'}
+        self.log = []
+        self.attached = []
+        self.silent = ()
+        self.lock = threading.Lock()
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+        self.sock.bind(self.path)
+        self.thr = threading.Thread(target=self.serve)
+        self.thr.daemon = True
+        self.thr.start()
+
+    def reply(self, req):
+        words = req.split(' ', 3)
+        cmd = words[0]
+
+        if cmd == 'PING':
+            return 'PONG\n'
+        if cmd == 'STATUS':
+            return ''.join('%s=%s\n' % kv for kv in self.status.items())
+        if cmd == 'SET_NETWORK' and len(words) == 4:
+            if 'failme' in words[3]:
+                return 'FAIL\n'
+            self.net[words[2]] = words[3]
+            return 'OK\n'
+        if cmd == 'GET_NETWORK' and len(words) >= 3:
+            if words[2] not in self.net:
+                return 'FAIL\n'
+            return '*' if words[2] in SECRETS else self.net[words[2]]
+        if cmd == 'ENABLE_NETWORK':
+            self.net['disabled'] = '0'
+        elif cmd == 'DISABLE_NETWORK':
+            self.net['disabled'] = '1'
+        elif cmd == 'ADD_NETWORK':
+            return '0\n'
+        elif cmd == 'LIST_NETWORKS':
+            return 'network id / ssid / bssid / flags\n0\t%s\tany\t[CURRENT]\n' % self.net['ssid'].strip('"')
+        return 'OK\n'
+
+    def serve(self):
+        while True:
+            try:
+                data, addr = self.sock.recvfrom(4096)
+            except OSError:
+                return
+            req = data.decode(errors='replace')
+            with self.lock:
+                self.log.append(req)
+                if req == 'ATTACH':
+                    if addr not in self.attached:
+                        self.attached.append(addr)
+                    rep = 'OK\n'
+                elif req == 'DETACH':
+                    if addr in self.attached:
+                        self.attached.remove(addr)
+                    rep = 'OK\n'
+                elif any(word in req for word in self.silent):
+                    continue
+                else:
+                    rep = self.reply(req)
+            try:
+                self.sock.sendto(rep.encode(), addr)
+            except OSError:
+                pass
+
+    def events(self, evs, level=3):
+        """send each event to every attached socket, in order"""
+        with self.lock:
+            dests = list(self.attached)
+        for ev in evs:
+            for addr in dests:
+                try:
+                    self.sock.sendto(('<%d>%s' % (level, ev)).encode(), addr)
+                except OSError:
+                    with self.lock:
+                        if addr in self.attached:
+                            self.attached.remove(addr)
+
+    def requests(self, since=0):
+        with self.lock:
+            return self.log[since:]
+
+    def close(self):
+        self.sock.close()
+        try:
+            os.unlink(self.path)
+        except OSError:
+            pass
+
+
+class Agents(object):
+    """a wfa_dut and a wfa_ca on loopback, the DUT using ctrlDir"""
+
+    def __init__(self, ctrlDir):
+        for prog in (DUT, CA):
+            if not os.access(prog, os.X_OK):
+                sys.exit('%s not built, run make at the top first' % prog)
+
+        env = dict(os.environ, WFA_ENV_WPA_CTRL_DIR=ctrlDir)
+        # line buffered, so the checks see the output as it is printed
+        run = ['stdbuf', '-oL'] if shutil.which('stdbuf') else []
+        self.dutLog = os.path.join(ctrlDir, 'dut.log')
+        self.caLog = os.path.join(ctrlDir, 'ca.log')
+        self.procs = []
+        self.procs.append(subprocess.Popen(run + [DUT, 'lo', str(DUT_PORT)], env=env,
+                                           stdout=open(self.dutLog, 'w'), stderr=subprocess.STDOUT))
+        waitPort(DUT_PORT)
+        self.procs.append(subprocess.Popen(run + [CA, 'lo', '%d:127.0.0.1:%d' % (CA_PORT, DUT_PORT)], env=env,
+                                           stdout=open(self.caLog, 'w'), stderr=subprocess.STDOUT))
+        waitPort(CA_PORT)
+        self.tm = TestManager(CA_PORT)
+
+    def capi(self, cmd):
+        return self.tm.capi(cmd)
+
+    def dutOutput(self):
+        with open(self.dutLog, errors='replace') as f:
+            return f.read()
+
+    def stop(self):
+        self.tm.close()
+        for p in reversed(self.procs):
+            p.terminate()
+            p.wait()
+
+
+class TestManager(object):
+    """the test manager end of a control agent"""
+
+    def __init__(self, port):
+        self.sock = socket.create_connection(('127.0.0.1', port))
+        self.sock.settimeout(10)
+        self.pending = b''
+
+    def capi(self, cmd):
+        """send a CAPI command, return its final status line"""
+        self.sock.sendall((cmd + ' \r\n').encode())
+        while True:
+            while b'\r\n' not in self.pending:
+                data = self.sock.recv(4096)
+                if not data:
+                    raise RuntimeError('control agent closed the link on %s' % cmd)
+                self.pending += data
+            line, self.pending = self.pending.split(b'\r\n', 1)
+            line = line.decode(errors='replace')
+            if line != 'status,RUNNING':
+                return line
+
+    def close(self):
+        self.sock.close()
+
+
+def waitPort(port, tmout=5.0):
+    end = time.time() + tmout
+    while time.time() < end:
+        try:
+            socket.create_connection(('127.0.0.1', port)).close()
+            return
+        except OSError:
+            time.sleep(0.1)
+    sys.exit('nothing listens on port %d' % port)
+
+
+def waitFor(cond, tmout=2.0):
+    end = time.time() + tmout
+    while time.time() < end:
+        if cond():
+            return True
+        time.sleep(0.05)
+    return cond()
+
+
+class Checks(object):
+    """counts the checks of one script, the exit status tells the result"""
+
+    def __init__(self, name):
+        self.name = name
+        self.failed = 0
+        self.run = 0
+
+    def expect(self, what, got, want):
+        self.run += 1
+        if got == want:
+            print('ok   %s' % what)
+        else:
+            self.failed += 1
+            print('FAIL %s\n     got:  %r\n     want: %r' % (what, got, want))
+
+    def true(self, what, cond, detail=''):
+        self.run += 1
+        if cond:
+            print('ok   %s' % what)
+        else:
+            self.failed += 1
+            print('FAIL %s %s' % (what, detail))
+
+    def done(self):
+        print('%s: %d checks, %d failed' % (self.name, self.run, self.failed))
+        return 1 if self.failed else 0
+
+
+def setup():
+    """a fresh control directory with the mock in it and the agents running"""
+    ctrlDir = tempfile.mkdtemp(prefix='wfa_mock.')
+    mock = MockWpa(ctrlDir)
+    return ctrlDir, mock, Agents(ctrlDir)
+
+
+def teardown(ctrlDir, mock, agents, keep):
+    agents.stop()
+    mock.close()
+    if keep:
+        print('DUT output kept in %s' % agents.dutLog)
+    else:
+        shutil.rmtree(ctrlDir, ignore_errors=True)